@@ -585,6 +585,7 @@ class MixxxCore(Feature):
                    "effects/native/filtereffect.cpp",
                    "effects/native/moogladder4filtereffect.cpp",
                    "effects/native/reverbeffect.cpp",
+                   "effects/native/convolutionreverbeffect.cpp",
                    "effects/native/echoeffect.cpp",
                    "effects/native/autopaneffect.cpp",
                    "effects/native/phasereffect.cpp",
@@ -601,6 +602,10 @@ class MixxxCore(Feature):
 
                    "engine/engineworker.cpp",
                    "engine/engineworkerscheduler.cpp",
+                   "engine/channelworkerpool.cpp",
+                   "engine/scratchbufferpool.cpp",
+                   "engine/convolutionworker.cpp",
+                   "engine/partitionedconvolver.cpp",
                    "engine/enginebuffer.cpp",
                    "engine/enginebufferscale.cpp",
                    "engine/enginebufferscalelinear.cpp",
@@ -640,9 +645,11 @@ class MixxxCore(Feature):
                    "engine/enginetalkoverducking.cpp",
                    "cachingreader.cpp",
                    "cachingreaderworker.cpp",
+                   "cachingreaderdiskcache.cpp",
 
                    "analyserrg.cpp",
                    "analyserqueue.cpp",
+                   "analyserpipeline.cpp",
                    "analyserwaveform.cpp",
                    "analyserkey.cpp",
 
@@ -757,12 +764,16 @@ class MixxxCore(Feature):
                    "library/librarytablemodel.cpp",
                    "library/searchquery.cpp",
                    "library/searchqueryparser.cpp",
+                   "library/tracksearchindex.cpp",
+                   "library/tracksortindex.cpp",
                    "library/analysislibrarytablemodel.cpp",
                    "library/missingtablemodel.cpp",
                    "library/hiddentablemodel.cpp",
                    "library/proxytrackmodel.cpp",
                    "library/coverart.cpp",
                    "library/coverartcache.cpp",
+                   "library/coverartdiskcache.cpp",
+                   "library/workerdatabase.cpp",
 
                    "library/playlisttablemodel.cpp",
                    "library/libraryfeature.cpp",
@@ -900,6 +911,7 @@ class MixxxCore(Feature):
                    "skin/pixmapsource.cpp",
 
                    "sampleutil.cpp",
+                   "sampleutil_simd.cpp",
                    "samplebuffer.cpp",
                    "singularsamplebuffer.cpp",
                    "circularsamplebuffer.cpp",
@@ -937,6 +949,8 @@ class MixxxCore(Feature):
                    "util/statsmanager.cpp",
                    "util/stat.cpp",
                    "util/statmodel.cpp",
+                   "util/callbackbudget.cpp",
+                   "util/callbackbudgetmodel.cpp",
                    "util/time.cpp",
                    "util/timer.cpp",
                    "util/performancetimer.cpp",
@@ -952,6 +966,7 @@ class MixxxCore(Feature):
                    "util/xml.cpp",
                    "util/tapfilter.cpp",
                    "util/movinginterquartilemean.cpp",
+                   "util/fft.cpp",
                    "util/console.cpp",
 
                    '#res/mixxx.qrc'
@@ -740,6 +740,44 @@ class TestSuite(Feature):
         return []
 
 
+class AnalyzeTool(Feature):
+    def description(self):
+        return "mixxx-analyze batch analysis tool"
+
+    def enabled(self, build):
+        build.flags['analyze'] = util.get_flags(build.env, 'analyze', 0) or \
+            'mixxx-analyze' in SCons.BUILD_TARGETS
+        if int(build.flags['analyze']):
+            return True
+        return False
+
+    def add_options(self, build, vars):
+        vars.Add('analyze', 'Set to 1 to build the mixxx-analyze command line tool.', 0)
+
+    def configure(self, build, conf):
+        if not self.enabled(build):
+            return
+
+
+class EngineBenchTool(Feature):
+    def description(self):
+        return "mixxx-enginebench offline engine benchmark"
+
+    def enabled(self, build):
+        build.flags['enginebench'] = util.get_flags(build.env, 'enginebench', 0) or \
+            'mixxx-enginebench' in SCons.BUILD_TARGETS
+        if int(build.flags['enginebench']):
+            return True
+        return False
+
+    def add_options(self, build, vars):
+        vars.Add('enginebench', 'Set to 1 to build the mixxx-enginebench engine benchmark.', 0)
+
+    def configure(self, build, conf):
+        if not self.enabled(build):
+            return
+
+
 class Shoutcast(Feature):
     def description(self):
         return "Shoutcast Broadcasting (OGG/MP3)"
@@ -19,6 +19,15 @@ public:
     virtual bool initialise(TrackPointer tio, int sampleRate, int totalSamples) = 0;
     virtual bool loadStored(TrackPointer tio) const = 0;
     virtual void process(const CSAMPLE* pIn, const int iLen) = 0;
+    // Like process(), but the caller also provides the left and right
+    // channels of the interleaved stereo samples in pIn, iLen / 2 samples
+    // each. Analysers that work on separate channels can skip splitting them.
+    virtual void processStereo(const CSAMPLE* pIn, const CSAMPLE* pLeft,
+                               const CSAMPLE* pRight, const int iLen) {
+        Q_UNUSED(pLeft);
+        Q_UNUSED(pRight);
+        process(pIn, iLen);
+    }
     virtual void cleanup(TrackPointer tio) = 0;
     virtual void finalise(TrackPointer tio) = 0;
     virtual ~Analyser() {}
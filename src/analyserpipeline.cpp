@@ -0,0 +1,117 @@
+#include <QtDebug>
+
+#include "analyserpipeline.h"
+#include "sampleutil.h"
+#include "util/assert.h"
+#include "util/compatibility.h"
+
+AnalyserPipeline::AnalyserPipeline(const QList<Analyser*>& analysers,
+                                   SINT samplesPerBlock)
+        : m_freeBlocks(kBlockCount),
+          m_writeIndex(0),
+          m_writing(false),
+          m_discard(0) {
+    for (int i = 0; i < kBlockCount; ++i) {
+        m_blocks.append(new Block(samplesPerBlock));
+    }
+    foreach (Analyser* pAnalyser, analysers) {
+        AnalyserPipelineLane* pLane = new AnalyserPipelineLane(this, pAnalyser);
+        m_lanes.append(pLane);
+        pLane->start(QThread::LowPriority);
+    }
+}
+
+AnalyserPipeline::~AnalyserPipeline() {
+    drain(true);
+    // The lanes stop when they are deleted.
+    qDeleteAll(m_lanes);
+    qDeleteAll(m_blocks);
+}
+
+CSAMPLE* AnalyserPipeline::nextBlock() {
+    if (!m_writing) {
+        m_freeBlocks.acquire();
+        m_writing = true;
+    }
+    return m_blocks[m_writeIndex]->interleaved.data();
+}
+
+void AnalyserPipeline::pushBlock(SINT sampleCount) {
+    DEBUG_ASSERT_AND_HANDLE(m_writing) {
+        return;
+    }
+    m_writing = false;
+    Block* pBlock = m_blocks[m_writeIndex];
+    m_writeIndex = (m_writeIndex + 1) % kBlockCount;
+
+    pBlock->sampleCount = sampleCount;
+    // Split the channels once for all analysers.
+    SampleUtil::deinterleaveBuffer(pBlock->left.data(), pBlock->right.data(),
+                                   pBlock->interleaved.data(), sampleCount / 2);
+
+    if (m_lanes.isEmpty()) {
+        m_freeBlocks.release();
+        return;
+    }
+    pBlock->pendingLanes = m_lanes.size();
+    foreach (AnalyserPipelineLane* pLane, m_lanes) {
+        pLane->blockReady();
+    }
+}
+
+void AnalyserPipeline::drain(bool discard) {
+    if (m_writing) {
+        // A block was requested but never pushed.
+        m_writing = false;
+        m_freeBlocks.release();
+    }
+    m_discard = discard ? 1 : 0;
+    // All blocks are free once every lane has caught up with the decoder.
+    m_freeBlocks.acquire(kBlockCount);
+    m_freeBlocks.release(kBlockCount);
+    m_discard = 0;
+}
+
+void AnalyserPipeline::releaseBlock(Block* pBlock) {
+    // Lanes consume the blocks in order, so the blocks are released in
+    // the same order in which they were pushed.
+    if (!pBlock->pendingLanes.deref()) {
+        m_freeBlocks.release();
+    }
+}
+
+AnalyserPipelineLane::AnalyserPipelineLane(AnalyserPipeline* pPipeline,
+                                           Analyser* pAnalyser)
+        : m_pPipeline(pPipeline),
+          m_pAnalyser(pAnalyser),
+          m_readIndex(0),
+          m_stop(false) {
+}
+
+AnalyserPipelineLane::~AnalyserPipelineLane() {
+    m_stop = true;
+    m_readyBlocks.release();
+    wait();
+}
+
+void AnalyserPipelineLane::run() {
+    unsigned static id = 0; //the id of this thread, for debugging purposes
+    QThread::currentThread()->setObjectName(
+            QString("AnalyserPipelineLane %1").arg(++id));
+
+    while (true) {
+        m_readyBlocks.acquire();
+        if (m_stop) {
+            return;
+        }
+        AnalyserPipeline::Block* pBlock = m_pPipeline->m_blocks[m_readIndex];
+        m_readIndex = (m_readIndex + 1) % AnalyserPipeline::kBlockCount;
+        if (!load_atomic(m_pPipeline->m_discard)) {
+            m_pAnalyser->processStereo(pBlock->interleaved.data(),
+                                       pBlock->left.data(),
+                                       pBlock->right.data(),
+                                       pBlock->sampleCount);
+        }
+        m_pPipeline->releaseBlock(pBlock);
+    }
+}
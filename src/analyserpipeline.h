@@ -0,0 +1,92 @@
+#ifndef ANALYSERPIPELINE_H
+#define ANALYSERPIPELINE_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QSemaphore>
+#include <QThread>
+
+#include "analyser.h"
+#include "samplebuffer.h"
+
+class AnalyserPipelineLane;
+
+// AnalyserPipeline decouples decoding a track from running its analysers.
+// The decoding thread writes each block of audio once into a bounded ring of
+// shared blocks, together with the left and right channel views that several
+// analysers would otherwise split off on their own. Every analyser runs on its
+// own lane thread and consumes the blocks in order. A block is reused as soon
+// as the slowest lane is done with it, so a slow analyser throttles the
+// decoder instead of letting the memory grow.
+class AnalyserPipeline {
+  public:
+    // Number of blocks in the ring.
+    static const int kBlockCount = 8;
+
+    AnalyserPipeline(const QList<Analyser*>& analysers, SINT samplesPerBlock);
+    virtual ~AnalyserPipeline();
+
+    // Returns the buffer for the next block of interleaved stereo samples.
+    // Blocks until the lanes have released a block. Calling it again before
+    // pushBlock() returns the same buffer.
+    CSAMPLE* nextBlock();
+    // Hands the block returned by nextBlock() to all lanes.
+    void pushBlock(SINT sampleCount);
+
+    // Blocks until all lanes have processed every pushed block. With
+    // discard = true the lanes skip the blocks that are still pending,
+    // e.g. because the analysis was cancelled.
+    void drain(bool discard = false);
+
+  private:
+    friend class AnalyserPipelineLane;
+
+    struct Block {
+        explicit Block(SINT samplesPerBlock)
+                : interleaved(samplesPerBlock),
+                  left(samplesPerBlock / 2),
+                  right(samplesPerBlock / 2),
+                  sampleCount(0),
+                  pendingLanes(0) {
+        }
+        SampleBuffer interleaved;
+        SampleBuffer left;
+        SampleBuffer right;
+        SINT sampleCount;
+        QAtomicInt pendingLanes;
+    };
+
+    // Called by a lane when it is done with a block.
+    void releaseBlock(Block* pBlock);
+
+    QList<Block*> m_blocks;
+    QList<AnalyserPipelineLane*> m_lanes;
+    QSemaphore m_freeBlocks;
+    int m_writeIndex;
+    bool m_writing;
+    QAtomicInt m_discard;
+};
+
+// A thread that feeds the blocks of an AnalyserPipeline to one analyser.
+class AnalyserPipelineLane : public QThread {
+  public:
+    AnalyserPipelineLane(AnalyserPipeline* pPipeline, Analyser* pAnalyser);
+    virtual ~AnalyserPipelineLane();
+
+    // Signals that one more block is ready to be processed.
+    void blockReady() {
+        m_readyBlocks.release();
+    }
+
+  protected:
+    void run();
+
+  private:
+    AnalyserPipeline* m_pPipeline;
+    Analyser* m_pAnalyser;
+    QSemaphore m_readyBlocks;
+    int m_readIndex;
+    volatile bool m_stop;
+};
+
+#endif /* ANALYSERPIPELINE_H */
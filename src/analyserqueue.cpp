@@ -2,10 +2,12 @@
 
 #include <QtDebug>
 #include <QMutexLocker>
+#include <QScopedPointer>
 
 #include "trackinfoobject.h"
 #include "playerinfo.h"
 #include "analyserqueue.h"
+#include "analyserpipeline.h"
 #include "soundsourceproxy.h"
 #include "playerinfo.h"
 #include "util/timer.h"
@@ -16,6 +18,7 @@
 #include "analyserkey.h"
 #include "vamp/vampanalyser.h"
 #include "util/compatibility.h"
+#include "util/math.h"
 #include "util/event.h"
 #include "util/trace.h"
 
@@ -37,39 +40,62 @@ namespace {
 } // anonymous namespace
 
 AnalyserQueue::AnalyserQueue(TrackCollection* pTrackCollection)
-        : m_aq(),
-          m_exit(false),
+        : m_exit(false),
           m_aiCheckPriorities(false),
-          m_sampleBuffer(kAnalysisSamplesPerBlock),
           m_tioq(),
+          m_idleWorkers(0),
           m_qm(),
           m_qwait(),
           m_queue_size(0) {
     Q_UNUSED(pTrackCollection);
-    connect(this, SIGNAL(updateProgress()),
-            this, SLOT(slotUpdateProgress()));
+    connect(this, SIGNAL(updateProgress(int)),
+            this, SLOT(slotUpdateProgress(int)));
 }
 
 AnalyserQueue::~AnalyserQueue() {
     stop();
-    m_progressInfo.sema.release();
-    wait(); //Wait until thread has actually stopped before proceeding.
-
-    QListIterator<Analyser*> it(m_aq);
-    while (it.hasNext()) {
-        Analyser* an = it.next();
-        //qDebug() << "AnalyserQueue: deleting " << typeid(an).name();
-        delete an;
+    // Unblock all workers that wait in emitUpdateProgress().
+    foreach (progress_info* pProgressInfo, m_progressInfos) {
+        pProgressInfo->sema.release();
     }
+    foreach (AnalyserQueueWorker* pWorker, m_workers) {
+        pWorker->wait(); //Wait until thread has actually stopped before proceeding.
+    }
+    qDeleteAll(m_workers);
+    qDeleteAll(m_progressInfos);
     //qDebug() << "AnalyserQueue::~AnalyserQueue()";
 }
 
-void AnalyserQueue::addAnalyser(Analyser* an) {
-    m_aq.push_back(an);
+AnalyserQueueWorker* AnalyserQueue::addWorker() {
+    progress_info* pProgressInfo = new progress_info;
+    pProgressInfo->current_track = TrackPointer();
+    pProgressInfo->track_progress = 0;
+    pProgressInfo->queue_size = 0;
+    pProgressInfo->sema.release(); // Initalise with one
+    m_progressInfos.push_back(pProgressInfo);
+    AnalyserQueueWorker* pWorker =
+            new AnalyserQueueWorker(this, m_workers.size());
+    m_workers.push_back(pWorker);
+    return pWorker;
+}
+
+void AnalyserQueue::start() {
+    foreach (AnalyserQueueWorker* pWorker, m_workers) {
+        pWorker->start(QThread::LowPriority);
+    }
+}
+
+// static
+int AnalyserQueue::analysisThreadCount(ConfigObject<ConfigValue>* pConfig) {
+    const int threadCount = pConfig->getValueString(
+            ConfigKey("[Library]", "AnalysisThreadCount"),
+            QString::number(QThread::idealThreadCount())).toInt();
+    return math_max(1, threadCount);
 }
 
-// This is called from the AnalyserQueue thread
-bool AnalyserQueue::isLoadedTrackWaiting(TrackPointer tio) {
+// This is called from the AnalyserQueueWorker threads
+bool AnalyserQueue::isLoadedTrackWaiting(int worker, TrackPointer tio,
+                                         const QList<Analyser*>& analysers) {
     QMutexLocker queueLocker(&m_qm);
 
     const PlayerInfo& info = PlayerInfo::instance();
@@ -91,7 +117,7 @@ bool AnalyserQueue::isLoadedTrackWaiting(TrackPointer tio) {
         int progress = pTrack->getAnalyserProgress();
         if (progress < 0) {
             // Load stored analysis
-            QListIterator<Analyser*> ita(m_aq);
+            QListIterator<Analyser*> ita(analysers);
             bool processTrack = false;
             while (ita.hasNext()) {
                 if (!ita.next()->loadStored(pTrack)) {
@@ -99,10 +125,10 @@ bool AnalyserQueue::isLoadedTrackWaiting(TrackPointer tio) {
                 }
             }
             if (!processTrack) {
-                emitUpdateProgress(pTrack, 1000);
+                emitUpdateProgress(worker, pTrack, 1000);
                 it.remove();
             } else {
-                emitUpdateProgress(pTrack, 0);
+                emitUpdateProgress(worker, pTrack, 0);
             }
         } else if (progress == 1000) {
             it.remove();
@@ -111,46 +137,63 @@ bool AnalyserQueue::isLoadedTrackWaiting(TrackPointer tio) {
     if (info.isTrackLoaded(tio)) {
         return false;
     }
+    // An idle worker picks up the loaded track without interrupting anybody.
+    if (m_idleWorkers > 0) {
+        return false;
+    }
     return trackWaiting;
 }
 
-// This is called from the AnalyserQueue thread
+// This is called from the AnalyserQueueWorker threads
 TrackPointer AnalyserQueue::dequeueNextBlocking() {
-    m_qm.lock();
-    if (m_tioq.isEmpty()) {
-        Event::end("AnalyserQueue process");
-        m_qwait.wait(&m_qm);
-        Event::start("AnalyserQueue process");
-
-        if (m_exit) {
-            m_qm.unlock();
-            return TrackPointer();
-        }
-    }
+    QMutexLocker queueLocker(&m_qm);
 
     const PlayerInfo& info = PlayerInfo::instance();
     TrackPointer pLoadTrack;
-    QMutableListIterator<TrackPointer> it(m_tioq);
-    while (it.hasNext()) {
-        TrackPointer& pTrack = it.next();
-        if (!pTrack) {
-            it.remove();
-            continue;
+    while (!m_exit) {
+        int nextIndex = -1;
+        QMutableListIterator<TrackPointer> it(m_tioq);
+        while (it.hasNext()) {
+            TrackPointer& pTrack = it.next();
+            if (!pTrack) {
+                it.remove();
+                continue;
+            }
+            // A track that another worker is analysing right now stays in the
+            // queue until that worker is done with it.
+            if (m_activeTracks.contains(pTrack.data())) {
+                continue;
+            }
+            // Prioritize tracks that are loaded.
+            if (info.isTrackLoaded(pTrack)) {
+                qDebug() << "Prioritizing" << pTrack->getTitle() << pTrack->getLocation();
+                pLoadTrack = pTrack;
+                it.remove();
+                break;
+            }
+            if (nextIndex < 0) {
+                nextIndex = m_tioq.indexOf(pTrack);
+            }
         }
-        // Prioritize tracks that are loaded.
-        if (info.isTrackLoaded(pTrack)) {
-            qDebug() << "Prioritizing" << pTrack->getTitle() << pTrack->getLocation();
-            pLoadTrack = pTrack;
-            it.remove();
+
+        if (!pLoadTrack && nextIndex >= 0) {
+            pLoadTrack = m_tioq.takeAt(nextIndex);
+        }
+        if (pLoadTrack) {
+            m_activeTracks.insert(pLoadTrack.data());
             break;
         }
-    }
 
-    if (!pLoadTrack && !m_tioq.isEmpty()) {
-        pLoadTrack = m_tioq.dequeue();
+        ++m_idleWorkers;
+        Event::end("AnalyserQueue process");
+        m_qwait.wait(&m_qm);
+        Event::start("AnalyserQueue process");
+        --m_idleWorkers;
     }
 
-    m_qm.unlock();
+    if (m_exit) {
+        return TrackPointer();
+    }
 
     if (pLoadTrack) {
         qDebug() << "Analyzing" << pLoadTrack->getTitle() << pLoadTrack->getLocation();
@@ -159,13 +202,50 @@ TrackPointer AnalyserQueue::dequeueNextBlocking() {
     return pLoadTrack;
 }
 
-// This is called from the AnalyserQueue thread
-bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudioSource) {
+// This is called from the AnalyserQueueWorker threads
+void AnalyserQueue::finishTrack(TrackPointer tio) {
+    m_qm.lock();
+    m_activeTracks.remove(tio.data());
+    m_queue_size = m_tioq.size();
+    const bool done = m_tioq.isEmpty() && m_activeTracks.isEmpty();
+    // Tracks that were skipped because they were active may be dequeued now.
+    m_qwait.wakeAll();
+    m_qm.unlock();
+    if (done) {
+        emit(queueEmpty()); // emit asynchrony for no deadlock
+    }
+}
+
+AnalyserQueueWorker::AnalyserQueueWorker(AnalyserQueue* pQueue, int index)
+        : m_pQueue(pQueue),
+          m_index(index),
+          m_aq(),
+          m_sampleBuffer(kAnalysisSamplesPerBlock),
+          m_bPipelined(false),
+          m_pPipeline(NULL) {
+}
+
+AnalyserQueueWorker::~AnalyserQueueWorker() {
+    QListIterator<Analyser*> it(m_aq);
+    while (it.hasNext()) {
+        Analyser* an = it.next();
+        //qDebug() << "AnalyserQueueWorker: deleting " << typeid(an).name();
+        delete an;
+    }
+}
+
+void AnalyserQueueWorker::addAnalyser(Analyser* an) {
+    m_aq.push_back(an);
+}
+
+// This is called from the AnalyserQueueWorker thread
+bool AnalyserQueueWorker::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudioSource) {
 
     QTime progressUpdateInhibitTimer;
     progressUpdateInhibitTimer.start(); // Inhibit Updates for 60 milliseconds
 
     SINT frameIndex = pAudioSource->getMinFrameIndex();
+    int lastProgressPromille = 0;
     bool dieflag = false;
     bool cancelled = false;
     do {
@@ -178,10 +258,14 @@ bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudi
                 math_min(kAnalysisFramesPerBlock, framesRemaining);
         DEBUG_ASSERT(0 < framesToRead);
 
+        // The pipeline decodes into its shared blocks directly.
+        CSAMPLE* pSamples = m_pPipeline ?
+                m_pPipeline->nextBlock() : m_sampleBuffer.data();
         const SINT framesRead =
                 pAudioSource->readSampleFramesStereo(
                         kAnalysisFramesPerBlock,
-                        &m_sampleBuffer);
+                        pSamples,
+                        kAnalysisSamplesPerBlock);
         DEBUG_ASSERT(framesRead <= framesToRead);
         frameIndex += framesRead;
         DEBUG_ASSERT(pAudioSource->isValidFrameIndex(frameIndex));
@@ -190,12 +274,16 @@ bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudi
         // the full block size.
         if (kAnalysisFramesPerBlock == framesRead) {
             // Complete analysis block of audio samples has been read.
-            QListIterator<Analyser*> it(m_aq);
-            while (it.hasNext()) {
-                Analyser* an =  it.next();
-                //qDebug() << typeid(*an).name() << ".process()";
-                an->process(m_sampleBuffer.data(), m_sampleBuffer.size());
-                //qDebug() << "Done " << typeid(*an).name() << ".process()";
+            if (m_pPipeline) {
+                m_pPipeline->pushBlock(kAnalysisSamplesPerBlock);
+            } else {
+                QListIterator<Analyser*> it(m_aq);
+                while (it.hasNext()) {
+                    Analyser* an =  it.next();
+                    //qDebug() << typeid(*an).name() << ".process()";
+                    an->process(m_sampleBuffer.data(), m_sampleBuffer.size());
+                    //qDebug() << "Done " << typeid(*an).name() << ".process()";
+                }
             }
         } else {
             // Partial analysis block of audio samples has been read.
@@ -224,10 +312,11 @@ bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudi
                 double(frameIndex) / double(pAudioSource->getMaxFrameIndex());
         int progressPromille = frameProgress * (1000 - FINALIZE_PROMILLE);
 
-        if (m_progressInfo.track_progress != progressPromille) {
+        if (lastProgressPromille != progressPromille) {
             if (progressUpdateInhibitTimer.elapsed() > 60) {
                 // Inhibit Updates for 60 milliseconds
-                emitUpdateProgress(tio, progressPromille);
+                m_pQueue->emitUpdateProgress(m_index, tio, progressPromille);
+                lastProgressPromille = progressPromille;
                 progressUpdateInhibitTimer.start();
             }
         }
@@ -240,16 +329,15 @@ bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudi
         //QThread::usleep(10);
 
         //has something new entered the queue?
-        if (load_atomic(m_aiCheckPriorities)) {
-            m_aiCheckPriorities = false;
-            if (isLoadedTrackWaiting(tio)) {
+        if (m_pQueue->m_aiCheckPriorities.testAndSetOrdered(1, 0)) {
+            if (m_pQueue->isLoadedTrackWaiting(m_index, tio, m_aq)) {
                 qDebug() << "Interrupting analysis to give preference to a loaded track.";
                 dieflag = true;
                 cancelled = true;
             }
         }
 
-        if (m_exit) {
+        if (m_pQueue->m_exit) {
             dieflag = true;
             cancelled = true;
         }
@@ -260,6 +348,12 @@ bool AnalyserQueue::doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudi
         }
     } while (!dieflag && (frameIndex < pAudioSource->getMaxFrameIndex()));
 
+    if (m_pPipeline) {
+        // Wait for the analysers to catch up before they are finalised or
+        // cleaned up. A cancelled track is analysed again anyway.
+        m_pPipeline->drain(cancelled);
+    }
+
     return !cancelled; //don't return !dieflag or we might reanalyze over and over
 }
 
@@ -270,7 +364,7 @@ void AnalyserQueue::stop() {
     m_qm.unlock();
 }
 
-void AnalyserQueue::run() {
+void AnalyserQueueWorker::run() {
     unsigned static id = 0; //the id of this thread, for debugging purposes
     QThread::currentThread()->setObjectName(QString("AnalyserQueue %1").arg(++id));
 
@@ -278,29 +372,24 @@ void AnalyserQueue::run() {
     if (m_aq.size() == 0)
         return;
 
-    m_progressInfo.current_track = TrackPointer();
-    m_progressInfo.track_progress = 0;
-    m_progressInfo.queue_size = 0;
-    m_progressInfo.sema.release(); // Initalise with one
+    QScopedPointer<AnalyserPipeline> pPipeline;
+    if (m_bPipelined) {
+        pPipeline.reset(new AnalyserPipeline(m_aq, kAnalysisSamplesPerBlock));
+        m_pPipeline = pPipeline.data();
+    }
 
-    while (!m_exit) {
-        TrackPointer nextTrack = dequeueNextBlocking();
+    while (!m_pQueue->m_exit) {
+        TrackPointer nextTrack = m_pQueue->dequeueNextBlocking();
 
         // It's important to check for m_exit here in case we decided to exit
         // while blocking for a new track.
-        if (m_exit)
+        if (m_pQueue->m_exit)
             return;
 
         // If the track is NULL, try to get the next one.
         // Could happen if the track was queued but then deleted.
         // Or if dequeueNextBlocking is unblocked by exit == true
         if (!nextTrack) {
-            m_qm.lock();
-            m_queue_size = m_tioq.size();
-            m_qm.unlock();
-            if (m_queue_size == 0) {
-                emit(queueEmpty()); // emit asynchrony for no deadlock
-            }
             continue;
         }
 
@@ -313,6 +402,7 @@ void AnalyserQueue::run() {
         Mixxx::AudioSourcePointer pAudioSource(soundSourceProxy.openAudioSource(audioSrcCfg));
         if (!pAudioSource) {
             qWarning() << "Failed to open file for analyzing:" << nextTrack->getLocation();
+            m_pQueue->finishTrack(nextTrack);
             continue;
         }
 
@@ -325,12 +415,12 @@ void AnalyserQueue::run() {
             }
         }
 
-        m_qm.lock();
-        m_queue_size = m_tioq.size();
-        m_qm.unlock();
+        m_pQueue->m_qm.lock();
+        m_pQueue->m_queue_size = m_pQueue->m_tioq.size();
+        m_pQueue->m_qm.unlock();
 
         if (processTrack) {
-            emitUpdateProgress(nextTrack, 0);
+            m_pQueue->emitUpdateProgress(m_index, nextTrack, 0);
             bool completed = doAnalysis(nextTrack, pAudioSource);
             if (!completed) {
                 //This track was cancelled
@@ -338,66 +428,64 @@ void AnalyserQueue::run() {
                 while (itf.hasNext()) {
                     itf.next()->cleanup(nextTrack);
                 }
-                queueAnalyseTrack(nextTrack);
-                emitUpdateProgress(nextTrack, 0);
+                m_pQueue->queueAnalyseTrack(nextTrack);
+                m_pQueue->emitUpdateProgress(m_index, nextTrack, 0);
             } else {
                 // 100% - FINALIZE_PERCENT finished
-                emitUpdateProgress(nextTrack, 1000 - FINALIZE_PROMILLE);
+                m_pQueue->emitUpdateProgress(m_index, nextTrack, 1000 - FINALIZE_PROMILLE);
                 // This takes around 3 sec on a Atom Netbook
                 QListIterator<Analyser*> itf(m_aq);
                 while (itf.hasNext()) {
                     itf.next()->finalise(nextTrack);
                 }
-                emit(trackDone(nextTrack));
-                emitUpdateProgress(nextTrack, 1000); // 100%
+                emit(m_pQueue->trackDone(nextTrack));
+                m_pQueue->emitUpdateProgress(m_index, nextTrack, 1000); // 100%
             }
         } else {
-            emitUpdateProgress(nextTrack, 1000); // 100%
+            m_pQueue->emitUpdateProgress(m_index, nextTrack, 1000); // 100%
             qDebug() << "Skipping track analysis because no analyzer initialized.";
         }
 
-        m_qm.lock();
-        m_queue_size = m_tioq.size();
-        m_qm.unlock();
-        if (m_queue_size == 0) {
-            emit(queueEmpty()); // emit asynchrony for no deadlock
-        }
+        m_pQueue->finishTrack(nextTrack);
     }
-    emit(queueEmpty()); // emit in case of exit;
 }
 
-// This is called from the AnalyserQueue thread
-void AnalyserQueue::emitUpdateProgress(TrackPointer tio, int progress) {
+// This is called from the AnalyserQueueWorker threads
+void AnalyserQueue::emitUpdateProgress(int worker, TrackPointer tio,
+                                       int progress) {
     if (!m_exit) {
         // First tryAcqire will have always success because sema is initialized with on
         // The following tries will success if the previous signal was processed in the GUI Thread
         // This prevent the AnalysisQueue from filling up the GUI Thread event Queue
         // 100 % is emitted in any case
+        progress_info* pProgressInfo = m_progressInfos[worker];
         if (progress < 1000 - FINALIZE_PROMILLE && progress > 0) {
             // Signals during processing are not required in any case
-            if (!m_progressInfo.sema.tryAcquire()) {
+            if (!pProgressInfo->sema.tryAcquire()) {
                return;
             }
         } else {
-            m_progressInfo.sema.acquire();
+            pProgressInfo->sema.acquire();
         }
-        m_progressInfo.current_track = tio;
-        m_progressInfo.track_progress = progress;
-        m_progressInfo.queue_size = m_queue_size;
-        emit(updateProgress());
+        pProgressInfo->current_track = tio;
+        pProgressInfo->track_progress = progress;
+        pProgressInfo->queue_size = m_queue_size;
+        emit(updateProgress(worker));
     }
 }
 
 //slot
-void AnalyserQueue::slotUpdateProgress() {
-    if (m_progressInfo.current_track) {
-        m_progressInfo.current_track->setAnalyserProgress(m_progressInfo.track_progress);
+void AnalyserQueue::slotUpdateProgress(int worker) {
+    progress_info* pProgressInfo = m_progressInfos[worker];
+    if (pProgressInfo->current_track) {
+        pProgressInfo->current_track->setAnalyserProgress(
+                pProgressInfo->track_progress);
     }
-    emit(trackProgress(m_progressInfo.track_progress/10));
-    if (m_progressInfo.track_progress == 1000) {
-        emit(trackFinished(m_progressInfo.queue_size));
+    emit(trackProgress(pProgressInfo->track_progress/10));
+    if (pProgressInfo->track_progress == 1000) {
+        emit(trackFinished(pProgressInfo->queue_size));
     }
-    m_progressInfo.sema.release();
+    pProgressInfo->sema.release();
 }
 
 //slot
@@ -417,18 +505,44 @@ void AnalyserQueue::queueAnalyseTrack(TrackPointer tio) {
     m_qm.unlock();
 }
 
+void AnalyserQueue::queueAnalyseTracks(const QList<TrackPointer>& tracks) {
+    QMutexLocker queueLocker(&m_qm);
+    QSet<TrackInfoObject*> queued;
+    foreach (const TrackPointer& pTrack, m_tioq) {
+        queued.insert(pTrack.data());
+    }
+    foreach (const TrackPointer& pTrack, tracks) {
+        if (pTrack && !queued.contains(pTrack.data())) {
+            queued.insert(pTrack.data());
+            m_tioq.enqueue(pTrack);
+        }
+    }
+    m_qwait.wakeAll();
+}
+
+bool AnalyserQueue::isEmpty() {
+    QMutexLocker queueLocker(&m_qm);
+    return m_tioq.isEmpty() && m_activeTracks.isEmpty();
+}
+
 // static
 AnalyserQueue* AnalyserQueue::createDefaultAnalyserQueue(
         ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection) {
     AnalyserQueue* ret = new AnalyserQueue(pTrackCollection);
 
-    ret->addAnalyser(new AnalyserWaveform(pConfig));
-    ret->addAnalyser(new AnalyserGain(pConfig));
+    // Tracks are analysed here while they are loaded into players, so a single
+    // worker keeps the CPU free for the engine.
+    AnalyserQueueWorker* pWorker = ret->addWorker();
+    // Decode once and analyse on separate threads to finish the loaded
+    // track as soon as possible.
+    pWorker->setPipelined(true);
+    pWorker->addAnalyser(new AnalyserWaveform(pConfig));
+    pWorker->addAnalyser(new AnalyserGain(pConfig));
     VampAnalyser::initializePluginPaths();
-    ret->addAnalyser(new AnalyserBeats(pConfig));
-    ret->addAnalyser(new AnalyserKey(pConfig));
+    pWorker->addAnalyser(new AnalyserBeats(pConfig));
+    pWorker->addAnalyser(new AnalyserKey(pConfig));
 
-    ret->start(QThread::LowPriority);
+    ret->start();
     return ret;
 }
 
@@ -437,11 +551,39 @@ AnalyserQueue* AnalyserQueue::createAnalysisFeatureAnalyserQueue(
         ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection) {
     AnalyserQueue* ret = new AnalyserQueue(pTrackCollection);
 
-    ret->addAnalyser(new AnalyserGain(pConfig));
     VampAnalyser::initializePluginPaths();
-    ret->addAnalyser(new AnalyserBeats(pConfig));
-    ret->addAnalyser(new AnalyserKey(pConfig));
+    const int workerCount = analysisThreadCount(pConfig);
+    for (int i = 0; i < workerCount; ++i) {
+        AnalyserQueueWorker* pWorker = ret->addWorker();
+        pWorker->addAnalyser(new AnalyserGain(pConfig));
+        pWorker->addAnalyser(new AnalyserBeats(pConfig));
+        pWorker->addAnalyser(new AnalyserKey(pConfig));
+        // Workers already keep all cores busy with different tracks.
+        pWorker->setPipelined(workerCount == 1);
+    }
+    qDebug() << "Analysing tracks with" << workerCount << "threads";
+
+    ret->start();
+    return ret;
+}
+
+// static
+AnalyserQueue* AnalyserQueue::createBatchAnalyserQueue(
+        ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection) {
+    AnalyserQueue* ret = new AnalyserQueue(pTrackCollection);
+
+    VampAnalyser::initializePluginPaths();
+    const int workerCount = analysisThreadCount(pConfig);
+    for (int i = 0; i < workerCount; ++i) {
+        AnalyserQueueWorker* pWorker = ret->addWorker();
+        pWorker->addAnalyser(new AnalyserWaveform(pConfig));
+        pWorker->addAnalyser(new AnalyserGain(pConfig));
+        pWorker->addAnalyser(new AnalyserBeats(pConfig));
+        pWorker->addAnalyser(new AnalyserKey(pConfig));
+        pWorker->setPipelined(workerCount == 1);
+    }
+    qDebug() << "Analysing tracks with" << workerCount << "threads";
 
-    ret->start(QThread::LowPriority);
+    ret->start();
     return ret;
 }
@@ -8,6 +8,7 @@
 #include "samplebuffer.h"
 
 #include <QList>
+#include <QSet>
 #include <QThread>
 #include <QQueue>
 #include <QWaitCondition>
@@ -16,8 +17,15 @@
 #include <vector>
 
 class TrackCollection;
-
-class AnalyserQueue : public QThread {
+class AnalyserQueueWorker;
+class AnalyserPipeline;
+
+// AnalyserQueue owns a queue of tracks waiting for analysis and a pool of
+// AnalyserQueueWorker threads that analyse different tracks concurrently.
+// Each worker decodes its track and runs its own set of analysers. Tracks that
+// are loaded into a player are always dequeued first, and if all workers are
+// busy one of them interrupts its analysis in favour of the loaded track.
+class AnalyserQueue : public QObject {
     Q_OBJECT
 
   public:
@@ -25,15 +33,27 @@ class AnalyserQueue : public QThread {
     virtual ~AnalyserQueue();
     void stop();
     void queueAnalyseTrack(TrackPointer tio);
+    // Queues many tracks at once, in time linear in the size of the queue.
+    void queueAnalyseTracks(const QList<TrackPointer>& tracks);
+    // Returns true if no track is queued or being analysed.
+    bool isEmpty();
+
+    // Number of workers used by the analysis feature. Configured by
+    // [Library],AnalysisThreadCount and defaults to the number of cores.
+    static int analysisThreadCount(ConfigObject<ConfigValue>* pConfig);
 
     static AnalyserQueue* createDefaultAnalyserQueue(
             ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection);
     static AnalyserQueue* createAnalysisFeatureAnalyserQueue(
             ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection);
+    // Like the analysis feature queue, but also analyses waveforms. Used for
+    // analysing whole libraries without a GUI.
+    static AnalyserQueue* createBatchAnalyserQueue(
+            ConfigObject<ConfigValue>* pConfig, TrackCollection* pTrackCollection);
 
   public slots:
     void slotAnalyseTrack(TrackPointer tio);
-    void slotUpdateProgress();
+    void slotUpdateProgress(int worker);
 
   signals:
     void trackProgress(int progress);
@@ -41,13 +61,14 @@ class AnalyserQueue : public QThread {
     void trackFinished(int size);
     // Signals from AnalyserQueue Thread:
     void queueEmpty();
-    void updateProgress();
-
-  protected:
-    void run();
+    // The progress of the worker with the given index has changed.
+    void updateProgress(int worker);
 
   private:
+    friend class AnalyserQueueWorker;
 
+    // The last progress of a worker, handed to the GUI thread. Every worker
+    // has its own, so concurrent tracks do not overwrite each other.
     struct progress_info {
         TrackPointer current_track;
         int track_progress; // in 0.1 %
@@ -55,26 +76,66 @@ class AnalyserQueue : public QThread {
         QSemaphore sema;
     };
 
-    void addAnalyser(Analyser* an);
+    AnalyserQueueWorker* addWorker();
+    void start();
 
-    QList<Analyser*> m_aq;
+    QList<AnalyserQueueWorker*> m_workers;
 
-    bool isLoadedTrackWaiting(TrackPointer tio);
+    bool isLoadedTrackWaiting(int worker, TrackPointer tio,
+                              const QList<Analyser*>& analysers);
     TrackPointer dequeueNextBlocking();
-    bool doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudioSource);
-    void emitUpdateProgress(TrackPointer tio, int progress);
+    // Called by a worker once it is done with a dequeued track.
+    void finishTrack(TrackPointer tio);
+    void emitUpdateProgress(int worker, TrackPointer tio, int progress);
 
     bool m_exit;
     QAtomicInt m_aiCheckPriorities;
 
-    SampleBuffer m_sampleBuffer;
-
     // The processing queue and associated mutex
     QQueue<TrackPointer> m_tioq;
+    // Tracks that are currently analysed by a worker. Guarded by m_qm.
+    QSet<TrackInfoObject*> m_activeTracks;
+    // Number of workers waiting for a track. Guarded by m_qm.
+    int m_idleWorkers;
     QMutex m_qm;
     QWaitCondition m_qwait;
-    struct progress_info m_progressInfo;
+    // One for each worker, by index.
+    QList<progress_info*> m_progressInfos;
     int m_queue_size;
 };
 
+// A thread of the AnalyserQueue pool that analyses one track at a time.
+class AnalyserQueueWorker : public QThread {
+  public:
+    // index is the position of the worker in the pool.
+    AnalyserQueueWorker(AnalyserQueue* pQueue, int index);
+    virtual ~AnalyserQueueWorker();
+
+    void addAnalyser(Analyser* an);
+
+    // Runs the analysers on their own threads, fed by an AnalyserPipeline,
+    // so that decoding overlaps with the analysis of the track. Must be
+    // set before the worker is started.
+    void setPipelined(bool pipelined) {
+        m_bPipelined = pipelined;
+    }
+
+    bool hasAnalysers() const {
+        return !m_aq.isEmpty();
+    }
+
+  protected:
+    void run();
+
+  private:
+    bool doAnalysis(TrackPointer tio, Mixxx::AudioSourcePointer pAudioSource);
+
+    AnalyserQueue* m_pQueue;
+    const int m_index;
+    QList<Analyser*> m_aq;
+    SampleBuffer m_sampleBuffer;
+    bool m_bPipelined;
+    AnalyserPipeline* m_pPipeline;
+};
+
 #endif
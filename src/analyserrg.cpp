@@ -48,18 +48,37 @@ void AnalyserGain::process(const CSAMPLE *pIn, const int iLen) {
         return;
 
     int halfLength = static_cast<int>(iLen / 2);
-    if (halfLength > m_iBufferSize) {
-        delete [] m_pLeftTempBuffer;
-        delete [] m_pRightTempBuffer;
-        m_pLeftTempBuffer = new CSAMPLE[halfLength];
-        m_pRightTempBuffer = new CSAMPLE[halfLength];
-    }
+    allocateTempBuffers(halfLength);
     SampleUtil::deinterleaveBuffer(m_pLeftTempBuffer, m_pRightTempBuffer, pIn, halfLength);
     SampleUtil::applyGain(m_pLeftTempBuffer, 32767, halfLength);
     SampleUtil::applyGain(m_pRightTempBuffer, 32767, halfLength);
     m_bStepControl = m_pReplayGain->process(m_pLeftTempBuffer, m_pRightTempBuffer, halfLength);
 }
 
+void AnalyserGain::processStereo(const CSAMPLE* pIn, const CSAMPLE* pLeft,
+                                 const CSAMPLE* pRight, const int iLen) {
+    Q_UNUSED(pIn);
+    if(!m_bStepControl)
+        return;
+
+    // The channels are already split, so scaling them is a single pass.
+    int halfLength = static_cast<int>(iLen / 2);
+    allocateTempBuffers(halfLength);
+    SampleUtil::copyWithGain(m_pLeftTempBuffer, pLeft, 32767, halfLength);
+    SampleUtil::copyWithGain(m_pRightTempBuffer, pRight, 32767, halfLength);
+    m_bStepControl = m_pReplayGain->process(m_pLeftTempBuffer, m_pRightTempBuffer, halfLength);
+}
+
+void AnalyserGain::allocateTempBuffers(int size) {
+    if (size > m_iBufferSize) {
+        delete [] m_pLeftTempBuffer;
+        delete [] m_pRightTempBuffer;
+        m_pLeftTempBuffer = new CSAMPLE[size];
+        m_pRightTempBuffer = new CSAMPLE[size];
+        m_iBufferSize = size;
+    }
+}
+
 void AnalyserGain::finalise(TrackPointer tio) {
     //TODO: We are going to store values as relative peaks so that "0" means that no replaygain has been evaluated.
     // This means that we are going to transform from dB to peaks and viceversa.
@@ -21,10 +21,14 @@ class AnalyserGain : public Analyser {
     bool initialise(TrackPointer tio, int sampleRate, int totalSamples);
     bool loadStored(TrackPointer tio) const;
     void process(const CSAMPLE *pIn, const int iLen);
+    void processStereo(const CSAMPLE* pIn, const CSAMPLE* pLeft,
+                       const CSAMPLE* pRight, const int iLen);
     void cleanup(TrackPointer tio);
     void finalise(TrackPointer tio);
 
   private:
+    void allocateTempBuffers(int size);
+
     bool m_bStepControl;
     ConfigObject<ConfigValue> *m_pConfigReplayGain;
     CSAMPLE* m_pLeftTempBuffer;
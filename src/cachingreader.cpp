@@ -7,6 +7,7 @@
 #include "cachingreader.h"
 #include "trackinfoobject.h"
 #include "sampleutil.h"
+#include "util/callbackbudget.h"
 #include "util/counter.h"
 #include "util/math.h"
 #include "util/assert.h"
@@ -21,14 +22,16 @@ CachingReader::CachingReader(QString group,
         : m_pConfig(config),
           m_chunkReadRequestFIFO(1024),
           m_readerStatusFIFO(1024),
+          m_predecodeReleaseFIFO(16),
           m_readerStatus(INVALID),
+          m_freeChunks(maximumChunksInMemory),
+          m_freeChunkCount(0),
+          m_allocatedChunks(maximumChunksInMemory),
           m_mruChunk(NULL),
           m_lruChunk(NULL),
           m_sampleBuffer(CachingReaderWorker::kSamplesPerChunk * maximumChunksInMemory),
           m_iTrackNumFramesCallbackSafe(0) {
 
-    m_allocatedChunks.reserve(m_sampleBuffer.size());
-
     CSAMPLE* bufferStart = m_sampleBuffer.data();
 
     // Divide up the allocated raw memory buffer into total_chunks
@@ -44,14 +47,15 @@ CachingReader::CachingReader(QString group,
         c->state = Chunk::FREE;
 
         m_chunks.push_back(c);
-        m_freeChunks.push_back(c);
+        m_freeChunks[m_freeChunkCount++] = c;
 
         bufferStart += CachingReaderWorker::kSamplesPerChunk;
     }
 
-    m_pWorker = new CachingReaderWorker(group,
+    m_pWorker = new CachingReaderWorker(group, config,
             &m_chunkReadRequestFIFO,
-            &m_readerStatusFIFO);
+            &m_readerStatusFIFO,
+            &m_predecodeReleaseFIFO);
 
     // Forward signals from worker
     connect(m_pWorker, SIGNAL(trackLoading()),
@@ -71,8 +75,11 @@ CachingReader::CachingReader(QString group,
 CachingReader::~CachingReader() {
 
     m_pWorker->quitWait();
+    // The worker is stopped, so we can free the predecoded track here.
+    CachingReaderWorker::freePredecodedTrack(m_predecodedTrack);
+    m_predecodedTrack = PredecodedTrack();
     delete m_pWorker;
-    m_freeChunks.clear();
+    m_freeChunkCount = 0;
     m_allocatedChunks.clear();
     m_lruChunk = m_mruChunk = NULL;
     qDeleteAll(m_chunks);
@@ -129,14 +136,18 @@ Chunk* CachingReader::insertIntoLRUList(Chunk* chunk, Chunk* head) {
 }
 
 
-void CachingReader::freeChunk(Chunk* pChunk) {
-    int removed = m_allocatedChunks.remove(pChunk->chunk_number);
+void CachingReader::pushFreeChunk(Chunk* pChunk) {
+    DEBUG_ASSERT_AND_HANDLE(m_freeChunkCount < m_freeChunks.size()) {
+        return;
+    }
+    m_freeChunks[m_freeChunkCount++] = pChunk;
+}
 
+void CachingReader::freeChunk(Chunk* pChunk) {
     // We'll tolerate not being in allocatedChunks because sometime you free a
-    // chunk right after you allocated it.
-    if (removed > 1) {
-        qDebug() << "ERROR: freeChunk free'd a chunk that was multiply-allocated.";
-    }
+    // chunk right after you allocated it. Only removes the index entry if it
+    // still refers to pChunk.
+    m_allocatedChunks.remove(pChunk);
 
     // If this is the LRU chunk then set its previous LRU chunk to the LRU
     if (m_lruChunk == pChunk) {
@@ -147,7 +158,7 @@ void CachingReader::freeChunk(Chunk* pChunk) {
     pChunk->state = Chunk::FREE;
     pChunk->chunk_number = -1;
     pChunk->frameCount = 0;
-    m_freeChunks.push_back(pChunk);
+    pushFreeChunk(pChunk);
 }
 
 void CachingReader::freeAllChunks() {
@@ -170,21 +181,28 @@ void CachingReader::freeAllChunks() {
             pChunk->frameCount = 0;
             pChunk->next_lru = NULL;
             pChunk->prev_lru = NULL;
-            m_freeChunks.append(pChunk);
+            pushFreeChunk(pChunk);
         }
     }
 }
 
 Chunk* CachingReader::allocateChunk(int chunk) {
-    if (m_freeChunks.isEmpty()) {
+    if (m_freeChunkCount == 0) {
         return NULL;
     }
-    Chunk* pChunk = m_freeChunks.takeFirst();
-    pChunk->state = Chunk::ALLOCATED;
+    Chunk* pChunk = m_freeChunks[m_freeChunkCount - 1];
     pChunk->chunk_number = chunk;
 
     //qDebug() << "Allocating chunk" << pChunk << pChunk->chunk_number;
-    m_allocatedChunks.insert(pChunk->chunk_number, pChunk);
+    if (!m_allocatedChunks.insert(pChunk)) {
+        // Exceeding the probe distance of the index is extremely unlikely
+        // with its low load factor. Treat it like running out of chunks.
+        Counter("CachingReader::allocateChunk index full")++;
+        pChunk->chunk_number = -1;
+        return NULL;
+    }
+    --m_freeChunkCount;
+    pChunk->state = Chunk::ALLOCATED;
 
     // Insert the chunk into the least-recently-used linked list as the "most
     // recently used" item.
@@ -214,9 +232,22 @@ Chunk* CachingReader::allocateChunkExpireLRU(int chunk) {
     return pChunk;
 }
 
+void CachingReader::releasePredecodedTrack() {
+    if (m_predecodedTrack.stereoSamples == NULL) {
+        return;
+    }
+    // process() makes sure there is room, dropping the track would leak it
+    // and its share of the predecode memory budget.
+    DEBUG_ASSERT_AND_HANDLE(
+            m_predecodeReleaseFIFO.write(&m_predecodedTrack, 1) == 1) {
+        return;
+    }
+    m_predecodedTrack = PredecodedTrack();
+}
+
 Chunk* CachingReader::lookupChunk(int chunk_number) {
-    // Defaults to NULL if it's not in the hash.
-    Chunk* chunk = m_allocatedChunks.value(chunk_number, NULL);
+    // Defaults to NULL if it's not in the index.
+    Chunk* chunk = m_allocatedChunks.lookup(chunk_number);
 
     // Make sure the allocated number matches the indexed chunk number.
     DEBUG_ASSERT(chunk == NULL || chunk_number == chunk->chunk_number);
@@ -250,12 +281,22 @@ void CachingReader::newTrack(TrackPointer pTrack) {
 
 void CachingReader::process() {
     ReaderStatusUpdate status;
-    while (m_readerStatusFIFO.read(&status, 1) == 1) {
+    while (m_readerStatusFIFO.readAvailable() > 0) {
+        // Any update may release the predecoded track. If the worker has not
+        // freed the released tracks yet, the updates wait for the next
+        // callback.
+        if (m_predecodeReleaseFIFO.writeAvailable() == 0) {
+            m_pWorker->workReady();
+            break;
+        }
+        m_readerStatusFIFO.read(&status, 1);
         // qDebug() << "Got ReaderStatusUpdate:" << status.status
         //          << (status.chunk ? status.chunk->chunk_number : -1);
         if (status.status == TRACK_NOT_LOADED) {
+            releasePredecodedTrack();
             m_readerStatus = status.status;
         } else if (status.status == TRACK_LOADED) {
+            releasePredecodedTrack();
             freeAllChunks();
             m_readerStatus = status.status;
             m_iTrackNumFramesCallbackSafe = status.trackFrameCount;
@@ -293,11 +334,15 @@ void CachingReader::process() {
             }
             DEBUG_ASSERT(pChunk->state == Chunk::READ_IN_PROGRESS);
             freeChunk(pChunk);
+        } else if (status.status == TRACK_PREDECODED) {
+            releasePredecodedTrack();
+            m_predecodedTrack = status.predecodedTrack;
         }
     }
 }
 
 int CachingReader::read(int sample, int num_samples, CSAMPLE* buffer) {
+    ScopedCallbackBudget budget(CallbackBudget::CACHING_READER_READ);
     // Check for bad inputs
     DEBUG_ASSERT_AND_HANDLE(sample % 2 == 0) {
         // This problem is easy to fix, but this type of call should be
@@ -346,6 +391,19 @@ int CachingReader::read(int sample, int num_samples, CSAMPLE* buffer) {
         DEBUG_ASSERT(0 <= sample);
     }
 
+    if (m_predecodedTrack.stereoSamples != NULL) {
+        // The whole track is in memory, so this read cannot miss.
+        const int track_samples =
+                m_predecodedTrack.frameCount * CachingReaderWorker::kChunkChannels;
+        const int samples_to_read =
+                math_clamp(track_samples - sample, 0, samples_remaining);
+        SampleUtil::copy(buffer, m_predecodedTrack.stereoSamples + sample,
+                         samples_to_read);
+        SampleUtil::clear(buffer + samples_to_read,
+                          samples_remaining - samples_to_read);
+        return num_samples;
+    }
+
     DEBUG_ASSERT(0 == (sample % CachingReaderWorker::kChunkChannels));
     const int frame = sample / CachingReaderWorker::kChunkChannels;
     DEBUG_ASSERT(0 == (samples_remaining % CachingReaderWorker::kChunkChannels));
@@ -451,8 +509,9 @@ int CachingReader::read(int sample, int num_samples, CSAMPLE* buffer) {
 }
 
 void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
-    // If no file is loaded, skip.
-    if (m_readerStatus != TRACK_LOADED) {
+    // If no file is loaded, skip. A predecoded track needs no hints.
+    if (m_readerStatus != TRACK_LOADED ||
+            m_predecodedTrack.stereoSamples != NULL) {
         return;
     }
 
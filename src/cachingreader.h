@@ -7,8 +7,6 @@
 #include <QtDebug>
 #include <QList>
 #include <QVector>
-#include <QLinkedList>
-#include <QHash>
 #include <QVarLengthArray>
 
 #include "util/types.h"
@@ -17,6 +15,7 @@
 #include "engine/engineworker.h"
 #include "util/fifo.h"
 #include "cachingreaderworker.h"
+#include "cachingreaderchunkindex.h"
 
 // A Hint is an indication to the CachingReader that a certain section of a
 // SoundSource will be used 'soon' and so it should be brought into memory by
@@ -66,6 +65,10 @@ typedef QVarLengthArray<Hint, 512> HintVector;
 // least-recently-used list. When a chunk needs to be allocated and there are no
 // free chunks then the least recently used chunk is free'd (see
 // allocateChunkExpireLRU).
+//
+// read() and hintAndMaybeWake() run in the engine callback. All bookkeeping
+// they touch (the chunk index, the free list and the LRU list) is preallocated
+// in the constructor, so they never allocate, lock or rehash.
 class CachingReader : public QObject {
     Q_OBJECT
 
@@ -121,6 +124,7 @@ class CachingReader : public QObject {
     // reader thread.
     FIFO<ChunkReadRequest> m_chunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate> m_readerStatusFIFO;
+    FIFO<PredecodedTrack> m_predecodeReleaseFIFO;
 
     // Looks for the provided chunk number in the index of in-memory chunks and
     // returns it if it is present. If not, returns NULL. If it is present then
@@ -136,6 +140,7 @@ class CachingReader : public QObject {
 
     // Returns a Chunk to the free list
     void freeChunk(Chunk* pChunk);
+    void pushFreeChunk(Chunk* pChunk);
 
     // Returns all allocated chunks to the free list
     void freeAllChunks();
@@ -146,18 +151,22 @@ class CachingReader : public QObject {
     // Gets a chunk from the free list, frees the LRU Chunk if none available.
     Chunk* allocateChunkExpireLRU(int chunk);
 
+    // Hands the predecoded track (if any) back to the worker for deallocation.
+    void releasePredecodedTrack();
+
     ReaderStatus m_readerStatus;
 
     // Keeps track of all Chunks we've allocated.
     QVector<Chunk*> m_chunks;
 
-    // List of free chunks. Linked list so that we have constant time insertions
-    // and deletions. Iteration is not necessary.
-    QLinkedList<Chunk*> m_freeChunks;
+    // Stack of free chunks. Preallocated to hold all chunks, the first
+    // m_freeChunkCount entries are free.
+    QVector<Chunk*> m_freeChunks;
+    int m_freeChunkCount;
 
     // Keeps track of what Chunks we've allocated and indexes them based on what
     // chunk number they are allocated to.
-    QHash<int, Chunk*> m_allocatedChunks;
+    CachingReaderChunkIndex m_allocatedChunks;
 
     // The linked list of recently-used chunks.
     Chunk* m_mruChunk;
@@ -168,6 +177,10 @@ class CachingReader : public QObject {
 
     int m_iTrackNumFramesCallbackSafe;
 
+    // The whole decoded track if the worker has finished predecoding it. While
+    // it is set read() is served from it and the chunk cache is bypassed.
+    PredecodedTrack m_predecodedTrack;
+
     CachingReaderWorker* m_pWorker;
 };
 
@@ -0,0 +1,179 @@
+#ifndef CACHINGREADERCHUNKINDEX_H
+#define CACHINGREADERCHUNKINDEX_H
+
+#include <QtGlobal>
+
+#include "cachingreaderworker.h"
+#include "util/assert.h"
+
+// CachingReaderChunkIndex maps chunk numbers to the Chunks that are allocated
+// for them. It replaces a QHash<int, Chunk*> in the engine callback: all
+// memory is allocated up front in the constructor, nothing is ever rehashed,
+// and the index is only touched from the callback thread so no locking is
+// required.
+//
+// The index is an open-addressed hash table with linear probing. Its slots
+// are stored in one cache-line aligned array that is sized to keep the load
+// factor at or below 1/4. Insertions that would place an entry further than
+// kMaxProbeDistance slots from its home slot are rejected, and removals use
+// backward-shift deletion instead of tombstones. Together this bounds every
+// lookup (hit or miss) to at most kMaxProbeDistance + 1 slots.
+class CachingReaderChunkIndex {
+  public:
+    static const int kMaxProbeDistance = 8;
+
+    explicit CachingReaderChunkIndex(int maxEntries)
+            : m_size(0) {
+        // Keep the load factor at or below 1/4. The capacity must be a power
+        // of 2 so the home slot can be computed with a mask.
+        int capacity = 1;
+        m_shift = 32;
+        while (capacity < 4 * maxEntries || capacity < 2) {
+            capacity <<= 1;
+            --m_shift;
+        }
+        m_mask = capacity - 1;
+
+        // Over-allocate to align the slots to a cache line.
+        m_pStorage = new char[capacity * sizeof(Slot) + kCacheLineSize];
+        const quintptr address = reinterpret_cast<quintptr>(m_pStorage);
+        m_pSlots = reinterpret_cast<Slot*>(
+                (address + kCacheLineSize - 1) & ~quintptr(kCacheLineSize - 1));
+        clear();
+    }
+
+    virtual ~CachingReaderChunkIndex() {
+        delete [] m_pStorage;
+    }
+
+    // Returns the chunk allocated for chunkNumber or NULL.
+    inline Chunk* lookup(int chunkNumber) const {
+        if (chunkNumber < 0) {
+            return NULL;
+        }
+        int slot = homeSlot(chunkNumber);
+        for (int distance = 0; distance <= kMaxProbeDistance; ++distance) {
+            const Slot& current = m_pSlots[slot];
+            if (current.chunkNumber == chunkNumber) {
+                return current.pChunk;
+            }
+            if (current.chunkNumber == kEmpty) {
+                return NULL;
+            }
+            slot = (slot + 1) & m_mask;
+        }
+        return NULL;
+    }
+
+    // Indexes pChunk by its chunk_number. Returns false if the chunk number
+    // is already indexed or the probe distance limit would be exceeded.
+    bool insert(Chunk* pChunk) {
+        const int chunkNumber = pChunk->chunk_number;
+        DEBUG_ASSERT_AND_HANDLE(chunkNumber >= 0) {
+            return false;
+        }
+        int slot = homeSlot(chunkNumber);
+        for (int distance = 0; distance <= kMaxProbeDistance; ++distance) {
+            Slot& current = m_pSlots[slot];
+            if (current.chunkNumber == chunkNumber) {
+                return false;
+            }
+            if (current.chunkNumber == kEmpty) {
+                current.chunkNumber = chunkNumber;
+                current.pChunk = pChunk;
+                ++m_size;
+                return true;
+            }
+            slot = (slot + 1) & m_mask;
+        }
+        return false;
+    }
+
+    // Removes pChunk from the index. Does nothing if its chunk number is not
+    // indexed or indexed for a different chunk.
+    void remove(const Chunk* pChunk) {
+        const int chunkNumber = pChunk->chunk_number;
+        if (chunkNumber < 0) {
+            return;
+        }
+        int slot = homeSlot(chunkNumber);
+        int distance = 0;
+        for (; distance <= kMaxProbeDistance; ++distance) {
+            const Slot& current = m_pSlots[slot];
+            if (current.chunkNumber == kEmpty) {
+                return;
+            }
+            if (current.chunkNumber == chunkNumber) {
+                break;
+            }
+            slot = (slot + 1) & m_mask;
+        }
+        if (distance > kMaxProbeDistance || m_pSlots[slot].pChunk != pChunk) {
+            return;
+        }
+
+        // Backward-shift deletion: move every following entry of the probe
+        // run that may live in the freed slot one step closer to its home.
+        int hole = slot;
+        int next = (hole + 1) & m_mask;
+        while (m_pSlots[next].chunkNumber != kEmpty) {
+            const int home = homeSlot(m_pSlots[next].chunkNumber);
+            // Entries whose home slot lies cyclically in (hole, next] must
+            // stay where they are.
+            const bool stays = hole <= next ?
+                    (hole < home && home <= next) :
+                    (hole < home || home <= next);
+            if (!stays) {
+                m_pSlots[hole] = m_pSlots[next];
+                hole = next;
+            }
+            next = (next + 1) & m_mask;
+        }
+        m_pSlots[hole].chunkNumber = kEmpty;
+        m_pSlots[hole].pChunk = NULL;
+        --m_size;
+    }
+
+    void clear() {
+        for (int i = 0; i <= m_mask; ++i) {
+            m_pSlots[i].chunkNumber = kEmpty;
+            m_pSlots[i].pChunk = NULL;
+        }
+        m_size = 0;
+    }
+
+    int size() const {
+        return m_size;
+    }
+
+    int capacity() const {
+        return m_mask + 1;
+    }
+
+  private:
+    Q_DISABLE_COPY(CachingReaderChunkIndex);
+
+    static const int kEmpty = -1;
+    static const int kCacheLineSize = 64;
+
+    struct Slot {
+        int chunkNumber;
+        Chunk* pChunk;
+    };
+
+    // Fibonacci hashing spreads both consecutive chunk numbers (the playhead)
+    // and chunk numbers that are a power of 2 apart evenly across the table.
+    inline int homeSlot(int chunkNumber) const {
+        return static_cast<int>(
+                (static_cast<quint32>(chunkNumber) * 2654435769u) >> m_shift)
+                & m_mask;
+    }
+
+    char* m_pStorage;
+    Slot* m_pSlots;
+    int m_mask;
+    int m_shift;
+    int m_size;
+};
+
+#endif /* CACHINGREADERCHUNKINDEX_H */
@@ -0,0 +1,328 @@
+#include <cstddef>
+
+#include <QtDebug>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include "cachingreaderdiskcache.h"
+#include "sampleutil.h"
+#include "util/counter.h"
+#include "util/math.h"
+
+namespace {
+
+const quint32 kCacheMagic = 0x4358584d; // "MXXC"
+const quint32 kCacheVersion = 1;
+
+// The sample data starts at a page boundary so that chunk reads never
+// straddle the header pages.
+const qint64 kPageSize = 4096;
+
+const uchar kChunkPresent = 1;
+
+struct CacheHeader {
+    quint32 magic;
+    quint32 version;
+    qint64 frameCount;
+    qint32 frameRate;
+    qint32 channelCount;
+    qint64 framesPerChunk;
+    qint64 chunkCount;
+    // Milliseconds since epoch of the last time this entry was opened. Only
+    // written with QFile::write() so that the modification time of the file
+    // reflects the last use, which is what expireEntries() sorts by.
+    qint64 lastUsed;
+};
+
+const char* kCacheFileSuffix = ".pcm";
+
+} // anonymous namespace
+
+CachingReaderDiskCache::CachingReaderDiskCache(
+        ConfigObject<ConfigValue>* pConfig,
+        SINT framesPerChunk, SINT channelCount)
+        : m_pConfig(pConfig),
+          m_framesPerChunk(framesPerChunk),
+          m_channelCount(channelCount),
+          m_pMapped(NULL),
+          m_pChunkStates(NULL),
+          m_pSamples(NULL),
+          m_frameCount(0),
+          m_frameRate(0),
+          m_chunkCount(0),
+          m_hits(0),
+          m_misses(0) {
+}
+
+CachingReaderDiskCache::~CachingReaderDiskCache() {
+    close();
+}
+
+qint64 CachingReaderDiskCache::getMaxSizeBytes() const {
+    if (m_pConfig == NULL) {
+        return 0;
+    }
+    const qint64 sizeMB = m_pConfig->getValueString(
+            ConfigKey("[Config]", "DecodedAudioCacheSizeMB"), "0").toLongLong();
+    return math_max(sizeMB, qint64(0)) * 1024 * 1024;
+}
+
+QString CachingReaderDiskCache::getCacheDirectory() const {
+    return m_pConfig->getSettingsPath().append("/decodedaudiocache");
+}
+
+QString CachingReaderDiskCache::getEntryPath(const TrackPointer& pTrack) const {
+    const QFileInfo fileInfo(pTrack->getFileInfo());
+    // The size and modification time are part of the key so that an entry
+    // becomes stale as soon as the file is modified, e.g. by a tag editor.
+    const QString key = QString("%1|%2|%3")
+            .arg(fileInfo.absoluteFilePath())
+            .arg(fileInfo.size())
+            .arg(fileInfo.lastModified().toMSecsSinceEpoch());
+    const QByteArray digest = QCryptographicHash::hash(
+            key.toUtf8(), QCryptographicHash::Sha1);
+    return getCacheDirectory() + "/" + digest.toHex() + kCacheFileSuffix;
+}
+
+qint64 CachingReaderDiskCache::getDataOffset(qint64 chunkCount) const {
+    const qint64 headerSize = sizeof(CacheHeader) + chunkCount;
+    return ((headerSize + kPageSize - 1) / kPageSize) * kPageSize;
+}
+
+qint64 CachingReaderDiskCache::getEntrySize(qint64 chunkCount,
+                                            qint64 frameCount) const {
+    return getDataOffset(chunkCount) +
+            frameCount * m_channelCount * sizeof(CSAMPLE);
+}
+
+SINT CachingReaderDiskCache::getChunkFrameCount(int chunkNumber) const {
+    const SINT firstFrame = chunkNumber * m_framesPerChunk;
+    return math_clamp(m_frameCount - firstFrame, SINT(0), m_framesPerChunk);
+}
+
+bool CachingReaderDiskCache::open(const TrackPointer& pTrack) {
+    close();
+    if (getMaxSizeBytes() <= 0) {
+        return false;
+    }
+
+    m_file.setFileName(getEntryPath(pTrack));
+    if (!m_file.exists()) {
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "CachingReaderDiskCache: Failed to open"
+                   << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    // Touch the entry so that it becomes the most recently used one.
+    const qint64 lastUsed = QDateTime::currentMSecsSinceEpoch();
+    if (!m_file.seek(offsetof(CacheHeader, lastUsed)) ||
+            m_file.write(reinterpret_cast<const char*>(&lastUsed),
+                         sizeof(lastUsed)) != sizeof(lastUsed)) {
+        m_file.close();
+        return false;
+    }
+    m_file.flush();
+
+    if (!mapEntry()) {
+        qWarning() << "CachingReaderDiskCache: Discarding invalid entry"
+                   << m_file.fileName();
+        discard();
+        return false;
+    }
+    return true;
+}
+
+bool CachingReaderDiskCache::create(const TrackPointer& pTrack,
+                                    SINT frameCount, SINT frameRate) {
+    close();
+    const qint64 maxSizeBytes = getMaxSizeBytes();
+    if (maxSizeBytes <= 0 || frameCount <= 0) {
+        return false;
+    }
+
+    const qint64 chunkCount =
+            (frameCount + m_framesPerChunk - 1) / m_framesPerChunk;
+    const qint64 entrySize = getEntrySize(chunkCount, frameCount);
+    if (entrySize > maxSizeBytes) {
+        qDebug() << "CachingReaderDiskCache: Track too large for cache"
+                 << pTrack->getLocation();
+        return false;
+    }
+
+    QDir().mkpath(getCacheDirectory());
+    expireEntries(maxSizeBytes - entrySize);
+
+    m_file.setFileName(getEntryPath(pTrack));
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "CachingReaderDiskCache: Failed to create"
+                   << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    CacheHeader header;
+    header.magic = kCacheMagic;
+    header.version = kCacheVersion;
+    header.frameCount = frameCount;
+    header.frameRate = frameRate;
+    header.channelCount = m_channelCount;
+    header.framesPerChunk = m_framesPerChunk;
+    header.chunkCount = chunkCount;
+    header.lastUsed = QDateTime::currentMSecsSinceEpoch();
+
+    // The file is sparse until chunks are written, so resizing it is cheap.
+    // The chunk states are implicitly zero, i.e. absent. writeChunk() fills
+    // the holes with QFile::write() so a full disk is a failed write.
+    if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+            != sizeof(header) || !m_file.resize(entrySize)) {
+        qWarning() << "CachingReaderDiskCache: Failed to initialize"
+                   << m_file.fileName() << m_file.errorString();
+        discard();
+        return false;
+    }
+    m_file.flush();
+
+    if (!mapEntry()) {
+        discard();
+        return false;
+    }
+    return true;
+}
+
+bool CachingReaderDiskCache::mapEntry() {
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(CacheHeader))) {
+        return false;
+    }
+
+    uchar* pMapped = m_file.map(0, fileSize);
+    if (pMapped == NULL) {
+        qWarning() << "CachingReaderDiskCache: Failed to map"
+                   << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    const CacheHeader* pHeader = reinterpret_cast<const CacheHeader*>(pMapped);
+    if (pHeader->magic != kCacheMagic ||
+            pHeader->version != kCacheVersion ||
+            pHeader->channelCount != m_channelCount ||
+            pHeader->framesPerChunk != m_framesPerChunk ||
+            pHeader->frameCount <= 0 ||
+            pHeader->chunkCount !=
+            (pHeader->frameCount + m_framesPerChunk - 1) / m_framesPerChunk ||
+            getEntrySize(pHeader->chunkCount, pHeader->frameCount) != fileSize) {
+        m_file.unmap(pMapped);
+        return false;
+    }
+
+    m_pMapped = pMapped;
+    m_frameCount = pHeader->frameCount;
+    m_frameRate = pHeader->frameRate;
+    m_chunkCount = pHeader->chunkCount;
+    m_pChunkStates = m_pMapped + sizeof(CacheHeader);
+    m_pSamples = reinterpret_cast<CSAMPLE*>(
+            m_pMapped + getDataOffset(m_chunkCount));
+    m_hits = 0;
+    m_misses = 0;
+    return true;
+}
+
+void CachingReaderDiskCache::close() {
+    if (m_pMapped != NULL) {
+        if (m_hits + m_misses > 0) {
+            qDebug() << "CachingReaderDiskCache:" << m_file.fileName()
+                     << "hits" << m_hits << "misses" << m_misses
+                     << "hit rate" << 100.0 * m_hits / (m_hits + m_misses) << "%";
+        }
+        m_file.unmap(m_pMapped);
+    }
+    m_pMapped = NULL;
+    m_pChunkStates = NULL;
+    m_pSamples = NULL;
+    m_frameCount = 0;
+    m_frameRate = 0;
+    m_chunkCount = 0;
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void CachingReaderDiskCache::discard() {
+    close();
+    m_file.remove();
+}
+
+bool CachingReaderDiskCache::readChunk(int chunkNumber, CSAMPLE* pDest,
+                                       SINT* pFrameCount) {
+    if (!isOpen() || chunkNumber < 0 || chunkNumber >= m_chunkCount) {
+        return false;
+    }
+    if (m_pChunkStates[chunkNumber] != kChunkPresent) {
+        ++m_misses;
+        Counter("CachingReaderDiskCache miss")++;
+        return false;
+    }
+    const SINT frameCount = getChunkFrameCount(chunkNumber);
+    SampleUtil::copy(pDest,
+                     m_pSamples + chunkNumber * m_framesPerChunk * m_channelCount,
+                     frameCount * m_channelCount);
+    *pFrameCount = frameCount;
+    ++m_hits;
+    Counter("CachingReaderDiskCache hit")++;
+    return true;
+}
+
+void CachingReaderDiskCache::writeChunk(int chunkNumber, const CSAMPLE* pSrc,
+                                        SINT frameCount) {
+    if (!isOpen() || chunkNumber < 0 || chunkNumber >= m_chunkCount) {
+        return;
+    }
+    if (frameCount != getChunkFrameCount(chunkNumber)) {
+        return;
+    }
+    // Writing through the mapping would fault with SIGBUS if the disk is full
+    // and the sparse file cannot be extended, so only reads use the mapping.
+    const qint64 sampleOffset = getDataOffset(m_chunkCount) +
+            qint64(chunkNumber) * m_framesPerChunk * m_channelCount *
+            sizeof(CSAMPLE);
+    const qint64 sampleBytes = qint64(frameCount) * m_channelCount *
+            sizeof(CSAMPLE);
+    if (!m_file.seek(sampleOffset) ||
+            m_file.write(reinterpret_cast<const char*>(pSrc), sampleBytes)
+            != sampleBytes ||
+            !m_file.seek(sizeof(CacheHeader) + chunkNumber) ||
+            !m_file.putChar(kChunkPresent) ||
+            !m_file.flush()) {
+        qWarning() << "CachingReaderDiskCache: Failed to write to"
+                   << m_file.fileName() << m_file.errorString();
+        // Most likely the disk is full. Free the space of this entry.
+        discard();
+    }
+}
+
+void CachingReaderDiskCache::expireEntries(qint64 maxSizeBytes) {
+    QDir cacheDir(getCacheDirectory());
+    // Oldest entries last.
+    QFileInfoList entries = cacheDir.entryInfoList(
+            QStringList() << QString("*") + kCacheFileSuffix,
+            QDir::Files, QDir::Time);
+
+    qint64 totalSize = 0;
+    foreach (const QFileInfo& entry, entries) {
+        totalSize += entry.size();
+    }
+
+    while (totalSize > maxSizeBytes && !entries.isEmpty()) {
+        const QFileInfo entry = entries.takeLast();
+        // Removing an entry that is mapped by another deck is fine on POSIX
+        // systems. On Windows the removal fails and we try the next one.
+        if (QFile::remove(entry.absoluteFilePath())) {
+            totalSize -= entry.size();
+            Counter("CachingReaderDiskCache eviction")++;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef CACHINGREADERDISKCACHE_H
+#define CACHINGREADERDISKCACHE_H
+
+#include <QFile>
+#include <QString>
+
+#include "configobject.h"
+#include "trackinfoobject.h"
+#include "util/types.h"
+
+// CachingReaderDiskCache is an optional on-disk store of fully decoded PCM
+// audio for CachingReaderWorker. Each track gets one file in the cache
+// directory, keyed by its location, size and modification time. The file is
+// memory-mapped so a chunk that was decoded once (in this or a previous
+// session) is served by a memcpy from the page cache instead of being decoded
+// from the SoundSource again. Chunks are written with QFile::write(), never
+// through the mapping, since the file is sparse and a store into an
+// unallocated page raises SIGBUS when the disk is full.
+//
+// File layout:
+//   [header][one state byte per chunk][padding to a page boundary][samples]
+//
+// The sample section has the same layout as the CachingReader chunks, i.e.
+// interleaved stereo CSAMPLE frames. The chunk state byte is written after the
+// chunk samples so that a chunk is never marked present before its data.
+//
+// The cache is disabled unless [Config],DecodedAudioCacheSizeMB is set to a
+// positive value. When a new entry is created the least recently used entries
+// are deleted until the cache fits into that budget.
+//
+// All methods must be called from the thread that owns the
+// CachingReaderWorker.
+class CachingReaderDiskCache {
+  public:
+    CachingReaderDiskCache(ConfigObject<ConfigValue>* pConfig,
+                           SINT framesPerChunk, SINT channelCount);
+    virtual ~CachingReaderDiskCache();
+
+    // Opens the existing cache entry of pTrack. Returns false if the cache is
+    // disabled or no valid entry exists.
+    bool open(const TrackPointer& pTrack);
+
+    // Creates a new (empty) cache entry for pTrack after evicting old entries
+    // that do not fit into the size budget anymore. Returns false if the cache
+    // is disabled or the entry could not be created.
+    bool create(const TrackPointer& pTrack, SINT frameCount, SINT frameRate);
+
+    // Closes and unmaps the current entry.
+    void close();
+
+    // Closes the current entry and deletes it from disk, e.g. because it does
+    // not match the decoded track anymore.
+    void discard();
+
+    bool isOpen() const {
+        return m_pMapped != NULL;
+    }
+
+    SINT getFrameCount() const {
+        return m_frameCount;
+    }
+
+    SINT getFrameRate() const {
+        return m_frameRate;
+    }
+
+    // Copies chunk chunkNumber into pDest if it is present in the cache and
+    // stores its number of frames in pFrameCount. Returns false on a miss.
+    bool readChunk(int chunkNumber, CSAMPLE* pDest, SINT* pFrameCount);
+
+    // Stores a completely decoded chunk in the cache. Partial chunks are
+    // ignored. If the write fails the entry is discarded.
+    void writeChunk(int chunkNumber, const CSAMPLE* pSrc, SINT frameCount);
+
+  private:
+    qint64 getMaxSizeBytes() const;
+    QString getCacheDirectory() const;
+    QString getEntryPath(const TrackPointer& pTrack) const;
+    qint64 getEntrySize(qint64 chunkCount, qint64 frameCount) const;
+    qint64 getDataOffset(qint64 chunkCount) const;
+    SINT getChunkFrameCount(int chunkNumber) const;
+    bool mapEntry();
+
+    // Deletes least recently used entries until at most maxSizeBytes are
+    // occupied by the cache directory.
+    void expireEntries(qint64 maxSizeBytes);
+
+    ConfigObject<ConfigValue>* m_pConfig;
+    const SINT m_framesPerChunk;
+    const SINT m_channelCount;
+
+    QFile m_file;
+    uchar* m_pMapped;
+    uchar* m_pChunkStates;
+    CSAMPLE* m_pSamples;
+    SINT m_frameCount;
+    SINT m_frameRate;
+    qint64 m_chunkCount;
+
+    // Per-entry statistics, logged when the entry is closed.
+    int m_hits;
+    int m_misses;
+};
+
+#endif /* CACHINGREADERDISKCACHE_H */
@@ -3,9 +3,11 @@
 
 #include "controlobject.h"
 #include "controlobjectthread.h"
+#include "controlpushbutton.h"
 
 #include "cachingreaderworker.h"
 #include "trackinfoobject.h"
+#include "sampleutil.h"
 #include "soundsourceproxy.h"
 #include "util/compatibility.h"
 #include "util/event.h"
@@ -24,18 +26,60 @@
 const SINT CachingReaderWorker::kChunkChannels = Mixxx::AudioSource::kChannelCountStereo;
 const SINT CachingReaderWorker::kFramesPerChunk = 8192; // ~ 170 ms at 48 kHz
 const SINT CachingReaderWorker::kSamplesPerChunk = kFramesPerChunk * kChunkChannels;
+const int CachingReaderWorker::kDefaultPredecodeMemoryBudgetMB = 2048;
+
+namespace {
+
+// Memory used by the predecoded tracks of all players. Guarded by
+// s_predecodeMutex.
+QMutex s_predecodeMutex;
+qint64 s_predecodeBytesInUse = 0;
+
+qint64 predecodeBytes(SINT frameCount) {
+    return qint64(frameCount) * CachingReaderWorker::kChunkChannels *
+            sizeof(CSAMPLE);
+}
+
+} // anonymous namespace
 
 CachingReaderWorker::CachingReaderWorker(QString group,
+        ConfigObject<ConfigValue>* pConfig,
         FIFO<ChunkReadRequest>* pChunkReadRequestFIFO,
-        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO)
+        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+        FIFO<PredecodedTrack>* pPredecodeReleaseFIFO)
         : m_group(group),
           m_tag(QString("CachingReaderWorker %1").arg(m_group)),
+          m_pConfig(pConfig),
           m_pChunkReadRequestFIFO(pChunkReadRequestFIFO),
           m_pReaderStatusFIFO(pReaderStatusFIFO),
+          m_pPredecodeReleaseFIFO(pPredecodeReleaseFIFO),
+          m_diskCache(pConfig, kFramesPerChunk, kChunkChannels),
+          m_predecodeNextChunk(0),
           m_stop(0) {
+    // Whether to decode the whole track into memory after loading. Takes
+    // effect with the next track load.
+    m_pPredecodeMode = new ControlPushButton(ConfigKey(m_group, "predecode"), true);
+    m_pPredecodeMode->setButtonMode(ControlPushButton::TOGGLE);
+    // Fraction of the loaded track that has been predecoded [0, 1].
+    m_pPredecodeProgress = new ControlObject(
+            ConfigKey(m_group, "predecode_progress"));
 }
 
 CachingReaderWorker::~CachingReaderWorker() {
+    abortPredecode();
+    releasePredecodedTracks();
+    delete m_pPredecodeProgress;
+    delete m_pPredecodeMode;
+}
+
+// static
+void CachingReaderWorker::freePredecodedTrack(const PredecodedTrack& track) {
+    if (track.stereoSamples == NULL) {
+        return;
+    }
+    SampleUtil::free(track.stereoSamples);
+    QMutexLocker locker(&s_predecodeMutex);
+    s_predecodeBytesInUse -= predecodeBytes(track.frameCount);
 }
 
 void CachingReaderWorker::processChunkReadRequest(
@@ -47,10 +91,31 @@ void CachingReaderWorker::processChunkReadRequest(
     update->chunk = request->chunk;
     update->chunk->frameCount = 0;
 
-    const int chunk_number = request->chunk->chunk_number;
-    if (!m_pAudioSource || chunk_number < 0) {
-        update->status = CHUNK_READ_INVALID;
-        return;
+    SINT frameCount = 0;
+    update->status = readChunk(request->chunk->chunk_number,
+            request->chunk->stereoSamples, kFramesPerChunk, &frameCount);
+    update->chunk->frameCount = frameCount;
+}
+
+ReaderStatus CachingReaderWorker::readChunk(int chunk_number, CSAMPLE* pDest,
+                                            SINT maxFrames, SINT* pFrameCount) {
+    *pFrameCount = 0;
+    if ((!m_pAudioSource && !m_diskCache.isOpen()) || chunk_number < 0) {
+        return CHUNK_READ_INVALID;
+    }
+
+    if (m_diskCache.isOpen()) {
+        if (frameForChunk(chunk_number) >= m_diskCache.getFrameCount()) {
+            // No more data available for reading
+            return CHUNK_READ_EOF;
+        }
+        if (m_diskCache.readChunk(chunk_number, pDest, pFrameCount)) {
+            return CHUNK_READ_SUCCESS;
+        }
+    }
+
+    if (!openAudioSource()) {
+        return CHUNK_READ_INVALID;
     }
 
     const SINT chunkFrameIndex =
@@ -59,8 +124,7 @@ void CachingReaderWorker::processChunkReadRequest(
         // Frame index out of range
         qWarning() << "Invalid chunk seek position"
                 << chunkFrameIndex;
-        update->status = CHUNK_READ_INVALID;
-        return;
+        return CHUNK_READ_INVALID;
     }
 
     const SINT seekFrameIndex =
@@ -70,34 +134,131 @@ void CachingReaderWorker::processChunkReadRequest(
         // Corrupt file? -> Stop reading!
         qWarning() << "Failed to seek chunk position"
                 << seekFrameIndex << "<>" << chunkFrameIndex;
-        update->status = CHUNK_READ_INVALID;
-        return;
+        return CHUNK_READ_INVALID;
     }
 
     const SINT framesRemaining =
             m_pAudioSource->getMaxFrameIndex() - seekFrameIndex;
     const SINT framesToRead =
-            math_min(kFramesPerChunk, framesRemaining);
+            math_min(math_min(kFramesPerChunk, maxFrames), framesRemaining);
     if (0 >= framesToRead) {
         // No more data available for reading
-        update->status = CHUNK_READ_EOF;
-        return;
+        return CHUNK_READ_EOF;
     }
 
     const SINT framesRead =
             m_pAudioSource->readSampleFramesStereo(
-                    framesToRead, request->chunk->stereoSamples, kSamplesPerChunk);
+                    framesToRead, pDest, maxFrames * kChunkChannels);
     DEBUG_ASSERT(framesRead <= framesToRead);
-    update->chunk->frameCount = framesRead;
+    *pFrameCount = framesRead;
     if (framesRead < framesToRead) {
         // Incomplete read! Corrupt file?
         qWarning() << "Incomplete chunk read @" << seekFrameIndex
                 << "[" << m_pAudioSource->getMinFrameIndex()
                 << "," << m_pAudioSource->getFrameCount()
                 << "]:" << framesRead << "<" << framesToRead;
-        update->status = CHUNK_READ_PARTIAL;
-    } else {
-        update->status = CHUNK_READ_SUCCESS;
+        return CHUNK_READ_PARTIAL;
+    }
+    m_diskCache.writeChunk(chunk_number, pDest, framesRead);
+    return CHUNK_READ_SUCCESS;
+}
+
+void CachingReaderWorker::startPredecode(SINT frameCount) {
+    abortPredecode();
+    if (!m_pPredecodeMode->toBool() || frameCount <= 0) {
+        return;
+    }
+
+    const qint64 bytes = predecodeBytes(frameCount);
+    const qint64 budgetBytes = m_pConfig == NULL ? 0 :
+            m_pConfig->getValueString(
+                    ConfigKey("[Config]", "PredecodeMemoryBudgetMB"),
+                    QString::number(kDefaultPredecodeMemoryBudgetMB))
+                    .toLongLong() * 1024 * 1024;
+    {
+        QMutexLocker locker(&s_predecodeMutex);
+        if (s_predecodeBytesInUse + bytes > budgetBytes) {
+            qDebug() << m_group << "Not predecoding track, the predecode"
+                     << "memory budget is exhausted:"
+                     << s_predecodeBytesInUse << "+" << bytes << ">"
+                     << budgetBytes << "bytes";
+            return;
+        }
+        s_predecodeBytesInUse += bytes;
+    }
+
+    m_predecodingTrack.stereoSamples =
+            SampleUtil::alloc(frameCount * kChunkChannels);
+    m_predecodingTrack.frameCount = frameCount;
+    if (m_predecodingTrack.stereoSamples == NULL) {
+        qWarning() << m_group << "Failed to allocate" << bytes
+                   << "bytes for predecoding";
+        abortPredecode();
+        return;
+    }
+    m_predecodeNextChunk = 0;
+}
+
+void CachingReaderWorker::predecodeNextChunk() {
+    const SINT frameIndex = frameForChunk(m_predecodeNextChunk);
+    const SINT trackFrameCount = m_predecodingTrack.frameCount;
+    SINT frameCount = 0;
+    const ReaderStatus status = readChunk(m_predecodeNextChunk,
+            m_predecodingTrack.stereoSamples + frameIndex * kChunkChannels,
+            trackFrameCount - frameIndex, &frameCount);
+    // The decoder may deliver a few frames less than announced at the end
+    // of the track. The missing frames of the last chunk are silent.
+    const bool lastChunk = frameIndex + kFramesPerChunk >= trackFrameCount;
+    if (status == CHUNK_READ_PARTIAL && lastChunk) {
+        SampleUtil::clear(m_predecodingTrack.stereoSamples +
+                                  (frameIndex + frameCount) * kChunkChannels,
+                          (trackFrameCount - frameIndex - frameCount) *
+                                  kChunkChannels);
+        frameCount = trackFrameCount - frameIndex;
+    } else if (status != CHUNK_READ_SUCCESS) {
+        qWarning() << m_group << "Predecoding failed at chunk"
+                   << m_predecodeNextChunk << "status" << status;
+        abortPredecode();
+        return;
+    }
+
+    ++m_predecodeNextChunk;
+    const SINT framesDone = frameIndex + frameCount;
+    if (framesDone < trackFrameCount) {
+        m_pPredecodeProgress->set(
+                static_cast<double>(framesDone) / trackFrameCount);
+        return;
+    }
+
+    // Hand the complete track to the CachingReader.
+    ReaderStatusUpdate update;
+    update.status = TRACK_PREDECODED;
+    update.trackFrameCount = trackFrameCount;
+    update.predecodedTrack = m_predecodingTrack;
+    m_pReaderStatusFIFO->writeBlocking(&update, 1);
+    m_predecodingTrack = PredecodedTrack();
+    m_pPredecodeProgress->set(1.0);
+}
+
+void CachingReaderWorker::abortPredecode() {
+    if (m_predecodingTrack.frameCount > 0) {
+        if (m_predecodingTrack.stereoSamples != NULL) {
+            freePredecodedTrack(m_predecodingTrack);
+        } else {
+            // The allocation failed, only return the reserved budget.
+            QMutexLocker locker(&s_predecodeMutex);
+            s_predecodeBytesInUse -= predecodeBytes(m_predecodingTrack.frameCount);
+        }
+    }
+    m_predecodingTrack = PredecodedTrack();
+    m_predecodeNextChunk = 0;
+    m_pPredecodeProgress->set(0.0);
+}
+
+void CachingReaderWorker::releasePredecodedTracks() {
+    PredecodedTrack track;
+    while (m_pPredecodeReleaseFIFO->read(&track, 1) == 1) {
+        freePredecodedTrack(track);
     }
 }
 
@@ -118,6 +279,7 @@ void CachingReaderWorker::run() {
 
     Event::start(m_tag);
     while (!load_atomic(m_stop)) {
+        releasePredecodedTracks();
         if (m_newTrack) {
             m_newTrackMutex.lock();
             pLoadTrack = m_newTrack;
@@ -128,6 +290,10 @@ void CachingReaderWorker::run() {
             // Read the requested chunks.
             processChunkReadRequest(&request, &status);
             m_pReaderStatusFIFO->writeBlocking(&status, 1);
+        } else if (m_predecodingTrack.stereoSamples != NULL) {
+            // Chunk read requests of the engine always take precedence, so
+            // only decode one chunk at a time.
+            predecodeNextChunk();
         } else {
             Event::end(m_tag);
             m_semaRun.acquire();
@@ -161,6 +327,12 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     status.chunk = NULL;
     status.trackFrameCount = 0;
 
+    // Release the previous track before loading the new one.
+    abortPredecode();
+    m_pAudioSource.clear();
+    m_pTrack.clear();
+    m_diskCache.close();
+
     QString filename = pTrack->getLocation();
 
     if (filename.isEmpty() || !pTrack->exists()) {
@@ -173,20 +345,31 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         return;
     }
 
-    Mixxx::AudioSourceConfig audioSrcCfg;
-    audioSrcCfg.channelCountHint = kChunkChannels;
-    m_pAudioSource = openAudioSourceForReading(pTrack, audioSrcCfg);
-    if (m_pAudioSource.isNull()) {
-        // Must unlock before emitting to avoid deadlock
-        qDebug() << m_group << "CachingReaderWorker::loadTrack() load failed for\""
-                 << filename << "\", file invalid, unlocked reader lock";
-        m_pReaderStatusFIFO->writeBlocking(&status, 1);
-        emit(trackLoadFailed(
-            pTrack, QString("The file '%1' could not be loaded.").arg(filename)));
-        return;
+    m_pTrack = pTrack;
+    SINT frameCount = 0;
+    SINT frameRate = 0;
+    if (m_diskCache.open(pTrack)) {
+        // The track has been decoded before. Opening the audio source is
+        // deferred until a chunk is missing from the cache.
+        frameCount = m_diskCache.getFrameCount();
+        frameRate = m_diskCache.getFrameRate();
+    } else {
+        if (!openAudioSource()) {
+            m_pTrack.clear();
+            // Must unlock before emitting to avoid deadlock
+            qDebug() << m_group << "CachingReaderWorker::loadTrack() load failed for\""
+                     << filename << "\", file invalid, unlocked reader lock";
+            m_pReaderStatusFIFO->writeBlocking(&status, 1);
+            emit(trackLoadFailed(
+                pTrack, QString("The file '%1' could not be loaded.").arg(filename)));
+            return;
+        }
+        frameCount = m_pAudioSource->getFrameCount();
+        frameRate = m_pAudioSource->getFrameRate();
+        m_diskCache.create(pTrack, frameCount, frameRate);
     }
 
-    status.trackFrameCount = m_pAudioSource->getFrameCount();
+    status.trackFrameCount = frameCount;
     status.status = TRACK_LOADED;
     m_pReaderStatusFIFO->writeBlocking(&status, 1);
 
@@ -199,10 +382,35 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         m_pReaderStatusFIFO->writeBlocking(&status, 1);
     }
 
+    startPredecode(frameCount);
+
     // Emit that the track is loaded.
-    const SINT sampleCount =
-            m_pAudioSource->getFrameCount() * kChunkChannels;
-    emit(trackLoaded(pTrack, m_pAudioSource->getFrameRate(), sampleCount));
+    const SINT sampleCount = frameCount * kChunkChannels;
+    emit(trackLoaded(pTrack, frameRate, sampleCount));
+}
+
+bool CachingReaderWorker::openAudioSource() {
+    if (m_pAudioSource) {
+        return true;
+    }
+    if (!m_pTrack) {
+        return false;
+    }
+    Mixxx::AudioSourceConfig audioSrcCfg;
+    audioSrcCfg.channelCountHint = kChunkChannels;
+    m_pAudioSource = openAudioSourceForReading(m_pTrack, audioSrcCfg);
+    if (m_pAudioSource.isNull()) {
+        return false;
+    }
+    if (m_diskCache.isOpen() &&
+            m_diskCache.getFrameCount() != m_pAudioSource->getFrameCount()) {
+        // The decoder disagrees with the cached entry, e.g. after an upgrade
+        // of the decoding library. Don't mix samples from both.
+        qWarning() << "Discarding stale decoded audio cache entry for"
+                   << m_pTrack->getLocation();
+        m_diskCache.discard();
+    }
+    return true;
 }
 
 void CachingReaderWorker::quitWait() {
@@ -7,6 +7,8 @@
 #include <QThread>
 #include <QString>
 
+#include "cachingreaderdiskcache.h"
+#include "configobject.h"
 #include "trackinfoobject.h"
 #include "engine/engineworker.h"
 #include "sources/audiosource.h"
@@ -15,6 +17,8 @@
 
 // forward declaration(s)
 class AudioSourceProxy;
+class ControlObject;
+class ControlPushButton;
 
 // A Chunk is a section of audio that is being cached. The chunk_number can be
 // used to figure out the sample number of the first sample in data by using
@@ -48,13 +52,29 @@ enum ReaderStatus {
     CHUNK_READ_SUCCESS,
     CHUNK_READ_PARTIAL,
     CHUNK_READ_EOF,
-    CHUNK_READ_INVALID
+    CHUNK_READ_INVALID,
+    TRACK_PREDECODED
 };
 
+// A track that has been decoded completely into memory by the worker in
+// predecode mode. Ownership is handed to the CachingReader with a
+// TRACK_PREDECODED status update and handed back to the worker through the
+// predecode release FIFO once the reader does not use it anymore, so that no
+// memory is ever freed in the engine callback.
+typedef struct PredecodedTrack {
+    CSAMPLE* stereoSamples;
+    SINT frameCount;
+    PredecodedTrack()
+        : stereoSamples(NULL)
+        , frameCount(0) {
+    }
+} PredecodedTrack;
+
 typedef struct ReaderStatusUpdate {
     ReaderStatus status;
     Chunk* chunk;
     int trackFrameCount;
+    PredecodedTrack predecodedTrack;
     ReaderStatusUpdate()
         : status(INVALID)
         , chunk(NULL)
@@ -68,8 +88,10 @@ class CachingReaderWorker : public EngineWorker {
   public:
     // Construct a CachingReader with the given group.
     CachingReaderWorker(QString group,
+            ConfigObject<ConfigValue>* pConfig,
             FIFO<ChunkReadRequest>* pChunkReadRequestFIFO,
-            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO);
+            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+            FIFO<PredecodedTrack>* pPredecodeReleaseFIFO);
     virtual ~CachingReaderWorker();
 
     // Request to load a new track. wake() must be called afterwards.
@@ -92,6 +114,15 @@ class CachingReaderWorker : public EngineWorker {
         return chunk_number * kFramesPerChunk;
     }
 
+    // The default of [Config],PredecodeMemoryBudgetMB, the memory that the
+    // predecoded tracks of all players may use.
+    static const int kDefaultPredecodeMemoryBudgetMB;
+
+    // Frees the memory of a predecoded track and returns it to the predecode
+    // memory budget that is shared by all players. Must not be called from the
+    // engine callback.
+    static void freePredecodedTrack(const PredecodedTrack& track);
+
   signals:
     // Emitted once a new track is loaded and ready to be read from.
     void trackLoading();
@@ -102,11 +133,13 @@ class CachingReaderWorker : public EngineWorker {
 
     QString m_group;
     QString m_tag;
+    ConfigObject<ConfigValue>* m_pConfig;
 
     // Thread-safe FIFOs for communication between the engine callback and
     // reader thread.
     FIFO<ChunkReadRequest>* m_pChunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate>* m_pReaderStatusFIFO;
+    FIFO<PredecodedTrack>* m_pPredecodeReleaseFIFO;
 
     // Queue of Tracks to load, and the corresponding lock. Must acquire the
     // lock to touch.
@@ -121,9 +154,41 @@ class CachingReaderWorker : public EngineWorker {
     void processChunkReadRequest(ChunkReadRequest* request,
                                  ReaderStatusUpdate* update);
 
-    // The current audio source of the track loaded
+    // Reads at most maxFrames frames of the given chunk into pDest, either
+    // from the disk cache or from the audio source. Returns one of the
+    // CHUNK_READ_* states.
+    ReaderStatus readChunk(int chunk_number, CSAMPLE* pDest, SINT maxFrames,
+                           SINT* pFrameCount);
+
+    // Predecode mode: the whole track is decoded into memory chunk by chunk
+    // while there are no pending chunk read requests. Once done it is handed
+    // to the CachingReader so that reads can never miss.
+    void startPredecode(SINT frameCount);
+    void predecodeNextChunk();
+    void abortPredecode();
+    // Frees the predecoded tracks that the CachingReader has released.
+    void releasePredecodedTracks();
+
+    // Opens the audio source of the loaded track if it has not been opened
+    // yet. Tracks that are served from the disk cache are only decoded once a
+    // chunk is missing from the cache.
+    bool openAudioSource();
+
+    // The current track and its audio source
+    TrackPointer m_pTrack;
     Mixxx::AudioSourcePointer m_pAudioSource;
 
+    // Optional memory-mapped cache of decoded chunks.
+    CachingReaderDiskCache m_diskCache;
+
+    // The track that is being predecoded and the next chunk to decode. The
+    // buffer is owned by the worker until predecoding has finished.
+    PredecodedTrack m_predecodingTrack;
+    int m_predecodeNextChunk;
+
+    ControlPushButton* m_pPredecodeMode;
+    ControlObject* m_pPredecodeProgress;
+
     QAtomicInt m_stop;
 };
 
@@ -16,7 +16,8 @@ DlgAnalysis::DlgAnalysis(QWidget* parent,
           m_pTrackCollection(pTrackCollection),
           m_bAnalysisActive(false),
           m_tracksInQueue(0),
-          m_currentTrack(0) {
+          m_currentTrack(0),
+          m_finishedTracks(0) {
     setupUi(this);
     m_songsButtonGroup.addButton(radioButtonRecentlyAdded);
     m_songsButtonGroup.addButton(radioButtonAllSongs);
@@ -132,6 +133,10 @@ void DlgAnalysis::analyze() {
 
 void DlgAnalysis::analysisActive(bool bActive) {
     qDebug() << this << "analysisActive" << bActive;
+    if (bActive && !m_bAnalysisActive) {
+        m_analysisTime.start();
+        m_finishedTracks = 0;
+    }
     m_bAnalysisActive = bActive;
     if (bActive) {
         pushButtonAnalyze->setEnabled(true);
@@ -150,13 +155,27 @@ void DlgAnalysis::trackAnalysisFinished(int size) {
     }
 }
 
+// slot
+void DlgAnalysis::trackAnalysisDone(TrackPointer pTrack) {
+    Q_UNUSED(pTrack);
+    // Only tracks that ran through the analysers count towards the
+    // throughput, tracks skipped as already analysed would inflate it.
+    ++m_finishedTracks;
+}
+
 // slot
 void DlgAnalysis::trackAnalysisProgress(int progress) {
     if (m_bAnalysisActive) {
-        QString text = tr("Analyzing %1/%2 %3%").arg(
+        // Several tracks are analysed in parallel, so the throughput tells
+        // more about the remaining time than the progress of a single track.
+        const int elapsedMillis = m_analysisTime.elapsed();
+        const double tracksPerMinute = elapsedMillis > 0 ?
+                m_finishedTracks * 60000.0 / elapsedMillis : 0.0;
+        QString text = tr("Analyzing %1/%2 %3% (%4 tracks/min)").arg(
                 QString::number(m_currentTrack),
                 QString::number(m_tracksInQueue),
-                QString::number(progress));
+                QString::number(progress),
+                QString::number(tracksPerMinute, 'f', 1));
         labelProgress->setText(text);
     }
 }
@@ -2,6 +2,8 @@
 #define DLGANALYSIS_H
 
 #include <QItemSelection>
+#include <QTime>
+
 #include "ui_dlganalysis.h"
 #include "configobject.h"
 #include "library/libraryview.h"
@@ -37,6 +39,7 @@ class DlgAnalysis : public QWidget, public Ui::DlgAnalysis, public virtual Libra
     void selectAll();
     void analyze();
     void trackAnalysisFinished(int size);
+    void trackAnalysisDone(TrackPointer pTrack);
     void trackAnalysisProgress(int progress);
     void trackAnalysisStarted(int size);
     void showRecentSongs();
@@ -61,6 +64,9 @@ class DlgAnalysis : public QWidget, public Ui::DlgAnalysis, public virtual Libra
     AnalysisLibraryTableModel* m_pAnalysisLibraryTableModel;
     int m_tracksInQueue;
     int m_currentTrack;
+    // Throughput of the current analysis run, shown as tracks per minute.
+    QTime m_analysisTime;
+    int m_finishedTracks;
 };
 
 #endif //DLGTRIAGE_H
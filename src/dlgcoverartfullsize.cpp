@@ -1,6 +1,7 @@
 #include <QDesktopWidget>
 
 #include "dlgcoverartfullsize.h"
+#include "library/coverartcache.h"
 #include "library/coverartutils.h"
 
 DlgCoverArtFullSize::DlgCoverArtFullSize(QWidget* parent)
@@ -14,7 +15,10 @@ DlgCoverArtFullSize::~DlgCoverArtFullSize() {
 
 void DlgCoverArtFullSize::init(CoverInfo info) {
     // TODO(rryan): don't do this in the main thread
-    QImage cover = CoverArtUtils::loadCover(info);
+    CoverArtCache* pCache = CoverArtCache::instance();
+    QImage cover = pCache != NULL ?
+            pCache->loadCoverImage(info, CoverArtCache::kFullSizeWidth) :
+            CoverArtUtils::loadCover(info);
     QPixmap pixmap;
     if (!cover.isNull()) {
         pixmap.convertFromImage(cover);
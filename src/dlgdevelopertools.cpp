@@ -1,7 +1,9 @@
 #include "dlgdevelopertools.h"
 
 #include "control/control.h"
+#include "util/callbackbudget.h"
 #include "util/cmdlineargs.h"
+#include "util/math.h"
 #include "util/statsmanager.h"
 
 DlgDeveloperTools::DlgDeveloperTools(QWidget* pParent,
@@ -48,6 +50,13 @@ DlgDeveloperTools::DlgDeveloperTools(QWidget* pParent,
     m_statProxyModel.setSourceModel(&m_statModel);
     statsTable->setModel(&m_statProxyModel);
 
+    // Only show callbacks from after the dialog was opened. The older records
+    // have been waiting in the FIFO.
+    if (CallbackBudget::isEnabled()) {
+        CallbackBudget::instance()->discardRecords();
+    }
+    callbackBudgetTable->setModel(&m_callbackBudgetModel);
+
     QString logFileName = CmdlineArgs::Instance().getSettingsPath() + "/mixxx.log";
     m_logFile.setFileName(logFileName);
     if (!m_logFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -106,6 +115,42 @@ void DlgDeveloperTools::timerEvent(QTimerEvent* pEvent) {
             pManager->updateStats();
         }
     }
+
+    // The records are read even when the tab is hidden, so the FIFO does not
+    // overflow while the dialog is open.
+    m_callbackBudgetModel.update();
+    if (toolTabWidget->currentWidget() == callbackBudgetTab) {
+        updateCallbackBudgetSummary();
+    }
+}
+
+void DlgDeveloperTools::updateCallbackBudgetSummary() {
+    if (!CallbackBudget::isEnabled()) {
+        return;
+    }
+    callbackBudgetSummary->setText(
+            tr("%1 callbacks, %2 xruns, %3 dropped records")
+            .arg(QString::number(m_callbackBudgetModel.windowCallbackCount()),
+                 QString::number(m_callbackBudgetModel.windowXrunCount()),
+                 QString::number(m_callbackBudgetModel.droppedRecordCount())));
+
+    // Text bars of the callback time as a fraction of the budget.
+    const QVector<int>& histogram = m_callbackBudgetModel.callbackHistogram();
+    int maxCount = 1;
+    foreach (int count, histogram) {
+        maxCount = math_max(maxCount, count);
+    }
+    const int kBarWidth = 60;
+    QStringList lines;
+    for (int i = 0; i < histogram.size(); ++i) {
+        QString label = i + 1 < histogram.size() ?
+                QString("%1-%2%").arg(10 * i, 3).arg(10 * (i + 1), 3) :
+                QString(">%1%").arg(10 * i, 6);
+        lines.append(QString("%1 %2 %3").arg(label)
+                     .arg(histogram[i], 6)
+                     .arg(QString(kBarWidth * histogram[i] / maxCount, '#')));
+    }
+    callbackBudgetHistogram->setPlainText(lines.join("\n"));
 }
 
 void DlgDeveloperTools::slotControlSearch(const QString& search) {
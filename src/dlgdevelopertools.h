@@ -9,6 +9,7 @@
 #include "configobject.h"
 #include "controlobject.h"
 #include "control/controlmodel.h"
+#include "util/callbackbudgetmodel.h"
 #include "util/statmodel.h"
 
 class DlgDeveloperTools : public QDialog, public Ui::DlgDeveloperTools {
@@ -27,12 +28,16 @@ class DlgDeveloperTools : public QDialog, public Ui::DlgDeveloperTools {
     void slotLogSearch();
 
   private:
+    void updateCallbackBudgetSummary();
+
     ControlModel m_controlModel;
     QSortFilterProxyModel m_controlProxyModel;
 
     StatModel m_statModel;
     QSortFilterProxyModel m_statProxyModel;
 
+    CallbackBudgetModel m_callbackBudgetModel;
+
     QFile m_logFile;
     QTextCursor m_logCursor;
 
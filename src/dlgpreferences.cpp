@@ -96,6 +96,8 @@ DlgPreferences::DlgPreferences(MixxxMainWindow * mixxx, SkinLoader* pSkinLoader,
     addPageWidget(m_wlibrary);
     connect(m_wlibrary, SIGNAL(scanLibrary()),
             mixxx, SLOT(slotScanLibrary()));
+    connect(m_wlibrary, SIGNAL(watchDirectories(bool)),
+            mixxx, SLOT(slotWatchLibraryDirectories(bool)));
     m_wcontrols = new DlgPrefControls(this, mixxx, pSkinLoader, pPlayerManager, m_pConfig);
     addPageWidget(m_wcontrols);
     m_wwaveform = new DlgPrefWaveform(this, mixxx, m_pConfig);
@@ -135,6 +135,7 @@ void DlgPrefLibrary::slotExtraPlugins() {
 
 void DlgPrefLibrary::slotResetToDefaults() {
     checkBox_library_scan->setChecked(false);
+    checkBox_watch_directories->setChecked(false);
     checkbox_ID3_sync->setChecked(false);
     checkBox_use_relative_path->setChecked(false);
     checkBox_show_rhythmbox->setChecked(true);
@@ -152,6 +153,8 @@ void DlgPrefLibrary::slotUpdate() {
     initialiseDirList();
     checkBox_library_scan->setChecked((bool)m_pconfig->getValueString(
             ConfigKey("[Library]","RescanOnStartup")).toInt());
+    checkBox_watch_directories->setChecked((bool)m_pconfig->getValueString(
+            ConfigKey("[Library]","WatchDirectories")).toInt());
     checkbox_ID3_sync->setChecked((bool)m_pconfig->getValueString(
             ConfigKey("[Library]","WriteAudioTags")).toInt());
     checkBox_use_relative_path->setChecked((bool)m_pconfig->getValueString(
@@ -285,6 +288,13 @@ void DlgPrefLibrary::slotRelocateDir() {
 void DlgPrefLibrary::slotApply() {
     m_pconfig->set(ConfigKey("[Library]","RescanOnStartup"),
                 ConfigValue((int)checkBox_library_scan->isChecked()));
+    const bool watch = checkBox_watch_directories->isChecked();
+    if (watch != (bool)m_pconfig->getValueString(
+            ConfigKey("[Library]","WatchDirectories")).toInt()) {
+        emit(watchDirectories(watch));
+    }
+    m_pconfig->set(ConfigKey("[Library]","WatchDirectories"),
+                ConfigValue((int)watch));
     m_pconfig->set(ConfigKey("[Library]","WriteAudioTags"),
                 ConfigValue((int)checkbox_ID3_sync->isChecked()));
     m_pconfig->set(ConfigKey("[Library]","UseRelativePathOnExport"),
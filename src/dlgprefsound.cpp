@@ -17,6 +17,7 @@
 #include <QMessageBox>
 #include "dlgprefsound.h"
 #include "dlgprefsounditem.h"
+#include "cachingreaderworker.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginemaster.h"
 #include "playermanager.h"
@@ -91,6 +92,8 @@ DlgPrefSound::DlgPrefSound(QWidget* pParent, SoundManager* pSoundManager,
             this, SLOT(settingChanged()));
     connect(keylockComboBox, SIGNAL(currentIndexChanged(int)),
             this, SLOT(settingChanged()));
+    connect(predecodeBudgetSpinBox, SIGNAL(valueChanged(int)),
+            this, SLOT(settingChanged()));
 
     connect(queryButton, SIGNAL(clicked()),
             this, SLOT(queryClicked()));
@@ -194,6 +197,9 @@ void DlgPrefSound::slotApply() {
     m_pKeylockEngine->set(keylockComboBox->currentIndex());
     m_pConfig->set(ConfigKey("[Master]", "keylock_engine"),
                    ConfigValue(keylockComboBox->currentIndex()));
+    // Read by the players whenever they start predecoding a track.
+    m_pConfig->set(ConfigKey("[Config]", "PredecodeMemoryBudgetMB"),
+                   ConfigValue(predecodeBudgetSpinBox->value()));
 
     m_config.clearInputs();
     m_config.clearOutputs();
@@ -381,6 +387,11 @@ void DlgPrefSound::loadSettings(const SoundManagerConfig &config) {
             ConfigKey("[Master]", "keylock_engine"), "1").toInt();
     keylockComboBox->setCurrentIndex(keylock_engine);
 
+    predecodeBudgetSpinBox->setValue(m_pConfig->getValueString(
+            ConfigKey("[Config]", "PredecodeMemoryBudgetMB"),
+            QString::number(CachingReaderWorker::kDefaultPredecodeMemoryBudgetMB))
+            .toInt());
+
     emit(loadPaths(m_config));
     m_loading = false;
 }
@@ -534,6 +545,9 @@ void DlgPrefSound::slotResetToDefaults() {
     keylockComboBox->setCurrentIndex(EngineBuffer::RUBBERBAND);
     m_pKeylockEngine->set(EngineBuffer::RUBBERBAND);
 
+    predecodeBudgetSpinBox->setValue(
+            CachingReaderWorker::kDefaultPredecodeMemoryBudgetMB);
+
     masterMixComboBox->setCurrentIndex(1);
     m_pMasterEnabled->set(1.0);
 
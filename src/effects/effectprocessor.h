@@ -21,6 +21,9 @@ class EffectProcessor {
     };
 
 
+    // The most channels processBatch() is called with at once.
+    static const int kMaxBatchSize = 8;
+
     virtual ~EffectProcessor() { }
 
     virtual void initialize(
@@ -41,6 +44,29 @@ class EffectProcessor {
                          const unsigned int sampleRate,
                          const enum EnableState enableState,
                          const GroupFeatureState& groupFeatures) = 0;
+
+    // Processes the buffers of count channels, e.g. all decks, in place.
+    // pProcessors are count fully enabled instances of the same effect, one
+    // for each channel, pProcessors[0] is this one. The effect may process
+    // the channels together, which is cheaper if they share work.
+    // Returns false if it does not support this, the caller then calls
+    // process() for each channel.
+    virtual bool processBatch(EffectProcessor* const* pProcessors,
+                              const ChannelHandle* pHandles,
+                              CSAMPLE* const* pInOut,
+                              const GroupFeatureState* const* pGroupFeatures,
+                              const int count,
+                              const unsigned int numSamples,
+                              const unsigned int sampleRate) {
+        Q_UNUSED(pProcessors);
+        Q_UNUSED(pHandles);
+        Q_UNUSED(pInOut);
+        Q_UNUSED(pGroupFeatures);
+        Q_UNUSED(count);
+        Q_UNUSED(numSamples);
+        Q_UNUSED(sampleRate);
+        return false;
+    }
 };
 
 // Helper class for automatically fetching channel state parameters upon receipt
@@ -90,7 +116,7 @@ class PerChannelEffectProcessor : public EffectProcessor {
                                 const EffectProcessor::EnableState enableState,
                                 const GroupFeatureState& groupFeatures) = 0;
 
-  private:
+  protected:
     inline T* getOrCreateChannelState(const ChannelHandle& handle) {
         ChannelStateHolder& holder = m_channelState[handle];
         if (holder.state == NULL) {
@@ -99,6 +125,7 @@ class PerChannelEffectProcessor : public EffectProcessor {
         return holder.state;
     }
 
+  private:
     ChannelHandleMap<ChannelStateHolder> m_channelState;
 };
 
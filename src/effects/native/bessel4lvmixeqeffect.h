@@ -36,11 +36,23 @@ class Bessel4LVMixEQEffect : public PerChannelEffectProcessor<Bessel4LVMixEQEffe
                         const EffectProcessor::EnableState enableState,
                         const GroupFeatureState& groupFeatureState);
 
+    // Processes the EQs of all decks together, see effectprocessor.h
+    bool processBatch(EffectProcessor* const* pProcessors,
+                      const ChannelHandle* pHandles,
+                      CSAMPLE* const* pInOut,
+                      const GroupFeatureState* const* pGroupFeatures,
+                      const int count,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate);
+
   private:
     QString debugString() const {
         return getId();
     }
 
+    void getGains(const EffectProcessor::EnableState enableState,
+                  double* pLow, double* pMid, double* pHigh) const;
+
     EngineEffectParameter* m_pPotLow;
     EngineEffectParameter* m_pPotMid;
     EngineEffectParameter* m_pPotHigh;
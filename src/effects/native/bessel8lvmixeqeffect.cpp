@@ -122,30 +122,65 @@ void Bessel8LVMixEQEffect::processChannel(const ChannelHandle& handle,
     double fLow;
     double fMid;
     double fHigh;
+    getGains(enableState, &fLow, &fMid, &fHigh);
+
+    pState->processChannel(pInput, pOutput, numSamples, sampleRate,
+                           fLow, fMid, fHigh,
+                           m_pLoFreqCorner->get(), m_pHiFreqCorner->get());
+}
+
+bool Bessel8LVMixEQEffect::processBatch(EffectProcessor* const* pProcessors,
+                                        const ChannelHandle* pHandles,
+                                        CSAMPLE* const* pInOut,
+                                        const GroupFeatureState* const* pGroupFeatures,
+                                        const int count,
+                                        const unsigned int numSamples,
+                                        const unsigned int sampleRate) {
+    Q_UNUSED(pGroupFeatures);
+
+    LVMixEQEffectGroupState<EngineFilterBessel8Low>* states[kMaxBatchSize];
+    double fLow[kMaxBatchSize];
+    double fMid[kMaxBatchSize];
+    double fHigh[kMaxBatchSize];
+    for (int i = 0; i < count; ++i) {
+        // All processors are instances of this effect.
+        Bessel8LVMixEQEffect* pEffect =
+                static_cast<Bessel8LVMixEQEffect*>(pProcessors[i]);
+        states[i] = pEffect->getOrCreateChannelState(pHandles[i]);
+        pEffect->getGains(EffectProcessor::ENABLED,
+                          &fLow[i], &fMid[i], &fHigh[i]);
+    }
+
+    LVMixEQEffectGroupState<EngineFilterBessel8Low>::processChannels(
+            states, pInOut, pInOut, fLow, fMid, fHigh, count,
+            numSamples, sampleRate,
+            m_pLoFreqCorner->get(), m_pHiFreqCorner->get());
+    return true;
+}
+
+void Bessel8LVMixEQEffect::getGains(const EffectProcessor::EnableState enableState,
+                                    double* pLow, double* pMid,
+                                    double* pHigh) const {
     if (enableState == EffectProcessor::DISABLING) {
         // Ramp to dry, when disabling, this will ramp from dry when enabling as well
-        fLow = 1.0;
-        fMid = 1.0;
-        fHigh = 1.0;
+        *pLow = 1.0;
+        *pMid = 1.0;
+        *pHigh = 1.0;
     } else {
         if (!m_pKillLow->toBool()) {
-            fLow = m_pPotLow->value();
+            *pLow = m_pPotLow->value();
         } else {
-            fLow = 0;
+            *pLow = 0;
         }
         if (!m_pKillMid->toBool()) {
-            fMid = m_pPotMid->value();
+            *pMid = m_pPotMid->value();
         } else {
-            fMid = 0;
+            *pMid = 0;
         }
         if (!m_pKillHigh->toBool()) {
-            fHigh = m_pPotHigh->value();
+            *pHigh = m_pPotHigh->value();
         } else {
-            fHigh = 0;
+            *pHigh = 0;
         }
     }
-
-    pState->processChannel(pInput, pOutput, numSamples, sampleRate,
-                           fLow, fMid, fHigh,
-                           m_pLoFreqCorner->get(), m_pHiFreqCorner->get());
 }
@@ -0,0 +1,164 @@
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtDebug>
+
+#include "effects/native/convolutionreverbeffect.h"
+
+#include "engine/convolutionworker.h"
+#include "sampleutil.h"
+#include "util/math.h"
+
+namespace {
+
+// The head block size is the latency of the effect, 1.5 ms at 44.1 kHz. It
+// sets the cost of the engine thread, which does the head of 2 tail blocks
+// in head blocks. The rest is done by the ConvolutionWorker.
+const int kHeadBlockSize = 64;
+const int kTailBlockSize = 1024;
+
+// The impulse response is computed for this rate. At other rates the decay
+// is faster or slower in proportion.
+const int kImpulseSampleRate = 44100;
+const double kImpulseSeconds = 2.5;
+// The RMS gain of the reverb for white noise.
+const double kWetLevel = 0.5;
+
+QMutex s_kernelMutex;
+QWeakPointer<const ConvolutionKernel> s_pKernels[2];
+
+} // anonymous namespace
+
+ConvolutionReverbGroupState::ConvolutionReverbGroupState()
+        : left(ConvolutionReverbEffect::sharedKernel(0),
+               ConvolutionWorker::sharedWorker()),
+          right(ConvolutionReverbEffect::sharedKernel(1),
+                ConvolutionWorker::sharedWorker()),
+          wet_buffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
+          prev_send(0) {
+}
+
+ConvolutionReverbGroupState::~ConvolutionReverbGroupState() {
+    SampleUtil::free(wet_buffer);
+}
+
+// static
+QString ConvolutionReverbEffect::getId() {
+    return "org.mixxx.effects.convolutionreverb";
+}
+
+// static
+EffectManifest ConvolutionReverbEffect::getManifest() {
+    EffectManifest manifest;
+    manifest.setId(getId());
+    manifest.setName(QObject::tr("Convolution Reverb"));
+    manifest.setAuthor("The Mixxx Team");
+    manifest.setVersion("1.0");
+    manifest.setDescription(QObject::tr(
+            "Reverb that convolves the signal with the impulse response of "
+            "a hall"));
+
+    EffectManifestParameter* send = manifest.addParameter();
+    send->setId("send_amount");
+    send->setName(QObject::tr("Send"));
+    send->setDescription(
+            QObject::tr("How much of the signal to send into the reverb"));
+    send->setControlHint(EffectManifestParameter::CONTROL_KNOB_LINEAR);
+    send->setSemanticHint(EffectManifestParameter::SEMANTIC_UNKNOWN);
+    send->setUnitsHint(EffectManifestParameter::UNITS_UNKNOWN);
+    send->setMinimum(0.0);
+    send->setDefault(1.0);
+    send->setMaximum(1.0);
+
+    return manifest;
+}
+
+// static
+QSharedPointer<const ConvolutionKernel> ConvolutionReverbEffect::sharedKernel(
+        int channel) {
+    QMutexLocker locker(&s_kernelMutex);
+    QSharedPointer<const ConvolutionKernel> pKernel =
+            s_pKernels[channel].toStrongRef();
+    if (pKernel.isNull()) {
+        const int length = static_cast<int>(
+                kImpulseSeconds * kImpulseSampleRate);
+        const QVector<float> impulse = makeImpulse(channel, length);
+        pKernel = QSharedPointer<const ConvolutionKernel>(
+                new ConvolutionKernel(impulse.constData(), impulse.size(),
+                                      kHeadBlockSize, kTailBlockSize));
+        s_pKernels[channel] = pKernel;
+    }
+    return pKernel;
+}
+
+// static
+QVector<float> ConvolutionReverbEffect::makeImpulse(int channel, int length) {
+    QVector<float> impulse(length);
+    quint32 random = 12345 + 7919 * channel;
+    double lowpass = 0.0;
+    double energy = 0.0;
+    for (int i = 0; i < length; ++i) {
+        random = random * 1664525 + 1013904223;
+        const double noise = (random >> 8) / double(1 << 23) - 1.0;
+        const double position = double(i) / length;
+        // The one pole lowpass closes from 16 kHz to 1 kHz.
+        const double coefficient = 0.9 - 0.75 * position;
+        lowpass += coefficient * (noise - lowpass);
+        const double value = lowpass * pow(10.0, -3.0 * position);
+        impulse[i] = value;
+        energy += value * value;
+    }
+    const double gain = energy > 0.0 ? kWetLevel / sqrt(energy) : 0.0;
+    for (int i = 0; i < length; ++i) {
+        impulse[i] *= gain;
+    }
+    return impulse;
+}
+
+ConvolutionReverbEffect::ConvolutionReverbEffect(EngineEffect* pEffect,
+                                                 const EffectManifest& manifest)
+        : m_pSendParameter(pEffect->getParameterById("send_amount")),
+          m_pLeftKernel(sharedKernel(0)),
+          m_pRightKernel(sharedKernel(1)) {
+    Q_UNUSED(manifest);
+}
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect() {
+    //qDebug() << debugString() << "destroyed";
+}
+
+void ConvolutionReverbEffect::processChannel(
+        const ChannelHandle& handle,
+        ConvolutionReverbGroupState* pState,
+        const CSAMPLE* pInput, CSAMPLE* pOutput,
+        const unsigned int numSamples,
+        const unsigned int sampleRate,
+        const EffectProcessor::EnableState enableState,
+        const GroupFeatureState& groupFeatures) {
+    Q_UNUSED(handle);
+    Q_UNUSED(sampleRate);
+    Q_UNUSED(groupFeatures);
+    const CSAMPLE send = m_pSendParameter->value();
+
+    // Ramp the send and not the output, so the reverb of what has been
+    // sent rings out.
+    CSAMPLE* pWet = pState->wet_buffer;
+    SampleUtil::copyWithRampingGain(pWet, pInput, pState->prev_send, send,
+                                    numSamples);
+    pState->prev_send = send;
+    const int numFrames = numSamples / 2;
+    pState->left.process(pWet, pWet, numFrames, 2);
+    pState->right.process(pWet + 1, pWet + 1, numFrames, 2);
+
+    if (pOutput != pInput) {
+        SampleUtil::copy(pOutput, pInput, numSamples);
+    }
+    SampleUtil::addWithGain(pOutput, pWet, 1.0, numSamples);
+
+    if (enableState == EffectProcessor::DISABLING) {
+        // Start from silence when enabled again. reset() is cheap, it
+        // leaves the delay lines alone.
+        pState->left.reset();
+        pState->right.reset();
+        pState->prev_send = 0;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef CONVOLUTIONREVERBEFFECT_H
+#define CONVOLUTIONREVERBEFFECT_H
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include "util.h"
+#include "util/types.h"
+#include "util/defs.h"
+#include "effects/effectprocessor.h"
+#include "engine/effects/engineeffect.h"
+#include "engine/effects/engineeffectparameter.h"
+#include "engine/partitionedconvolver.h"
+#include "sampleutil.h"
+
+struct ConvolutionReverbGroupState {
+    ConvolutionReverbGroupState();
+    ~ConvolutionReverbGroupState();
+
+    // One convolver for each channel, they use different impulse responses
+    // for a wider sound.
+    PartitionedConvolver left;
+    PartitionedConvolver right;
+    CSAMPLE* wet_buffer;
+    CSAMPLE prev_send;
+};
+
+class ConvolutionReverbEffect
+        : public PerChannelEffectProcessor<ConvolutionReverbGroupState> {
+  public:
+    ConvolutionReverbEffect(EngineEffect* pEffect,
+                            const EffectManifest& manifest);
+    virtual ~ConvolutionReverbEffect();
+
+    static QString getId();
+    static EffectManifest getManifest();
+
+    // The kernel of a channel of the built in impulse response. All
+    // instances share it.
+    static QSharedPointer<const ConvolutionKernel> sharedKernel(int channel);
+
+    // A synthetic hall, noise that decays by 60 dB over length samples and
+    // gets darker as it decays. Each channel gets its own noise.
+    static QVector<float> makeImpulse(int channel, int length);
+
+    // See effectprocessor.h
+    void processChannel(const ChannelHandle& handle,
+                        ConvolutionReverbGroupState* pState,
+                        const CSAMPLE* pInput, CSAMPLE* pOutput,
+                        const unsigned int numSamples,
+                        const unsigned int sampleRate,
+                        const EffectProcessor::EnableState enableState,
+                        const GroupFeatureState& groupFeatures);
+
+  private:
+    QString debugString() const {
+        return getId();
+    }
+
+    EngineEffectParameter* m_pSendParameter;
+    // Keep the kernels alive while the effect exists.
+    QSharedPointer<const ConvolutionKernel> m_pLeftKernel;
+    QSharedPointer<const ConvolutionKernel> m_pRightKernel;
+
+    DISALLOW_COPY_AND_ASSIGN(ConvolutionReverbEffect);
+};
+
+#endif /* CONVOLUTIONREVERBEFFECT_H */
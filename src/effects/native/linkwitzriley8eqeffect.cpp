@@ -1,4 +1,5 @@
 #include "effects/native/linkwitzriley8eqeffect.h"
+#include "util/assert.h"
 #include "util/math.h"
 
 static const unsigned int kStartupSamplerate = 44100;
@@ -158,70 +159,159 @@ void LinkwitzRiley8EQEffect::processChannel(const ChannelHandle& handle,
     Q_UNUSED(handle);
     Q_UNUSED(groupFeatures);
 
-    float fLow = 0.f, fMid = 0.f, fHigh = 0.f;
+    float fLow;
+    float fMid;
+    float fHigh;
+    getGains(&fLow, &fMid, &fHigh);
+
+    processChannels(&pState, &pInput, &pOutput, &fLow, &fMid, &fHigh, 1,
+                    numSamples, sampleRate, enableState);
+}
+
+bool LinkwitzRiley8EQEffect::processBatch(EffectProcessor* const* pProcessors,
+                                          const ChannelHandle* pHandles,
+                                          CSAMPLE* const* pInOut,
+                                          const GroupFeatureState* const* pGroupFeatures,
+                                          const int count,
+                                          const unsigned int numSamples,
+                                          const unsigned int sampleRate) {
+    Q_UNUSED(pGroupFeatures);
+
+    LinkwitzRiley8EQEffectGroupState* states[kMaxBatchSize];
+    float fLow[kMaxBatchSize];
+    float fMid[kMaxBatchSize];
+    float fHigh[kMaxBatchSize];
+    for (int i = 0; i < count; ++i) {
+        // All processors are instances of this effect.
+        LinkwitzRiley8EQEffect* pEffect =
+                static_cast<LinkwitzRiley8EQEffect*>(pProcessors[i]);
+        states[i] = pEffect->getOrCreateChannelState(pHandles[i]);
+        pEffect->getGains(&fLow[i], &fMid[i], &fHigh[i]);
+    }
+
+    processChannels(states, pInOut, pInOut, fLow, fMid, fHigh, count,
+                    numSamples, sampleRate, EffectProcessor::ENABLED);
+    return true;
+}
+
+void LinkwitzRiley8EQEffect::getGains(float* pLow, float* pMid,
+                                      float* pHigh) const {
+    *pLow = 0.f;
+    *pMid = 0.f;
+    *pHigh = 0.f;
     if (!m_pKillLow->toBool()) {
-        fLow = m_pPotLow->value();
+        *pLow = m_pPotLow->value();
     }
     if (!m_pKillMid->toBool()) {
-        fMid = m_pPotMid->value();
+        *pMid = m_pPotMid->value();
     }
     if (!m_pKillHigh->toBool()) {
-        fHigh = m_pPotHigh->value();
+        *pHigh = m_pPotHigh->value();
     }
+}
+
+void LinkwitzRiley8EQEffect::processChannels(
+        LinkwitzRiley8EQEffectGroupState* const* pStates,
+        const CSAMPLE* const* pInputs, CSAMPLE* const* pOutputs,
+        const float* fLows, const float* fMids, const float* fHighs,
+        const int count,
+        const unsigned int numSamples,
+        const unsigned int sampleRate,
+        const EffectProcessor::EnableState enableState) {
+    DEBUG_ASSERT(count <= kMaxBatchSize);
+    EngineFilterLinkwtzRiley8Low* lowFilters[kMaxBatchSize];
+    EngineFilterLinkwtzRiley8High* highFilters[kMaxBatchSize];
+    CSAMPLE* lowBuffers[kMaxBatchSize];
+    CSAMPLE* bandBuffers[kMaxBatchSize];
+    CSAMPLE* highBuffers[kMaxBatchSize];
 
-    if (pState->m_oldSampleRate != sampleRate ||
-            (pState->m_loFreq != static_cast<int>(m_pLoFreqCorner->get())) ||
-            (pState->m_hiFreq != static_cast<int>(m_pHiFreqCorner->get()))) {
-        pState->m_loFreq = static_cast<int>(m_pLoFreqCorner->get());
-        pState->m_hiFreq = static_cast<int>(m_pHiFreqCorner->get());
-        pState->m_oldSampleRate = sampleRate;
-        pState->setFilters(sampleRate, pState->m_loFreq, pState->m_hiFreq);
+    const int loFreq = static_cast<int>(m_pLoFreqCorner->get());
+    const int hiFreq = static_cast<int>(m_pHiFreqCorner->get());
+    for (int i = 0; i < count; ++i) {
+        LinkwitzRiley8EQEffectGroupState* pState = pStates[i];
+        if (pState->m_oldSampleRate != sampleRate ||
+                (pState->m_loFreq != loFreq) ||
+                (pState->m_hiFreq != hiFreq)) {
+            pState->m_loFreq = loFreq;
+            pState->m_hiFreq = hiFreq;
+            pState->m_oldSampleRate = sampleRate;
+            pState->setFilters(sampleRate, pState->m_loFreq, pState->m_hiFreq);
+        }
+        lowBuffers[i] = pState->m_pLowBuf;
+        bandBuffers[i] = pState->m_pBandBuf;
+        highBuffers[i] = pState->m_pHighBuf;
     }
 
-    pState->m_high2->process(pInput, pState->m_pHighBuf, numSamples); // HighPass first run
-    pState->m_low2->process(pInput, pState->m_pLowBuf, numSamples); // LowPass first run for low and bandpass
-
-    if (fMid != pState->old_mid ||
-            fHigh != pState->old_high) {
-        SampleUtil::copy2WithRampingGain(pState->m_pHighBuf,
-                pState->m_pHighBuf, pState->old_high, fHigh,
-                pState->m_pLowBuf, pState->old_mid, fMid,
-                numSamples);
-    } else {
-        SampleUtil::copy2WithGain(pState->m_pHighBuf,
-                pState->m_pHighBuf, fHigh,
-                pState->m_pLowBuf, fMid,
-                numSamples);
+    // HighPass first run
+    for (int i = 0; i < count; ++i) {
+        highFilters[i] = pStates[i]->m_high2;
     }
+    EngineFilterLinkwtzRiley8High::processBatch(
+            highFilters, pInputs, highBuffers, count, numSamples);
+    // LowPass first run for low and bandpass
+    for (int i = 0; i < count; ++i) {
+        lowFilters[i] = pStates[i]->m_low2;
+    }
+    EngineFilterLinkwtzRiley8Low::processBatch(
+            lowFilters, pInputs, lowBuffers, count, numSamples);
 
-    pState->m_high1->process(pState->m_pHighBuf, pState->m_pBandBuf, numSamples); // HighPass + BandPass second run
-    pState->m_low1->process(pState->m_pLowBuf, pState->m_pLowBuf, numSamples); // LowPass second run
-
-    if (fLow != pState->old_low) {
-        SampleUtil::copy2WithRampingGain(pOutput,
-                pState->m_pLowBuf, pState->old_low, fLow,
-                pState->m_pBandBuf, 1, 1,
-                numSamples);
-    } else {
-        SampleUtil::copy2WithGain(pOutput,
-                pState->m_pLowBuf, fLow,
-                pState->m_pBandBuf, 1,
-                numSamples);
+    for (int i = 0; i < count; ++i) {
+        LinkwitzRiley8EQEffectGroupState* pState = pStates[i];
+        if (fMids[i] != pState->old_mid ||
+                fHighs[i] != pState->old_high) {
+            SampleUtil::copy2WithRampingGain(pState->m_pHighBuf,
+                    pState->m_pHighBuf, pState->old_high, fHighs[i],
+                    pState->m_pLowBuf, pState->old_mid, fMids[i],
+                    numSamples);
+        } else {
+            SampleUtil::copy2WithGain(pState->m_pHighBuf,
+                    pState->m_pHighBuf, fHighs[i],
+                    pState->m_pLowBuf, fMids[i],
+                    numSamples);
+        }
     }
 
-    if (enableState == EffectProcessor::DISABLING) {
-        // we rely on the ramping to dry in EngineEffect
-        // since this EQ is not fully dry at unity
-        pState->m_low1->pauseFilter();
-        pState->m_low2->pauseFilter();
-        pState->m_high1->pauseFilter();
-        pState->m_high2->pauseFilter();
-        pState->old_low = 1.0;
-        pState->old_mid = 1.0;
-        pState->old_high = 1.0;
-    } else {
-        pState->old_low = fLow;
-        pState->old_mid = fMid;
-        pState->old_high = fHigh;
+    // HighPass + BandPass second run
+    for (int i = 0; i < count; ++i) {
+        highFilters[i] = pStates[i]->m_high1;
+    }
+    EngineFilterLinkwtzRiley8High::processBatch(
+            highFilters, highBuffers, bandBuffers, count, numSamples);
+    // LowPass second run
+    for (int i = 0; i < count; ++i) {
+        lowFilters[i] = pStates[i]->m_low1;
+    }
+    EngineFilterLinkwtzRiley8Low::processBatch(
+            lowFilters, lowBuffers, lowBuffers, count, numSamples);
+
+    for (int i = 0; i < count; ++i) {
+        LinkwitzRiley8EQEffectGroupState* pState = pStates[i];
+        if (fLows[i] != pState->old_low) {
+            SampleUtil::copy2WithRampingGain(pOutputs[i],
+                    pState->m_pLowBuf, pState->old_low, fLows[i],
+                    pState->m_pBandBuf, 1, 1,
+                    numSamples);
+        } else {
+            SampleUtil::copy2WithGain(pOutputs[i],
+                    pState->m_pLowBuf, fLows[i],
+                    pState->m_pBandBuf, 1,
+                    numSamples);
+        }
+
+        if (enableState == EffectProcessor::DISABLING) {
+            // we rely on the ramping to dry in EngineEffect
+            // since this EQ is not fully dry at unity
+            pState->m_low1->pauseFilter();
+            pState->m_low2->pauseFilter();
+            pState->m_high1->pauseFilter();
+            pState->m_high2->pauseFilter();
+            pState->old_low = 1.0;
+            pState->old_mid = 1.0;
+            pState->old_high = 1.0;
+        } else {
+            pState->old_low = fLows[i];
+            pState->old_mid = fMids[i];
+            pState->old_high = fHighs[i];
+        }
     }
 }
@@ -56,11 +56,33 @@ class LinkwitzRiley8EQEffect : public PerChannelEffectProcessor<LinkwitzRiley8EQ
                         const EffectProcessor::EnableState enableState,
                         const GroupFeatureState& groupFeatureState);
 
+    // Processes the EQs of all decks together, see effectprocessor.h
+    bool processBatch(EffectProcessor* const* pProcessors,
+                      const ChannelHandle* pHandles,
+                      CSAMPLE* const* pInOut,
+                      const GroupFeatureState* const* pGroupFeatures,
+                      const int count,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate);
+
   private:
     QString debugString() const {
         return getId();
     }
 
+    void getGains(float* pLow, float* pMid, float* pHigh) const;
+
+    // Runs each filter stage of all channels through one processBatch()
+    // call.
+    void processChannels(LinkwitzRiley8EQEffectGroupState* const* pStates,
+                         const CSAMPLE* const* pInputs,
+                         CSAMPLE* const* pOutputs,
+                         const float* fLows, const float* fMids,
+                         const float* fHighs, const int count,
+                         const unsigned int numSamples,
+                         const unsigned int sampleRate,
+                         const EffectProcessor::EnableState enableState);
+
     EngineEffectParameter* m_pPotLow;
     EngineEffectParameter* m_pPotMid;
     EngineEffectParameter* m_pPotHigh;
@@ -4,7 +4,9 @@
 #include "util/types.h"
 #include "util/defs.h"
 #include "util/math.h"
+#include "util/assert.h"
 #include "sampleutil.h"
+#include "effects/effectprocessor.h"
 #include "engine/enginefilterdelay.h"
 
 static const int kMaxDelay = 3300; // allows a 30 Hz filter at 97346;
@@ -62,39 +64,91 @@ class LVMixEQEffectGroupState {
                         const unsigned int sampleRate,
                         double fLow, double fMid, double fHigh,
                         double loFreq, double hiFreq) {
-        if (m_oldSampleRate != sampleRate ||
-                (m_loFreq != loFreq) ||
-                (m_hiFreq != hiFreq)) {
-            m_loFreq = loFreq;
-            m_hiFreq = hiFreq;
-            m_oldSampleRate = sampleRate;
-            setFilters(sampleRate, loFreq, hiFreq);
-        }
+        LVMixEQEffectGroupState* pThis = this;
+        processChannels(&pThis, &pInput, &pOutput, &fLow, &fMid, &fHigh, 1,
+                        numSamples, sampleRate, loFreq, hiFreq);
+    }
 
-        // Since a Bessel Low pass Filter has a constant group delay in the pass band,
-        // we can subtract or add the filtered signal to the dry signal if we compensate this delay
-        // The dry signal represents the high gain
-        // Then the higher low pass is added and at least the lower low pass result.
-        fLow = fLow - fMid;
-        fMid = fMid - fHigh;
-
-        // Note: We do not call pauseFilter() here because this will introduce a
-        // buffer size-dependent start delay. During such start delay some unwanted
-        // frequencies are slipping though or wanted frequencies are damped.
-        // We know the exact group delay here so we can just hold off the ramping.
-        if (fHigh || m_oldHigh) {
-            m_delay3->process(pInput, m_pHighBuf, numSamples);
-        }
+    // Processes the buffers of count channels with the gains of each. The
+    // filters of all channels have the same frequencies, so they run through
+    // LPF::processBatch() together.
+    static void processChannels(LVMixEQEffectGroupState* const* pStates,
+                                const CSAMPLE* const* pInputs,
+                                CSAMPLE* const* pOutputs,
+                                const double* fLows, const double* fMids,
+                                const double* fHighs, const int count,
+                                const int numSamples,
+                                const unsigned int sampleRate,
+                                double loFreq, double hiFreq) {
+        DEBUG_ASSERT(count <= EffectProcessor::kMaxBatchSize);
+        LPF* lowFilters[EffectProcessor::kMaxBatchSize];
+        const CSAMPLE* lowInputs[EffectProcessor::kMaxBatchSize];
+        CSAMPLE* lowOutputs[EffectProcessor::kMaxBatchSize];
+        int lowCount = 0;
+        LPF* bandFilters[EffectProcessor::kMaxBatchSize];
+        CSAMPLE* bandBuffers[EffectProcessor::kMaxBatchSize];
+        int bandCount = 0;
+        double fLow[EffectProcessor::kMaxBatchSize];
+        double fMid[EffectProcessor::kMaxBatchSize];
+
+        for (int i = 0; i < count; ++i) {
+            LVMixEQEffectGroupState* pState = pStates[i];
+            if (pState->m_oldSampleRate != sampleRate ||
+                    (pState->m_loFreq != loFreq) ||
+                    (pState->m_hiFreq != hiFreq)) {
+                pState->m_loFreq = loFreq;
+                pState->m_hiFreq = hiFreq;
+                pState->m_oldSampleRate = sampleRate;
+                pState->setFilters(sampleRate, loFreq, hiFreq);
+            }
 
-        if (fMid || m_oldMid) {
-            m_delay2->process(pInput, m_pBandBuf, numSamples);
-            m_low2->process(m_pBandBuf, m_pBandBuf, numSamples);
+            // Since a Bessel Low pass Filter has a constant group delay in the pass band,
+            // we can subtract or add the filtered signal to the dry signal if we compensate this delay
+            // The dry signal represents the high gain
+            // Then the higher low pass is added and at least the lower low pass result.
+            fLow[i] = fLows[i] - fMids[i];
+            fMid[i] = fMids[i] - fHighs[i];
+
+            // Note: We do not call pauseFilter() here because this will introduce a
+            // buffer size-dependent start delay. During such start delay some unwanted
+            // frequencies are slipping though or wanted frequencies are damped.
+            // We know the exact group delay here so we can just hold off the ramping.
+            if (fHighs[i] || pState->m_oldHigh) {
+                pState->m_delay3->process(pInputs[i], pState->m_pHighBuf,
+                                          numSamples);
+            }
+
+            if (fMid[i] || pState->m_oldMid) {
+                pState->m_delay2->process(pInputs[i], pState->m_pBandBuf,
+                                          numSamples);
+                bandFilters[bandCount] = pState->m_low2;
+                bandBuffers[bandCount] = pState->m_pBandBuf;
+                ++bandCount;
+            }
+
+            if (fLow[i] || pState->m_oldLow) {
+                lowFilters[lowCount] = pState->m_low1;
+                lowInputs[lowCount] = pInputs[i];
+                lowOutputs[lowCount] = pState->m_pLowBuf;
+                ++lowCount;
+            }
         }
 
-        if (fLow || m_oldLow) {
-            m_low1->process(pInput, m_pLowBuf, numSamples);
+        LPF::processBatch(bandFilters, bandBuffers, bandBuffers, bandCount,
+                          numSamples);
+        LPF::processBatch(lowFilters, lowInputs, lowOutputs, lowCount,
+                          numSamples);
+
+        // All inputs are consumed, the outputs may be the same buffers.
+        for (int i = 0; i < count; ++i) {
+            pStates[i]->mixBands(pOutputs[i], numSamples,
+                                 fLow[i], fMid[i], fHighs[i]);
         }
+    }
 
+  private:
+    void mixBands(CSAMPLE* pOutput, const int numSamples,
+                  double fLow, double fMid, double fHigh) {
         // Test code for comparing streams as two stereo channels
         //for (unsigned int i = 0; i < numSamples; i +=2) {
         //    pOutput[i] = pState->m_pLowBuf[i];
@@ -158,7 +212,6 @@ class LVMixEQEffectGroupState {
         }
     }
 
-  private:
     LPF* m_low1;
     LPF* m_low2;
     EngineFilterDelay<kMaxDelay>* m_delay2;
@@ -12,6 +12,7 @@
 #ifndef __MACAPPSTORE__
 #include "effects/native/reverbeffect.h"
 #endif
+#include "effects/native/convolutionreverbeffect.h"
 #include "effects/native/echoeffect.h"
 #include "effects/native/autopaneffect.h"
 #include "effects/native/phasereffect.h"
@@ -36,6 +37,7 @@ NativeBackend::NativeBackend(QObject* pParent)
 #ifndef __MACAPPSTORE__
     registerEffect<ReverbEffect>();
 #endif
+    registerEffect<ConvolutionReverbEffect>();
     registerEffect<PhaserEffect>();
 }
 
@@ -0,0 +1,116 @@
+#include <QtDebug>
+
+#ifdef __LINUX__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "engine/channelworkerpool.h"
+#include "engine/enginechannel.h"
+#include "util/callbackbudget.h"
+#include "util/compatibility.h"
+
+ChannelWorker::ChannelWorker(ChannelWorkerPool* pPool, int cpu)
+        : m_pPool(pPool),
+          m_cpu(cpu) {
+}
+
+ChannelWorker::~ChannelWorker() {
+}
+
+void ChannelWorker::run() {
+    QThread::currentThread()->setObjectName(
+            QString("ChannelWorker %1").arg(m_cpu));
+#ifdef __LINUX__
+    if (m_cpu >= 0) {
+        // Keeps the worker's caches warm and prevents it from being moved
+        // onto the CPU of another worker in the middle of a callback.
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(m_cpu, &cpuSet);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+            qWarning() << "Failed to pin channel worker to CPU" << m_cpu;
+        }
+    }
+#endif
+    while (m_pPool->waitForTasks()) {
+        m_pPool->runTasks();
+    }
+}
+
+ChannelWorkerPool::ChannelWorkerPool(int workerCount)
+        : m_bQuit(0),
+          m_ppChannels(NULL),
+          m_ppBuffers(NULL),
+          m_iBufferSize(0),
+          m_remainingTasks(0),
+          m_finishedTasks(0) {
+    const int cpuCount = QThread::idealThreadCount();
+    for (int i = 0; i < workerCount; ++i) {
+        // CPU 0 is left to the engine thread and the rest of the system.
+        const int cpu = cpuCount > workerCount ? i + 1 : -1;
+        ChannelWorker* pWorker = new ChannelWorker(this, cpu);
+        m_workers.append(pWorker);
+        pWorker->start(QThread::TimeCriticalPriority);
+    }
+    qDebug() << "Processing channels with" << workerCount << "additional threads";
+}
+
+ChannelWorkerPool::~ChannelWorkerPool() {
+    m_bQuit.fetchAndStoreRelease(1);
+    m_wakeWorkers.release(m_workers.size());
+    foreach (ChannelWorker* pWorker, m_workers) {
+        pWorker->wait();
+        delete pWorker;
+    }
+}
+
+void ChannelWorkerPool::processIsolated(EngineChannel* const* ppChannels,
+                                        CSAMPLE* const* ppBuffers,
+                                        int count, int iBufferSize) {
+    if (count <= 0) {
+        return;
+    }
+    m_ppChannels = ppChannels;
+    m_ppBuffers = ppBuffers;
+    m_iBufferSize = iBufferSize;
+    m_finishedTasks.fetchAndStoreRelaxed(0);
+    // Publishes the batch. Releasing makes sure that a worker which claims
+    // a channel also sees the arrays above.
+    m_remainingTasks.fetchAndStoreRelease(count);
+
+    // The engine thread takes one of the channels itself. Releasing the
+    // semaphore locks its mutex, which a worker holds briefly while it goes
+    // to sleep, so this is not wait-free.
+    const int wakeCount = math_min(count - 1, m_workers.size());
+    if (wakeCount > 0) {
+        m_wakeWorkers.release(wakeCount);
+    }
+    runTasks();
+
+    // Waits until the workers are done with the channels they claimed.
+    while (m_finishedTasks.fetchAndAddAcquire(0) < count) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+void ChannelWorkerPool::runTasks() {
+    while (true) {
+        const int task = m_remainingTasks.fetchAndAddAcquire(-1) - 1;
+        if (task < 0) {
+            return;
+        }
+        {
+            EngineChannel* pChannel = m_ppChannels[task];
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannel->getHandle().handle());
+            pChannel->processIsolated(m_ppBuffers[task], m_iBufferSize);
+        }
+        m_finishedTasks.fetchAndAddRelease(1);
+    }
+}
+
+bool ChannelWorkerPool::waitForTasks() {
+    m_wakeWorkers.acquire();
+    return load_atomic(m_bQuit) == 0;
+}
@@ -0,0 +1,81 @@
+#ifndef CHANNELWORKERPOOL_H
+#define CHANNELWORKERPOOL_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QSemaphore>
+#include <QThread>
+
+#include "util/types.h"
+
+class EngineChannel;
+class ChannelWorkerPool;
+
+class ChannelWorker : public QThread {
+    Q_OBJECT
+  public:
+    ChannelWorker(ChannelWorkerPool* pPool, int cpu);
+    virtual ~ChannelWorker();
+
+  protected:
+    void run();
+
+  private:
+    ChannelWorkerPool* m_pPool;
+    // The CPU the worker is pinned to, or -1.
+    int m_cpu;
+};
+
+// Runs EngineChannel::processIsolated() of several channels in parallel
+// during the audio callback. The workers are started once and sleep between
+// callbacks. The calling thread takes part in the processing and returns
+// when all channels are done, so the callback keeps its ordering guarantees.
+//
+// Processing does not allocate. The channels are claimed through an atomic
+// counter and the end of the batch is detected by spinning on another one.
+// The only lock the engine thread may wait for is the internal mutex of the
+// QSemaphore that wakes the workers. A worker holds it only for a moment
+// while it goes to sleep or wakes up, never while it processes a channel.
+class ChannelWorkerPool {
+  public:
+    // Starts workerCount threads with time critical priority. On Linux they
+    // are pinned to separate CPUs.
+    explicit ChannelWorkerPool(int workerCount);
+    virtual ~ChannelWorkerPool();
+
+    int workerCount() const {
+        return m_workers.size();
+    }
+
+    // Calls ppChannels[i]->processIsolated(ppBuffers[i], iBufferSize) for
+    // all count channels and returns when all calls are done. The arrays
+    // must stay valid until then. Must only be called from one thread.
+    void processIsolated(EngineChannel* const* ppChannels,
+                         CSAMPLE* const* ppBuffers,
+                         int count, int iBufferSize);
+
+  private:
+    friend class ChannelWorker;
+
+    // Processes the channels of the current batch until none are left.
+    // Called from the workers and the engine thread.
+    void runTasks();
+
+    // Blocks a worker until the next batch. Returns false if the pool shuts
+    // down.
+    bool waitForTasks();
+
+    QList<ChannelWorker*> m_workers;
+    QSemaphore m_wakeWorkers;
+    QAtomicInt m_bQuit;
+
+    EngineChannel* const* m_ppChannels;
+    CSAMPLE* const* m_ppBuffers;
+    int m_iBufferSize;
+    // Counts down while the channels are claimed. Workers that wake up late
+    // for a finished batch may push it below zero, the next batch resets it.
+    QAtomicInt m_remainingTasks;
+    QAtomicInt m_finishedTasks;
+};
+
+#endif /* CHANNELWORKERPOOL_H */
@@ -0,0 +1,97 @@
+#include <QMutexLocker>
+#include <QtDebug>
+
+#include "engine/convolutionworker.h"
+
+#include "engine/partitionedconvolver.h"
+#include "util/assert.h"
+#include "util/compatibility.h"
+#include "util/denormalsarezero.h"
+#include "util/event.h"
+
+// static
+QMutex ConvolutionWorker::s_sharedMutex;
+// static
+QWeakPointer<ConvolutionWorker> ConvolutionWorker::s_pSharedWorker;
+// static
+EngineWorkerScheduler* ConvolutionWorker::s_pScheduler = NULL;
+
+ConvolutionWorker::ConvolutionWorker()
+        : m_wakePending(0),
+          m_stop(0) {
+}
+
+ConvolutionWorker::~ConvolutionWorker() {
+    m_stop = 1;
+    m_semaRun.release();
+    wait();
+    DEBUG_ASSERT(m_convolvers.isEmpty());
+}
+
+// static
+QSharedPointer<ConvolutionWorker> ConvolutionWorker::sharedWorker() {
+    QMutexLocker locker(&s_sharedMutex);
+    QSharedPointer<ConvolutionWorker> pWorker = s_pSharedWorker.toStrongRef();
+    if (pWorker.isNull()) {
+        pWorker = QSharedPointer<ConvolutionWorker>(new ConvolutionWorker());
+        pWorker->setScheduler(s_pScheduler);
+        pWorker->start(QThread::HighPriority);
+        s_pSharedWorker = pWorker;
+    }
+    return pWorker;
+}
+
+// static
+void ConvolutionWorker::setSharedScheduler(EngineWorkerScheduler* pScheduler) {
+    QMutexLocker locker(&s_sharedMutex);
+    s_pScheduler = pScheduler;
+    QSharedPointer<ConvolutionWorker> pWorker = s_pSharedWorker.toStrongRef();
+    if (pWorker) {
+        pWorker->setScheduler(pScheduler);
+    }
+}
+
+void ConvolutionWorker::addConvolver(PartitionedConvolver* pConvolver) {
+    QMutexLocker locker(&m_convolversMutex);
+    m_convolvers.append(pConvolver);
+}
+
+void ConvolutionWorker::removeConvolver(PartitionedConvolver* pConvolver) {
+    QMutexLocker locker(&m_convolversMutex);
+    m_convolvers.removeAll(pConvolver);
+}
+
+void ConvolutionWorker::schedule() {
+    if (m_wakePending.testAndSetOrdered(0, 1)) {
+        if (!hasScheduler()) {
+            wake();
+        } else if (!workReady()) {
+            // The scheduler FIFO is full. Let the next posted block try
+            // again, otherwise the worker would never be woken up.
+            m_wakePending.fetchAndStoreOrdered(0);
+        }
+    }
+}
+
+void ConvolutionWorker::run() {
+    QThread::currentThread()->setObjectName("ConvolutionWorker");
+#ifdef __SSE__
+    // Like the engine thread, the decaying tails must not run into
+    // denormals.
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+#endif
+
+    while (!load_atomic(m_stop)) {
+        m_semaRun.acquire();
+        // Blocks posted from now on need another wake up.
+        m_wakePending.fetchAndStoreOrdered(0);
+        Event::start("ConvolutionWorker");
+        m_convolversMutex.lock();
+        foreach (PartitionedConvolver* pConvolver, m_convolvers) {
+            pConvolver->runPendingTailBlocks();
+        }
+        m_convolversMutex.unlock();
+        Event::end("ConvolutionWorker");
+    }
+}
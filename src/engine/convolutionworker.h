@@ -0,0 +1,57 @@
+#ifndef CONVOLUTIONWORKER_H
+#define CONVOLUTIONWORKER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "engine/engineworker.h"
+
+class EngineWorkerScheduler;
+class PartitionedConvolver;
+
+// Computes the tail blocks of all PartitionedConvolvers in the background.
+// One worker is shared by all convolvers, it is started when the first one
+// asks for it and stopped when the last one is gone.
+class ConvolutionWorker : public EngineWorker {
+    Q_OBJECT
+  public:
+    virtual ~ConvolutionWorker();
+
+    // Returns the shared worker, starts it if needed. Not real-time safe.
+    static QSharedPointer<ConvolutionWorker> sharedWorker();
+
+    // Wakes the worker through pScheduler after the callback, so the
+    // engine thread does not have to. EngineMaster sets this up. Without a
+    // scheduler, schedule() wakes the worker itself.
+    static void setSharedScheduler(EngineWorkerScheduler* pScheduler);
+
+    // Not real-time safe, removeConvolver() waits for the running tail
+    // blocks.
+    void addConvolver(PartitionedConvolver* pConvolver);
+    void removeConvolver(PartitionedConvolver* pConvolver);
+
+    // Called by a convolver from the engine thread after it has posted a
+    // tail block.
+    void schedule();
+
+    void run();
+
+  private:
+    ConvolutionWorker();
+
+    static QMutex s_sharedMutex;
+    static QWeakPointer<ConvolutionWorker> s_pSharedWorker;
+    static EngineWorkerScheduler* s_pScheduler;
+
+    // Guards m_convolvers, held while the tail blocks run.
+    QMutex m_convolversMutex;
+    QList<PartitionedConvolver*> m_convolvers;
+    // Set while a wake up is on its way, so the scheduler gets one request
+    // per run and not one per convolver.
+    QAtomicInt m_wakePending;
+    QAtomicInt m_stop;
+};
+
+#endif /* CONVOLUTIONWORKER_H */
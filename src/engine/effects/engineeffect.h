@@ -27,6 +27,14 @@ class EngineEffect : public EffectsRequestHandler {
         return m_manifest.name();
     }
 
+    const QString& id() const {
+        return m_manifest.id();
+    }
+
+    EffectProcessor* processor() const {
+        return m_pProcessor;
+    }
+
     EngineEffectParameter* getParameterById(const QString& id) {
         return m_parametersById.value(id, NULL);
     }
@@ -46,6 +54,20 @@ class EngineEffect : public EffectsRequestHandler {
         return m_enableState != EffectProcessor::DISABLED;
     }
 
+    EffectProcessor::EnableState enableState() const {
+        return m_enableState;
+    }
+
+    // Returns true if process() with this enableState of the chain may use
+    // the same buffer for pInput and pOutput. Effects that do not ramp from
+    // dry themselves are faded against pInput while they ramp.
+    bool processesInPlace(const EffectProcessor::EnableState enableState) const {
+        return m_effectRampsFromDry ||
+                (m_enableState == EffectProcessor::ENABLED &&
+                 enableState != EffectProcessor::ENABLING &&
+                 enableState != EffectProcessor::DISABLING);
+    }
+
   private:
     QString debugString() const {
         return QString("EngineEffect(%1)").arg(m_manifest.name());
@@ -1,7 +1,9 @@
 #include "engine/effects/engineeffectchain.h"
 
 #include "engine/effects/engineeffect.h"
+#include "engine/scratchbufferpool.h"
 #include "sampleutil.h"
+#include "util/assert.h"
 #include "util/defs.h"
 
 EngineEffectChain::EngineEffectChain(const QString& id)
@@ -9,13 +11,12 @@ EngineEffectChain::EngineEffectChain(const QString& id)
           m_enableState(EffectProcessor::ENABLED),
           m_insertionType(EffectChain::INSERT),
           m_dMix(0),
-          m_pBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)) {
+          m_bPlanRamping(false) {
     // Try to prevent memory allocation.
     m_effects.reserve(256);
 }
 
 EngineEffectChain::~EngineEffectChain() {
-    SampleUtil::free(m_pBuffer);
 }
 
 bool EngineEffectChain::addEffect(EngineEffect* pEffect, int iIndex) {
@@ -149,11 +150,57 @@ EngineEffectChain::ChannelStatus& EngineEffectChain::getChannelStatus(
     return m_channelStatus[handle];
 }
 
+bool EngineEffectChain::activeForChannel(const ChannelHandle& handle) {
+    return m_enableState != EffectProcessor::DISABLED &&
+            getChannelStatus(handle).enable_state != EffectProcessor::DISABLED;
+}
+
+bool EngineEffectChain::rampsForChannel(const ChannelHandle& handle) {
+    if (!activeForChannel(handle)) {
+        return false;
+    }
+    const ChannelStatus& channel_info = getChannelStatus(handle);
+    return m_enableState != EffectProcessor::ENABLED ||
+            channel_info.enable_state != EffectProcessor::ENABLED ||
+            channel_info.old_gain != m_dMix || m_bPlanRamping;
+}
+
+void EngineEffectChain::updatePlan() {
+    m_plan.clear();
+    m_bPlanRamping = false;
+    foreach (EngineEffect* pEffect, m_effects) {
+        if (pEffect == NULL || !pEffect->enabled()) {
+            continue;
+        }
+        m_plan.append(pEffect);
+        if (pEffect->enableState() != EffectProcessor::ENABLED) {
+            m_bPlanRamping = true;
+        }
+    }
+}
+
+EngineEffect* EngineEffectChain::batchableEffect(const ChannelHandle& handle) {
+    const ChannelStatus& channel_info = getChannelStatus(handle);
+    if (m_enableState != EffectProcessor::ENABLED ||
+            channel_info.enable_state != EffectProcessor::ENABLED ||
+            m_insertionType != EffectChain::INSERT ||
+            channel_info.old_gain != 1.0 || m_dMix != 1.0 ||
+            m_plan.size() != 1) {
+        return NULL;
+    }
+    EngineEffect* pEffect = m_plan[0];
+    if (pEffect->enableState() != EffectProcessor::ENABLED) {
+        return NULL;
+    }
+    return pEffect;
+}
+
 void EngineEffectChain::process(const ChannelHandle& handle,
                                 CSAMPLE* pInOut,
                                 const unsigned int numSamples,
                                 const unsigned int sampleRate,
-                                const GroupFeatureState& groupFeatures) {
+                                const GroupFeatureState& groupFeatures,
+                                ScratchBufferPool* pScratch) {
     ChannelStatus& channel_info = getChannelStatus(handle);
 
     if (m_enableState == EffectProcessor::DISABLED
@@ -177,71 +224,72 @@ void EngineEffectChain::process(const ChannelHandle& handle,
     CSAMPLE wet_gain_old = channel_info.old_gain;
 
     // INSERT mode: output = input * (1-wet) + effect(input) * wet
-    if (m_insertionType == EffectChain::INSERT) {
-        if (wet_gain_old == 1.0 && wet_gain == 1.0) {
-            // Fully wet, no ramp, insert optimization. No temporary buffer needed.
-            for (int i = 0; i < m_effects.size(); ++i) {
-                EngineEffect* pEffect = m_effects[i];
-                if (pEffect == NULL || !pEffect->enabled()) {
-                    continue;
-                }
-                pEffect->process(handle, pInOut, pInOut,
-                                 numSamples, sampleRate,
-                                 effectiveEnableState, groupFeatures);
-            }
-        } else if (wet_gain_old == 0.0 && wet_gain == 0.0) {
-            // Fully dry, no ramp, insert optimization. No action is needed
-        } else {
-            // Clear scratch buffer.
-            SampleUtil::clear(m_pBuffer, numSamples);
+    // SEND mode: output = input + effect(input) * wet
+    // Fully wet INSERT needs no dry signal, so the effects run in place on
+    // pInOut. Fully dry INSERT needs no effects.
+    const bool fullyWet = m_insertionType == EffectChain::INSERT &&
+            wet_gain_old == 1.0 && wet_gain == 1.0;
+    const bool fullyDry = m_insertionType == EffectChain::INSERT &&
+            wet_gain_old == 0.0 && wet_gain == 0.0;
 
-            // Chain each effect
-            bool anyProcessed = false;
-            for (int i = 0; i < m_effects.size(); ++i) {
-                EngineEffect* pEffect = m_effects[i];
-                if (pEffect == NULL || !pEffect->enabled()) {
-                    continue;
+    if (!fullyDry && !m_plan.isEmpty()) {
+        // The wet signal moves to another buffer only if the dry signal in
+        // pInOut is still needed or an effect needs its input after
+        // processing. Then it ping-pongs between two scratch buffers, or
+        // between one and pInOut when the chain is fully wet.
+        CSAMPLE* scratch[2] = { NULL, NULL };
+        CSAMPLE* pWet = pInOut;
+        bool anyProcessed = false;
+        for (int i = 0; i < m_plan.size(); ++i) {
+            EngineEffect* pEffect = m_plan[i];
+            if (!pEffect->enabled()) {
+                // It has ramped out while processing another channel.
+                continue;
+            }
+            CSAMPLE* pOutput = pWet;
+            if ((pWet == pInOut && !fullyWet) ||
+                    !pEffect->processesInPlace(effectiveEnableState)) {
+                if (fullyWet && pWet != pInOut) {
+                    pOutput = pInOut;
+                } else {
+                    const int slot = pWet == scratch[0] ? 1 : 0;
+                    if (scratch[slot] == NULL) {
+                        scratch[slot] = pScratch->acquire();
+                    }
+                    pOutput = scratch[slot];
                 }
-                const CSAMPLE* pIntermediateInput = (i == 0) ? pInOut : m_pBuffer;
-                CSAMPLE* pIntermediateOutput = m_pBuffer;
-                pEffect->process(handle, pIntermediateInput, pIntermediateOutput,
-                                 numSamples, sampleRate,
-                                 effectiveEnableState, groupFeatures);
-                anyProcessed = true;
             }
+            DEBUG_ASSERT_AND_HANDLE(pOutput != NULL) {
+                // The pool is too small, leave the rest of the chain out.
+                break;
+            }
+            pEffect->process(handle, pWet, pOutput, numSamples, sampleRate,
+                             effectiveEnableState, groupFeatures);
+            pWet = pOutput;
+            anyProcessed = true;
+        }
 
-            if (anyProcessed) {
-                // m_pBuffer now contains the fully wet output.
-                // TODO(rryan): benchmark applyGain followed by addWithGain versus
-                // copy2WithGain.
+        if (anyProcessed) {
+            // The mix is the only pass over the wet signal after the last
+            // effect.
+            if (fullyWet) {
+                if (pWet != pInOut) {
+                    SampleUtil::copy(pInOut, pWet, numSamples);
+                }
+            } else if (m_insertionType == EffectChain::INSERT) {
                 SampleUtil::copy2WithRampingGain(
                     pInOut, pInOut, 1.0 - wet_gain_old, 1.0 - wet_gain,
-                    m_pBuffer, wet_gain_old, wet_gain, numSamples);
+                    pWet, wet_gain_old, wet_gain, numSamples);
+            } else {
+                SampleUtil::addWithRampingGain(pInOut, pWet,
+                                               wet_gain_old, wet_gain, numSamples);
             }
         }
-    } else { // SEND mode: output = input + effect(input) * wet
-        // Clear scratch buffer.
-        SampleUtil::applyGain(m_pBuffer, 0.0, numSamples);
 
-        // Chain each effect
-        bool anyProcessed = false;
-        for (int i = 0; i < m_effects.size(); ++i) {
-            EngineEffect* pEffect = m_effects[i];
-            if (pEffect == NULL || !pEffect->enabled()) {
-                continue;
+        for (int i = 0; i < 2; ++i) {
+            if (scratch[i] != NULL) {
+                pScratch->release(scratch[i]);
             }
-            const CSAMPLE* pIntermediateInput = (i == 0) ? pInOut : m_pBuffer;
-            CSAMPLE* pIntermediateOutput = m_pBuffer;
-            pEffect->process(handle, pIntermediateInput,
-                             pIntermediateOutput, numSamples, sampleRate,
-                             effectiveEnableState, groupFeatures);
-            anyProcessed = true;
-        }
-
-        if (anyProcessed) {
-            // m_pBuffer now contains the fully wet output.
-            SampleUtil::addWithRampingGain(pInOut, m_pBuffer,
-                                           wet_gain_old, wet_gain, numSamples);
         }
     }
 
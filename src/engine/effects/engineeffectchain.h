@@ -4,6 +4,7 @@
 #include <QString>
 #include <QList>
 #include <QLinkedList>
+#include <QVarLengthArray>
 
 #include "util.h"
 #include "util/types.h"
@@ -13,6 +14,7 @@
 #include "effects/effectchain.h"
 
 class EngineEffect;
+class ScratchBufferPool;
 
 class EngineEffectChain : public EffectsRequestHandler {
   public:
@@ -23,11 +25,26 @@ class EngineEffectChain : public EffectsRequestHandler {
         const EffectsRequest& message,
         EffectsResponsePipe* pResponsePipe);
 
+    // Runs the planned effects on pInOut. The wet signal goes through
+    // buffers of pScratch if the dry signal is mixed in or an effect needs
+    // its input after processing.
     void process(const ChannelHandle& handle,
                  CSAMPLE* pInOut,
                  const unsigned int numSamples,
                  const unsigned int sampleRate,
-                 const GroupFeatureState& groupFeatures);
+                 const GroupFeatureState& groupFeatures,
+                 ScratchBufferPool* pScratch);
+
+    // Collects the enabled effects for process(). EngineEffectsManager calls
+    // it at the start of a callback that received messages, since they may
+    // add, remove, enable or disable effects, and while planOutdated().
+    void updatePlan();
+
+    // Returns true if a planned effect ramps. It gets enabled or disabled
+    // during the callback, so the plan needs an update in the next one.
+    bool planOutdated() const {
+        return m_bPlanRamping;
+    }
 
     const QString& id() const {
         return m_id;
@@ -35,6 +52,20 @@ class EngineEffectChain : public EffectsRequestHandler {
 
     bool enabledForChannel(const ChannelHandle& handle) const;
 
+    // Returns true if process() does anything for the channel.
+    bool activeForChannel(const ChannelHandle& handle);
+
+    // Returns true if process() for the channel ramps, because the chain,
+    // the channel or one of the effects is being enabled or disabled or the
+    // mix has changed.
+    bool rampsForChannel(const ChannelHandle& handle);
+
+    // Returns the effect if process() for the channel would do nothing but
+    // run it in place with ENABLED. EngineEffectRack then calls its
+    // processor together with those of other channels. Returns NULL if the
+    // chain ramps, mixes or runs several effects.
+    EngineEffect* batchableEffect(const ChannelHandle& handle);
+
   private:
     struct ChannelStatus {
         ChannelStatus()
@@ -64,7 +95,9 @@ class EngineEffectChain : public EffectsRequestHandler {
     EffectChain::InsertionType m_insertionType;
     CSAMPLE m_dMix;
     QList<EngineEffect*> m_effects;
-    CSAMPLE* m_pBuffer;
+    // The enabled effects of m_effects in order, see updatePlan().
+    QVarLengthArray<EngineEffect*, 32> m_plan;
+    bool m_bPlanRamping;
     ChannelHandleMap<ChannelStatus> m_channelStatus;
 
     DISALLOW_COPY_AND_ASSIGN(EngineEffectChain);
@@ -1,6 +1,7 @@
 #include "engine/effects/engineeffectrack.h"
 
 #include "engine/effects/engineeffectchain.h"
+#include "engine/effects/engineeffect.h"
 
 EngineEffectRack::EngineEffectRack(int iRackNumber)
         : m_iRackNumber(iRackNumber) {
@@ -45,10 +46,105 @@ void EngineEffectRack::process(const ChannelHandle& handle,
                                CSAMPLE* pInOut,
                                const unsigned int numSamples,
                                const unsigned int sampleRate,
-                               const GroupFeatureState& groupFeatures) {
+                               const GroupFeatureState& groupFeatures,
+                               ScratchBufferPool* pScratch) {
     foreach (EngineEffectChain* pChain, m_chains) {
         if (pChain != NULL) {
-            pChain->process(handle, pInOut, numSamples, sampleRate, groupFeatures);
+            pChain->process(handle, pInOut, numSamples, sampleRate,
+                            groupFeatures, pScratch);
+        }
+    }
+}
+
+bool EngineEffectRack::rampsForChannel(const ChannelHandle& handle) {
+    foreach (EngineEffectChain* pChain, m_chains) {
+        if (pChain != NULL && pChain->rampsForChannel(handle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EngineEffectRack::processBatch(const ChannelHandle* pHandles,
+                                    CSAMPLE* const* pInOut,
+                                    const GroupFeatureState* const* pGroupFeatures,
+                                    const int count,
+                                    const unsigned int numSamples,
+                                    const unsigned int sampleRate,
+                                    ScratchBufferPool* pScratch) {
+    // Grouping the channels across chains keeps the order of the chains of a
+    // channel only if it runs through one chain.
+    m_activeChains.clear();
+    for (int i = 0; i < count; ++i) {
+        EngineEffectChain* pActiveChain = NULL;
+        foreach (EngineEffectChain* pChain, m_chains) {
+            if (pChain == NULL || !pChain->activeForChannel(pHandles[i])) {
+                continue;
+            }
+            if (pActiveChain != NULL) {
+                for (int j = 0; j < count; ++j) {
+                    process(pHandles[j], pInOut[j], numSamples, sampleRate,
+                            *pGroupFeatures[j], pScratch);
+                }
+                return;
+            }
+            pActiveChain = pChain;
+        }
+        m_activeChains.append(pActiveChain);
+    }
+
+    m_batchEffects.clear();
+    m_batchChannels.clear();
+    for (int i = 0; i < count; ++i) {
+        EngineEffectChain* pChain = m_activeChains[i];
+        if (pChain == NULL) {
+            continue;
+        }
+        EngineEffect* pEffect = pChain->batchableEffect(pHandles[i]);
+        if (pEffect == NULL) {
+            pChain->process(pHandles[i], pInOut[i], numSamples, sampleRate,
+                            *pGroupFeatures[i], pScratch);
+            continue;
+        }
+        m_batchEffects.append(pEffect);
+        m_batchChannels.append(i);
+    }
+
+    EngineEffect* effects[EffectProcessor::kMaxBatchSize];
+    EffectProcessor* processors[EffectProcessor::kMaxBatchSize];
+    ChannelHandle handles[EffectProcessor::kMaxBatchSize];
+    CSAMPLE* buffers[EffectProcessor::kMaxBatchSize];
+    const GroupFeatureState* features[EffectProcessor::kMaxBatchSize];
+    for (int first = 0; first < m_batchEffects.size(); ++first) {
+        if (m_batchEffects[first] == NULL) {
+            continue;
+        }
+        // The instances of an effect have the same manifest.
+        const QString& id = m_batchEffects[first]->id();
+        int batchSize = 0;
+        for (int j = first; j < m_batchEffects.size() &&
+                batchSize < EffectProcessor::kMaxBatchSize; ++j) {
+            EngineEffect* pEffect = m_batchEffects[j];
+            if (pEffect == NULL || pEffect->id() != id) {
+                continue;
+            }
+            const int channel = m_batchChannels[j];
+            effects[batchSize] = pEffect;
+            processors[batchSize] = pEffect->processor();
+            handles[batchSize] = pHandles[channel];
+            buffers[batchSize] = pInOut[channel];
+            features[batchSize] = pGroupFeatures[channel];
+            ++batchSize;
+            m_batchEffects[j] = NULL;
+        }
+        if (!processors[0]->processBatch(processors, handles, buffers,
+                                         features, batchSize, numSamples,
+                                         sampleRate)) {
+            for (int j = 0; j < batchSize; ++j) {
+                effects[j]->process(handles[j], buffers[j], buffers[j],
+                                    numSamples, sampleRate,
+                                    EffectProcessor::ENABLED, *features[j]);
+            }
         }
     }
 }
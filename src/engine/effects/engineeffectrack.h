@@ -2,12 +2,15 @@
 #define ENGINEEFFECTRACK_H
 
 #include <QList>
+#include <QVarLengthArray>
 
 #include "engine/channelhandle.h"
 #include "engine/effects/message.h"
 #include "engine/effects/groupfeaturestate.h"
 
 class EngineEffectChain;
+class EngineEffect;
+class ScratchBufferPool;
 
 class EngineEffectRack : public EffectsRequestHandler {
   public:
@@ -22,7 +25,22 @@ class EngineEffectRack : public EffectsRequestHandler {
                  CSAMPLE* pInOut,
                  const unsigned int numSamples,
                  const unsigned int sampleRate,
-                 const GroupFeatureState& groupFeatures);
+                 const GroupFeatureState& groupFeatures,
+                 ScratchBufferPool* pScratch);
+
+    // Like process() for count channels. If every channel runs through at
+    // most one chain of this rack, the channels whose chain runs a single
+    // effect are grouped by the effect, so e.g. the EQs of all decks are
+    // processed with one EffectProcessor::processBatch() call.
+    void processBatch(const ChannelHandle* pHandles,
+                      CSAMPLE* const* pInOut,
+                      const GroupFeatureState* const* pGroupFeatures,
+                      const int count,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate,
+                      ScratchBufferPool* pScratch);
+
+    bool rampsForChannel(const ChannelHandle& handle);
 
     int number() const {
         return m_iRackNumber;
@@ -39,6 +57,11 @@ class EngineEffectRack : public EffectsRequestHandler {
     int m_iRackNumber;
     QList<EngineEffectChain*> m_chains;
 
+    // Preallocated for processBatch().
+    QVarLengthArray<EngineEffectChain*, 64> m_activeChains;
+    QVarLengthArray<EngineEffect*, 64> m_batchEffects;
+    QVarLengthArray<int, 64> m_batchChannels;
+
     DISALLOW_COPY_AND_ASSIGN(EngineEffectRack);
 };
 
@@ -3,9 +3,16 @@
 #include "engine/effects/engineeffectrack.h"
 #include "engine/effects/engineeffectchain.h"
 #include "engine/effects/engineeffect.h"
+#include "util/callbackbudget.h"
+#include "util/defs.h"
+
+namespace {
+const int kScratchBuffers = 2;
+}  // namespace
 
 EngineEffectsManager::EngineEffectsManager(EffectsResponsePipe* pResponsePipe)
-        : m_pResponsePipe(pResponsePipe) {
+        : m_pResponsePipe(pResponsePipe),
+          m_scratchBuffers(kScratchBuffers, MAX_BUFFER_LEN) {
     // Try to prevent memory allocation.
     m_racks.reserve(256);
     m_chains.reserve(256);
@@ -17,7 +24,9 @@ EngineEffectsManager::~EngineEffectsManager() {
 
 void EngineEffectsManager::onCallbackStart() {
     EffectsRequest* request = NULL;
+    bool anyMessages = false;
     while (m_pResponsePipe->readMessages(&request, 1) > 0) {
+        anyMessages = true;
         EffectsResponse response(*request);
         bool processed = false;
         switch (request->type) {
@@ -128,6 +137,12 @@ void EngineEffectsManager::onCallbackStart() {
             m_pResponsePipe->writeMessages(&response, 1);
         }
     }
+
+    foreach (EngineEffectChain* pChain, m_chains) {
+        if (anyMessages || pChain->planOutdated()) {
+            pChain->updatePlan();
+        }
+    }
 }
 
 void EngineEffectsManager::process(const ChannelHandle& handle,
@@ -135,9 +150,33 @@ void EngineEffectsManager::process(const ChannelHandle& handle,
                                    const unsigned int numSamples,
                                    const unsigned int sampleRate,
                                    const GroupFeatureState& groupFeatures) {
+    ScopedCallbackBudget budget(CallbackBudget::ENGINE_EFFECTS);
     foreach (EngineEffectRack* pRack, m_racks) {
-        pRack->process(handle, pInOut, numSamples, sampleRate, groupFeatures);
+        pRack->process(handle, pInOut, numSamples, sampleRate, groupFeatures,
+                       &m_scratchBuffers);
+    }
+}
+
+void EngineEffectsManager::processBatch(const ChannelHandle* pHandles,
+                                        CSAMPLE* const* pInOut,
+                                        const GroupFeatureState* const* pGroupFeatures,
+                                        const int count,
+                                        const unsigned int numSamples,
+                                        const unsigned int sampleRate) {
+    ScopedCallbackBudget budget(CallbackBudget::ENGINE_EFFECTS);
+    foreach (EngineEffectRack* pRack, m_racks) {
+        pRack->processBatch(pHandles, pInOut, pGroupFeatures, count,
+                            numSamples, sampleRate, &m_scratchBuffers);
+    }
+}
+
+bool EngineEffectsManager::rampsForChannel(const ChannelHandle& handle) {
+    foreach (EngineEffectRack* pRack, m_racks) {
+        if (pRack->rampsForChannel(handle)) {
+            return true;
+        }
     }
+    return false;
 }
 
 bool EngineEffectsManager::addEffectRack(EngineEffectRack* pRack) {
@@ -8,6 +8,7 @@
 #include "engine/effects/message.h"
 #include "engine/effects/groupfeaturestate.h"
 #include "engine/channelhandle.h"
+#include "engine/scratchbufferpool.h"
 
 class EngineEffectRack;
 class EngineEffectChain;
@@ -18,6 +19,8 @@ class EngineEffectsManager : public EffectsRequestHandler {
     EngineEffectsManager(EffectsResponsePipe* pResponsePipe);
     virtual ~EngineEffectsManager();
 
+    // Processes the messages from EffectsManager and updates the plans of
+    // the chains they may have changed.
     void onCallbackStart();
 
     // Take a buffer of numSamples samples of audio from a channel, provided as
@@ -33,6 +36,20 @@ class EngineEffectsManager : public EffectsRequestHandler {
                          const unsigned int sampleRate,
                          const GroupFeatureState& groupFeatures);
 
+    // Like process() for the buffers of count channels, e.g. all decks. The
+    // channels that use the same effect in the same way, like the EQs of the
+    // decks, are processed together, see EngineEffectRack::processBatch().
+    void processBatch(const ChannelHandle* pHandles,
+                      CSAMPLE* const* pInOut,
+                      const GroupFeatureState* const* pGroupFeatures,
+                      const int count,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate);
+
+    // Returns true if an effect or chain that process() runs for the channel
+    // is being enabled or disabled, or its mix changes.
+    bool rampsForChannel(const ChannelHandle& handle);
+
     bool processEffectsRequest(
         const EffectsRequest& message,
         EffectsResponsePipe* pResponsePipe);
@@ -49,6 +66,8 @@ class EngineEffectsManager : public EffectsRequestHandler {
     QList<EngineEffectRack*> m_racks;
     QList<EngineEffectChain*> m_chains;
     QList<EngineEffect*> m_effects;
+    // The chains run one after the other and take at most two buffers each.
+    ScratchBufferPool m_scratchBuffers;
 };
 
 
@@ -44,6 +44,7 @@
 #include "engine/cuecontrol.h"
 #include "engine/clockcontrol.h"
 #include "engine/enginemaster.h"
+#include "util/callbackbudget.h"
 #include "util/timer.h"
 #include "util/math.h"
 #include "util/defs.h"
@@ -65,6 +66,7 @@ const int kSamplesPerFrame = 2; // Engine buffer uses Stereo frames only
 EngineBuffer::EngineBuffer(QString group, ConfigObject<ConfigValue>* _config,
                            EngineChannel* pChannel, EngineMaster* pMixingEngine)
         : m_group(group),
+          m_iChannelHandle(pChannel->getHandle().handle()),
           m_pConfig(_config),
           m_pLoopingControl(NULL),
           m_pSyncControl(NULL),
@@ -97,6 +99,7 @@ EngineBuffer::EngineBuffer(QString group, ConfigObject<ConfigValue>* _config,
           m_iEnableSyncQueued(SYNC_REQUEST_NONE),
           m_iSyncModeQueued(SYNC_INVALID),
           m_bLastBufferPaused(true),
+          m_bOutputSilent(false),
           m_iTrackLoading(0),
           m_bPlayAfterLoading(false),
           m_fRampValue(0.0),
@@ -106,7 +109,8 @@ EngineBuffer::EngineBuffer(QString group, ConfigObject<ConfigValue>* _config,
           m_iDitherBufferReadIndex(0),
           m_pCrossfadeBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
           m_bCrossfadeReady(false),
-          m_iLastBufferSize(0) {
+          m_iLastBufferSize(0),
+          m_bRequestsProcessed(false) {
 
     // Generate dither values. When engine samples used to be within [SAMPLE_MIN,
     // SAMPLE_MAX] dithering values were in the range [-0.5, 0.5]. Now that we
@@ -749,6 +753,9 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
         m_iSampleRate = sample_rate;
     }
 
+    const bool bRequestsProcessed = m_bRequestsProcessed;
+    m_bRequestsProcessed = false;
+
     bool bTrackLoading = load_atomic(m_iTrackLoading) != 0;
     if (!bTrackLoading && m_pause.tryLock()) {
         ScopedTimer t("EngineBuffer::process_pauselock");
@@ -773,8 +780,10 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
 
         // Update the slipped position and seek if it was disabled.
         processSlip(iBufferSize);
-        processSyncRequests();
-        processSeek();
+        if (!bRequestsProcessed) {
+            processSyncRequests();
+            processSeek();
+        }
 
         // speed is the ratio between track-time and real-time
         // (1.0 being normal rate. 2.0 plays at 2x speed -- 2 track seconds
@@ -975,7 +984,12 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
             }
 
             // Perform scaling of Reader buffer into buffer.
-            CSAMPLE* output = m_pScale->getScaled(iBufferSize);
+            CSAMPLE* output;
+            {
+                ScopedCallbackBudget budget(CallbackBudget::SCALER,
+                                            m_iChannelHandle);
+                output = m_pScale->getScaled(iBufferSize);
+            }
             double samplesRead = m_pScale->getSamplesRead();
 
             //qDebug() << "sourceSamples used " << iSourceSamples
@@ -1040,6 +1054,7 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
     } else { // if (!bTrackLoading && m_pause.tryLock()) {
         // If we can't get the pause lock then this buffer will be silence.
         bCurBufferPaused = true;
+        SampleUtil::clear(pOutput, iBufferSize);
 
         // We are stopped. Report a speed of 0 to SyncControl.
         m_pSyncControl->reportPlayerSpeed(0.0, false);
@@ -1076,6 +1091,11 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
         }
     }
 
+    // A paused buffer is only written by the ramp and the crossfade of a
+    // seek, without them it keeps the zeros from above.
+    m_bOutputSilent = bCurBufferPaused && !m_bCrossfadeReady &&
+            m_iRampState == ENGINE_RAMP_NONE;
+
     // let's try holding the last sample value constant, and pull it
     // towards zero
     float ramp_inc = 0;
@@ -1154,6 +1174,17 @@ void EngineBuffer::processSlip(int iBufferSize) {
     }
 }
 
+void EngineBuffer::processRequests() {
+    if (load_atomic(m_iTrackLoading) == 0 && m_pause.tryLock()) {
+        processSyncRequests();
+        processSeek();
+        m_pause.unlock();
+    }
+    // Even if the track is loading, process() must not pick up the requests
+    // on the worker thread.
+    m_bRequestsProcessed = true;
+}
+
 void EngineBuffer::processSyncRequests() {
     SyncRequestQueued enable_request =
             static_cast<SyncRequestQueued>(
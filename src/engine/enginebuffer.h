@@ -140,6 +140,11 @@ class EngineBuffer : public EngineObject {
     void process(CSAMPLE* pOut, const int iBufferSize);
     void processSlip(int iBufferSize);
     void postProcess(const int iBufferSize);
+    // Runs the queued sync requests and seeks ahead of process(). These touch
+    // EngineSync and the BpmControl of the other decks, so the engine thread
+    // calls this before process() runs on a worker thread. Requests queued in
+    // between wait for the next callback.
+    void processRequests();
 
     QString getGroup();
     bool isTrackLoaded();
@@ -150,6 +155,13 @@ class EngineBuffer : public EngineObject {
 
     void collectFeatures(GroupFeatureState* pGroupFeatures) const;
 
+    // Returns true if process() has written only zeros, i.e. the deck is
+    // paused and has finished ramping down. The following engines may skip
+    // work that does not change silence.
+    bool isOutputSilent() const {
+        return m_bOutputSilent;
+    }
+
     // For dependency injection of readers.
     //void setReader(CachingReader* pReader);
 
@@ -240,6 +252,9 @@ class EngineBuffer : public EngineObject {
 
     // Holds the name of the control group
     QString m_group;
+    // The handle of the channel this buffer belongs to. Used to attribute
+    // the scaler time in CallbackBudget.
+    const int m_iChannelHandle;
     ConfigObject<ConfigValue>* m_pConfig;
 
     LoopingControl* m_pLoopingControl;
@@ -380,6 +395,8 @@ class EngineBuffer : public EngineObject {
     float m_fLastSampleValue[2];
     // Is true if the previous buffer was silent due to pausing
     bool m_bLastBufferPaused;
+    // Is true if the previous buffer holds only zeros, see isOutputSilent().
+    bool m_bOutputSilent;
     QAtomicInt m_iTrackLoading;
     bool m_bPlayAfterLoading;
     float m_fRampValue;
@@ -402,6 +419,9 @@ class EngineBuffer : public EngineObject {
     bool m_bCrossfadeReady;
     int m_iLastBufferSize;
 
+    // Set by processRequests() for the next process() call.
+    bool m_bRequestsProcessed;
+
     QSharedPointer<VisualPlayPosition> m_visualPlayPos;
 };
 
@@ -53,6 +53,11 @@ class EngineChannel : public EngineObject {
     }
 
     virtual bool isActive() = 0;
+    // Returns true if the buffer of the last process() call is inaudible.
+    // EngineMaster leaves such channels out of the mix.
+    virtual bool isSilent() const {
+        return false;
+    }
     void setPfl(bool enabled);
     virtual bool isPflEnabled() const;
     void setMaster(bool enabled);
@@ -63,6 +68,26 @@ class EngineChannel : public EngineObject {
     virtual void process(CSAMPLE* pOut, const int iBufferSize) = 0;
     virtual void postProcess(const int iBuffersize) = 0;
 
+    // Does the part of process() that only touches the state of this
+    // channel. EngineMaster may call it from a worker thread, concurrently
+    // with other channels, right before it calls process() for the same
+    // buffer from the engine thread. Returns false if the channel does not
+    // split its processing, process() then does all the work.
+    virtual bool processIsolated(CSAMPLE* pOut, const int iBufferSize) {
+        Q_UNUSED(pOut);
+        Q_UNUSED(iBufferSize);
+        return false;
+    }
+
+    // May be called after processIsolated() to take the effects of the
+    // buffer out of the following process() call. Returns the features the
+    // effects need, EngineMaster then processes the effects of all channels
+    // that handed them over at once. Returns NULL if process() runs the
+    // effects itself, e.g. if the buffer is silent.
+    virtual const GroupFeatureState* handOverEffects() {
+        return NULL;
+    }
+
     // TODO(XXX) This hack needs to be removed.
     virtual EngineBuffer* getEngineBuffer() {
         return NULL;
@@ -26,6 +26,15 @@
 
 #include "sampleutil.h"
 
+namespace {
+// Longer than the longest echo delay, so the effects do not stop between
+// two repeats of an echo.
+const int kEffectTailSeconds = 3;
+// A sum of the absolute values below this is silence, each sample is at
+// -100 dB or less.
+const CSAMPLE kSilenceThreshold = 0.00001f;
+}  // namespace
+
 EngineDeck::EngineDeck(const ChannelHandleAndGroup& handle_group,
                        ConfigObject<ConfigValue>* pConfig,
                        EngineMaster* pMixingEngine,
@@ -46,6 +55,11 @@ EngineDeck::EngineDeck(const ChannelHandleAndGroup& handle_group,
     m_pPassing->setButtonMode(ControlPushButton::POWERWINDOW);
     m_bPassthroughIsActive = false;
     m_bPassthroughWasActive = false;
+    m_bIsolatedProcessed = false;
+    m_bIsolatedSilent = false;
+    m_bEffectsHandedOver = false;
+    m_bSilent = false;
+    m_iSilentEffectFrames = 0;
 
     // Set up passthrough toggle button
     connect(m_pPassing, SIGNAL(valueChanged(double)),
@@ -69,8 +83,9 @@ EngineDeck::~EngineDeck() {
     delete m_pSampleRate;
 }
 
-void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
-    GroupFeatureState features;
+bool EngineDeck::processIsolated(CSAMPLE* pOut, const int iBufferSize) {
+    m_features = GroupFeatureState();
+    m_bIsolatedProcessed = true;
     // Feed the incoming audio through if passthrough is active
     const CSAMPLE* sampleBuffer = m_sampleBuffer; // save pointer on stack
     if (isPassthroughActive() && sampleBuffer) {
@@ -83,31 +98,101 @@ void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
         if (m_bPassthroughWasActive) {
             SampleUtil::clear(pOut, iBufferSize);
             m_bPassthroughWasActive = false;
-            return;
+            m_pPregain->processSilence();
+            m_bIsolatedSilent = true;
+            return true;
         }
 
         // Process the raw audio
         m_pBuffer->process(pOut, iBufferSize);
-        m_pBuffer->collectFeatures(&features);
+        m_pBuffer->collectFeatures(&m_features);
         m_pPregain->setSpeed(m_pBuffer->getSpeed());
         m_bPassthroughWasActive = false;
+        if (m_pBuffer->isOutputSilent()) {
+            // The pregain keeps the zeros, but its gain ramp moves on.
+            m_pPregain->processSilence();
+            m_bIsolatedSilent = true;
+            return true;
+        }
     }
 
     // Apply pregain
     m_pPregain->process(pOut, iBufferSize);
+    m_bIsolatedSilent = false;
+    return true;
+}
+
+void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
+    if (!m_bIsolatedProcessed) {
+        processIsolated(pOut, iBufferSize);
+    }
+    m_bIsolatedProcessed = false;
+    const bool effectsHandedOver = m_bEffectsHandedOver;
+    m_bEffectsHandedOver = false;
+    if (m_bIsolatedSilent) {
+        processSilence(pOut, iBufferSize);
+        return;
+    }
+    m_bSilent = false;
+    m_iSilentEffectFrames = 0;
+
     // Process effects enabled for this channel
-    if (m_pEngineEffectsManager != NULL) {
+    if (m_pEngineEffectsManager != NULL && !effectsHandedOver) {
         // This is out of date by a callback but some effects will want the RMS
         // volume.
-        m_pVUMeter->collectFeatures(&features);
+        m_pVUMeter->collectFeatures(&m_features);
         m_pEngineEffectsManager->process(
                 getHandle(), pOut, iBufferSize,
-                static_cast<unsigned int>(m_pSampleRate->get()), features);
+                static_cast<unsigned int>(m_pSampleRate->get()), m_features);
     }
     // Update VU meter
     m_pVUMeter->process(pOut, iBufferSize);
 }
 
+void EngineDeck::processSilence(CSAMPLE* pOut, const int iBufferSize) {
+    const unsigned int sampleRate =
+            static_cast<unsigned int>(m_pSampleRate->get());
+    // Effects that are enabled or disabled meanwhile still run their ramp
+    // on the silent buffer. Otherwise it would be left for the first buffer
+    // of audio and e.g. an effect would reset its state in the middle of it.
+    if (m_pEngineEffectsManager == NULL ||
+            (m_iSilentEffectFrames >= static_cast<int>(
+                    sampleRate * kEffectTailSeconds) &&
+             !m_pEngineEffectsManager->rampsForChannel(getHandle()))) {
+        m_bSilent = true;
+        m_pVUMeter->processSilence(iBufferSize);
+        return;
+    }
+
+    // The effects play out their tails.
+    m_pVUMeter->collectFeatures(&m_features);
+    m_pEngineEffectsManager->process(getHandle(), pOut, iBufferSize,
+                                     sampleRate, m_features);
+    CSAMPLE fAbsL, fAbsR;
+    SampleUtil::sumAbsPerChannel(&fAbsL, &fAbsR, pOut, iBufferSize);
+    if (fAbsL + fAbsR < kSilenceThreshold) {
+        m_bSilent = true;
+        m_iSilentEffectFrames += iBufferSize / 2;
+        m_pVUMeter->processSilence(iBufferSize);
+    } else {
+        m_bSilent = false;
+        m_iSilentEffectFrames = 0;
+        m_pVUMeter->process(pOut, iBufferSize);
+    }
+}
+
+const GroupFeatureState* EngineDeck::handOverEffects() {
+    if (!m_bIsolatedProcessed || m_bIsolatedSilent ||
+            m_pEngineEffectsManager == NULL) {
+        return NULL;
+    }
+    // This is out of date by a callback but some effects will want the RMS
+    // volume.
+    m_pVUMeter->collectFeatures(&m_features);
+    m_bEffectsHandedOver = true;
+    return &m_features;
+}
+
 void EngineDeck::postProcess(const int iBufferSize) {
     m_pBuffer->postProcess(iBufferSize);
 }
@@ -116,6 +201,10 @@ EngineBuffer* EngineDeck::getEngineBuffer() {
     return m_pBuffer;
 }
 
+bool EngineDeck::isSilent() const {
+    return m_bSilent;
+}
+
 bool EngineDeck::isActive() {
     if (m_bPassthroughWasActive && !m_bPassthroughIsActive) {
         return true;
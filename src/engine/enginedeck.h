@@ -23,6 +23,7 @@
 #include "controlpushbutton.h"
 #include "engine/engineobject.h"
 #include "engine/enginechannel.h"
+#include "engine/effects/groupfeaturestate.h"
 #include "util/circularbuffer.h"
 
 #include "soundmanagerutil.h"
@@ -46,11 +47,16 @@ class EngineDeck : public EngineChannel, public AudioDestination {
 
     virtual void process(CSAMPLE* pOutput, const int iBufferSize);
     virtual void postProcess(const int iBufferSize);
+    // Runs the EngineBuffer and the pregain. Effects and the VU meter are
+    // left to process() since the effect chains are shared by all decks.
+    virtual bool processIsolated(CSAMPLE* pOutput, const int iBufferSize);
+    virtual const GroupFeatureState* handOverEffects();
 
     // TODO(XXX) This hack needs to be removed.
     virtual EngineBuffer* getEngineBuffer();
 
     virtual bool isActive();
+    virtual bool isSilent() const;
 
     // This is called by SoundManager whenever there are new samples from the
     // configured input to be processed. This is run in the callback thread of
@@ -87,6 +93,19 @@ class EngineDeck : public EngineChannel, public AudioDestination {
     const CSAMPLE* volatile m_sampleBuffer;
     bool m_bPassthroughIsActive;
     bool m_bPassthroughWasActive;
+
+    // Results of processIsolated() for the following process() call.
+    bool m_bIsolatedProcessed;
+    bool m_bIsolatedSilent;
+    // Set by handOverEffects() for the following process() call.
+    bool m_bEffectsHandedOver;
+    GroupFeatureState m_features;
+    // The result of the last process() call, see isSilent().
+    bool m_bSilent;
+    // How long the effects have been processing a silent buffer into a
+    // silent one. They are skipped after a while, a reverb or echo tail has
+    // decayed by then.
+    int m_iSilentEffectFrames;
 };
 
 #endif
@@ -52,11 +52,11 @@ class EngineFilterDelay : public EngineObjectConstIn {
             for (int i = 0; i < iBufferSize; ++i) {
                 // put sample into delay buffer:
                 m_buf[m_delayPos] = pIn[i];
-                m_delayPos = (m_delayPos + 1) % SIZE;
+                m_delayPos = nextPos(m_delayPos);
 
                 // Take delayed sample from delay buffer and copy it to dest buffer:
                 pOutput[i] = m_buf[delaySourcePos];
-                delaySourcePos = (delaySourcePos + 1) % SIZE;
+                delaySourcePos = nextPos(delaySourcePos);
             }
         } else {
             int delaySourcePos = (m_delayPos + SIZE - m_delaySamples + iBufferSize / 2) % SIZE;
@@ -85,19 +85,19 @@ class EngineFilterDelay : public EngineObjectConstIn {
             for (int i = 0; i < iBufferSize; ++i) {
                 // put sample into delay buffer:
                 m_buf[m_delayPos] = pIn[i];
-                m_delayPos = (m_delayPos + 1) % SIZE;
+                m_delayPos = nextPos(m_delayPos);
 
                 // Take delayed sample from delay buffer and copy it to dest buffer:
                 if (i < iBufferSize / 2) {
                     // only ramp the second half of the buffer, because we do
                     // the same in the IIR filter to wait for settling
                     pOutput[i] = m_buf[oldDelaySourcePos];
-                    oldDelaySourcePos = (oldDelaySourcePos + 1) % SIZE;
+                    oldDelaySourcePos = nextPos(oldDelaySourcePos);
                 } else {
                     pOutput[i] = m_buf[delaySourcePos] * cross_mix;
-                    delaySourcePos = (delaySourcePos + 1) % SIZE;
+                    delaySourcePos = nextPos(delaySourcePos);
                     pOutput[i] += m_buf[oldDelaySourcePos] * (1.0 - cross_mix);
-                    oldDelaySourcePos = (oldDelaySourcePos + 1) % SIZE;
+                    oldDelaySourcePos = nextPos(oldDelaySourcePos);
                     cross_mix += cross_inc;
                 }
             }
@@ -107,6 +107,12 @@ class EngineFilterDelay : public EngineObjectConstIn {
     }
 
   protected:
+    // A compare instead of the modulo, which is a division for most SIZEs.
+    static inline int nextPos(int pos) {
+        ++pos;
+        return pos < static_cast<int>(SIZE) ? pos : 0;
+    }
+
     int m_delaySamples;
     int m_oldDelaySamples;
     int m_delayPos;
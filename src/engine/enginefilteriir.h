@@ -5,9 +5,17 @@
 
 #include "engine/engineobject.h"
 #include "sampleutil.h"
+#include "sampleutil_simd.h"
 #define MIXXX
 #include <fidlib.h>
 
+#ifdef SAMPLEUTIL_SSE2
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+#endif
+
 // set to 1 to print some analysis data using qDebug()
 // It prints the resulting delay after 50 % of impulse have passed
 // and the gain and phase shift at some sample frequencies
@@ -28,6 +36,166 @@ class EngineFilterIIRBase : public EngineObjectConstIn {
     virtual void assumeSettled() = 0;
 };
 
+#ifdef SAMPLEUTIL_SSE2
+// The stereo frame of one filter, the left and right sample in the two lanes
+// of a SSE2 register. processSample() is written for both double and this
+// type, so both channels of a filter run through it with one instruction per
+// operation. Every lane does exactly the same IEEE double math as the scalar
+// code, so the results are bit identical.
+class IIRStereoLanes {
+  public:
+    // The number of filters in the lanes.
+    static const int kFilters = 1;
+
+    IIRStereoLanes() {
+    }
+
+    // Loads the stereo frame at index i of the buffer of each filter.
+    static IIRStereoLanes load(const CSAMPLE* const* pBuffers, int i) {
+        // Accessing the float pair as a double would break strict aliasing,
+        // __m64 is declared to alias anything.
+        IIRStereoLanes lanes;
+        lanes.m_value = _mm_cvtps_pd(_mm_loadl_pi(_mm_setzero_ps(),
+                reinterpret_cast<const __m64*>(pBuffers[0] + i)));
+        return lanes;
+    }
+
+    // Stores the lanes of each filter as the stereo frame at index i of its
+    // buffer.
+    void store(CSAMPLE* const* pBuffers, int i) const {
+        _mm_storel_pi(reinterpret_cast<__m64*>(pBuffers[0] + i),
+                _mm_cvtpd_ps(m_value));
+    }
+
+    void set(int n, double left, double right) {
+        Q_UNUSED(n);
+        m_value = _mm_setr_pd(left, right);
+    }
+
+    double left(int n) const {
+        Q_UNUSED(n);
+        return _mm_cvtsd_f64(m_value);
+    }
+
+    double right(int n) const {
+        Q_UNUSED(n);
+        return _mm_cvtsd_f64(_mm_unpackhi_pd(m_value, m_value));
+    }
+
+    IIRStereoLanes operator-() const {
+        // Flip the sign bit like a scalar negation does.
+        return IIRStereoLanes(_mm_xor_pd(m_value, _mm_set1_pd(-0.0)));
+    }
+    IIRStereoLanes operator+(const IIRStereoLanes& other) const {
+        return IIRStereoLanes(_mm_add_pd(m_value, other.m_value));
+    }
+    IIRStereoLanes operator-(const IIRStereoLanes& other) const {
+        return IIRStereoLanes(_mm_sub_pd(m_value, other.m_value));
+    }
+    IIRStereoLanes operator*(double coef) const {
+        return IIRStereoLanes(_mm_mul_pd(m_value, _mm_set1_pd(coef)));
+    }
+    IIRStereoLanes& operator+=(const IIRStereoLanes& other) {
+        m_value = _mm_add_pd(m_value, other.m_value);
+        return *this;
+    }
+    IIRStereoLanes& operator-=(const IIRStereoLanes& other) {
+        m_value = _mm_sub_pd(m_value, other.m_value);
+        return *this;
+    }
+
+  private:
+    explicit IIRStereoLanes(__m128d value)
+            : m_value(value) {
+    }
+
+    __m128d m_value;
+};
+
+inline IIRStereoLanes operator*(double coef, const IIRStereoLanes& lanes) {
+    return lanes * coef;
+}
+
+#ifdef __AVX__
+// The stereo frames of two filters in the four lanes of an AVX register,
+// for builds that target CPUs with AVX (optimize=native). This halves the
+// instructions of processBatch(), the math per lane is the same as above.
+class IIRStereoLanesAvx {
+  public:
+    static const int kFilters = 2;
+
+    IIRStereoLanesAvx() {
+    }
+
+    static IIRStereoLanesAvx load(const CSAMPLE* const* pBuffers, int i) {
+        __m128 frames = _mm_loadl_pi(_mm_setzero_ps(),
+                reinterpret_cast<const __m64*>(pBuffers[0] + i));
+        frames = _mm_loadh_pi(frames,
+                reinterpret_cast<const __m64*>(pBuffers[1] + i));
+        return IIRStereoLanesAvx(_mm256_cvtps_pd(frames));
+    }
+
+    void store(CSAMPLE* const* pBuffers, int i) const {
+        const __m128 frames = _mm256_cvtpd_ps(m_value);
+        _mm_storel_pi(reinterpret_cast<__m64*>(pBuffers[0] + i), frames);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(pBuffers[1] + i), frames);
+    }
+
+    void set(int n, double left, double right) {
+        double values[4];
+        _mm256_storeu_pd(values, m_value);
+        values[2 * n] = left;
+        values[2 * n + 1] = right;
+        m_value = _mm256_loadu_pd(values);
+    }
+
+    double left(int n) const {
+        double values[4];
+        _mm256_storeu_pd(values, m_value);
+        return values[2 * n];
+    }
+
+    double right(int n) const {
+        double values[4];
+        _mm256_storeu_pd(values, m_value);
+        return values[2 * n + 1];
+    }
+
+    IIRStereoLanesAvx operator-() const {
+        return IIRStereoLanesAvx(_mm256_xor_pd(m_value, _mm256_set1_pd(-0.0)));
+    }
+    IIRStereoLanesAvx operator+(const IIRStereoLanesAvx& other) const {
+        return IIRStereoLanesAvx(_mm256_add_pd(m_value, other.m_value));
+    }
+    IIRStereoLanesAvx operator-(const IIRStereoLanesAvx& other) const {
+        return IIRStereoLanesAvx(_mm256_sub_pd(m_value, other.m_value));
+    }
+    IIRStereoLanesAvx operator*(double coef) const {
+        return IIRStereoLanesAvx(_mm256_mul_pd(m_value, _mm256_set1_pd(coef)));
+    }
+    IIRStereoLanesAvx& operator+=(const IIRStereoLanesAvx& other) {
+        m_value = _mm256_add_pd(m_value, other.m_value);
+        return *this;
+    }
+    IIRStereoLanesAvx& operator-=(const IIRStereoLanesAvx& other) {
+        m_value = _mm256_sub_pd(m_value, other.m_value);
+        return *this;
+    }
+
+  private:
+    explicit IIRStereoLanesAvx(__m256d value)
+            : m_value(value) {
+    }
+
+    __m256d m_value;
+};
+
+inline IIRStereoLanesAvx operator*(double coef,
+                                   const IIRStereoLanesAvx& lanes) {
+    return lanes * coef;
+}
+#endif
+#endif
 
 // length of the 3rd argument to fid_design_coef
 #define FIDSPEC_LENGTH 40
@@ -190,9 +358,17 @@ class EngineFilterIIR : public EngineFilterIIRBase {
     virtual void process(const CSAMPLE* pIn, CSAMPLE* pOutput,
                          const int iBufferSize) {
         if (!m_doRamping) {
+#ifdef SAMPLEUTIL_SSE2
+            if (SampleUtil::simdLevel() != SampleUtil::SIMD_NONE) {
+                EngineFilterIIR* pThis = this;
+                processLanes<IIRStereoLanes, 1>(&pThis, &pIn, &pOutput,
+                                                iBufferSize);
+                return;
+            }
+#endif
             for (int i = 0; i < iBufferSize; i += 2) {
-                pOutput[i] = processSample(m_coef, m_buf1, pIn[i]);
-                pOutput[i+1] = processSample(m_coef, m_buf2, pIn[i + 1]);
+                pOutput[i] = processSample<double>(m_coef, m_buf1, pIn[i]);
+                pOutput[i+1] = processSample<double>(m_coef, m_buf2, pIn[i + 1]);
             }
         } else {
             double cross_mix = 0.0;
@@ -213,8 +389,8 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                 double old2;
                 if (!m_doStart) {
                     // Process old filter, but only if we do not do a fresh start
-                    old1 = processSample(m_oldCoef, m_oldBuf1, pIn[i]);
-                    old2 = processSample(m_oldCoef, m_oldBuf2, pIn[i + 1]);
+                    old1 = processSample<double>(m_oldCoef, m_oldBuf1, pIn[i]);
+                    old2 = processSample<double>(m_oldCoef, m_oldBuf2, pIn[i + 1]);
                 } else {
                     if (m_startFromDry) {
                         old1 = pIn[i];
@@ -224,8 +400,8 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                         old2 = 0;
                     }
                 }
-                double new1 = processSample(m_coef, m_buf1, pIn[i]);
-                double new2 = processSample(m_coef, m_buf2, pIn[i + 1]);
+                double new1 = processSample<double>(m_coef, m_buf1, pIn[i]);
+                double new2 = processSample<double>(m_coef, m_buf2, pIn[i + 1]);
 
                 if (i < iBufferSize / 2) {
                     pOutput[i] = old1;
@@ -243,8 +419,146 @@ class EngineFilterIIR : public EngineFilterIIRBase {
         }
     }
 
+    // Processes the buffers of several filters of the same kind, e.g. the
+    // same EQ filter of all decks. pIn[i] is processed by pFilters[i] into
+    // pOutput[i]. Filters with the same coefficients run interleaved, which
+    // costs little more than processing one of them. The results are the same
+    // as with process() for each filter.
+    template<class Filter>
+    static void processBatch(Filter* const* pFilters,
+                             const CSAMPLE* const* pIn,
+                             CSAMPLE* const* pOutput,
+                             int count, const int iBufferSize) {
+#ifdef SAMPLEUTIL_SSE2
+        if (SampleUtil::simdLevel() != SampleUtil::SIMD_NONE) {
+            EngineFilterIIR* group[kMaxLanes];
+            const CSAMPLE* groupIn[kMaxLanes];
+            CSAMPLE* groupOutput[kMaxLanes];
+            int groupSize = 0;
+            for (int i = 0; i < count; ++i) {
+                EngineFilterIIR* pFilter = pFilters[i];
+                if (pFilter->m_doRamping) {
+                    pFilter->process(pIn[i], pOutput[i], iBufferSize);
+                    continue;
+                }
+                if (groupSize == kMaxLanes || (groupSize > 0 &&
+                        memcmp(group[0]->m_coef, pFilter->m_coef,
+                               sizeof(m_coef)) != 0)) {
+                    processLanes(group, groupIn, groupOutput, groupSize,
+                                 iBufferSize);
+                    groupSize = 0;
+                }
+                group[groupSize] = pFilter;
+                groupIn[groupSize] = pIn[i];
+                groupOutput[groupSize] = pOutput[i];
+                ++groupSize;
+            }
+            processLanes(group, groupIn, groupOutput, groupSize, iBufferSize);
+            return;
+        }
+#endif
+        for (int i = 0; i < count; ++i) {
+            pFilters[i]->process(pIn[i], pOutput[i], iBufferSize);
+        }
+    }
+
   protected:
-    inline double processSample(double* coef, double* buf, double val);
+    // The number of filters processBatch() runs interleaved. Four stereo
+    // channels are about the number of independent additions and
+    // multiplications a CPU core can have in flight.
+    static const int kMaxLanes = 4;
+
+    // T is double for a single channel or one of the lane types for both
+    // channels of one or two filters at once.
+    template<typename T>
+    inline T processSample(double* coef, T* buf, T val);
+
+#ifdef SAMPLEUTIL_SSE2
+    // Processes N * Lanes::kFilters filters with the same coefficients
+    // at once.
+    template<class Lanes, int N>
+    static void processLanes(EngineFilterIIR* const* pFilters,
+                             const CSAMPLE* const* pIn,
+                             CSAMPLE* const* pOutput,
+                             const int iBufferSize) {
+        // Each of the N lane registers has its own state, so the
+        // processSample() calls of one frame do not depend on each other.
+        Lanes buf[N][SIZE];
+        for (int n = 0; n < N; ++n) {
+            for (int k = 0; k < Lanes::kFilters; ++k) {
+                EngineFilterIIR* pFilter = pFilters[n * Lanes::kFilters + k];
+                for (unsigned int j = 0; j < SIZE; ++j) {
+                    buf[n][j].set(k, pFilter->m_buf1[j], pFilter->m_buf2[j]);
+                }
+            }
+        }
+        EngineFilterIIR* pFirst = pFilters[0];
+        for (int i = 0; i < iBufferSize; i += 2) {
+            for (int n = 0; n < N; ++n) {
+                pFirst->processSample(pFirst->m_coef, buf[n],
+                        Lanes::load(pIn + n * Lanes::kFilters, i))
+                        .store(pOutput + n * Lanes::kFilters, i);
+            }
+        }
+        for (int n = 0; n < N; ++n) {
+            for (int k = 0; k < Lanes::kFilters; ++k) {
+                EngineFilterIIR* pFilter = pFilters[n * Lanes::kFilters + k];
+                for (unsigned int j = 0; j < SIZE; ++j) {
+                    pFilter->m_buf1[j] = buf[n][j].left(k);
+                    pFilter->m_buf2[j] = buf[n][j].right(k);
+                }
+            }
+        }
+    }
+
+    static void processLanes(EngineFilterIIR* const* pFilters,
+                             const CSAMPLE* const* pIn,
+                             CSAMPLE* const* pOutput,
+                             int count, const int iBufferSize) {
+#ifdef __AVX__
+        switch (count) {
+        case 4:
+            processLanes<IIRStereoLanesAvx, 2>(pFilters, pIn, pOutput,
+                                               iBufferSize);
+            break;
+        case 3:
+            processLanes<IIRStereoLanesAvx, 1>(pFilters, pIn, pOutput,
+                                               iBufferSize);
+            processLanes<IIRStereoLanes, 1>(pFilters + 2, pIn + 2,
+                                            pOutput + 2, iBufferSize);
+            break;
+        case 2:
+            processLanes<IIRStereoLanesAvx, 1>(pFilters, pIn, pOutput,
+                                               iBufferSize);
+            break;
+        case 1:
+            processLanes<IIRStereoLanes, 1>(pFilters, pIn, pOutput,
+                                            iBufferSize);
+            break;
+        }
+#else
+        switch (count) {
+        case 4:
+            processLanes<IIRStereoLanes, 4>(pFilters, pIn, pOutput,
+                                            iBufferSize);
+            break;
+        case 3:
+            processLanes<IIRStereoLanes, 3>(pFilters, pIn, pOutput,
+                                            iBufferSize);
+            break;
+        case 2:
+            processLanes<IIRStereoLanes, 2>(pFilters, pIn, pOutput,
+                                            iBufferSize);
+            break;
+        case 1:
+            processLanes<IIRStereoLanes, 1>(pFilters, pIn, pOutput,
+                                            iBufferSize);
+            break;
+        }
+#endif
+    }
+#endif
+
     inline void pauseFilterInner() {
         // Set the current buffers to 0
         memset(m_buf1, 0, sizeof(m_buf1));
@@ -276,10 +590,11 @@ class EngineFilterIIR : public EngineFilterIIRBase {
 };
 
 template<>
-inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -290,10 +605,11 @@ inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = -tmp;
@@ -304,10 +620,11 @@ inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -318,10 +635,11 @@ inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -337,10 +655,11 @@ inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -367,10 +686,11 @@ inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir= val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -386,10 +706,11 @@ inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -416,10 +737,11 @@ inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
-                                                         double* buf,
-                                                         double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
+                                                    T* buf,
+                                                    T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     buf[7] = buf[8]; buf[8] = buf[9]; buf[9] = buf[10]; buf[10] = buf[11];
@@ -468,10 +790,11 @@ inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -499,10 +822,11 @@ inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
 
 // IIR_LP and IIR_HP use the same processSample routine
 template<>
-inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = coef[2] * tmp;
@@ -513,10 +837,11 @@ inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= tmp;
@@ -539,10 +864,11 @@ inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
 
 
 template<>
-inline double EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
+                                                   T* buf,
+                                                   T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= -tmp;
@@ -27,6 +27,8 @@
 #include "engine/enginebuffer.h"
 #include "engine/enginemaster.h"
 #include "engine/engineworkerscheduler.h"
+#include "engine/channelworkerpool.h"
+#include "engine/convolutionworker.h"
 #include "engine/enginedeck.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginechannel.h"
@@ -39,6 +41,7 @@
 #include "sampleutil.h"
 #include "engine/effects/engineeffectsmanager.h"
 #include "effects/effectsmanager.h"
+#include "util/callbackbudget.h"
 #include "util/timer.h"
 #include "util/trace.h"
 #include "util/defs.h"
@@ -67,6 +70,21 @@ EngineMaster::EngineMaster(ConfigObject<ConfigValue>* _config,
     m_bBusOutputConnected[EngineChannel::RIGHT] = false;
     m_pWorkerScheduler = new EngineWorkerScheduler(this);
     m_pWorkerScheduler->start(QThread::HighPriority);
+    // Convolution effects compute their tails in the background.
+    ConvolutionWorker::setSharedScheduler(m_pWorkerScheduler);
+
+    // Opt-in, the number of threads that process channels in addition to
+    // the engine thread.
+    const int channelWorkerThreads = _config->getValueString(
+            ConfigKey(group, "channel_worker_threads"), "0").toInt();
+    m_pChannelWorkerPool = channelWorkerThreads > 0 ?
+            new ChannelWorkerPool(channelWorkerThreads) : NULL;
+
+    // Opt-out, runs the effects of all decks at once, which processes e.g.
+    // their EQs together.
+    m_bBatchEffects = m_pEngineEffectsManager != NULL &&
+            _config->getValueString(
+                    ConfigKey(group, "batch_effects"), "1").toInt() != 0;
 
     if (pEffectsManager) {
         pEffectsManager->registerChannel(m_masterHandle);
@@ -225,7 +243,9 @@ EngineMaster::~EngineMaster() {
         SampleUtil::free(m_pOutputBusBuffers[o]);
     }
 
+    ConvolutionWorker::setSharedScheduler(NULL);
     delete m_pWorkerScheduler;
+    delete m_pChannelWorkerPool;
 
     for (int i = 0; i < m_channels.size(); ++i) {
         ChannelInfo* pChannelInfo = m_channels[i];
@@ -245,6 +265,30 @@ const CSAMPLE* EngineMaster::getHeadphoneBuffer() const {
     return m_pHead;
 }
 
+void EngineMaster::processEffectsBatch(int firstChannel, int iBufferSize) {
+    m_batchHandles.clear();
+    m_batchBuffers.clear();
+    m_batchFeatures.clear();
+    for (int i = firstChannel; i < m_activeChannels.size(); ++i) {
+        ChannelInfo* pChannelInfo = m_activeChannels[i];
+        const GroupFeatureState* pFeatures =
+                pChannelInfo->m_pChannel->handOverEffects();
+        if (pFeatures == NULL) {
+            continue;
+        }
+        m_batchHandles.append(pChannelInfo->m_handle.handle());
+        m_batchBuffers.append(pChannelInfo->m_pBuffer);
+        m_batchFeatures.append(pFeatures);
+    }
+    if (m_batchHandles.isEmpty()) {
+        return;
+    }
+    m_pEngineEffectsManager->processBatch(
+            m_batchHandles.constData(), m_batchBuffers.constData(),
+            m_batchFeatures.constData(), m_batchHandles.size(), iBufferSize,
+            static_cast<unsigned int>(m_pMasterSampleRate->get()));
+}
+
 void EngineMaster::processChannels(int iBufferSize) {
     m_activeBusChannels[EngineChannel::LEFT].clear();
     m_activeBusChannels[EngineChannel::CENTER].clear();
@@ -325,11 +369,81 @@ void EngineMaster::processChannels(int iBufferSize) {
     }
 
     // Now that the list is built and ordered, do the processing.
-    for (int i = activeChannelsStartIndex;
-             i < m_activeChannels.size(); ++i) {
-        ChannelInfo* pChannelInfo = m_activeChannels[i];
-        EngineChannel* pChannel = pChannelInfo->m_pChannel;
-        pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+    if (m_pChannelWorkerPool && m_activeChannels.size() > 2) {
+        // The sync master updates the followers, so it is done before the
+        // others start.
+        int firstUnfinished = 1;
+        if (activeChannelsStartIndex == 0) {
+            ChannelInfo* pChannelInfo = m_activeChannels[0];
+            EngineChannel* pChannel = pChannelInfo->m_pChannel;
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannelInfo->m_handle.handle());
+            if (m_bBatchEffects &&
+                    pChannel->processIsolated(pChannelInfo->m_pBuffer,
+                                              iBufferSize)) {
+                // Its effects run together with those of the others.
+                firstUnfinished = 0;
+            } else {
+                pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+            }
+        }
+        m_isolatedChannels.clear();
+        m_isolatedBuffers.clear();
+        for (int i = 1; i < m_activeChannels.size(); ++i) {
+            EngineChannel* pChannel = m_activeChannels[i]->m_pChannel;
+            // Sync requests and quantized seeks touch EngineSync and the
+            // other decks, so they must not run on the worker threads.
+            EngineBuffer* pBuffer = pChannel->getEngineBuffer();
+            if (pBuffer) {
+                pBuffer->processRequests();
+            }
+            m_isolatedChannels.append(pChannel);
+            m_isolatedBuffers.append(m_activeChannels[i]->m_pBuffer);
+        }
+        m_pChannelWorkerPool->processIsolated(
+                m_isolatedChannels.constData(), m_isolatedBuffers.constData(),
+                m_isolatedChannels.size(), iBufferSize);
+        if (m_bBatchEffects) {
+            processEffectsBatch(firstUnfinished, iBufferSize);
+        }
+        // Finishes the channels with the parts that touch shared state,
+        // e.g. the effect chains.
+        for (int i = firstUnfinished; i < m_activeChannels.size(); ++i) {
+            ChannelInfo* pChannelInfo = m_activeChannels[i];
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannelInfo->m_handle.handle());
+            pChannelInfo->m_pChannel->process(pChannelInfo->m_pBuffer,
+                                              iBufferSize);
+        }
+    } else if (m_bBatchEffects) {
+        // The same order as below, only the effects of all channels run
+        // after the isolated parts of all of them.
+        for (int i = activeChannelsStartIndex;
+                 i < m_activeChannels.size(); ++i) {
+            ChannelInfo* pChannelInfo = m_activeChannels[i];
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannelInfo->m_handle.handle());
+            pChannelInfo->m_pChannel->processIsolated(pChannelInfo->m_pBuffer,
+                                                      iBufferSize);
+        }
+        processEffectsBatch(activeChannelsStartIndex, iBufferSize);
+        for (int i = activeChannelsStartIndex;
+                 i < m_activeChannels.size(); ++i) {
+            ChannelInfo* pChannelInfo = m_activeChannels[i];
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannelInfo->m_handle.handle());
+            pChannelInfo->m_pChannel->process(pChannelInfo->m_pBuffer,
+                                              iBufferSize);
+        }
+    } else {
+        for (int i = activeChannelsStartIndex;
+                 i < m_activeChannels.size(); ++i) {
+            ChannelInfo* pChannelInfo = m_activeChannels[i];
+            EngineChannel* pChannel = pChannelInfo->m_pChannel;
+            ScopedCallbackBudget budget(CallbackBudget::ENGINE_CHANNEL,
+                                        pChannelInfo->m_handle.handle());
+            pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+        }
     }
 
     // After all the engines have been processed, trigger post-processing
@@ -338,10 +452,43 @@ void EngineMaster::processChannels(int iBufferSize) {
     // if the sync target was processed before or after the sync origin.
     for (int i = activeChannelsStartIndex;
             i < m_activeChannels.size(); ++i) {
-        m_activeChannels[i]->m_pChannel->postProcess(iBufferSize);
+        ChannelInfo* pChannelInfo = m_activeChannels[i];
+        pChannelInfo->m_pChannel->postProcess(iBufferSize);
+        pChannelInfo->m_bSilent = pChannelInfo->m_pChannel->isSilent();
+        if (pChannelInfo->m_bSilent) {
+            CallbackBudget::markChannelSilent(pChannelInfo->m_handle.handle());
+        }
     }
 }
 
+// static
+void EngineMaster::removeInaudibleChannels(
+        const GainCalculator& gainCalculator,
+        QVarLengthArray<ChannelInfo*, kPreallocatedChannels>* pChannels,
+        QVarLengthArray<GainCache, kPreallocatedChannels>* pGainCache) {
+    int kept = 0;
+    for (int i = 0; i < pChannels->size(); ++i) {
+        ChannelInfo* pChannelInfo = pChannels->at(i);
+        GainCache& gainCache = (*pGainCache)[pChannelInfo->m_index];
+        if (pChannelInfo->m_bSilent) {
+            // The gain ramps of ChannelMixer are over, as if it had mixed
+            // the silence.
+            gainCache.m_gain = gainCache.m_fadeout ?
+                    0 : gainCalculator.getGain(pChannelInfo);
+            gainCache.m_fadeout = false;
+            continue;
+        }
+        if (!gainCache.m_fadeout && gainCache.m_gain == 0 &&
+                gainCalculator.getGain(pChannelInfo) == 0) {
+            // E.g. the volume fader is down. There is no ramp and the cache
+            // stays at zero.
+            continue;
+        }
+        (*pChannels)[kept++] = pChannelInfo;
+    }
+    pChannels->resize(kept);
+}
+
 void EngineMaster::process(const int iBufferSize) {
     static bool haveSetName = false;
     if (!haveSetName) {
@@ -349,6 +496,7 @@ void EngineMaster::process(const int iBufferSize) {
         haveSetName = true;
     }
     Trace t("EngineMaster::process");
+    ScopedCallbackBudget budget(CallbackBudget::ENGINE_MASTER);
 
     bool masterEnabled = m_pMasterEnabled->get();
     bool headphoneEnabled = m_pHeadphoneEnabled->get();
@@ -379,6 +527,8 @@ void EngineMaster::process(const int iBufferSize) {
 
     // Mix all the PFL enabled channels together.
     m_headphoneGain.setGain(chead_gain);
+    removeInaudibleChannels(m_headphoneGain, &m_activeHeadphoneChannels,
+                            &m_channelHeadphoneGainCache);
 
     if (m_bRampingGain) {
         ChannelMixer::mixChannelsRamping(
@@ -393,6 +543,8 @@ void EngineMaster::process(const int iBufferSize) {
     }
 
     // Mix all the talkover enabled channels together.
+    removeInaudibleChannels(m_talkoverGain, &m_activeTalkoverChannels,
+                            &m_channelTalkoverGainCache);
     if (m_bRampingGain) {
         ChannelMixer::mixChannelsRamping(
                 m_talkoverGain, &m_activeTalkoverChannels,
@@ -427,6 +579,8 @@ void EngineMaster::process(const int iBufferSize) {
     // Make the mix for each output bus. m_masterGain takes care of applying the
     // master volume, the channel volume, and the orientation gain.
     for (int o = EngineChannel::LEFT; o <= EngineChannel::RIGHT; o++) {
+        removeInaudibleChannels(m_masterGain, &m_activeBusChannels[o],
+                                &m_channelMasterGainCache);
         if (m_bRampingGain) {
             ChannelMixer::mixChannelsRamping(
                     m_masterGain,
@@ -522,6 +676,7 @@ void EngineMaster::process(const int iBufferSize) {
                         iBufferSize);
                 pSidechain = m_pTalkover;
             }
+            ScopedCallbackBudget budget(CallbackBudget::SIDECHAIN_WRITE);
             m_pSideChain->writeSamples(pSidechain, iBufferSize);
         }
 
@@ -610,6 +765,10 @@ void EngineMaster::addChannel(EngineChannel* pChannel) {
     pChannelInfo->m_pBuffer = SampleUtil::alloc(MAX_BUFFER_LEN);
     SampleUtil::clear(pChannelInfo->m_pBuffer, MAX_BUFFER_LEN);
     m_channels.append(pChannelInfo);
+    if (CallbackBudget::isEnabled()) {
+        CallbackBudget::instance()->setChannelName(
+                pChannelInfo->m_handle.handle(), group);
+    }
     const GainCache gainCacheDefault = {0, false};
     m_channelHeadphoneGainCache.append(gainCacheDefault);
     m_channelTalkoverGainCache.append(gainCacheDefault);
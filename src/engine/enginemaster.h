@@ -30,6 +30,7 @@
 #include "recording/recordingmanager.h"
 
 class EngineWorkerScheduler;
+class ChannelWorkerPool;
 class EngineBuffer;
 class EngineChannel;
 class EngineDeck;
@@ -140,7 +141,8 @@ class EngineMaster : public QObject, public AudioSource {
                   m_pBuffer(NULL),
                   m_pVolumeControl(NULL),
                   m_pMuteControl(NULL),
-                  m_index(index) {
+                  m_index(index),
+                  m_bSilent(false) {
         }
         ChannelHandle m_handle;
         EngineChannel* m_pChannel;
@@ -148,6 +150,9 @@ class EngineMaster : public QObject, public AudioSource {
         ControlObject* m_pVolumeControl;
         ControlPushButton* m_pMuteControl;
         int m_index;
+        // m_pBuffer is inaudible in this callback, see
+        // EngineChannel::isSilent().
+        bool m_bSilent;
     };
 
     struct GainCache {
@@ -261,12 +266,26 @@ class EngineMaster : public QObject, public AudioSource {
                      CSAMPLE* pOutput, unsigned int iBufferSize, GainCalculator* pGainCalculator);
 
     // Processes active channels. The master sync channel (if any) is processed
-    // first and all others are processed after. Populates m_activeChannels,
+    // first and all others are processed after, in parallel if enabled with
+    // [Master],channel_worker_threads. Populates m_activeChannels,
     // m_activeBusChannels, m_activeHeadphoneChannels, and
     // m_activeTalkoverChannels with each channel that is active for the
     // respective output.
     void processChannels(int iBufferSize);
 
+    // Runs the effects of the active channels from firstChannel on that
+    // hand them over after processIsolated(), see
+    // EngineChannel::handOverEffects().
+    void processEffectsBatch(int firstChannel, int iBufferSize);
+
+    // Removes the channels from pChannels that would add nothing to the mix:
+    // silent ones and those that stay at zero gain. Their gain cache is
+    // updated like mixing would.
+    static void removeInaudibleChannels(
+            const GainCalculator& gainCalculator,
+            QVarLengthArray<ChannelInfo*, kPreallocatedChannels>* pChannels,
+            QVarLengthArray<GainCache, kPreallocatedChannels>* pGainCache);
+
     ChannelHandleFactory m_channelHandleFactory;
     EngineEffectsManager* m_pEngineEffectsManager;
     bool m_bRampingGain;
@@ -286,12 +305,25 @@ class EngineMaster : public QObject, public AudioSource {
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeHeadphoneChannels;
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeTalkoverChannels;
 
+    // The channels and buffers handed to m_pChannelWorkerPool.
+    QVarLengthArray<EngineChannel*, kPreallocatedChannels> m_isolatedChannels;
+    QVarLengthArray<CSAMPLE*, kPreallocatedChannels> m_isolatedBuffers;
+
+    // [Master],batch_effects and the channels handed to
+    // EngineEffectsManager::processBatch().
+    bool m_bBatchEffects;
+    QVarLengthArray<ChannelHandle, kPreallocatedChannels> m_batchHandles;
+    QVarLengthArray<CSAMPLE*, kPreallocatedChannels> m_batchBuffers;
+    QVarLengthArray<const GroupFeatureState*, kPreallocatedChannels> m_batchFeatures;
+
     // Mixing buffers for each output.
     CSAMPLE* m_pOutputBusBuffers[3];
     CSAMPLE* m_pHead;
     CSAMPLE* m_pTalkover;
 
     EngineWorkerScheduler* m_pWorkerScheduler;
+    // NULL unless channels are processed in parallel.
+    ChannelWorkerPool* m_pChannelWorkerPool;
     EngineSync* m_pMasterSync;
 
     ControlObject* m_pMasterGain;
@@ -67,6 +67,22 @@ void EnginePregain::setSpeed(double speed) {
 }
 
 void EnginePregain::process(CSAMPLE* pInOut, const int iBufferSize) {
+    const float totalGain = updateTotalGain();
+    if (totalGain != m_fPrevGain) {
+        // Prevent sound wave discontinuities by interpolating from old to new gain.
+        SampleUtil::applyRampingGain(pInOut, m_fPrevGain, totalGain, iBufferSize);
+        m_fPrevGain = totalGain;
+    } else {
+        // SampleUtil deals with aliased buffers and gains of 1 or 0.
+        SampleUtil::applyGain(pInOut, totalGain, iBufferSize);
+    }
+}
+
+void EnginePregain::processSilence() {
+    m_fPrevGain = updateTotalGain();
+}
+
+float EnginePregain::updateTotalGain() {
     const float fReplayGain = m_pCOReplayGain->get();
     float fReplayGainCorrection;
     if (!s_pEnableReplayGain->toBool() || m_pPassthroughEnabled->toBool()) {
@@ -130,13 +146,5 @@ void EnginePregain::process(CSAMPLE* pInOut, const int iBufferSize) {
     if (fabs(m_dSpeed) < kThresholdSpeed) {
         totalGain *= fabs(m_dSpeed) / kThresholdSpeed;
     }
-
-    if (totalGain != m_fPrevGain) {
-        // Prevent sound wave discontinuities by interpolating from old to new gain.
-        SampleUtil::applyRampingGain(pInOut, m_fPrevGain, totalGain, iBufferSize);
-        m_fPrevGain = totalGain;
-    } else {
-        // SampleUtil deals with aliased buffers and gains of 1 or 0.
-        SampleUtil::applyGain(pInOut, totalGain, iBufferSize);
-    }
+    return totalGain;
 }
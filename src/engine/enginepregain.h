@@ -32,8 +32,13 @@ class EnginePregain : public EngineObject {
 
     void setSpeed(double speed);
     void process(CSAMPLE* pInOut, const int iBufferSize);
+    // Like process() for a silent buffer, which stays silent. Only moves the
+    // gain on, so audio that resumes later does not ramp from a stale gain.
+    void processSilence();
 
   private:
+    float updateTotalGain();
+
     double m_dSpeed;
     float m_fPrevGain;
     ControlAudioTaperPot* m_pPotmeterPregain;
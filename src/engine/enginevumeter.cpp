@@ -50,10 +50,18 @@ EngineVuMeter::~EngineVuMeter()
 
 void EngineVuMeter::process(CSAMPLE* pIn, const int iBufferSize) {
     CSAMPLE fVolSumL, fVolSumR;
+    bool clipped = SampleUtil::sumAbsPerChannel(&fVolSumL, &fVolSumR, pIn, iBufferSize);
+    update(fVolSumL, fVolSumR, clipped, iBufferSize);
+}
 
+void EngineVuMeter::processSilence(const int iBufferSize) {
+    update(0, 0, false, iBufferSize);
+}
+
+void EngineVuMeter::update(CSAMPLE fVolSumL, CSAMPLE fVolSumR, bool clipped,
+                           const int iBufferSize) {
     int sampleRate = (int)m_pSampleRate->get();
 
-    bool clipped = SampleUtil::sumAbsPerChannel(&fVolSumL, &fVolSumR, pIn, iBufferSize);
     m_fRMSvolumeSumL += fVolSumL;
     m_fRMSvolumeSumR += fVolSumR;
 
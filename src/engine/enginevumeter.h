@@ -38,12 +38,17 @@ class EngineVuMeter : public EngineObject {
     virtual ~EngineVuMeter();
 
     virtual void process(CSAMPLE* pInOut, const int iBufferSize);
+    // Same as process() for a buffer of zeros, without reading one. The
+    // meters decay as usual.
+    void processSilence(const int iBufferSize);
 
     virtual void collectFeatures(GroupFeatureState* pGroupFeatures) const;
 
     void reset();
 
   private:
+    void update(CSAMPLE fVolSumL, CSAMPLE fVolSumR, bool clipped,
+                const int iBufferSize);
     void doSmooth(CSAMPLE &currentVolume, CSAMPLE newVolume);
 
     ControlPotmeter* m_ctrlVuMeter;
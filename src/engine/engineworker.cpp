@@ -20,8 +20,7 @@ void EngineWorker::setScheduler(EngineWorkerScheduler* pScheduler) {
 
 bool EngineWorker::workReady() {
     if (m_pScheduler) {
-        m_pScheduler->workerReady(this);
-        return true;
+        return m_pScheduler->workerReady(this);
     }
     return false;
 }
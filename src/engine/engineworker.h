@@ -25,6 +25,11 @@ class EngineWorker : public QThread {
     virtual void run();
 
     void setScheduler(EngineWorkerScheduler* pScheduler);
+    bool hasScheduler() const {
+        return m_pScheduler != NULL;
+    }
+    // Returns false if there is no scheduler or the scheduler could not take
+    // the worker.
     bool workReady();
     void wake() {
         m_semaRun.release();
@@ -20,14 +20,17 @@ EngineWorkerScheduler::~EngineWorkerScheduler() {
     wait();
 }
 
-void EngineWorkerScheduler::workerReady(EngineWorker* pWorker) {
+bool EngineWorkerScheduler::workerReady(EngineWorker* pWorker) {
     if (pWorker) {
         // If the write fails, we really can't do much since we should not block
-        // in this slot. Write the address of the variable pWorker, since it is
-        // a 1-element array.
-        m_scheduleFIFO.write(&pWorker, 1);
+        // in this slot, so let the caller know. Write the address of the
+        // variable pWorker, since it is a 1-element array.
+        if (m_scheduleFIFO.write(&pWorker, 1) != 1) {
+            return false;
+        }
         m_bWakeScheduler = true;
     }
+    return true;
 }
 
 void EngineWorkerScheduler::runWorkers() {
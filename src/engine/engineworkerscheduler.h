@@ -20,7 +20,9 @@ class EngineWorkerScheduler : public QThread {
     virtual ~EngineWorkerScheduler();
 
     void runWorkers();
-    void workerReady(EngineWorker* worker);
+    // Returns false if the worker could not be scheduled because the FIFO is
+    // full.
+    bool workerReady(EngineWorker* worker);
 
   protected:
     void run();
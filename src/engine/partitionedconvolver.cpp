@@ -0,0 +1,338 @@
+#include <algorithm>
+
+#include "engine/partitionedconvolver.h"
+
+#include "engine/convolutionworker.h"
+#include "sampleutil.h"
+#include "util/assert.h"
+#include "util/math.h"
+
+ConvolutionKernel::ConvolutionKernel(const float* pImpulse, int length,
+                                     int headBlockSize, int tailBlockSize)
+        : m_length(length),
+          m_headBlockSize(headBlockSize),
+          m_tailBlockSize(tailBlockSize) {
+    DEBUG_ASSERT(tailBlockSize % headBlockSize == 0);
+    const int headLength = math_min(length, 2 * tailBlockSize);
+    m_headPartitions = partition(pImpulse, headLength, headBlockSize,
+                                 &m_headRe, &m_headIm);
+    m_tailPartitions = partition(pImpulse + headLength, length - headLength,
+                                 tailBlockSize, &m_tailRe, &m_tailIm);
+}
+
+ConvolutionKernel::~ConvolutionKernel() {
+}
+
+// static
+int ConvolutionKernel::partition(const float* pImpulse, int length,
+                                 int blockSize,
+                                 QVector<float>* pRe, QVector<float>* pIm) {
+    const int partitions = (length + blockSize - 1) / blockSize;
+    const int bins = blockSize + 1;
+    pRe->resize(partitions * bins);
+    pIm->resize(partitions * bins);
+
+    RealFFT fft(2 * blockSize);
+    QVector<float> window(2 * blockSize);
+    // Folds the normalization of the inverse transform into the kernel.
+    const float scale = 1.0f / fft.size();
+    for (int i = 0; i < partitions; ++i) {
+        window.fill(0.0f);
+        const int start = i * blockSize;
+        const int count = math_min(blockSize, length - start);
+        for (int j = 0; j < count; ++j) {
+            window[j] = pImpulse[start + j] * scale;
+        }
+        fft.forward(window.constData(), pRe->data() + i * bins,
+                    pIm->data() + i * bins);
+    }
+    return partitions;
+}
+
+PartitionedConvolver::TailWorkspace::TailWorkspace(int blockSize)
+        : fft(2 * blockSize),
+          sumRe(blockSize + 1),
+          sumIm(blockSize + 1),
+          result(2 * blockSize) {
+}
+
+PartitionedConvolver::TailSlot::TailSlot()
+        : state(TAIL_FREE),
+          newest(0),
+          partitions(0) {
+}
+
+PartitionedConvolver::PartitionedConvolver(
+        QSharedPointer<const ConvolutionKernel> pKernel,
+        QSharedPointer<ConvolutionWorker> pWorker)
+        : m_pKernel(pKernel),
+          m_pWorker(pWorker),
+          m_headBlockSize(pKernel->headBlockSize()),
+          m_tailBlockSize(pKernel->tailBlockSize()),
+          m_headBins(m_headBlockSize + 1),
+          m_tailBins(m_tailBlockSize + 1),
+          m_input(m_headBlockSize),
+          m_output(m_headBlockSize),
+          m_blockPosition(0),
+          m_headFft(2 * m_headBlockSize),
+          m_headWindow(2 * m_headBlockSize),
+          m_headDelayRe(math_max(1, pKernel->headPartitions()) * m_headBins),
+          m_headDelayIm(m_headDelayRe.size()),
+          m_headDelayPosition(0),
+          m_headSumRe(m_headBins),
+          m_headSumIm(m_headBins),
+          m_headResult(2 * m_headBlockSize),
+          m_tailSpectra(0),
+          m_tailDelayPosition(0),
+          m_tailPosition(0),
+          m_tailBlocks(0),
+          m_tailSlot(0),
+          m_pTailOutput(NULL),
+          m_engineWorkspace(m_tailBlockSize),
+          m_lateTailBlocks(0),
+          m_workerWorkspace(m_tailBlockSize) {
+    for (int i = 0; i < kTailSlots; ++i) {
+        m_tailBlockPosted[i] = false;
+        m_tailBlockNewest[i] = 0;
+        m_tailBlockPartitions[i] = 0;
+    }
+    if (m_pKernel->tailPartitions() > 0) {
+        m_tailWindow.resize(2 * m_tailBlockSize);
+        m_tailSpectra = m_pKernel->tailPartitions() + kSpareSpectra;
+        m_tailDelayRe.resize(m_tailSpectra * m_tailBins);
+        m_tailDelayIm.resize(m_tailDelayRe.size());
+        for (int i = 0; i < kTailSlots; ++i) {
+            m_tailSlots[i].output.resize(m_tailBlockSize);
+        }
+        m_lateOutput.resize(m_tailBlockSize);
+        if (m_pWorker) {
+            m_pWorker->addConvolver(this);
+        }
+    }
+}
+
+PartitionedConvolver::~PartitionedConvolver() {
+    if (m_pWorker && m_pKernel->tailPartitions() > 0) {
+        // Waits until the worker is done with us.
+        m_pWorker->removeConvolver(this);
+    }
+}
+
+void PartitionedConvolver::process(const CSAMPLE* pInput, CSAMPLE* pOutput,
+                                   int numFrames, int stride) {
+    float* pBlockInput = m_input.data();
+    const float* pBlockOutput = m_output.constData();
+    for (int i = 0; i < numFrames; ++i) {
+        // Read first, pInput may be pOutput.
+        pBlockInput[m_blockPosition] = pInput[i * stride];
+        pOutput[i * stride] = pBlockOutput[m_blockPosition];
+        if (++m_blockPosition == m_headBlockSize) {
+            processBlock();
+            m_blockPosition = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::reset() {
+    m_input.fill(0.0f);
+    m_output.fill(0.0f);
+    m_blockPosition = 0;
+    m_headWindow.fill(0.0f);
+    m_headDelayRe.fill(0.0f);
+    m_headDelayIm.fill(0.0f);
+    m_headDelayPosition = 0;
+
+    // The tail delay line can be megabytes, instead of clearing it the next
+    // blocks sum up only the spectra added after the reset.
+    m_tailWindow.fill(0.0f);
+    m_tailPosition = 0;
+    m_tailBlocks = 0;
+    m_pTailOutput = NULL;
+    for (int i = 0; i < kTailSlots; ++i) {
+        if (m_tailBlockPosted[i]) {
+            // Whatever the worker does with them is dropped.
+            m_tailSlots[i].state.testAndSetOrdered(TAIL_PENDING, TAIL_FREE);
+            m_tailSlots[i].state.testAndSetOrdered(TAIL_RUNNING, TAIL_ABORTED);
+            m_tailBlockPosted[i] = false;
+        }
+    }
+}
+
+void PartitionedConvolver::runPendingTailBlocks() {
+    for (int i = 0; i < kTailSlots; ++i) {
+        TailSlot* pSlot = &m_tailSlots[i];
+        if (pSlot->state.testAndSetAcquire(TAIL_PENDING, TAIL_RUNNING)) {
+            runTailBlock(pSlot);
+        }
+    }
+}
+
+void PartitionedConvolver::runTailBlock(TailSlot* pSlot) {
+    const bool complete = convolveTail(&m_workerWorkspace, pSlot->newest,
+                                       pSlot->partitions, &pSlot->state,
+                                       pSlot->output.data());
+    if (!complete ||
+            !pSlot->state.testAndSetRelease(TAIL_RUNNING, TAIL_DONE)) {
+        // process() has given up on it.
+        pSlot->state.fetchAndStoreRelease(TAIL_FREE);
+    }
+}
+
+void PartitionedConvolver::processBlock() {
+    const int blockSize = m_headBlockSize;
+    const int partitions = m_pKernel->headPartitions();
+
+    // Slide the window by one block and transform it into the newest slot
+    // of the delay line.
+    float* pWindow = m_headWindow.data();
+    std::copy(pWindow + blockSize, pWindow + 2 * blockSize, pWindow);
+    std::copy(m_input.constData(), m_input.constData() + blockSize,
+              pWindow + blockSize);
+    const int newest = m_headDelayPosition * m_headBins;
+    m_headFft.forward(pWindow, m_headDelayRe.data() + newest,
+                      m_headDelayIm.data() + newest);
+
+    m_headSumRe.fill(0.0f);
+    m_headSumIm.fill(0.0f);
+    int slot = m_headDelayPosition;
+    for (int i = 0; i < partitions; ++i) {
+        multiplyAccumulate(m_headDelayRe.constData() + slot * m_headBins,
+                           m_headDelayIm.constData() + slot * m_headBins,
+                           m_pKernel->headRe(i), m_pKernel->headIm(i),
+                           m_headSumRe.data(), m_headSumIm.data(), m_headBins);
+        slot = slot > 0 ? slot - 1 : partitions - 1;
+    }
+    if (++m_headDelayPosition >= partitions) {
+        m_headDelayPosition = 0;
+    }
+
+    // The second half of the result is free of the circular wrap around.
+    m_headFft.inverse(m_headSumRe.constData(), m_headSumIm.constData(),
+                      m_headResult.data());
+    float* pOutput = m_output.data();
+    std::copy(m_headResult.constData() + blockSize,
+              m_headResult.constData() + 2 * blockSize, pOutput);
+
+    if (m_pKernel->tailPartitions() == 0) {
+        return;
+    }
+
+    // The second half of the tail window collects the current tail block.
+    std::copy(m_input.constData(), m_input.constData() + blockSize,
+              m_tailWindow.data() + m_tailBlockSize + m_tailPosition);
+    if (m_pTailOutput) {
+        const float* pTail = m_pTailOutput + m_tailPosition;
+        for (int i = 0; i < blockSize; ++i) {
+            pOutput[i] += pTail[i];
+        }
+    }
+    m_tailPosition += blockSize;
+    if (m_tailPosition == m_tailBlockSize) {
+        // The tail starts 2 tail blocks into the kernel, so the block
+        // before the one completed now is played next.
+        const float* pNextOutput = m_tailBlocks > 0 ? takeTailBlock() : NULL;
+        postTailBlock();
+        m_pTailOutput = pNextOutput;
+        m_tailPosition = 0;
+    }
+}
+
+void PartitionedConvolver::postTailBlock() {
+    float* pWindow = m_tailWindow.data();
+    const int newest = m_tailDelayPosition;
+    m_engineWorkspace.fft.forward(pWindow,
+                                  m_tailDelayRe.data() + newest * m_tailBins,
+                                  m_tailDelayIm.data() + newest * m_tailBins);
+    std::copy(pWindow + m_tailBlockSize, pWindow + 2 * m_tailBlockSize,
+              pWindow);
+    if (++m_tailDelayPosition >= m_tailSpectra) {
+        m_tailDelayPosition = 0;
+    }
+    if (m_tailBlocks < m_pKernel->tailPartitions()) {
+        ++m_tailBlocks;
+    }
+
+    if (++m_tailSlot >= kTailSlots) {
+        m_tailSlot = 0;
+    }
+    m_tailBlockNewest[m_tailSlot] = newest;
+    m_tailBlockPartitions[m_tailSlot] = m_tailBlocks;
+    m_tailBlockPosted[m_tailSlot] = false;
+    if (!m_pWorker) {
+        return;
+    }
+
+    // If the worker still has the slot, it is far behind and process()
+    // computes the block itself.
+    TailSlot& slot = m_tailSlots[m_tailSlot];
+    if (slot.state.testAndSetAcquire(TAIL_FREE, TAIL_FREE) ||
+            slot.state.testAndSetAcquire(TAIL_DONE, TAIL_FREE)) {
+        slot.newest = newest;
+        slot.partitions = m_tailBlocks;
+        slot.state.fetchAndStoreRelease(TAIL_PENDING);
+        m_tailBlockPosted[m_tailSlot] = true;
+        m_pWorker->schedule();
+    }
+}
+
+const float* PartitionedConvolver::takeTailBlock() {
+    if (m_tailBlockPosted[m_tailSlot]) {
+        TailSlot& slot = m_tailSlots[m_tailSlot];
+        // Only the worker changes the state meanwhile, from pending to
+        // running to done, so this takes a few rounds at most.
+        while (true) {
+            if (slot.state.testAndSetAcquire(TAIL_DONE, TAIL_DONE)) {
+                return slot.output.constData();
+            }
+            if (slot.state.testAndSetOrdered(TAIL_PENDING, TAIL_FREE) ||
+                    slot.state.testAndSetOrdered(TAIL_RUNNING,
+                                                 TAIL_ABORTED)) {
+                break;
+            }
+        }
+    }
+    if (m_pWorker) {
+        ++m_lateTailBlocks;
+    }
+    convolveTail(&m_engineWorkspace, m_tailBlockNewest[m_tailSlot],
+                 m_tailBlockPartitions[m_tailSlot], NULL, m_lateOutput.data());
+    return m_lateOutput.constData();
+}
+
+bool PartitionedConvolver::convolveTail(TailWorkspace* pWorkspace,
+                                        int newest, int partitions,
+                                        QAtomicInt* pAbort, float* pOutput) {
+    pWorkspace->sumRe.fill(0.0f);
+    pWorkspace->sumIm.fill(0.0f);
+    int spectrum = newest;
+    for (int i = 0; i < partitions; ++i) {
+        if (pAbort && pAbort->testAndSetAcquire(TAIL_ABORTED, TAIL_ABORTED)) {
+            return false;
+        }
+        multiplyAccumulate(m_tailDelayRe.constData() + spectrum * m_tailBins,
+                           m_tailDelayIm.constData() + spectrum * m_tailBins,
+                           m_pKernel->tailRe(i), m_pKernel->tailIm(i),
+                           pWorkspace->sumRe.data(), pWorkspace->sumIm.data(),
+                           m_tailBins);
+        spectrum = spectrum > 0 ? spectrum - 1 : m_tailSpectra - 1;
+    }
+
+    pWorkspace->fft.inverse(pWorkspace->sumRe.constData(),
+                            pWorkspace->sumIm.constData(),
+                            pWorkspace->result.data());
+    std::copy(pWorkspace->result.constData() + m_tailBlockSize,
+              pWorkspace->result.constData() + 2 * m_tailBlockSize, pOutput);
+    return true;
+}
+
+// static
+void PartitionedConvolver::multiplyAccumulate(
+        const float* _RESTRICT pXRe, const float* _RESTRICT pXIm,
+        const float* _RESTRICT pHRe, const float* _RESTRICT pHIm,
+        float* _RESTRICT pYRe, float* _RESTRICT pYIm, int bins) {
+    // Separate real and imaginary arrays let the compiler vectorize this.
+    for (int i = 0; i < bins; ++i) {
+        pYRe[i] += pXRe[i] * pHRe[i] - pXIm[i] * pHIm[i];
+        pYIm[i] += pXRe[i] * pHIm[i] + pXIm[i] * pHRe[i];
+    }
+}
@@ -0,0 +1,224 @@
+#ifndef PARTITIONEDCONVOLVER_H
+#define PARTITIONEDCONVOLVER_H
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "util.h"
+#include "util/fft.h"
+#include "util/types.h"
+
+class ConvolutionWorker;
+
+// The spectra of an impulse response, cut into the partitions a
+// PartitionedConvolver works with. The head, the first 2 * tailBlockSize
+// samples, is cut into partitions of headBlockSize samples, the rest into
+// partitions of tailBlockSize samples. A kernel is immutable after
+// construction, so all convolvers of the same impulse response share one.
+class ConvolutionKernel {
+  public:
+    // Both block sizes must be powers of 2 and tailBlockSize a multiple of
+    // headBlockSize.
+    ConvolutionKernel(const float* pImpulse, int length,
+                      int headBlockSize, int tailBlockSize);
+    virtual ~ConvolutionKernel();
+
+    int length() const {
+        return m_length;
+    }
+    int headBlockSize() const {
+        return m_headBlockSize;
+    }
+    int tailBlockSize() const {
+        return m_tailBlockSize;
+    }
+    int headPartitions() const {
+        return m_headPartitions;
+    }
+    int tailPartitions() const {
+        return m_tailPartitions;
+    }
+
+    // The spectrum of a partition has blockSize + 1 bins. The spectra are
+    // normalized for the unnormalized RealFFT::inverse().
+    const float* headRe(int partition) const {
+        return m_headRe.constData() + partition * (m_headBlockSize + 1);
+    }
+    const float* headIm(int partition) const {
+        return m_headIm.constData() + partition * (m_headBlockSize + 1);
+    }
+    const float* tailRe(int partition) const {
+        return m_tailRe.constData() + partition * (m_tailBlockSize + 1);
+    }
+    const float* tailIm(int partition) const {
+        return m_tailIm.constData() + partition * (m_tailBlockSize + 1);
+    }
+
+  private:
+    static int partition(const float* pImpulse, int length, int blockSize,
+                         QVector<float>* pRe, QVector<float>* pIm);
+
+    const int m_length;
+    const int m_headBlockSize;
+    const int m_tailBlockSize;
+    int m_headPartitions;
+    int m_tailPartitions;
+    QVector<float> m_headRe;
+    QVector<float> m_headIm;
+    QVector<float> m_tailRe;
+    QVector<float> m_tailIm;
+
+    DISALLOW_COPY_AND_ASSIGN(ConvolutionKernel);
+};
+
+// Convolves a signal with a ConvolutionKernel by uniformly partitioned FFT
+// convolution with frequency domain delay lines, in two stages. The head of
+// the kernel is convolved in blocks of headBlockSize frames by process(),
+// so the output is delayed by only headBlockSize frames. The tail is
+// convolved in blocks of tailBlockSize frames. process() adds the spectrum
+// of each completed tail block to the delay line and hands the expensive
+// part, the sum over all partitions, to a ConvolutionWorker. The result is
+// not needed before another tailBlockSize frames have been processed. If
+// the worker is not done by then, process() computes the block itself and
+// drops the result of the worker, it never waits for it.
+//
+// process() must only be called from one thread, usually the engine thread.
+class PartitionedConvolver {
+  public:
+    // Without a worker, the tail blocks are computed by process().
+    PartitionedConvolver(QSharedPointer<const ConvolutionKernel> pKernel,
+                         QSharedPointer<ConvolutionWorker> pWorker);
+    virtual ~PartitionedConvolver();
+
+    // Convolves numFrames frames of pInput into pOutput. The frames of both
+    // are stride samples apart, e.g. 2 for a channel of a stereo buffer.
+    void process(const CSAMPLE* pInput, CSAMPLE* pOutput,
+                 int numFrames, int stride);
+
+    // Forgets the input so far. Real-time safe, the tail delay line is not
+    // cleared, the tail blocks after a reset ignore the older spectra.
+    void reset();
+
+    // The number of tail blocks that process() had to compute itself
+    // because the worker was late.
+    int lateTailBlocks() const {
+        return m_lateTailBlocks;
+    }
+
+    // Computes the pending tail blocks. Called by the worker.
+    void runPendingTailBlocks();
+
+  private:
+    enum TailState {
+        TAIL_FREE = 0,
+        TAIL_PENDING,
+        TAIL_RUNNING,
+        // process() gave up on a running block, the worker drops it.
+        TAIL_ABORTED,
+        TAIL_DONE
+    };
+
+    // Enough slots that a late worker does not hold up the next blocks.
+    static const int kTailSlots = 3;
+    // Spectra the delay line keeps beyond the partitions of the kernel, so
+    // process() does not overwrite the ones a late worker still reads
+    // unless it is this many tail blocks late.
+    static const int kSpareSpectra = 8;
+
+    // The buffers for summing up a tail block, one set for the worker and
+    // one for process().
+    struct TailWorkspace {
+        explicit TailWorkspace(int blockSize);
+        RealFFT fft;
+        QVector<float> sumRe;
+        QVector<float> sumIm;
+        QVector<float> result;
+    };
+
+    // A tail block handed to the worker. The fields are written by
+    // process() before the state becomes TAIL_PENDING.
+    struct TailSlot {
+        TailSlot();
+        QAtomicInt state;
+        // The delay line position of the newest spectrum.
+        int newest;
+        // The number of partitions to sum up, fewer after a reset.
+        int partitions;
+        QVector<float> output;
+    };
+
+    // Convolves m_input into m_output.
+    void processBlock();
+    // Adds the spectrum of the completed tail block to the delay line and
+    // posts it to the worker.
+    void postTailBlock();
+    // Returns the output of the tail block posted before the last one.
+    const float* takeTailBlock();
+    // Runs the block of a slot the worker has claimed.
+    void runTailBlock(TailSlot* pSlot);
+    // Sums up a tail block into pOutput. Returns false if pAbort became
+    // TAIL_ABORTED on the way.
+    bool convolveTail(TailWorkspace* pWorkspace, int newest, int partitions,
+                      QAtomicInt* pAbort, float* pOutput);
+
+    static void multiplyAccumulate(const float* pXRe, const float* pXIm,
+                                   const float* pHRe, const float* pHIm,
+                                   float* pYRe, float* pYIm, int bins);
+
+    const QSharedPointer<const ConvolutionKernel> m_pKernel;
+    const QSharedPointer<ConvolutionWorker> m_pWorker;
+    const int m_headBlockSize;
+    const int m_tailBlockSize;
+    const int m_headBins;
+    const int m_tailBins;
+
+    // One block of input and the output of the previous block.
+    QVector<float> m_input;
+    QVector<float> m_output;
+    int m_blockPosition;
+
+    // The head stage, the previous and the current block of input, the
+    // delay line of their spectra and the accumulated output spectrum.
+    RealFFT m_headFft;
+    QVector<float> m_headWindow;
+    QVector<float> m_headDelayRe;
+    QVector<float> m_headDelayIm;
+    int m_headDelayPosition;
+    QVector<float> m_headSumRe;
+    QVector<float> m_headSumIm;
+    QVector<float> m_headResult;
+
+    // The tail stage. Written by process() only, the worker reads the
+    // delay line.
+    QVector<float> m_tailWindow;
+    QVector<float> m_tailDelayRe;
+    QVector<float> m_tailDelayIm;
+    int m_tailSpectra;
+    int m_tailDelayPosition;
+    int m_tailPosition;
+    // The tail blocks since the reset, up to the number of partitions.
+    int m_tailBlocks;
+    // The slot of the last tail block.
+    int m_tailSlot;
+    // What process() knows about the block of each slot, in case it has to
+    // compute it itself.
+    bool m_tailBlockPosted[kTailSlots];
+    int m_tailBlockNewest[kTailSlots];
+    int m_tailBlockPartitions[kTailSlots];
+    TailSlot m_tailSlots[kTailSlots];
+    // The tail output played in the current tail block, NULL for none.
+    const float* m_pTailOutput;
+    QVector<float> m_lateOutput;
+    TailWorkspace m_engineWorkspace;
+    int m_lateTailBlocks;
+
+    // Only touched by the worker.
+    TailWorkspace m_workerWorkspace;
+
+    friend class PartitionedConvolverTest;
+
+    DISALLOW_COPY_AND_ASSIGN(PartitionedConvolver);
+};
+
+#endif /* PARTITIONEDCONVOLVER_H */
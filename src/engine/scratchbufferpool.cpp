@@ -0,0 +1,40 @@
+#include "engine/scratchbufferpool.h"
+
+#include "sampleutil.h"
+#include "util/assert.h"
+
+ScratchBufferPool::ScratchBufferPool(int count, int bufferSize)
+        : m_bufferSize(bufferSize) {
+    m_buffers.reserve(count);
+    m_free.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        CSAMPLE* pBuffer = SampleUtil::alloc(bufferSize);
+        m_buffers.append(pBuffer);
+        m_free.append(pBuffer);
+    }
+}
+
+ScratchBufferPool::~ScratchBufferPool() {
+    DEBUG_ASSERT(m_free.size() == m_buffers.size());
+    foreach (CSAMPLE* pBuffer, m_buffers) {
+        SampleUtil::free(pBuffer);
+    }
+}
+
+CSAMPLE* ScratchBufferPool::acquire() {
+    if (m_free.isEmpty()) {
+        return NULL;
+    }
+    CSAMPLE* pBuffer = m_free.last();
+    m_free.removeLast();
+    return pBuffer;
+}
+
+void ScratchBufferPool::release(CSAMPLE* pBuffer) {
+    DEBUG_ASSERT_AND_HANDLE(m_buffers.contains(pBuffer) &&
+                            !m_free.contains(pBuffer)) {
+        return;
+    }
+    // Does not allocate, the capacity covers all buffers.
+    m_free.append(pBuffer);
+}
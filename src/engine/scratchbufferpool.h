@@ -0,0 +1,40 @@
+#ifndef SCRATCHBUFFERPOOL_H
+#define SCRATCHBUFFERPOOL_H
+
+#include <QVector>
+
+#include "util.h"
+#include "util/types.h"
+
+// A fixed set of sample buffers that the engine borrows for intermediate
+// results, e.g. the wet signal of an effect chain. All buffers are
+// allocated by the constructor, so acquire() and release() are real-time
+// safe. They must only be called from one thread, the engine thread.
+class ScratchBufferPool {
+  public:
+    ScratchBufferPool(int count, int bufferSize);
+    virtual ~ScratchBufferPool();
+
+    int bufferSize() const {
+        return m_bufferSize;
+    }
+
+    // The number of buffers that are not acquired.
+    int available() const {
+        return m_free.size();
+    }
+
+    // Returns a buffer with undefined content or NULL if all buffers are in
+    // use.
+    CSAMPLE* acquire();
+    void release(CSAMPLE* pBuffer);
+
+  private:
+    const int m_bufferSize;
+    QVector<CSAMPLE*> m_buffers;
+    QVector<CSAMPLE*> m_free;
+
+    DISALLOW_COPY_AND_ASSIGN(ScratchBufferPool);
+};
+
+#endif /* SCRATCHBUFFERPOOL_H */
@@ -124,6 +124,8 @@ void AnalysisFeature::analyzeTracks(QList<int> trackIds) {
                 this, SLOT(slotProgressUpdate(int)));
         connect(m_pAnalyserQueue, SIGNAL(trackFinished(int)),
                 m_pAnalysisView, SLOT(trackAnalysisFinished(int)));
+        connect(m_pAnalyserQueue, SIGNAL(trackDone(TrackPointer)),
+                m_pAnalysisView, SLOT(trackAnalysisDone(TrackPointer)));
 
         connect(m_pAnalyserQueue, SIGNAL(queueEmpty()),
                 this, SLOT(cleanupAnalyser()));
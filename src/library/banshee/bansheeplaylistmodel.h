@@ -20,6 +20,12 @@ class BansheePlaylistModel : public BaseSqlTableModel {
     void setTableModel(int playlistId);
 
     virtual TrackPointer getTrack(const QModelIndex& index) const;
+    // The tracks of this model are not in the library table until they are
+    // loaded with getTrack().
+    virtual int getLibraryTrackId(const QModelIndex& index) const {
+        Q_UNUSED(index);
+        return -1;
+    }
     virtual QString getTrackLocation(const QModelIndex& index) const;
     virtual bool isColumnInternal(int column);
 
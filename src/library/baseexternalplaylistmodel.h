@@ -23,6 +23,12 @@ class BaseExternalPlaylistModel : public BaseSqlTableModel {
     virtual ~BaseExternalPlaylistModel();
 
     virtual TrackPointer getTrack(const QModelIndex& index) const;
+    // The tracks of this model are not in the library table until they are
+    // loaded with getTrack().
+    virtual int getLibraryTrackId(const QModelIndex& index) const {
+        Q_UNUSED(index);
+        return -1;
+    }
     virtual bool isColumnInternal(int column);
     Qt::ItemFlags flags(const QModelIndex &index) const;
     void setPlaylist(QString path_name);
@@ -23,6 +23,12 @@ class BaseExternalTrackModel : public BaseSqlTableModel {
 
     virtual TrackModel::CapabilitiesFlags getCapabilities() const;
     TrackPointer getTrack(const QModelIndex& index) const;
+    // The tracks of this model are not in the library table until they are
+    // loaded with getTrack().
+    virtual int getLibraryTrackId(const QModelIndex& index) const {
+        Q_UNUSED(index);
+        return -1;
+    }
     virtual void trackLoaded(QString group, TrackPointer pTrack);
     virtual bool isColumnInternal(int column);
     Qt::ItemFlags flags(const QModelIndex &index) const;
@@ -7,6 +7,7 @@
 
 #include "library/basesqltablemodel.h"
 
+#include "library/coverartcache.h"
 #include "library/coverartdelegate.h"
 #include "library/stardelegate.h"
 #include "library/starrating.h"
@@ -20,6 +21,7 @@
 #include "util/time.h"
 #include "util/dnd.h"
 #include "util/assert.h"
+#include "util/math.h"
 
 static const bool sDebug = false;
 
@@ -29,6 +31,34 @@ static const bool sDebug = false;
 static const int kIdColumn = 0;
 static const int kMaxSortColumns = 3;
 
+namespace {
+
+// Orders row numbers by the order that select() determined for their rows.
+// Rows with order -1 are placed at the end.
+class RowOrderLessThan {
+  public:
+    explicit RowOrderLessThan(const QVector<int>& rowOrders)
+            : m_rowOrders(rowOrders) {
+    }
+
+    bool operator()(int left, int right) const {
+        const int leftOrder = m_rowOrders[left];
+        const int rightOrder = m_rowOrders[right];
+        // -1 is greater than anything
+        if (leftOrder == -1) {
+            return false;
+        } else if (rightOrder == -1) {
+            return true;
+        }
+        return leftOrder < rightOrder;
+    }
+
+  private:
+    const QVector<int>& m_rowOrders;
+};
+
+}  // anonymous namespace
+
 BaseSqlTableModel::BaseSqlTableModel(QObject* pParent,
                                      TrackCollection* pTrackCollection,
                                      const char* settingsNamespace)
@@ -39,6 +69,7 @@ BaseSqlTableModel::BaseSqlTableModel(QObject* pParent,
           m_database(pTrackCollection->getDatabase()),
           m_previewDeckGroup(PlayerManager::groupForPreviewDeck(0)),
           m_iPreviewDeckTrackId(-1),
+          m_keyNotationRevision(KeyUtils::notationRevision()),
           m_bInitialized(false),
           m_currentSearch(""),
           m_trackSourceSortColumn(kIdColumn),
@@ -223,93 +254,113 @@ void BaseSqlTableModel::select() {
     // Remove all the rows from the table. We wait to do this until after the
     // table query has succeeded. See Bug #1090888.
     // TODO(rryan) we could edit the table in place instead of clearing it?
-    if (!m_rowInfo.isEmpty()) {
-        beginRemoveRows(QModelIndex(), 0, m_rowInfo.size() - 1);
-        m_rowInfo.clear();
+    if (!m_rowTrackIds.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, m_rowTrackIds.size() - 1);
+        m_rowTrackIds.clear();
+        m_tableValues.clear();
+        m_displayValues.fill(QVector<QVariant>(), m_columnFormats.size());
         m_trackIdToRows.clear();
         endRemoveRows();
     }
-    // sqlite does not set size and m_rowInfo was just cleared
+    // sqlite does not set size and m_rowTrackIds was just cleared
     //if (sDebug) {
-    //    qDebug() << "Rows returned" << rows << m_rowInfo.size();
+    //    qDebug() << "Rows returned" << rows << m_rowTrackIds.size();
     //}
 
-    QVector<RowInfo> rowInfo;
+    const int numTableColumns = m_tableColumns.size();
+    QVector<int> rowTrackIds;
+    QVector<QVector<QVariant> > tableValues(numTableColumns);
     QSet<int> trackIds;
     while (query.next()) {
         int id = query.value(kIdColumn).toInt();
         trackIds.insert(id);
-
-        RowInfo thisRowInfo;
-        thisRowInfo.trackId = id;
-        // save rows where this currently track id is located
-        thisRowInfo.order = rowInfo.size();
-        // Get all the table columns and store them in the hash for this
-        // row-info section.
-
-        thisRowInfo.metadata.reserve(m_tableColumns.size());
-        for (int i = 0;  i < m_tableColumns.size(); ++i) {
-            thisRowInfo.metadata << query.value(i);
+        rowTrackIds.append(id);
+        for (int i = 0; i < numTableColumns; ++i) {
+            tableValues[i].append(query.value(i));
         }
-        rowInfo.push_back(thisRowInfo);
     }
+    const int numRowsReceived = rowTrackIds.size();
 
     if (sDebug) {
-        qDebug() << "Rows actually received:" << rowInfo.size();
+        qDebug() << "Rows actually received:" << numRowsReceived;
+    }
+
+    // The order of each received row. Rows are kept in the order they were
+    // received unless the track source sorts them.
+    QVector<int> rowOrders(numRowsReceived);
+    for (int i = 0; i < numRowsReceived; ++i) {
+        rowOrders[i] = i;
     }
 
     if (m_trackSource) {
         m_trackSource->filterAndSort(trackIds, m_currentSearch,
                                      m_currentSearchFilter,
                                      m_trackSourceOrderBy,
+                                     m_trackSourceSortColumns,
                                      m_trackSourceSortColumn,
                                      m_trackSourceSortOrder,
                                      &m_trackSortOrder);
 
         // Re-sort the track IDs since filterAndSort can change their order or mark
         // them for removal (by setting their row to -1).
-        for (QVector<RowInfo>::iterator it = rowInfo.begin();
-                it != rowInfo.end(); ++it) {
+        for (int i = 0; i < numRowsReceived; ++i) {
             // If the sort is not a track column then we will sort only to
             // separate removed tracks (order == -1) from present tracks (order ==
             // 0). Otherwise we sort by the order that filterAndSort returned to us.
+            const int trackId = rowTrackIds[i];
             if (m_trackSourceOrderBy.isEmpty()) {
-                it->order = m_trackSortOrder.contains(it->trackId) ? 0 : -1;
+                rowOrders[i] = m_trackSortOrder.contains(trackId) ? 0 : -1;
             } else {
-                it->order = m_trackSortOrder.value(it->trackId, -1);
+                rowOrders[i] = m_trackSortOrder.value(trackId, -1);
             }
         }
     }
 
-    // RowInfo::operator< sorts by the order field, except -1 is placed at the
-    // end so we can easily slice off rows that are no longer present. Stable
-    // sort is necessary because the tracks may be in pre-sorted order so we
-    // should not disturb that if we are only removing tracks.
-    qStableSort(rowInfo.begin(), rowInfo.end());
+    // Sort the row numbers instead of the rows. RowOrderLessThan sorts by the
+    // row order, except -1 is placed at the end so we can easily slice off
+    // rows that are no longer present. Stable sort is necessary because the
+    // tracks may be in pre-sorted order so we should not disturb that if we
+    // are only removing tracks.
+    QVector<int> sortedRows(numRowsReceived);
+    for (int i = 0; i < numRowsReceived; ++i) {
+        sortedRows[i] = i;
+    }
+    qStableSort(sortedRows.begin(), sortedRows.end(),
+                RowOrderLessThan(rowOrders));
 
-    m_trackIdToRows.clear();
-    for (int i = 0; i < rowInfo.size(); ++i) {
-        const RowInfo& row = rowInfo[i];
+    int numRows = 0;
+    while (numRows < numRowsReceived &&
+            rowOrders[sortedRows[numRows]] != -1) {
+        ++numRows;
+    }
 
-        if (row.order == -1) {
-            // We've reached the end of valid rows. Resize rowInfo to cut off
-            // this and all further elements.
-            rowInfo.resize(i);
-            break;
+    QVector<int> sortedTrackIds(numRows);
+    QVector<QVector<QVariant> > sortedTableValues(numTableColumns);
+    for (int column = 0; column < numTableColumns; ++column) {
+        sortedTableValues[column].resize(numRows);
+    }
+    m_trackIdToRows.clear();
+    for (int i = 0; i < numRows; ++i) {
+        const int receivedRow = sortedRows[i];
+        const int trackId = rowTrackIds[receivedRow];
+        sortedTrackIds[i] = trackId;
+        for (int column = 0; column < numTableColumns; ++column) {
+            sortedTableValues[column][i] = tableValues[column][receivedRow];
         }
-        QLinkedList<int>& rows = m_trackIdToRows[row.trackId];
+        QLinkedList<int>& rows = m_trackIdToRows[trackId];
         rows.push_back(i);
     }
 
     // We're done! Issue the update signals and replace the master maps.
-    if (!rowInfo.isEmpty()) {
-        beginInsertRows(QModelIndex(), 0, rowInfo.size() - 1);
-        m_rowInfo = rowInfo;
+    if (numRows > 0) {
+        beginInsertRows(QModelIndex(), 0, numRows - 1);
+        m_rowTrackIds = sortedTrackIds;
+        m_tableValues = sortedTableValues;
         endInsertRows();
     }
 
     int elapsed = time.elapsed();
-    qDebug() << this << "select() took" << elapsed << "ms" << rowInfo.size();
+    qDebug() << this << "select() took" << elapsed << "ms" << numRows;
 }
 
 void BaseSqlTableModel::setTable(const QString& tableName,
@@ -343,6 +394,7 @@ void BaseSqlTableModel::setTable(const QString& tableName,
 
     // Build a map from the column names to their indices, used by fieldIndex()
     m_tableColumnCache.setColumns(m_tableColumns);
+    initColumnFormats();
 
     initHeaderData();
 
@@ -423,6 +475,7 @@ void BaseSqlTableModel::setSort(int column, Qt::SortOrder order) {
 
     // reset the old order by clauses
     m_trackSourceOrderBy.clear();
+    m_trackSourceSortColumns.clear();
     m_tableOrderBy.clear();
     m_trackSourceSortColumn = 0;
     m_trackSourceSortOrder = Qt::AscendingOrder;
@@ -452,10 +505,14 @@ void BaseSqlTableModel::setSort(int column, Qt::SortOrder order) {
             QString sort_field;
             if (sc.m_column == kIdColumn) {
                 sort_field = m_trackSource->columnSortForFieldIndex(kIdColumn);
+                m_trackSourceSortColumns.append(
+                        TrackSortIndex::SortColumn(kIdColumn, sc.m_order));
             } else {
                 // + 1 to skip id column
                 int ccColumn = sc.m_column - m_tableColumns.size() + 1;
                 sort_field = m_trackSource->columnSortForFieldIndex(ccColumn);
+                m_trackSourceSortColumns.append(
+                        TrackSortIndex::SortColumn(ccColumn, sc.m_order));
                 if (i == 0) {
                     // first cycle: main sort criteria
                     m_trackSourceSortColumn = ccColumn;
@@ -484,7 +541,7 @@ void BaseSqlTableModel::sort(int column, Qt::SortOrder order) {
 }
 
 int BaseSqlTableModel::rowCount(const QModelIndex& parent) const {
-    int count = parent.isValid() ? 0 : m_rowInfo.size();
+    int count = parent.isValid() ? 0 : m_rowTrackIds.size();
     //qDebug() << "rowCount()" << parent << count;
     return count;
 }
@@ -548,6 +605,31 @@ QVariant BaseSqlTableModel::data(const QModelIndex& index, int role) const {
     int row = index.row();
     int column = index.column();
 
+    // Display values are formatted once and then kept until the row changes,
+    // so that painting the table does not format them again and again.
+    const ColumnFormat format = columnFormat(column);
+    if (role == Qt::DisplayRole && format != FORMAT_NONE &&
+            row >= 0 && row < m_rowTrackIds.size()) {
+        QVector<QVariant>& displayValues = m_displayValues[column];
+        if (format == FORMAT_KEY) {
+            const int keyNotationRevision = KeyUtils::notationRevision();
+            if (keyNotationRevision != m_keyNotationRevision) {
+                // Render the keys again with the new notation.
+                m_keyNotationRevision = keyNotationRevision;
+                displayValues.clear();
+            }
+        }
+        if (displayValues.size() != m_rowTrackIds.size()) {
+            displayValues.resize(m_rowTrackIds.size());
+        }
+        QVariant& displayValue = displayValues[row];
+        if (!displayValue.isValid()) {
+            displayValue = formatDisplayValue(
+                    row, format, getBaseValue(index, role), role);
+        }
+        return displayValue;
+    }
+
     // This value is the value in its most raw form. It was looked up either
     // from the SQL table or from the cached track layer.
     QVariant value = getBaseValue(index, role);
@@ -557,66 +639,7 @@ QVariant BaseSqlTableModel::data(const QModelIndex& index, int role) const {
     switch (role) {
         case Qt::ToolTipRole:
         case Qt::DisplayRole:
-            if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_DURATION)) {
-                int duration = value.toInt();
-                if (duration > 0) {
-                    value = Time::formatSeconds(duration, false);
-                } else {
-                    value = QString();
-                }
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_RATING)) {
-                if (qVariantCanConvert<int>(value))
-                    value = qVariantFromValue(StarRating(value.toInt()));
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_TIMESPLAYED)) {
-                if (qVariantCanConvert<int>(value))
-                    value =  QString("(%1)").arg(value.toInt());
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_PLAYED)) {
-                value = value.toBool();
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_DATETIMEADDED)) {
-                QDateTime gmtDate = value.toDateTime();
-                gmtDate.setTimeSpec(Qt::UTC);
-                value = gmtDate.toLocalTime();
-            } else if (column == fieldIndex(ColumnCache::COLUMN_PLAYLISTTRACKSTABLE_DATETIMEADDED)) {
-                QDateTime gmtDate = value.toDateTime();
-                gmtDate.setTimeSpec(Qt::UTC);
-                value = gmtDate.toLocalTime();
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_BPM_LOCK)) {
-                value = value.toBool();
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_YEAR)) {
-                if (Qt::DisplayRole == role) {
-                    value = Mixxx::TrackMetadata::formatCalendarYear(value.toString());
-                }
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_TRACKNUMBER)) {
-                int track_number = value.toInt();
-                if (track_number <= 0) {
-                    // clear invalid values
-                    value = QString();
-                }
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_BITRATE)) {
-                int bitrate = value.toInt();
-                if (bitrate <= 0) {
-                    // clear invalid values
-                    value = QString();
-                }
-            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_KEY)) {
-                // If we know the semantic key via the LIBRARYTABLE_KEY_ID
-                // column (as opposed to the string representation of the key
-                // currently stored in the DB) then lookup the key and render it
-                // using the user's selected notation.
-                int keyIdColumn = fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_KEY_ID);
-                if (keyIdColumn != -1) {
-                    mixxx::track::io::key::ChromaticKey key =
-                            KeyUtils::keyFromNumericValue(
-                                index.sibling(row, keyIdColumn).data().toInt());
-
-                    if (key != mixxx::track::io::key::INVALID) {
-                        // Render this key with the user-provided notation.
-                        value = KeyUtils::keyToString(key);
-                    }
-                }
-                // Otherwise, just use the column value.
-            }
-
+            value = formatDisplayValue(row, format, value, role);
             break;
         case Qt::EditRole:
             if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_BPM)) {
@@ -647,6 +670,107 @@ QVariant BaseSqlTableModel::data(const QModelIndex& index, int role) const {
     return value;
 }
 
+QVariant BaseSqlTableModel::formatDisplayValue(int row, ColumnFormat format,
+                                               const QVariant& value,
+                                               int role) const {
+    switch (format) {
+        case FORMAT_DURATION: {
+            int duration = value.toInt();
+            if (duration > 0) {
+                return Time::formatSeconds(duration, false);
+            }
+            return QString();
+        }
+        case FORMAT_RATING:
+            if (qVariantCanConvert<int>(value)) {
+                return qVariantFromValue(StarRating(value.toInt()));
+            }
+            break;
+        case FORMAT_TIMESPLAYED:
+            if (qVariantCanConvert<int>(value)) {
+                return QString("(%1)").arg(value.toInt());
+            }
+            break;
+        case FORMAT_BOOL:
+            return value.toBool();
+        case FORMAT_DATETIME: {
+            QDateTime gmtDate = value.toDateTime();
+            gmtDate.setTimeSpec(Qt::UTC);
+            return gmtDate.toLocalTime();
+        }
+        case FORMAT_YEAR:
+            if (Qt::DisplayRole == role) {
+                return Mixxx::TrackMetadata::formatCalendarYear(value.toString());
+            }
+            break;
+        case FORMAT_POSITIVE_INT:
+            if (value.toInt() <= 0) {
+                // clear invalid values
+                return QString();
+            }
+            break;
+        case FORMAT_KEY: {
+            // If we know the semantic key via the LIBRARYTABLE_KEY_ID
+            // column (as opposed to the string representation of the key
+            // currently stored in the DB) then lookup the key and render it
+            // using the user's selected notation.
+            int keyIdColumn = fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_KEY_ID);
+            if (keyIdColumn != -1) {
+                mixxx::track::io::key::ChromaticKey key =
+                        KeyUtils::keyFromNumericValue(
+                            getBaseValue(index(row, keyIdColumn)).toInt());
+
+                if (key != mixxx::track::io::key::INVALID) {
+                    // Render this key with the user-provided notation.
+                    return KeyUtils::keyToString(key);
+                }
+            }
+            // Otherwise, just use the column value.
+            break;
+        }
+        case FORMAT_NONE:
+            break;
+    }
+    return value;
+}
+
+void BaseSqlTableModel::initColumnFormats() {
+    m_columnFormats.fill(FORMAT_NONE, columnCount());
+    m_displayValues.fill(QVector<QVariant>(), m_columnFormats.size());
+
+    const struct {
+        ColumnCache::Column column;
+        ColumnFormat format;
+    } kColumnFormats[] = {
+        { ColumnCache::COLUMN_LIBRARYTABLE_DURATION, FORMAT_DURATION },
+        { ColumnCache::COLUMN_LIBRARYTABLE_RATING, FORMAT_RATING },
+        { ColumnCache::COLUMN_LIBRARYTABLE_TIMESPLAYED, FORMAT_TIMESPLAYED },
+        { ColumnCache::COLUMN_LIBRARYTABLE_PLAYED, FORMAT_BOOL },
+        { ColumnCache::COLUMN_LIBRARYTABLE_DATETIMEADDED, FORMAT_DATETIME },
+        { ColumnCache::COLUMN_PLAYLISTTRACKSTABLE_DATETIMEADDED, FORMAT_DATETIME },
+        { ColumnCache::COLUMN_LIBRARYTABLE_BPM_LOCK, FORMAT_BOOL },
+        { ColumnCache::COLUMN_LIBRARYTABLE_YEAR, FORMAT_YEAR },
+        { ColumnCache::COLUMN_LIBRARYTABLE_TRACKNUMBER, FORMAT_POSITIVE_INT },
+        { ColumnCache::COLUMN_LIBRARYTABLE_BITRATE, FORMAT_POSITIVE_INT },
+        { ColumnCache::COLUMN_LIBRARYTABLE_KEY, FORMAT_KEY },
+    };
+    for (size_t i = 0; i < sizeof(kColumnFormats) / sizeof(kColumnFormats[0]); ++i) {
+        int column = fieldIndex(kColumnFormats[i].column);
+        if (column >= 0 && column < m_columnFormats.size()) {
+            m_columnFormats[column] = kColumnFormats[i].format;
+        }
+    }
+}
+
+void BaseSqlTableModel::clearDisplayValues(int row) {
+    for (int column = 0; column < m_displayValues.size(); ++column) {
+        QVector<QVariant>& displayValues = m_displayValues[column];
+        if (row < displayValues.size()) {
+            displayValues[row] = QVariant();
+        }
+    }
+}
+
 bool BaseSqlTableModel::setData(
     const QModelIndex& index, const QVariant& value, int role) {
     if (!index.isValid())
@@ -672,12 +796,11 @@ bool BaseSqlTableModel::setData(
         return false;
     }
 
-    if (row < 0 || row >= m_rowInfo.size()) {
+    if (row < 0 || row >= m_rowTrackIds.size()) {
         return false;
     }
 
-    const RowInfo& rowInfo = m_rowInfo[row];
-    int trackId = rowInfo.trackId;
+    int trackId = m_rowTrackIds[row];
 
     // You can't set something in the table columns because we have no way of
     // persisting it.
@@ -767,13 +890,65 @@ int BaseSqlTableModel::getTrackId(const QModelIndex& index) const {
     if (!index.isValid()) {
         return -1;
     }
-    return index.sibling(index.row(), fieldIndex(m_idColumn)).data().toInt();
+    // The id column needs no formatting, skip data().
+    return getBaseValue(
+            index.sibling(index.row(), fieldIndex(m_idColumn))).toInt();
 }
 
 TrackPointer BaseSqlTableModel::getTrack(const QModelIndex& index) const {
     return m_trackDAO.getTrack(getTrackId(index));
 }
 
+int BaseSqlTableModel::getLibraryTrackId(const QModelIndex& index) const {
+    return getTrackId(index);
+}
+
+void BaseSqlTableModel::prefetchCovers(int firstVisibleRow,
+                                       int lastVisibleRow, int coverWidth) {
+    const int numRows = m_rowTrackIds.size();
+    if (firstVisibleRow < 0 || firstVisibleRow >= numRows ||
+            lastVisibleRow < firstVisibleRow || coverWidth <= 0) {
+        return;
+    }
+    lastVisibleRow = math_min(lastVisibleRow, numRows - 1);
+
+    CoverArtCache* pCache = CoverArtCache::instance();
+    const int sourceColumn = fieldIndex(
+            ColumnCache::COLUMN_LIBRARYTABLE_COVERART_SOURCE);
+    const int typeColumn = fieldIndex(
+            ColumnCache::COLUMN_LIBRARYTABLE_COVERART_TYPE);
+    const int locationColumn = fieldIndex(
+            ColumnCache::COLUMN_LIBRARYTABLE_COVERART_LOCATION);
+    const int hashColumn = fieldIndex(
+            ColumnCache::COLUMN_LIBRARYTABLE_COVERART_HASH);
+    const int trackLocationColumn = fieldIndex(TRACKLOCATIONSTABLE_LOCATION);
+    if (pCache == NULL || sourceColumn == -1 || typeColumn == -1 ||
+            locationColumn == -1 || hashColumn == -1) {
+        return;
+    }
+
+    // The covers of the page before and the page after the visible rows.
+    const int pageSize = lastVisibleRow - firstVisibleRow + 1;
+    const int firstRow = math_max(0, firstVisibleRow - pageSize);
+    const int lastRow = math_min(numRows - 1, lastVisibleRow + pageSize);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        // Same as CoverArtDelegate::paint(), which picks up the covers from
+        // the cache.
+        CoverInfo info;
+        info.type = static_cast<CoverInfo::Type>(
+                getBaseValue(index(row, typeColumn)).toInt());
+        if (info.type != CoverInfo::METADATA && info.type != CoverInfo::FILE) {
+            continue;
+        }
+        info.source = static_cast<CoverInfo::Source>(
+                getBaseValue(index(row, sourceColumn)).toInt());
+        info.coverLocation = getBaseValue(index(row, locationColumn)).toString();
+        info.hash = getBaseValue(index(row, hashColumn)).toUInt();
+        info.trackLocation = getBaseValue(index(row, trackLocationColumn)).toString();
+        pCache->requestCover(info, this, info.hash, coverWidth, false, false);
+    }
+}
+
 QString BaseSqlTableModel::getTrackLocation(const QModelIndex& index) const {
     if (!index.isValid()) {
         return "";
@@ -811,6 +986,7 @@ void BaseSqlTableModel::tracksChanged(QSet<int> trackIds) {
         QLinkedList<int> rows = getTrackRows(trackId);
         foreach (int row, rows) {
             //qDebug() << "Row in this result set was updated. Signalling update. track:" << trackId << "row:" << row;
+            clearDisplayValues(row);
             QModelIndex left = index(row, 0);
             QModelIndex right = index(row, numColumns);
             emit(dataChanged(left, right));
@@ -878,14 +1054,13 @@ QVariant BaseSqlTableModel::getBaseValue(
     int row = index.row();
     int column = index.column();
 
-    if (row < 0 || row >= m_rowInfo.size()) {
+    if (row < 0 || row >= m_rowTrackIds.size()) {
         return QVariant();
     }
 
     // TODO(rryan) check range on column
 
-    const RowInfo& rowInfo = m_rowInfo[row];
-    int trackId = rowInfo.trackId;
+    int trackId = m_rowTrackIds[row];
 
     // If the row info has the row-specific column, return that.
     if (column < m_tableColumns.size()) {
@@ -898,12 +1073,12 @@ QVariant BaseSqlTableModel::getBaseValue(
             return m_iPreviewDeckTrackId == trackId;
         }
 
-        const QVector<QVariant>& columns = rowInfo.metadata;
+        const QVariant& value = m_tableValues[column][row];
         if (sDebug) {
-            qDebug() << "Returning table-column value" << columns.at(column)
+            qDebug() << "Returning table-column value" << value
                      << "for column" << column << "role" << role;
         }
-        return columns[column];
+        return value;
     }
 
     // Otherwise, return the information from the track record cache for the
@@ -35,6 +35,9 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     // functions that can be implemented
     // function to reimplement for external libraries
     virtual TrackPointer getTrack(const QModelIndex& index) const;
+    virtual int getLibraryTrackId(const QModelIndex& index) const;
+    virtual void prefetchCovers(int firstVisibleRow, int lastVisibleRow,
+                                int coverWidth);
     // calls readWriteFlags() by default, reimplement this if the child calls
     // should be readOnly
     virtual Qt::ItemFlags flags(const QModelIndex &index) const;
@@ -114,22 +117,28 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     QString orderByClause() const;
     QSqlDatabase database() const;
 
-    struct RowInfo {
-        int trackId;
-        int order;
-        QVector<QVariant> metadata;
-
-        bool operator<(const RowInfo& other) const {
-            // -1 is greater than anything
-            if (order == -1) {
-                return false;
-            } else if (other.order == -1) {
-                return true;
-            }
-            return order < other.order;
-        }
+    // How data() formats the values of a column for display.
+    enum ColumnFormat {
+        FORMAT_NONE = 0,
+        FORMAT_DURATION,
+        FORMAT_RATING,
+        FORMAT_TIMESPLAYED,
+        FORMAT_BOOL,
+        FORMAT_DATETIME,
+        FORMAT_YEAR,
+        FORMAT_POSITIVE_INT,
+        FORMAT_KEY,
     };
 
+    void initColumnFormats();
+    ColumnFormat columnFormat(int column) const {
+        return column >= 0 && column < m_columnFormats.size() ?
+                m_columnFormats[column] : FORMAT_NONE;
+    }
+    QVariant formatDisplayValue(int row, ColumnFormat format,
+                                const QVariant& value, int role) const;
+    void clearDisplayValues(int row);
+
     class SortColumn {
       public:
         SortColumn(int column, Qt::SortOrder order)
@@ -140,7 +149,17 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
         Qt::SortOrder m_order;
     };
 
-    QVector<RowInfo> m_rowInfo;
+    // The rows of the result set are stored column by column, so that
+    // select() moves ints instead of whole rows when it sorts and filters
+    // them. m_tableValues[column][row] is the value of a table column.
+    QVector<int> m_rowTrackIds;
+    QVector<QVector<QVariant> > m_tableValues;
+    QVector<ColumnFormat> m_columnFormats;
+    // The formatted Qt::DisplayRole values of the columns that need
+    // formatting, m_displayValues[column][row]. Filled in by data() as rows
+    // are painted. A null QVariant has not been formatted yet.
+    mutable QVector<QVector<QVariant> > m_displayValues;
+    mutable int m_keyNotationRevision;
 
     QString m_tableName;
     QString m_idColumn;
@@ -157,6 +176,8 @@ class BaseSqlTableModel : public QAbstractTableModel, public TrackModel {
     QString m_currentSearchFilter;
     QVector<QHash<int, QVariant> > m_headerInfo;
     QString m_trackSourceOrderBy;
+    // The columns of m_trackSourceOrderBy.
+    QList<TrackSortIndex::SortColumn> m_trackSourceSortColumns;
     QString m_tableOrderBy;
     int m_trackSourceSortColumn;
     Qt::SortOrder m_trackSourceSortOrder;
@@ -13,6 +13,10 @@ namespace {
 
 const bool sDebug = false;
 
+// Updating more tracks than this at once sorts the columns of m_sortIndex
+// again instead of moving each track.
+const int kMaxIncrementalSortUpdates = 1000;
+
 }  // namespace
 
 BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
@@ -28,6 +32,7 @@ BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
           m_columnCache(columns),
           m_bIndexBuilt(false),
           m_bIsCaching(isCaching),
+          m_sortIndex(m_columnCache, m_trackInfo),
           m_trackDAO(pTrackCollection->getTrackDAO()),
           m_database(pTrackCollection->getDatabase()),
           m_pQueryParser(new SearchQueryParser(pTrackCollection->getDatabase())) {
@@ -46,6 +51,39 @@ BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
     for (int i = 0; i < m_searchColumns.size(); ++i) {
         m_searchColumnIndices[i] = m_columnCache.fieldIndex(m_searchColumns[i]);
     }
+
+    QStringList indexTextColumns;
+    indexTextColumns << LIBRARYTABLE_ARTIST
+                     << LIBRARYTABLE_ALBUMARTIST
+                     << LIBRARYTABLE_ALBUM
+                     << LIBRARYTABLE_TITLE
+                     << LIBRARYTABLE_GENRE
+                     << LIBRARYTABLE_COMPOSER
+                     << LIBRARYTABLE_GROUPING
+                     << LIBRARYTABLE_COMMENT
+                     << LIBRARYTABLE_LOCATION
+                     << LIBRARYTABLE_KEY;
+    foreach (const QString& column, indexTextColumns) {
+        int index = m_columnCache.fieldIndex(column);
+        if (index >= 0) {
+            m_searchIndex.addTextColumn(column, index);
+        }
+    }
+    // Year and track number are stored as text and compared as text by
+    // SQLite, so they are left to SQL.
+    QStringList indexNumericColumns;
+    indexNumericColumns << LIBRARYTABLE_BPM
+                        << LIBRARYTABLE_DURATION
+                        << LIBRARYTABLE_BITRATE
+                        << LIBRARYTABLE_TIMESPLAYED
+                        << LIBRARYTABLE_RATING
+                        << LIBRARYTABLE_KEY_ID;
+    foreach (const QString& column, indexNumericColumns) {
+        int index = m_columnCache.fieldIndex(column);
+        if (index >= 0) {
+            m_searchIndex.addNumericColumn(column, index);
+        }
+    }
 }
 
 BaseTrackCache::~BaseTrackCache() {
@@ -92,6 +130,8 @@ void BaseTrackCache::slotTracksRemoved(QSet<int> trackIds) {
     }
     foreach (int trackId, trackIds) {
         m_trackInfo.remove(trackId);
+        m_searchIndex.removeTrack(trackId);
+        m_sortIndex.removeTrack(trackId);
     }
 }
 
@@ -135,6 +175,10 @@ void BaseTrackCache::setSearchColumns(const QStringList& columns) {
     m_searchColumns = columns;
 }
 
+void BaseTrackCache::setFullTextTable(const QString& fullTextTable) {
+    m_pQueryParser->setFullTextTable(fullTextTable, m_idColumn);
+}
+
 TrackPointer BaseTrackCache::lookupCachedTrack(int trackId) const {
     // Only get the track from the TrackDAO if it's in the cache and marked as
     // dirty.
@@ -166,6 +210,8 @@ bool BaseTrackCache::updateIndexWithTrackpointer(TrackPointer pTrack) {
         for (int i = 0; i < numColumns; ++i) {
             getTrackValueForColumn(pTrack, i, record[i]);
         }
+        m_searchIndex.updateTrack(id, record);
+        m_sortIndex.updateTrack(id);
     }
     return true;
 }
@@ -203,6 +249,8 @@ bool BaseTrackCache::updateIndexWithQuery(const QString& queryString) {
         for (int i = 0; i < numColumns; ++i) {
             record[i] = query.value(i);
         }
+        m_searchIndex.updateTrack(id, record);
+        m_sortIndex.updateTrack(id);
     }
 
     qDebug() << this << "updateIndexWithQuery took" << timer.elapsed() << "ms";
@@ -225,6 +273,8 @@ void BaseTrackCache::buildIndex() {
     // clear the table, and keep track of what IDs we see, then delete the ones
     // we don't see.
     m_trackInfo.clear();
+    m_searchIndex.clear();
+    m_sortIndex.clear();
 
     if (!updateIndexWithQuery(queryString)) {
         qDebug() << "buildIndex failed!";
@@ -243,6 +293,9 @@ void BaseTrackCache::updateTracksInIndex(QSet<int> trackIds) {
     if (trackIds.size() == 0) {
         return;
     }
+    if (trackIds.size() > kMaxIncrementalSortUpdates) {
+        m_sortIndex.clear();
+    }
 
     QStringList idStrings;
     foreach (int trackId, trackIds) {
@@ -365,6 +418,7 @@ void BaseTrackCache::filterAndSort(const QSet<int>& trackIds,
                                    QString searchQuery,
                                    QString extraFilter,
                                    QString orderByClause,
+                                   const QList<TrackSortIndex::SortColumn>& sortColumns,
                                    const int sortColumn,
                                    Qt::SortOrder sortOrder,
                                    QHash<int, int>* trackToIndex) {
@@ -382,60 +436,33 @@ void BaseTrackCache::filterAndSort(const QSet<int>& trackIds,
         return;
     }
 
-    QStringList idStrings;
     // TODO(rryan) consider making this the data passed in and a separate
     // QVector for output
     QSet<int> dirtyTracks;
     foreach (int trackId, trackIds) {
-        idStrings << QVariant(trackId).toString();
         if (m_dirtyTracks.contains(trackId)) {
             dirtyTracks.insert(trackId);
         }
     }
 
-    std::unique_ptr<QueryNode> pQuery(parseQuery(
-        searchQuery, extraFilter, idStrings));
-
-    QString filter = pQuery->toSql();
-    if (!filter.isEmpty()) {
-        filter.prepend("WHERE ");
-    }
-
-    QString queryString = QString("SELECT %1 FROM %2 %3 %4")
-            .arg(m_idColumn, m_tableName, filter, orderByClause);
-
-    if (sDebug) {
-        qDebug() << this << "select() executing:" << queryString;
-    }
-
-    QSqlQuery query(m_database);
-    // This causes a memory savings since QSqlCachedResult (what QtSQLite uses)
-    // won't allocate a giant in-memory table that we won't use at all.
-    query.setForwardOnly(true);
-    query.prepare(queryString);
-
-    if (!query.exec()) {
-        LOG_FAILED_QUERY(query);
-    }
-
-    int idColumn = query.record().indexOf(m_idColumn);
-    int rows = query.size();
-
-    if (sDebug) {
-        qDebug() << "Rows returned:" << rows;
-    }
-
-    m_trackOrder.resize(0); // keeps alocated memory
-    trackToIndex->clear();
-    if (rows > 0) {
-        trackToIndex->reserve(rows);
-        m_trackOrder.reserve(rows);
+    // Searches within the searchable columns are evaluated in memory. Extra
+    // filters are arbitrary SQL and need the database.
+    std::unique_ptr<QueryNode> pQuery;
+    if (extraFilter.isEmpty()) {
+        pQuery = m_pQueryParser->parseQuery(searchQuery, m_searchColumns,
+                                            QString());
+        if (!filterWithSearchIndex(trackIds, *pQuery, orderByClause,
+                                   sortColumns, trackToIndex)) {
+            pQuery.reset();
+        }
     }
-
-    while (query.next()) {
-        int id = query.value(idColumn).toInt();
-        (*trackToIndex)[id] = m_trackOrder.size();
-        m_trackOrder.push_back(id);
+    if (!pQuery) {
+        QStringList idStrings;
+        foreach (int trackId, trackIds) {
+            idStrings << QVariant(trackId).toString();
+        }
+        pQuery = parseQuery(searchQuery, extraFilter, idStrings);
+        filterWithSqlQuery(*pQuery, orderByClause, trackToIndex);
     }
 
     // At this point, the original set of tracks have been divided into two
@@ -512,6 +539,106 @@ void BaseTrackCache::filterAndSort(const QSet<int>& trackIds,
     }
 }
 
+bool BaseTrackCache::filterWithSearchIndex(const QSet<int>& trackIds,
+                                           const QueryNode& query,
+                                           const QString& orderByClause,
+                                           const QList<TrackSortIndex::SortColumn>& sortColumns,
+                                           QHash<int, int>* trackToIndex) {
+    if (!orderByClause.isEmpty() && sortColumns.isEmpty()) {
+        // Only SQLite knows this order.
+        return false;
+    }
+    if (!m_searchIndex.evaluate(query, &m_searchMatches)) {
+        return false;
+    }
+
+    m_trackOrder.resize(0); // keeps alocated memory
+    trackToIndex->clear();
+
+    if (orderByClause.isEmpty()) {
+        // The caller does not use the order.
+        foreach (int trackId, trackIds) {
+            int row = m_searchIndex.row(trackId);
+            if (row < 0) {
+                return false;
+            }
+            if (m_searchMatches[row] == TrackSearchIndex::MATCH_TRUE) {
+                (*trackToIndex)[trackId] = m_trackOrder.size();
+                m_trackOrder.push_back(trackId);
+            }
+        }
+        return true;
+    }
+
+    foreach (int trackId, trackIds) {
+        if (m_searchIndex.row(trackId) < 0) {
+            // We have not been told about this track yet. Only SQLite knows
+            // whether it matches.
+            return false;
+        }
+    }
+
+    // Merge the matching tracks in the sorted order of the whole table.
+    const QVector<int>& sortedTrackIds = m_sortIndex.sortedTrackIds(sortColumns);
+    foreach (int trackId, sortedTrackIds) {
+        if (!trackIds.contains(trackId)) {
+            continue;
+        }
+        int row = m_searchIndex.row(trackId);
+        if (m_searchMatches[row] == TrackSearchIndex::MATCH_TRUE) {
+            (*trackToIndex)[trackId] = m_trackOrder.size();
+            m_trackOrder.push_back(trackId);
+        }
+    }
+    return true;
+}
+
+void BaseTrackCache::filterWithSqlQuery(const QueryNode& sqlQuery,
+                                        const QString& orderByClause,
+                                        QHash<int, int>* trackToIndex) {
+    QString filter = sqlQuery.toSql();
+    if (!filter.isEmpty()) {
+        filter.prepend("WHERE ");
+    }
+
+    QString queryString = QString("SELECT %1 FROM %2 %3 %4")
+            .arg(m_idColumn, m_tableName, filter, orderByClause);
+
+    if (sDebug) {
+        qDebug() << this << "select() executing:" << queryString;
+    }
+
+    QSqlQuery query(m_database);
+    // This causes a memory savings since QSqlCachedResult (what QtSQLite uses)
+    // won't allocate a giant in-memory table that we won't use at all.
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+    }
+
+    int idColumn = query.record().indexOf(m_idColumn);
+    int rows = query.size();
+
+    if (sDebug) {
+        qDebug() << "Rows returned:" << rows;
+    }
+
+    m_trackOrder.resize(0); // keeps alocated memory
+    trackToIndex->clear();
+    if (rows > 0) {
+        trackToIndex->reserve(rows);
+        m_trackOrder.reserve(rows);
+    }
+
+    while (query.next()) {
+        int id = query.value(idColumn).toInt();
+        (*trackToIndex)[id] = m_trackOrder.size();
+        m_trackOrder.push_back(id);
+    }
+}
+
 std::unique_ptr<QueryNode> BaseTrackCache::parseQuery(QString query, QString extraFilter,
                                       QStringList idStrings) const {
     QStringList queryFragments;
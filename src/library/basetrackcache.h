@@ -15,6 +15,8 @@
 
 #include "library/dao/trackdao.h"
 #include "library/columncache.h"
+#include "library/tracksearchindex.h"
+#include "library/tracksortindex.h"
 #include "trackinfoobject.h"
 #include "util.h"
 #include "util/memory.h"
@@ -56,6 +58,7 @@ class BaseTrackCache : public QObject {
     virtual void filterAndSort(const QSet<int>& trackIds,
                                QString query, QString extraFilter,
                                QString orderByClause,
+                               const QList<TrackSortIndex::SortColumn>& sortColumns,
                                const int sortColumn,
                                Qt::SortOrder sortOrder,
                                QHash<int, int>* trackToIndex);
@@ -63,6 +66,9 @@ class BaseTrackCache : public QObject {
     virtual void ensureCached(int trackId);
     virtual void ensureCached(QSet<int> trackIds);
     virtual void setSearchColumns(const QStringList& columns);
+    // Looks up words of searches in a full-text table of the database. Its
+    // document ids must be the track ids of this cache.
+    void setFullTextTable(const QString& fullTextTable);
 
   signals:
     void tracksChanged(QSet<int> trackIds);
@@ -86,6 +92,17 @@ class BaseTrackCache : public QObject {
 
     std::unique_ptr<QueryNode> parseQuery(QString query, QString extraFilter,
                           QStringList idStrings) const;
+    // Fills m_trackOrder and trackToIndex with the tracks that match pQuery
+    // using m_searchIndex, sorted with m_sortIndex. Returns false if the query
+    // can not be evaluated without SQL.
+    bool filterWithSearchIndex(const QSet<int>& trackIds,
+                               const QueryNode& query,
+                               const QString& orderByClause,
+                               const QList<TrackSortIndex::SortColumn>& sortColumns,
+                               QHash<int, int>* trackToIndex);
+    void filterWithSqlQuery(const QueryNode& query,
+                            const QString& orderByClause,
+                            QHash<int, int>* trackToIndex);
     int findSortInsertionPoint(TrackPointer pTrack,
                                const int sortColumn,
                                const Qt::SortOrder sortOrder,
@@ -113,12 +130,20 @@ class BaseTrackCache : public QObject {
     // Temporary storage for filterAndSort()
 
     QVector<int> m_trackOrder;
+    QVector<qint8> m_searchMatches;
+
+    // The searchable columns of m_trackInfo. Queries that only use these
+    // columns are evaluated without SQL.
+    TrackSearchIndex m_searchIndex;
 
     QSet<int> m_dirtyTracks;
 
     bool m_bIndexBuilt;
     bool m_bIsCaching;
     QHash<int, QVector<QVariant> > m_trackInfo;
+    // The track ids of m_trackInfo sorted by the columns that have been
+    // sorted by. Must be declared after m_trackInfo.
+    TrackSortIndex m_sortIndex;
     TrackDAO& m_trackDAO;
     QSqlDatabase m_database;
     SearchQueryParser* m_pQueryParser;
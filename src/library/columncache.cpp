@@ -89,4 +89,14 @@ void ColumnCache::setColumns(const QStringList& columns) {
     m_columnSortByIndex.insert(m_columnIndexByEnum[COLUMN_PLAYLISTTRACKSTABLE_LOCATION], sortNoCase);
     m_columnSortByIndex.insert(m_columnIndexByEnum[COLUMN_PLAYLISTTRACKSTABLE_ARTIST], sortNoCase);
     m_columnSortByIndex.insert(m_columnIndexByEnum[COLUMN_PLAYLISTTRACKSTABLE_TITLE], sortNoCase);
+
+    m_columnSortTypeByIndex.clear();
+    for (QMap<int, QString>::const_iterator it = m_columnSortByIndex.constBegin();
+            it != m_columnSortByIndex.constEnd(); ++it) {
+        if (it.value() == sortNoCase) {
+            m_columnSortTypeByIndex.insert(it.key(), SORT_NO_CASE);
+        } else if (it.value() == sortInt) {
+            m_columnSortTypeByIndex.insert(it.key(), SORT_INTEGER);
+        }
+    }
 }
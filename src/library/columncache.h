@@ -66,6 +66,16 @@ class ColumnCache {
         NUM_COLUMNS
     };
 
+    // The sort expression of a column, see columnSortForFieldIndex().
+    enum SortType {
+        // %1
+        SORT_VALUE = 0,
+        // lower(%1)
+        SORT_NO_CASE,
+        // cast(%1 as integer)
+        SORT_INTEGER
+    };
+
     ColumnCache() { }
     ColumnCache(const QStringList& columns) {
         setColumns(columns);
@@ -101,8 +111,13 @@ class ColumnCache {
         return format.arg(columnNameForFieldIndex(index));
     }
 
+    inline SortType columnSortTypeForFieldIndex(int index) const {
+        return m_columnSortTypeByIndex.value(index, SORT_VALUE);
+    }
+
     QStringList m_columnsByIndex;
     QMap<int, QString> m_columnSortByIndex;
+    QMap<int, SortType> m_columnSortTypeByIndex;
     QMap<QString, int> m_columnIndexByName;
     // A mapping from column enum to logical index.
     int m_columnIndexByEnum[NUM_COLUMNS];
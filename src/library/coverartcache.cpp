@@ -1,3 +1,5 @@
+#include <QDir>
+#include <QFileInfo>
 #include <QFutureWatcher>
 #include <QPixmapCache>
 #include <QStringBuilder>
@@ -11,8 +13,30 @@
 // their full size. If no width is specified, this is the maximum width cap.
 const int kMaxCoverWidth = 300;
 
+// The cap for covers that are requested with kFullSizeWidth.
+const int kMaxFullSizeCoverWidth = 1600;
+
 const bool sDebug = false;
 
+namespace {
+
+// The thumbnail store tells covers apart by the file they are read from. The
+// 16-bit hash only notices when that file has changed.
+QString diskCacheLocation(const CoverInfo& info) {
+    if (info.type == CoverInfo::METADATA) {
+        return info.trackLocation;
+    } else if (info.type == CoverInfo::FILE) {
+        if (info.trackLocation.isEmpty()) {
+            return info.coverLocation;
+        }
+        return QFileInfo(QFileInfo(info.trackLocation).dir(),
+                         info.coverLocation).filePath();
+    }
+    return QString();
+}
+
+}  // anonymous namespace
+
 CoverArtCache::CoverArtCache() {
     // The initial QPixmapCache limit is 10MB.
     // But it is not used just by the coverArt stuff,
@@ -28,6 +52,12 @@ CoverArtCache::~CoverArtCache() {
     qDebug() << "~CoverArtCache()";
 }
 
+void CoverArtCache::setDiskCacheFile(const QString& packFilePath) {
+    m_pDiskCache.reset(new CoverArtDiskCache(packFilePath));
+    qDebug() << "CoverArtCache: thumbnail store" << packFilePath << "has"
+             << m_pDiskCache->count() << "covers";
+}
+
 QPixmap CoverArtCache::requestCover(const CoverInfo& requestInfo,
                                     const QObject* pRequestor,
                                     int requestReference,
@@ -71,6 +101,24 @@ QPixmap CoverArtCache::requestCover(const CoverInfo& requestInfo,
         return pixmap;
     }
 
+    // Loading a scaled cover from the thumbnail store is cheap enough to be
+    // done right away, even while scrolling through the library.
+    const QString location = diskCacheLocation(requestInfo);
+    if (m_pDiskCache && requestInfo.hash != 0 && !location.isEmpty() &&
+            m_pDiskCache->contains(location, requestInfo.hash, desiredWidth)) {
+        QImage image = m_pDiskCache->load(location, requestInfo.hash,
+                                          desiredWidth);
+        if (!image.isNull()) {
+            pixmap.convertFromImage(image);
+            QPixmapCache::insert(cacheKey, pixmap);
+            if (signalWhenDone) {
+                emit(coverFound(pRequestor, requestReference, requestInfo,
+                                pixmap, true));
+            }
+            return pixmap;
+        }
+    }
+
     if (onlyCached) {
         if (sDebug) {
             qDebug() << "CoverArtCache::requestCover cache miss";
@@ -105,10 +153,26 @@ CoverArtCache::FutureResult CoverArtCache::loadCover(
     res.cover.info = info;
     res.desiredWidth = desiredWidth;
     res.signalWhenDone = signalWhenDone;
-    res.cover.image = CoverArtUtils::loadCover(res.cover.info);
+    res.cover.image = loadCoverImage(info, desiredWidth);
+    return res;
+}
+
+QImage CoverArtCache::loadCoverImage(const CoverInfo& info,
+                                     const int desiredWidth) {
+    // A hash of 0 is the default of covers that have not been hashed.
+    const QString location = diskCacheLocation(info);
+    const bool useDiskCache = m_pDiskCache && info.hash != 0 &&
+            !location.isEmpty();
+    if (useDiskCache) {
+        QImage image = m_pDiskCache->load(location, info.hash, desiredWidth);
+        if (!image.isNull()) {
+            return image;
+        }
+    }
 
-    if (res.cover.image.isNull()) {
-        return res;
+    QImage image = CoverArtUtils::loadCover(info);
+    if (image.isNull()) {
+        return image;
     }
 
     // TODO(XXX) Should we re-hash here? If the cover file (or track metadata)
@@ -118,15 +182,18 @@ CoverArtCache::FutureResult CoverArtCache::loadCover(
 
     // Adjust the cover size according to the request or downsize the image for
     // efficiency.
-    if (res.desiredWidth > 0) {
-        res.cover.image = CoverArtUtils::resizeImage(res.cover.image,
-                                                     res.desiredWidth);
+    if (desiredWidth > 0) {
+        image = CoverArtUtils::resizeImage(image, desiredWidth);
+    } else if (desiredWidth == kFullSizeWidth) {
+        image = CoverArtUtils::maybeResizeImage(image, kMaxFullSizeCoverWidth);
     } else {
-        res.cover.image = CoverArtUtils::maybeResizeImage(res.cover.image,
-                                                          kMaxCoverWidth);
+        image = CoverArtUtils::maybeResizeImage(image, kMaxCoverWidth);
     }
 
-    return res;
+    if (useDiskCache) {
+        m_pDiskCache->save(location, info.hash, desiredWidth, image);
+    }
+    return image;
 }
 
 // watcher
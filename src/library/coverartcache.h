@@ -3,14 +3,25 @@
 
 #include <QObject>
 #include <QPixmap>
+#include <QScopedPointer>
 
 #include "library/coverart.h"
+#include "library/coverartdiskcache.h"
 #include "util/singleton.h"
 #include "trackinfoobject.h"
 
 class CoverArtCache : public QObject, public Singleton<CoverArtCache> {
     Q_OBJECT
   public:
+    // Requesting this width loads the cover in its original size, unless it
+    // is very large.
+    static const int kFullSizeWidth = -1;
+
+    // Keeps the scaled covers in a thumbnail store in packFilePath, so that
+    // they are loaded from there instead of the track or image file, also
+    // after a restart. Call this once before requesting covers.
+    void setDiskCacheFile(const QString& packFilePath);
+
     /* This method is used to request a cover art pixmap.
      *
      * @param pRequestor : an arbitrary pointer (can be any number you'd like,
@@ -21,7 +32,8 @@ class CoverArtCache : public QObject, public Singleton<CoverArtCache> {
      *      covers from the given 'coverLocation' and it will also NOT run the
      *      search algorithm.
      *      In this way, the method will just look into CoverCache and return
-     *      a Pixmap if it is already loaded in the QPixmapCache.
+     *      a Pixmap if it is already loaded in the QPixmapCache or stored in
+     *      the thumbnail store.
      *
      * TODO(rryan): Provide a QObject* and a SLOT to invoke directly. Why make
      * everyone filter the signals they receive?
@@ -39,6 +51,10 @@ class CoverArtCache : public QObject, public Singleton<CoverArtCache> {
     void requestGuessCovers(QList<TrackPointer> tracks);
     void requestGuessCover(TrackPointer pTrack);
 
+    // Loads the cover scaled to desiredWidth in the calling thread. Uses the
+    // thumbnail store if possible.
+    QImage loadCoverImage(const CoverInfo& info, const int desiredWidth);
+
     struct FutureResult {
         FutureResult() : pRequestor(NULL),
                          requestReference(0),
@@ -80,6 +96,7 @@ class CoverArtCache : public QObject, public Singleton<CoverArtCache> {
 
   private:
     QSet<QPair<const QObject*, int> > m_runningRequests;
+    QScopedPointer<CoverArtDiskCache> m_pDiskCache;
 };
 
 #endif // COVERARTCACHE_H
@@ -0,0 +1,263 @@
+#include <cstring>
+
+#include <QBuffer>
+#include <QMutexLocker>
+#include <QtDebug>
+#include <QtEndian>
+
+#include "library/coverartdiskcache.h"
+
+namespace {
+
+const char kPackFileMagic[4] = { 'M', 'X', 'C', 'A' };
+// Version 1 files keyed the covers on the hash alone and are started over.
+const quint32 kPackFileVersion = 2;
+const qint64 kHeaderSize = 8;
+const qint64 kRecordHeaderSize = 14;
+
+// JPEG keeps the pack file small. Covers with transparency are stored as PNG.
+const int kJpegQuality = 90;
+
+void writeRecordHeader(uchar* pHeader, quint16 hash, int width,
+                       quint32 locationSize, quint32 size) {
+    qToLittleEndian<quint16>(hash, pHeader);
+    qToLittleEndian<qint32>(width, pHeader + 2);
+    qToLittleEndian<quint32>(locationSize, pHeader + 6);
+    qToLittleEndian<quint32>(size, pHeader + 10);
+}
+
+}  // anonymous namespace
+
+// static
+const qint64 CoverArtDiskCache::kDefaultMaxFileSize = 256 * 1024 * 1024;
+
+CoverArtDiskCache::CoverArtDiskCache(const QString& packFilePath,
+                                     qint64 maxFileSize)
+        : m_file(packFilePath),
+          m_maxFileSize(maxFileSize),
+          m_bOpen(false),
+          m_pMapped(NULL),
+          m_mappedSize(0) {
+    QMutexLocker locker(&m_mutex);
+    m_bOpen = open();
+    if (!m_bOpen) {
+        qWarning() << "CoverArtDiskCache: could not open"
+                   << packFilePath << m_file.errorString();
+    }
+}
+
+CoverArtDiskCache::~CoverArtDiskCache() {
+    QMutexLocker locker(&m_mutex);
+    unmapFile();
+    m_file.close();
+}
+
+bool CoverArtDiskCache::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_bOpen;
+}
+
+int CoverArtDiskCache::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+bool CoverArtDiskCache::contains(const QString& location, quint16 hash,
+                                 int width) const {
+    QMutexLocker locker(&m_mutex);
+    QHash<Key, Entry>::const_iterator it =
+            m_entries.constFind(qMakePair(location, width));
+    return it != m_entries.constEnd() && it.value().hash == hash;
+}
+
+QImage CoverArtDiskCache::load(const QString& location, quint16 hash,
+                               int width) {
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<Key, Entry>::const_iterator it =
+                m_entries.constFind(qMakePair(location, width));
+        if (it == m_entries.constEnd() || it.value().hash != hash) {
+            return QImage();
+        }
+        const Entry& entry = it.value();
+        // Covers that were saved after the file has been mapped are not
+        // mapped yet.
+        if (entry.offset + entry.size > m_mappedSize && !mapFile()) {
+            return QImage();
+        }
+        // Copy the data so that the image is decoded without the lock.
+        data = QByteArray(reinterpret_cast<const char*>(m_pMapped + entry.offset),
+                          entry.size);
+    }
+    return QImage::fromData(data);
+}
+
+bool CoverArtDiskCache::save(const QString& location, quint16 hash, int width,
+                             const QImage& image) {
+    if (image.isNull()) {
+        return false;
+    }
+
+    // Encode the image without the lock.
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    const bool encoded = image.hasAlphaChannel() ?
+            image.save(&buffer, "PNG") :
+            image.save(&buffer, "JPG", kJpegQuality);
+    if (!encoded) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_bOpen) {
+        return false;
+    }
+    const Key key = qMakePair(location, width);
+    QHash<Key, Entry>::const_iterator it = m_entries.constFind(key);
+    if (it != m_entries.constEnd() && it.value().hash == hash) {
+        return true;
+    }
+    const QByteArray locationData = location.toUtf8();
+    const qint64 recordSize =
+            kRecordHeaderSize + locationData.size() + data.size();
+    if (kHeaderSize + recordSize > m_maxFileSize) {
+        // Would not even fit into an empty file.
+        return false;
+    }
+    if (m_file.size() + recordSize > m_maxFileSize) {
+        // Start over instead of refusing all new covers from now on. The
+        // dropped covers are saved again when they are shown next.
+        qDebug() << "CoverArtDiskCache: resetting full" << m_file.fileName();
+        m_bOpen = reset();
+        if (!m_bOpen) {
+            return false;
+        }
+    }
+    const qint64 offset = m_file.size();
+
+    uchar header[kRecordHeaderSize];
+    writeRecordHeader(header, hash, width, locationData.size(), data.size());
+    if (!m_file.seek(offset) ||
+            m_file.write(reinterpret_cast<const char*>(header),
+                         kRecordHeaderSize) != kRecordHeaderSize ||
+            m_file.write(locationData) != locationData.size() ||
+            m_file.write(data) != data.size() ||
+            !m_file.flush()) {
+        qWarning() << "CoverArtDiskCache: could not write"
+                   << m_file.fileName() << m_file.errorString();
+        // Drop what has been written of the record.
+        unmapFile();
+        m_file.resize(offset);
+        return false;
+    }
+
+    Entry entry;
+    entry.offset = offset + kRecordHeaderSize + locationData.size();
+    entry.size = data.size();
+    entry.hash = hash;
+    m_entries.insert(key, entry);
+    return true;
+}
+
+void CoverArtDiskCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    if (m_bOpen) {
+        m_bOpen = reset();
+    }
+}
+
+bool CoverArtDiskCache::open() {
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    if (m_file.size() > m_maxFileSize) {
+        qDebug() << "CoverArtDiskCache: resetting" << m_file.fileName()
+                 << "which has grown to" << m_file.size() << "bytes";
+        return reset();
+    }
+    if (m_file.size() < kHeaderSize) {
+        return reset();
+    }
+    if (!readIndex()) {
+        qWarning() << "CoverArtDiskCache: resetting invalid file"
+                   << m_file.fileName();
+        return reset();
+    }
+    return true;
+}
+
+bool CoverArtDiskCache::reset() {
+    unmapFile();
+    m_entries.clear();
+    uchar header[kHeaderSize];
+    memcpy(header, kPackFileMagic, sizeof(kPackFileMagic));
+    qToLittleEndian<quint32>(kPackFileVersion, header + sizeof(kPackFileMagic));
+    return m_file.resize(0) && m_file.seek(0) &&
+            m_file.write(reinterpret_cast<const char*>(header), kHeaderSize) ==
+                    kHeaderSize &&
+            m_file.flush();
+}
+
+bool CoverArtDiskCache::readIndex() {
+    if (!mapFile()) {
+        return false;
+    }
+    if (memcmp(m_pMapped, kPackFileMagic, sizeof(kPackFileMagic)) != 0 ||
+            qFromLittleEndian<quint32>(m_pMapped + sizeof(kPackFileMagic)) !=
+                    kPackFileVersion) {
+        return false;
+    }
+
+    qint64 offset = kHeaderSize;
+    while (offset + kRecordHeaderSize <= m_mappedSize) {
+        const uchar* pHeader = m_pMapped + offset;
+        const quint16 hash = qFromLittleEndian<quint16>(pHeader);
+        const int width = qFromLittleEndian<qint32>(pHeader + 2);
+        const quint32 locationSize = qFromLittleEndian<quint32>(pHeader + 6);
+        const quint32 size = qFromLittleEndian<quint32>(pHeader + 10);
+        const qint64 locationOffset = offset + kRecordHeaderSize;
+        if (locationOffset + locationSize + size > m_mappedSize) {
+            break;
+        }
+        const QString location = QString::fromUtf8(
+                reinterpret_cast<const char*>(m_pMapped + locationOffset),
+                locationSize);
+        Entry entry;
+        entry.offset = locationOffset + locationSize;
+        entry.size = size;
+        entry.hash = hash;
+        m_entries.insert(qMakePair(location, width), entry);
+        offset = entry.offset + size;
+    }
+
+    if (offset < m_mappedSize) {
+        qDebug() << "CoverArtDiskCache: dropping incomplete cover at the end of"
+                 << m_file.fileName();
+        unmapFile();
+        return m_file.resize(offset);
+    }
+    return true;
+}
+
+bool CoverArtDiskCache::mapFile() {
+    unmapFile();
+    const qint64 size = m_file.size();
+    m_pMapped = m_file.map(0, size);
+    if (m_pMapped == NULL) {
+        qWarning() << "CoverArtDiskCache: could not map"
+                   << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_mappedSize = size;
+    return true;
+}
+
+void CoverArtDiskCache::unmapFile() {
+    if (m_pMapped != NULL) {
+        m_file.unmap(m_pMapped);
+        m_pMapped = NULL;
+        m_mappedSize = 0;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef COVERARTDISKCACHE_H
+#define COVERARTDISKCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+#include "util.h"
+
+// A persistent store of scaled cover art, keyed by the location the cover was
+// read from and the width the cover was scaled to. The 16-bit cover hash that
+// is stored in the library is kept with each cover. It is far too narrow to
+// tell covers apart on its own, but a cover whose hash does not match anymore
+// has changed and is treated as missing. All covers are appended to a single
+// pack file that is memory-mapped for reading, so loading a thumbnail never
+// touches the audio file or the original image.
+//
+// The pack file starts with a header followed by records of
+//   hash (quint16), width (qint32), location size (quint32), size (quint32),
+//   location (UTF-8, location size bytes), encoded image (size bytes)
+// in little endian byte order. A later record for the same key replaces an
+// earlier one. A truncated record at the end of the file (e.g. after a crash)
+// is dropped when the file is opened.
+//
+// All methods are thread-safe.
+class CoverArtDiskCache {
+  public:
+    // When a cover does not fit into maxFileSize anymore, all covers are
+    // dropped and the pack file starts over.
+    CoverArtDiskCache(const QString& packFilePath,
+                      qint64 maxFileSize = kDefaultMaxFileSize);
+    virtual ~CoverArtDiskCache();
+
+    bool isOpen() const;
+    int count() const;
+    bool contains(const QString& location, quint16 hash, int width) const;
+
+    // Returns a null image if there is no cover for location and width or if
+    // the stored cover has a different hash.
+    QImage load(const QString& location, quint16 hash, int width);
+    // Returns false if the image could not be stored, e.g. because it is
+    // larger than the pack file may get.
+    bool save(const QString& location, quint16 hash, int width,
+              const QImage& image);
+    // Removes all covers.
+    void clear();
+
+    static const qint64 kDefaultMaxFileSize;
+
+  private:
+    typedef QPair<QString, int> Key;
+    struct Entry {
+        qint64 offset;
+        quint32 size;
+        quint16 hash;
+    };
+
+    bool open();
+    bool reset();
+    bool readIndex();
+    bool mapFile();
+    void unmapFile();
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    const qint64 m_maxFileSize;
+    bool m_bOpen;
+    uchar* m_pMapped;
+    qint64 m_mappedSize;
+    QHash<Key, Entry> m_entries;
+
+    DISALLOW_COPY_AND_ASSIGN(CoverArtDiskCache);
+};
+
+#endif /* COVERARTDISKCACHE_H */
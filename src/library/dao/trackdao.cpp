@@ -7,6 +7,8 @@
 #include <QRegExp>
 #include <QCoreApplication>
 #include <QChar>
+#include <QtConcurrentRun>
+#include <QFutureWatcher>
 
 #include "library/dao/trackdao.h"
 
@@ -25,6 +27,7 @@
 #include "library/dao/analysisdao.h"
 #include "library/dao/libraryhashdao.h"
 #include "library/coverartcache.h"
+#include "library/workerdatabase.h"
 #include "util/assert.h"
 #include "util/timer.h"
 #include "util/math.h"
@@ -34,6 +37,134 @@ QMutex TrackDAO::m_sTracksMutex;
 
 enum { UndefinedRecordIndex = -2 };
 
+namespace {
+
+// SQLite allows at most 999 parameters per statement by default, so the
+// multi-row statements of TrackDAO::addTracksAddBatch() are split.
+const int kMaxBatchParameters = 999;
+
+const char* kTrackLocationsInsertColumns[] = {
+    "location", "directory", "filename", "filesize", "fs_deleted",
+    "needs_verification"
+};
+const int kTrackLocationsInsertColumnCount =
+        sizeof(kTrackLocationsInsertColumns) / sizeof(kTrackLocationsInsertColumns[0]);
+
+const char* kLibraryInsertColumns[] = {
+    "artist", "title", "album", "album_artist", "year", "genre", "tracknumber",
+    "composer", "grouping", "filetype", "location", "comment", "url",
+    "duration", "rating", "key", "key_id", "bitrate", "samplerate", "cuepoint",
+    "bpm", "replaygain", "wavesummaryhex", "timesplayed", "channels",
+    "mixxx_deleted", "header_parsed", "beats_version", "beats_sub_version",
+    "beats", "bpm_lock", "keys_version", "keys_sub_version", "keys",
+    "coverart_source", "coverart_type", "coverart_location", "coverart_hash"
+};
+const int kLibraryInsertColumnCount =
+        sizeof(kLibraryInsertColumns) / sizeof(kLibraryInsertColumns[0]);
+
+// The number of values in one "WHERE column IN (...)" lookup.
+const int kSelectInValues = 500;
+
+QString placeholderSuffix(int row) {
+    return QString("_%1").arg(row);
+}
+
+// INSERT INTO table (column, ...) VALUES (:column_0, ...), (:column_1, ...)
+QString batchInsertStatement(const QString& table, const char** columns,
+                             int columnCount, int rows) {
+    QStringList columnNames;
+    for (int i = 0; i < columnCount; ++i) {
+        columnNames << columns[i];
+    }
+    QStringList values;
+    for (int row = 0; row < rows; ++row) {
+        QStringList placeholders;
+        foreach (const QString& column, columnNames) {
+            placeholders << ":" + column + placeholderSuffix(row);
+        }
+        values << "(" + placeholders.join(",") + ")";
+    }
+    return QString("INSERT INTO %1 (%2) VALUES %3").arg(
+            table, columnNames.join(","), values.join(","));
+}
+
+// Inserts count rows with as few multi-row INSERT statements as possible. The
+// statement for a full chunk of rows is prepared only once and kept in
+// *ppFullQuery. Calls bindRow(pQuery, row, placeholderSuffix) for every row
+// and chunkFailed(first, rows) for every chunk that could not be inserted.
+template <typename BindRow, typename ChunkFailed>
+void batchInsert(QSqlDatabase& database, QSqlQuery** ppFullQuery,
+                 const QString& table, const char** columns, int columnCount,
+                 int count, BindRow bindRow, ChunkFailed chunkFailed) {
+    const int chunkRows = kMaxBatchParameters / columnCount;
+    for (int first = 0; first < count; first += chunkRows) {
+        const int rows = math_min(chunkRows, count - first);
+        QSqlQuery partialQuery(database);
+        QSqlQuery* pQuery = &partialQuery;
+        if (rows == chunkRows) {
+            if (*ppFullQuery == NULL) {
+                *ppFullQuery = new QSqlQuery(database);
+                (*ppFullQuery)->prepare(batchInsertStatement(
+                        table, columns, columnCount, rows));
+            }
+            pQuery = *ppFullQuery;
+        } else {
+            partialQuery.prepare(batchInsertStatement(
+                    table, columns, columnCount, rows));
+        }
+        for (int row = 0; row < rows; ++row) {
+            bindRow(pQuery, first + row, placeholderSuffix(row));
+        }
+        if (!pQuery->exec()) {
+            LOG_FAILED_QUERY(*pQuery) << "Failed to insert" << rows
+                                      << "rows into" << table;
+            chunkFailed(first, rows);
+        }
+    }
+}
+
+// Runs the query, which has a "%1" for the list of values of an IN clause,
+// for all values. Calls rowCallback(query) for every result row.
+template <typename RowCallback>
+bool selectIn(QSqlDatabase& database, const QString& queryFormat,
+              const QList<QVariant>& values, RowCallback rowCallback) {
+    for (int first = 0; first < values.size(); first += kSelectInValues) {
+        const int count = math_min(kSelectInValues, values.size() - first);
+        QStringList placeholders;
+        for (int i = 0; i < count; ++i) {
+            placeholders << "?";
+        }
+        QSqlQuery query(database);
+        query.prepare(queryFormat.arg(placeholders.join(",")));
+        for (int i = 0; i < count; ++i) {
+            query.bindValue(i, values[first + i]);
+        }
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            return false;
+        }
+        while (query.next()) {
+            rowCallback(query);
+        }
+    }
+    return true;
+}
+
+// Moves a track that has been created in a worker thread to pThread, together
+// with its QObjects that are not children of the track.
+void moveTrackToThread(TrackPointer pTrack, QThread* pThread) {
+    foreach (Cue* pCue, pTrack->getCuePoints()) {
+        pCue->moveToThread(pThread);
+    }
+    QObject* pBeats = dynamic_cast<QObject*>(pTrack->getBeats().data());
+    if (pBeats != NULL) {
+        pBeats->moveToThread(pThread);
+    }
+    pTrack->moveToThread(pThread);
+}
+
+}  // anonymous namespace
+
 TrackCacheItem::TrackCacheItem(TrackPointer pTrack)
         : m_pTrack(pTrack) {
     DEBUG_ASSERT(m_pTrack);
@@ -83,6 +214,8 @@ TrackDAO::TrackDAO(QSqlDatabase& database,
           m_pQueryLibraryInsert(NULL),
           m_pQueryLibraryUpdate(NULL),
           m_pQueryLibrarySelect(NULL),
+          m_pQueryTrackLocationBatchInsert(NULL),
+          m_pQueryLibraryBatchInsert(NULL),
           m_pTransaction(NULL),
           m_trackLocationIdColumn(UndefinedRecordIndex),
           m_queryLibraryIdColumn(UndefinedRecordIndex),
@@ -332,6 +465,11 @@ void TrackDAO::databaseTrackAdded(TrackPointer pTrack) {
     emit(dbTrackAdded(pTrack));
 }
 
+void TrackDAO::databaseTracksAdded(QSet<int> trackIds) {
+    // results in a call of BaseTrackCache::updateTracksInIndex(trackIds);
+    emit(tracksAdded(trackIds));
+}
+
 void TrackDAO::databaseTracksMoved(QSet<int> tracksMovedSetOld, QSet<int> tracksMovedSetNew) {
     emit(tracksRemoved(tracksMovedSetNew));
     // results in a call of BaseTrackCache::updateTracksInIndex(trackIds);
@@ -363,57 +501,64 @@ void TrackDAO::slotTrackChanged(TrackInfoObject* pTrack) {
 }
 
 // No need to check here if the querys exist, this is already done in
-// addTracksAdd, which is the only function that calls this
-void TrackDAO::bindTrackToTrackLocationsInsert(TrackInfoObject* pTrack) {
-    // gets called only in addTracksAdd
-    m_pQueryTrackLocationInsert->bindValue(":location", pTrack->getLocation());
-    m_pQueryTrackLocationInsert->bindValue(":directory", pTrack->getDirectory());
-    m_pQueryTrackLocationInsert->bindValue(":filename", pTrack->getFilename());
-    m_pQueryTrackLocationInsert->bindValue(":filesize", pTrack->getLength());
+// addTracksAdd and addTracksAddBatch, which are the only functions that call
+// this
+void TrackDAO::bindTrackToTrackLocationsInsert(QSqlQuery* pQuery,
+                                               TrackInfoObject* pTrack,
+                                               const QString& placeholderSuffix) {
+    const QString& s = placeholderSuffix;
+    pQuery->bindValue(":location" + s, pTrack->getLocation());
+    pQuery->bindValue(":directory" + s, pTrack->getDirectory());
+    pQuery->bindValue(":filename" + s, pTrack->getFilename());
+    pQuery->bindValue(":filesize" + s, pTrack->getLength());
     // Should this check pTrack->exists()?
-    m_pQueryTrackLocationInsert->bindValue(":fs_deleted", 0);
-    m_pQueryTrackLocationInsert->bindValue(":needs_verification", 0);
+    pQuery->bindValue(":fs_deleted" + s, 0);
+    pQuery->bindValue(":needs_verification" + s, 0);
 }
 
 // No need to check here if the querys exist, this is already done in
-// addTracksAdd, which is the only function that calls this
-void TrackDAO::bindTrackToLibraryInsert(TrackInfoObject* pTrack, int trackLocationId) {
-    // gets called only in addTracksAdd
-    m_pQueryLibraryInsert->bindValue(":artist", pTrack->getArtist());
-    m_pQueryLibraryInsert->bindValue(":title", pTrack->getTitle());
-    m_pQueryLibraryInsert->bindValue(":album", pTrack->getAlbum());
-    m_pQueryLibraryInsert->bindValue(":album_artist", pTrack->getAlbumArtist());
-    m_pQueryLibraryInsert->bindValue(":year", pTrack->getYear());
-    m_pQueryLibraryInsert->bindValue(":genre", pTrack->getGenre());
-    m_pQueryLibraryInsert->bindValue(":composer", pTrack->getComposer());
-    m_pQueryLibraryInsert->bindValue(":grouping", pTrack->getGrouping());
-    m_pQueryLibraryInsert->bindValue(":tracknumber", pTrack->getTrackNumber());
-    m_pQueryLibraryInsert->bindValue(":filetype", pTrack->getType());
-    m_pQueryLibraryInsert->bindValue(":location", trackLocationId);
-    m_pQueryLibraryInsert->bindValue(":comment", pTrack->getComment());
-    m_pQueryLibraryInsert->bindValue(":url", pTrack->getURL());
-    m_pQueryLibraryInsert->bindValue(":duration", pTrack->getDuration());
-    m_pQueryLibraryInsert->bindValue(":rating", pTrack->getRating());
-    m_pQueryLibraryInsert->bindValue(":bitrate", pTrack->getBitrate());
-    m_pQueryLibraryInsert->bindValue(":samplerate", pTrack->getSampleRate());
-    m_pQueryLibraryInsert->bindValue(":cuepoint", pTrack->getCuePoint());
-    m_pQueryLibraryInsert->bindValue(":bpm_lock", pTrack->hasBpmLock()? 1 : 0);
-    m_pQueryLibraryInsert->bindValue(":replaygain", pTrack->getReplayGain());
+// addTracksAdd and addTracksAddBatch, which are the only functions that call
+// this
+void TrackDAO::bindTrackToLibraryInsert(QSqlQuery* pQuery,
+                                        TrackInfoObject* pTrack,
+                                        int trackLocationId,
+                                        const QString& placeholderSuffix) {
+    const QString& s = placeholderSuffix;
+    pQuery->bindValue(":artist" + s, pTrack->getArtist());
+    pQuery->bindValue(":title" + s, pTrack->getTitle());
+    pQuery->bindValue(":album" + s, pTrack->getAlbum());
+    pQuery->bindValue(":album_artist" + s, pTrack->getAlbumArtist());
+    pQuery->bindValue(":year" + s, pTrack->getYear());
+    pQuery->bindValue(":genre" + s, pTrack->getGenre());
+    pQuery->bindValue(":composer" + s, pTrack->getComposer());
+    pQuery->bindValue(":grouping" + s, pTrack->getGrouping());
+    pQuery->bindValue(":tracknumber" + s, pTrack->getTrackNumber());
+    pQuery->bindValue(":filetype" + s, pTrack->getType());
+    pQuery->bindValue(":location" + s, trackLocationId);
+    pQuery->bindValue(":comment" + s, pTrack->getComment());
+    pQuery->bindValue(":url" + s, pTrack->getURL());
+    pQuery->bindValue(":duration" + s, pTrack->getDuration());
+    pQuery->bindValue(":rating" + s, pTrack->getRating());
+    pQuery->bindValue(":bitrate" + s, pTrack->getBitrate());
+    pQuery->bindValue(":samplerate" + s, pTrack->getSampleRate());
+    pQuery->bindValue(":cuepoint" + s, pTrack->getCuePoint());
+    pQuery->bindValue(":bpm_lock" + s, pTrack->hasBpmLock()? 1 : 0);
+    pQuery->bindValue(":replaygain" + s, pTrack->getReplayGain());
 
     // We no longer store the wavesummary in the library table.
-    m_pQueryLibraryInsert->bindValue(":wavesummaryhex", QVariant(QVariant::ByteArray));
+    pQuery->bindValue(":wavesummaryhex" + s, QVariant(QVariant::ByteArray));
 
-    m_pQueryLibraryInsert->bindValue(":timesplayed", pTrack->getTimesPlayed());
+    pQuery->bindValue(":timesplayed" + s, pTrack->getTimesPlayed());
     //query.bindValue(":datetime_added", pTrack->getDateAdded());
-    m_pQueryLibraryInsert->bindValue(":channels", pTrack->getChannels());
-    m_pQueryLibraryInsert->bindValue(":mixxx_deleted", 0);
-    m_pQueryLibraryInsert->bindValue(":header_parsed", pTrack->getHeaderParsed() ? 1 : 0);
+    pQuery->bindValue(":channels" + s, pTrack->getChannels());
+    pQuery->bindValue(":mixxx_deleted" + s, 0);
+    pQuery->bindValue(":header_parsed" + s, pTrack->getHeaderParsed() ? 1 : 0);
 
     CoverInfo coverInfo = pTrack->getCoverInfo();
-    m_pQueryLibraryInsert->bindValue(":coverart_source", coverInfo.source);
-    m_pQueryLibraryInsert->bindValue(":coverart_type", coverInfo.type);
-    m_pQueryLibraryInsert->bindValue(":coverart_location", coverInfo.coverLocation);
-    m_pQueryLibraryInsert->bindValue(":coverart_hash", coverInfo.hash);
+    pQuery->bindValue(":coverart_source" + s, coverInfo.source);
+    pQuery->bindValue(":coverart_type" + s, coverInfo.type);
+    pQuery->bindValue(":coverart_location" + s, coverInfo.coverLocation);
+    pQuery->bindValue(":coverart_hash" + s, coverInfo.hash);
 
     const QByteArray* pBeatsBlob = NULL;
     QString beatsVersion = "";
@@ -429,10 +574,10 @@ void TrackDAO::bindTrackToLibraryInsert(TrackInfoObject* pTrack, int trackLocati
         dBpm = pBeats->getBpm();
     }
 
-    m_pQueryLibraryInsert->bindValue(":bpm", dBpm);
-    m_pQueryLibraryInsert->bindValue(":beats_version", beatsVersion);
-    m_pQueryLibraryInsert->bindValue(":beats_sub_version", beatsSubVersion);
-    m_pQueryLibraryInsert->bindValue(":beats", pBeatsBlob ? *pBeatsBlob : QVariant(QVariant::ByteArray));
+    pQuery->bindValue(":bpm" + s, dBpm);
+    pQuery->bindValue(":beats_version" + s, beatsVersion);
+    pQuery->bindValue(":beats_sub_version" + s, beatsSubVersion);
+    pQuery->bindValue(":beats" + s, pBeatsBlob ? *pBeatsBlob : QVariant(QVariant::ByteArray));
     delete pBeatsBlob;
 
     const Keys& keys = pTrack->getKeys();
@@ -451,12 +596,12 @@ void TrackDAO::bindTrackToLibraryInsert(TrackInfoObject* pTrack, int trackLocati
         keyText = pTrack->getKeyText();
     }
 
-    m_pQueryLibraryInsert->bindValue(
-        ":keys", pKeysBlob ? *pKeysBlob : QVariant(QVariant::ByteArray));
-    m_pQueryLibraryInsert->bindValue(":keys_version", keysVersion);
-    m_pQueryLibraryInsert->bindValue(":keys_sub_version", keysSubVersion);
-    m_pQueryLibraryInsert->bindValue(":key", keyText);
-    m_pQueryLibraryInsert->bindValue(":key_id", static_cast<int>(key));
+    pQuery->bindValue(
+        ":keys" + s, pKeysBlob ? *pKeysBlob : QVariant(QVariant::ByteArray));
+    pQuery->bindValue(":keys_version" + s, keysVersion);
+    pQuery->bindValue(":keys_sub_version" + s, keysSubVersion);
+    pQuery->bindValue(":key" + s, keyText);
+    pQuery->bindValue(":key_id" + s, static_cast<int>(key));
     delete pKeysBlob;
 }
 
@@ -521,12 +666,18 @@ void TrackDAO::addTracksFinish(bool rollback) {
     delete m_pQueryTrackLocationInsert;
     delete m_pQueryTrackLocationSelect;
     delete m_pQueryLibraryInsert;
+    delete m_pQueryLibraryUpdate;
     delete m_pQueryLibrarySelect;
+    delete m_pQueryTrackLocationBatchInsert;
+    delete m_pQueryLibraryBatchInsert;
     delete m_pTransaction;
     m_pQueryTrackLocationInsert = NULL;
     m_pQueryTrackLocationSelect = NULL;
     m_pQueryLibraryInsert = NULL;
+    m_pQueryLibraryUpdate = NULL;
     m_pQueryLibrarySelect = NULL;
+    m_pQueryTrackLocationBatchInsert = NULL;
+    m_pQueryLibraryBatchInsert = NULL;
     m_pTransaction = NULL;
 
     emit(tracksAdded(m_tracksAddedSet));
@@ -548,7 +699,7 @@ bool TrackDAO::addTracksAdd(TrackInfoObject* pTrack, bool unremove) {
     // Insert the track location into the corresponding table. This will fail
     // silently if the location is already in the table because it has a UNIQUE
     // constraint.
-    bindTrackToTrackLocationsInsert(pTrack);
+    bindTrackToTrackLocationsInsert(m_pQueryTrackLocationInsert, pTrack);
 
     if (!m_pQueryTrackLocationInsert->exec()) {
         LOG_FAILED_QUERY(*m_pQueryTrackLocationInsert)
@@ -620,7 +771,8 @@ bool TrackDAO::addTracksAdd(TrackInfoObject* pTrack, bool unremove) {
             return false;
         }
 
-        bindTrackToLibraryInsert(pTrack, trackLocationId);
+        bindTrackToLibraryInsert(m_pQueryLibraryInsert, pTrack,
+                                 trackLocationId);
 
         if (!m_pQueryLibraryInsert->exec()) {
             // We failed to insert the track. Maybe it is already in the library
@@ -640,6 +792,179 @@ bool TrackDAO::addTracksAdd(TrackInfoObject* pTrack, bool unremove) {
     return true;
 }
 
+QSet<int> TrackDAO::addTracksAddBatch(const QList<TrackInfoObject*>& tracks,
+                                      bool unremove) {
+    QSet<int> trackIdsAdded;
+    if (!m_pQueryLibraryInsert || !m_pQueryTrackLocationInsert ||
+        !m_pQueryLibrarySelect || !m_pQueryTrackLocationSelect) {
+        qDebug() << "TrackDAO::addTracksAddBatch: needed SqlQuerys have not "
+                    "been prepared. Adding no tracks";
+        return trackIdsAdded;
+    }
+
+    // Tracks with the same location as an earlier track in the batch are
+    // treated like tracks that are already in the library.
+    QHash<QString, TrackInfoObject*> tracksByLocation;
+    QList<TrackInfoObject*> duplicateTracks;
+    QList<QVariant> locations;
+    foreach (TrackInfoObject* pTrack, tracks) {
+        const QString location = pTrack->getLocation();
+        if (tracksByLocation.contains(location)) {
+            duplicateTracks.append(pTrack);
+        } else {
+            tracksByLocation.insert(location, pTrack);
+            locations.append(location);
+        }
+    }
+
+    // Skip the tracks that are already in the library, but set their ids and
+    // unremove them if requested.
+    QSet<QString> existingLocations;
+    QStringList trackIdsToUnremove;
+    selectIn(m_database,
+             "SELECT track_locations.location, library.id, "
+             "library.mixxx_deleted FROM track_locations "
+             "LEFT JOIN library ON library.location = track_locations.id "
+             "WHERE track_locations.location IN (%1)",
+             locations,
+             [&tracksByLocation, &existingLocations, &trackIdsToUnremove,
+              unremove](QSqlQuery& query) {
+        const QString location = query.value(0).toString();
+        TrackInfoObject* pTrack = tracksByLocation.value(location);
+        if (pTrack == NULL) {
+            return;
+        }
+        existingLocations.insert(location);
+        const int trackId = query.value(1).isNull() ? -1 : query.value(1).toInt();
+        if (unremove && trackId >= 0 && query.value(2).toBool()) {
+            trackIdsToUnremove.append(QString::number(trackId));
+        }
+        pTrack->setId(trackId);
+    });
+    if (!trackIdsToUnremove.isEmpty()) {
+        QSqlQuery query(m_database);
+        if (!query.exec(QString("UPDATE library SET mixxx_deleted=0 "
+                                "WHERE id in (%1)")
+                        .arg(trackIdsToUnremove.join(",")))) {
+            LOG_FAILED_QUERY(query) << "Failed to unremove existing tracks";
+        }
+    }
+
+    // Keep the order of the caller for the new tracks.
+    QList<TrackInfoObject*> newTracks;
+    foreach (TrackInfoObject* pTrack, tracks) {
+        const QString location = pTrack->getLocation();
+        if (tracksByLocation.value(location) == pTrack &&
+                !existingLocations.contains(location)) {
+            newTracks.append(pTrack);
+        }
+    }
+
+    // Insert the track locations. A chunk that fails is added track by track
+    // with the single-track path, which knows how to deal with each failure.
+    QVector<bool> locationInserted(newTracks.size(), true);
+    batchInsert(m_database, &m_pQueryTrackLocationBatchInsert,
+                "track_locations", kTrackLocationsInsertColumns,
+                kTrackLocationsInsertColumnCount, newTracks.size(),
+                [this, &newTracks](QSqlQuery* pQuery, int index,
+                                   const QString& suffix) {
+                    bindTrackToTrackLocationsInsert(
+                            pQuery, newTracks[index], suffix);
+                },
+                [this, &newTracks, &locationInserted, &trackIdsAdded, unremove](
+                        int first, int rows) {
+                    for (int i = first; i < first + rows; ++i) {
+                        locationInserted[i] = false;
+                        if (addTracksAdd(newTracks[i], unremove)) {
+                            trackIdsAdded.insert(newTracks[i]->getId());
+                        }
+                    }
+                });
+
+    QList<QVariant> insertedLocations;
+    for (int i = 0; i < newTracks.size(); ++i) {
+        if (locationInserted[i]) {
+            insertedLocations.append(newTracks[i]->getLocation());
+        }
+    }
+    QHash<QString, int> trackLocationIds;
+    selectIn(m_database,
+             "SELECT location, id FROM track_locations WHERE location IN (%1)",
+             insertedLocations,
+             [&trackLocationIds](QSqlQuery& query) {
+        trackLocationIds.insert(query.value(0).toString(),
+                                query.value(1).toInt());
+    });
+
+    QList<TrackInfoObject*> libraryTracks;
+    QList<QVariant> libraryLocationIds;
+    for (int i = 0; i < newTracks.size(); ++i) {
+        QHash<QString, int>::const_iterator it =
+                trackLocationIds.constFind(newTracks[i]->getLocation());
+        if (locationInserted[i] && it != trackLocationIds.constEnd()) {
+            libraryTracks.append(newTracks[i]);
+            libraryLocationIds.append(it.value());
+        }
+    }
+
+    // Insert the library rows. If a chunk fails, insert its rows one by one
+    // so that only the bad ones are skipped.
+    batchInsert(m_database, &m_pQueryLibraryBatchInsert,
+                "library", kLibraryInsertColumns, kLibraryInsertColumnCount,
+                libraryTracks.size(),
+                [this, &libraryTracks, &libraryLocationIds](
+                        QSqlQuery* pQuery, int index, const QString& suffix) {
+                    bindTrackToLibraryInsert(
+                            pQuery, libraryTracks[index],
+                            libraryLocationIds[index].toInt(), suffix);
+                },
+                [this, &libraryTracks, &libraryLocationIds](int first, int rows) {
+                    for (int i = first; i < first + rows; ++i) {
+                        bindTrackToLibraryInsert(
+                                m_pQueryLibraryInsert, libraryTracks[i],
+                                libraryLocationIds[i].toInt());
+                        if (!m_pQueryLibraryInsert->exec()) {
+                            LOG_FAILED_QUERY(*m_pQueryLibraryInsert)
+                                    << "Failed to INSERT new track into library:"
+                                    << libraryTracks[i]->getFilename();
+                        }
+                    }
+                });
+
+    QHash<int, int> trackIdsByLocationId;
+    selectIn(m_database,
+             "SELECT location, id FROM library WHERE location IN (%1)",
+             libraryLocationIds,
+             [&trackIdsByLocationId](QSqlQuery& query) {
+        trackIdsByLocationId.insert(query.value(0).toInt(),
+                                    query.value(1).toInt());
+    });
+
+    for (int i = 0; i < libraryTracks.size(); ++i) {
+        TrackInfoObject* pTrack = libraryTracks[i];
+        const int trackId = trackIdsByLocationId.value(
+                libraryLocationIds[i].toInt(), -1);
+        if (trackId < 0) {
+            continue;
+        }
+        pTrack->setId(trackId);
+        m_analysisDao.saveTrackAnalyses(pTrack);
+        // A new track has no cues in the database that would need to be
+        // deleted, so only tracks with cues need to be saved.
+        if (!pTrack->getCuePoints().isEmpty()) {
+            m_cueDao.saveTrackCues(trackId, pTrack);
+        }
+        pTrack->setDirty(false);
+        m_tracksAddedSet.insert(trackId);
+        trackIdsAdded.insert(trackId);
+    }
+
+    foreach (TrackInfoObject* pTrack, duplicateTracks) {
+        pTrack->setId(tracksByLocation.value(pTrack->getLocation())->getId());
+    }
+    return trackIdsAdded;
+}
+
 int TrackDAO::addTrack(const QFileInfo& fileInfo, bool unremove) {
     int trackId = -1;
     TrackInfoObject * pTrack = new TrackInfoObject(fileInfo);
@@ -742,19 +1067,14 @@ QList<int> TrackDAO::addTracks(const QList<QFileInfo>& fileInfoList,
         LOG_FAILED_QUERY(query);
     }
     const int addIndexColumn = query.record().indexOf("add_index");
-    const int locationColumn = query.record().indexOf("location");
+    QList<TrackInfoObject*> newTracks;
     while (query.next()) {
         int addIndex = query.value(addIndexColumn).toInt();
-        QString filePath = query.value(locationColumn).toString();
         const QFileInfo& fileInfo = fileInfoList.at(addIndex);
-        TrackInfoObject* pTrack = new TrackInfoObject(fileInfo);
-        addTracksAdd(pTrack, unremove);
-        int trackID = pTrack->getId();
-        if (trackID >= 0) {
-            trackIDs.append(trackID);
-        }
-        delete pTrack;
+        newTracks.append(new TrackInfoObject(fileInfo));
     }
+    addTracksAddBatch(newTracks, unremove);
+    qDeleteAll(newTracks);
 
     // Now that we have imported any tracks that were not already in the
     // library, clear trackIDs and re-select ordering by
@@ -1172,9 +1492,11 @@ struct ColumnPopulator {
 
 #define ARRAYLENGTH(x) (sizeof(x) / sizeof(*x))
 
-TrackPointer TrackDAO::getTrackFromDB(const int id) const {
-    ScopedTimer t("TrackDAO::getTrackFromDB");
-    QSqlQuery query(m_database);
+// static
+TrackPointer TrackDAO::loadTrackFromDB(QSqlDatabase& database,
+                                       const CueDAO& cueDao, const int id,
+                                       bool* pShouldDirty) {
+    QSqlQuery query(database);
 
     ColumnPopulator columns[] = {
         // Location must be first.
@@ -1280,12 +1602,38 @@ TrackPointer TrackDAO::getTrackFromDB(const int id) const {
     }
 
     // Populate track cues from the cues table.
-    pTrack->setCuePoints(m_cueDao.getCuesForTrack(id));
+    pTrack->setCuePoints(cueDao.getCuesForTrack(id));
 
     // Normally we will set the track as clean but sometimes when loading from
     // the database we need to perform upkeep that ought to be written back to
     // the database when the track is deleted.
     pTrack->setDirty(shouldDirty);
+    *pShouldDirty = shouldDirty;
+    return pTrack;
+}
+
+TrackPointer TrackDAO::getTrackFromDB(const int id) const {
+    ScopedTimer t("TrackDAO::getTrackFromDB");
+    bool shouldDirty = false;
+    TrackPointer pTrack = loadTrackFromDB(m_database, m_cueDao, id,
+                                          &shouldDirty);
+    if (!pTrack) {
+        return pTrack;
+    }
+    addTrackToCache(pTrack, shouldDirty);
+
+    // If the header hasn't been parsed, parse it but only after we set the
+    // track clean and hooked it up to the track cache, because this will
+    // dirty it.
+    if (!pTrack->getHeaderParsed()) {
+         pTrack->parse(false);
+    }
+
+    return pTrack;
+}
+
+void TrackDAO::addTrackToCache(TrackPointer pTrack, bool shouldDirty) const {
+    const int id = pTrack->getId();
 
     // Listen to dirty and changed signals
     connect(pTrack.data(), SIGNAL(dirty(TrackInfoObject*)),
@@ -1329,19 +1677,102 @@ TrackPointer TrackDAO::getTrackFromDB(const int id) const {
     if (shouldDirty) {
         emit(trackDirty(id));
     }
+}
 
-    // If the header hasn't been parsed, parse it but only after we set the
-    // track clean and hooked it up to the track cache, because this will
-    // dirty it.
-    if (!pTrack->getHeaderParsed()) {
-         pTrack->parse(false);
+TrackPointer TrackDAO::getTrack(const int id, const bool cacheOnly) const {
+    //qDebug() << "TrackDAO::getTrack" << QThread::currentThread() << m_database.connectionName();
+    TrackPointer pTrack = getCachedTrack(id);
+    if (pTrack) {
+        return pTrack;
+    } else if (cacheOnly) {
+        // The caller only wanted the track if it was cached.
+        //qDebug() << "TrackDAO::getTrack()" << id << "Caller wanted track but only if it was cached. Returning null.";
+        return TrackPointer();
     }
 
-    return pTrack;
+    // Otherwise, deserialize the track from the database.
+    return getTrackFromDB(id);
 }
 
-TrackPointer TrackDAO::getTrack(const int id, const bool cacheOnly) const {
-    //qDebug() << "TrackDAO::getTrack" << QThread::currentThread() << m_database.connectionName();
+TrackPointer TrackDAO::requestTrack(const int id) {
+    TrackPointer pTrack = getCachedTrack(id);
+    if (pTrack) {
+        return pTrack;
+    }
+    if (m_tracksLoading.contains(id)) {
+        return TrackPointer();
+    }
+    m_tracksLoading.insert(id);
+
+    QFutureWatcher<LoadTrackResult>* pWatcher =
+            new QFutureWatcher<LoadTrackResult>(this);
+    connect(pWatcher, SIGNAL(finished()),
+            this, SLOT(slotTrackLoadedInWorker()));
+    pWatcher->setFuture(QtConcurrent::run(
+            &TrackDAO::loadTrackInWorker, m_database.driverName(),
+            m_database.databaseName(), id, thread()));
+    return TrackPointer();
+}
+
+// static
+TrackDAO::LoadTrackResult TrackDAO::loadTrackInWorker(
+        const QString& driverName, const QString& databaseName, const int id,
+        QThread* pTargetThread) {
+    ScopedTimer t("TrackDAO::loadTrackInWorker");
+    LoadTrackResult result;
+    result.trackId = id;
+    result.shouldDirty = false;
+
+    QSqlDatabase database = workerThreadDatabase(driverName, databaseName);
+    if (!database.isOpen()) {
+        return result;
+    }
+
+    CueDAO cueDao(database);
+    TrackPointer pTrack = loadTrackFromDB(database, cueDao, id,
+                                          &result.shouldDirty);
+    if (!pTrack) {
+        return result;
+    }
+    // Parsing the header is what takes longest, so do it here. The track is
+    // not connected to the DAO yet, so the caller has to mark it dirty.
+    if (!pTrack->getHeaderParsed()) {
+        pTrack->parse(false);
+        result.shouldDirty = true;
+    }
+    // The track is dropped if it has been loaded by someone else in the
+    // meantime.
+    pTrack->setDeleteOnReferenceExpiration(true);
+    moveTrackToThread(pTrack, pTargetThread);
+    result.pTrack = pTrack;
+    return result;
+}
+
+void TrackDAO::slotTrackLoadedInWorker() {
+    QFutureWatcher<LoadTrackResult>* pWatcher =
+            static_cast<QFutureWatcher<LoadTrackResult>*>(sender());
+    LoadTrackResult result = pWatcher->result();
+    pWatcher->deleteLater();
+    m_tracksLoading.remove(result.trackId);
+
+    // Prefer the instance that is already in use, e.g. because getTrack()
+    // has been called for this track while it was loading.
+    TrackPointer pTrack = getCachedTrack(result.trackId);
+    if (!pTrack && result.pTrack) {
+        pTrack = result.pTrack;
+        pTrack->setDeleteOnReferenceExpiration(false);
+        addTrackToCache(pTrack, result.shouldDirty);
+    }
+    if (!pTrack) {
+        // Loading in the worker failed, e.g. because the database was locked.
+        qWarning() << "TrackDAO: loading track" << result.trackId
+                   << "in a worker thread failed, loading it now";
+        pTrack = getTrackFromDB(result.trackId);
+    }
+    emit(trackLoaded(result.trackId, pTrack));
+}
+
+TrackPointer TrackDAO::getCachedTrack(const int id) const {
     TrackPointer pTrack;
 
     // If the track cache contains the track ID, use it to get a strong
@@ -1388,15 +1819,8 @@ TrackPointer TrackDAO::getTrack(const int id, const bool cacheOnly) const {
                 Qt::QueuedConnection);
 
         m_recentTracksCache.insert(id, pCacheItem);
-        return pTrack;
-    } else if (cacheOnly) {
-        // The caller only wanted the track if it was cached.
-        //qDebug() << "TrackDAO::getTrack()" << id << "Caller wanted track but only if it was cached. Returning null.";
-        return TrackPointer();
     }
-
-    // Otherwise, deserialize the track from the database.
-    return getTrackFromDB(id);
+    return pTrack;
 }
 
 // Saves a track's info back to the database
@@ -1551,6 +1975,24 @@ void TrackDAO::invalidateTrackLocationsInLibrary() {
     }
 }
 
+void TrackDAO::invalidateTrackLocationsInDirectories(const QStringList& directories) {
+    //qDebug() << "TrackDAO::invalidateTrackLocationsInDirectories" << QThread::currentThread() << m_database.connectionName();
+
+    FieldEscaper escaper(m_database);
+    QStringList escapedDirectories = escaper.escapeStrings(directories);
+
+    QSqlQuery query(m_database);
+    query.prepare(
+        QString("UPDATE track_locations "
+                "SET needs_verification=1 "
+                "WHERE directory IN (%1)").arg(escapedDirectories.join(",")));
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query)
+                << "Couldn't mark tracks in" << directories.size()
+                << "directories as needing verification.";
+    }
+}
+
 void TrackDAO::markTrackLocationsAsVerified(const QStringList& locations) {
     //qDebug() << "TrackDAO::markTrackLocationsAsVerified" << QThread::currentThread() << m_database.connectionName();
 
@@ -65,6 +65,7 @@ const QString TRACKLOCATIONSTABLE_FILESIZE = "filesize";
 const QString TRACKLOCATIONSTABLE_FSDELETED = "fs_deleted";
 const QString TRACKLOCATIONSTABLE_NEEDSVERIFICATION = "needs_verification";
 
+class QThread;
 class ScopedTransaction;
 class PlaylistDAO;
 class AnalysisDao;
@@ -121,6 +122,13 @@ class TrackDAO : public QObject, public virtual DAO {
     int addTrack(const QFileInfo& fileInfo, bool unremove);
     void addTracksPrepare();
     bool addTracksAdd(TrackInfoObject* pTrack, bool unremove);
+    // Adds many tracks like addTracksAdd() but with a few multi-row
+    // statements per table instead of several statements per track. Must be
+    // called between addTracksPrepare() and addTracksFinish(). Returns the ids
+    // of the tracks that have been added. Tracks that are already in the
+    // library get their id set, but are not added.
+    QSet<int> addTracksAddBatch(const QList<TrackInfoObject*>& tracks,
+                                bool unremove);
     void addTracksFinish(bool rollback=false);
     QList<int> addTracks(const QList<QFileInfo>& fileInfoList, bool unremove);
     void hideTracks(const QList<int>& ids);
@@ -131,6 +139,12 @@ class TrackDAO : public QObject, public virtual DAO {
     // WARNING: Only call this from the main thread instance of TrackDAO.
     TrackPointer getTrack(const int id, const bool cacheOnly=false) const;
 
+    // Returns the track if it is cached. Otherwise returns a null pointer,
+    // reads the track from the database and parses its metadata in a worker
+    // thread and emits trackLoaded() once the track is ready.
+    // WARNING: Only call this from the main thread instance of TrackDAO.
+    TrackPointer requestTrack(const int id);
+
     // Fetches trackLocation from the database or adds it. If searchForCoverArt
     // is true, searches the track and its directory for cover art via
     // asynchronous request to CoverArtCache. If adding or fetching the track
@@ -148,6 +162,7 @@ class TrackDAO : public QObject, public virtual DAO {
     void markTrackLocationsAsVerified(const QStringList& locations);
     void markTracksInDirectoriesAsVerified(const QStringList& directories);
     void invalidateTrackLocationsInLibrary();
+    void invalidateTrackLocationsInDirectories(const QStringList& directories);
     void markUnverifiedTracksAsDeleted();
     void markTrackLocationsAsDeleted(const QString& directory);
     void detectMovedFiles(QSet<int>* tracksMovedSetNew, QSet<int>* tracksMovedSetOld);
@@ -162,6 +177,8 @@ class TrackDAO : public QObject, public virtual DAO {
     void tracksAdded(QSet<int> trackIds);
     void tracksRemoved(QSet<int> trackIds);
     void dbTrackAdded(TrackPointer pTrack);
+    // Emitted for every requestTrack() that did not return the track.
+    void trackLoaded(int trackId, TrackPointer pTrack);
     void progressVerifyTracksOutside(QString path);
     void progressCoverArt(QString file);
     void forceModelUpdate();
@@ -180,6 +197,7 @@ class TrackDAO : public QObject, public virtual DAO {
     void clearCache();
 
     void databaseTrackAdded(TrackPointer pTrack);
+    void databaseTracksAdded(QSet<int> trackIds);
     void databaseTracksMoved(QSet<int> tracksMovedSetOld, QSet<int> tracksMovedSetNew);
     void databaseTracksChanged(QSet<int> tracksChanged);
 
@@ -188,16 +206,42 @@ class TrackDAO : public QObject, public virtual DAO {
     void slotTrackChanged(TrackInfoObject* pTrack);
     void slotTrackClean(TrackInfoObject* pTrack);
     void slotTrackReferenceExpired(TrackInfoObject* pTrack);
+    void slotTrackLoadedInWorker();
 
   private:
+    struct LoadTrackResult {
+        int trackId;
+        TrackPointer pTrack;
+        bool shouldDirty;
+    };
     void saveTrack(TrackInfoObject* pTrack);
     void updateTrack(TrackInfoObject* pTrack);
     void addTrack(TrackInfoObject* pTrack, bool unremove);
     TrackPointer getTrackFromDB(const int id) const;
+    TrackPointer getCachedTrack(const int id) const;
+    // Adds a track that has been loaded from the database to the track caches
+    // and connects to its signals.
+    void addTrackToCache(TrackPointer pTrack, bool shouldDirty) const;
+    // Reads the track from the database without adding it to the track
+    // caches. Can be called from any thread with a connection of its own.
+    static TrackPointer loadTrackFromDB(QSqlDatabase& database,
+                                        const CueDAO& cueDao, const int id,
+                                        bool* pShouldDirty);
+    // Runs in a worker thread for requestTrack().
+    static LoadTrackResult loadTrackInWorker(const QString& driverName,
+                                             const QString& databaseName,
+                                             const int id,
+                                             QThread* pTargetThread);
     QString absoluteFilePath(QString location);
 
-    void bindTrackToTrackLocationsInsert(TrackInfoObject* pTrack);
-    void bindTrackToLibraryInsert(TrackInfoObject* pTrack, int trackLocationId);
+    // The placeholders of the query are the column names followed by
+    // placeholderSuffix.
+    void bindTrackToTrackLocationsInsert(QSqlQuery* pQuery,
+                                         TrackInfoObject* pTrack,
+                                         const QString& placeholderSuffix = QString());
+    void bindTrackToLibraryInsert(QSqlQuery* pQuery, TrackInfoObject* pTrack,
+                                  int trackLocationId,
+                                  const QString& placeholderSuffix = QString());
 
     void writeMetadataToFile(TrackInfoObject* pTrack);
 
@@ -226,12 +270,17 @@ class TrackDAO : public QObject, public virtual DAO {
     QSqlQuery* m_pQueryLibraryInsert;
     QSqlQuery* m_pQueryLibraryUpdate;
     QSqlQuery* m_pQueryLibrarySelect;
+    // Multi-row inserts of addTracksAddBatch().
+    QSqlQuery* m_pQueryTrackLocationBatchInsert;
+    QSqlQuery* m_pQueryLibraryBatchInsert;
     ScopedTransaction* m_pTransaction;
     int m_trackLocationIdColumn;
     int m_queryLibraryIdColumn;
     int m_queryLibraryMixxxDeletedColumn;
 
     QSet<int> m_tracksAddedSet;
+    // The tracks that are being loaded for requestTrack().
+    QSet<int> m_tracksLoading;
 
     DISALLOW_COPY_AND_ASSIGN(TrackDAO);
 };
@@ -88,6 +88,11 @@ MixxxLibraryFeature::MixxxLibraryFeature(Library* pLibrary,
 
     BaseTrackCache* pBaseTrackCache = new BaseTrackCache(
             pTrackCollection, tableName, LIBRARYTABLE_ID, columns, true);
+    // Schema revision 25 skips the full-text table if SQLite lacks FTS4,
+    // search keeps using LIKE then.
+    if (pTrackCollection->getDatabase().tables().contains("library_fts")) {
+        pBaseTrackCache->setFullTextTable("library_fts");
+    }
     connect(&m_trackDao, SIGNAL(trackDirty(int)),
             pBaseTrackCache, SLOT(slotTrackDirty(int)));
     connect(&m_trackDao, SIGNAL(trackClean(int)),
@@ -26,6 +26,7 @@ class ProxyTrackModel : public QSortFilterProxyModel, public TrackModel {
     virtual ~ProxyTrackModel();
 
     virtual TrackPointer getTrack(const QModelIndex& index) const;
+    virtual int getLibraryTrackId(const QModelIndex& index) const;
     virtual QString getTrackLocation(const QModelIndex& index) const;
     virtual int getTrackId(const QModelIndex& index) const;
     virtual const QLinkedList<int> getTrackRows(int trackId) const;
@@ -16,6 +16,7 @@
 ***************************************************************************/
 
 #include <QtDebug>
+#include <QDateTime>
 
 #include "library/scanner/libraryscanner.h"
 
@@ -25,15 +26,39 @@
 #include "library/scanner/libraryscannerdlg.h"
 #include "library/queryutil.h"
 #include "library/coverartutils.h"
+#include "library/dao/settingsdao.h"
 #include "library/trackcollection.h"
 #include "util/trace.h"
 #include "util/file.h"
 #include "util/timer.h"
+#include "util/math.h"
 #include "library/scanner/scannerutil.h"
 #include "upgrade.h"
 
+// Directories are hashed and the metadata of their files is read on one
+// thread per core.
 // TODO(rryan) make configurable
-const int kScannerThreadPoolSize = 1;
+const int kScannerThreadPoolSize = math_max(1, QThread::idealThreadCount());
+
+// The number of new tracks and directory hashes that are written to the
+// database in one transaction.
+const int kScannerWriteBatchSize = 250;
+
+// The number of scanned files between two progressFilesScanned() signals.
+const int kFilesScannedProgressInterval = 100;
+
+// Changed directories are scanned when no directory has changed for this
+// long.
+const int kChangedDirectoriesScanDelayMillis = 3000;
+
+// Every change of the library directories before this time, in milliseconds
+// since the epoch, has been scanned. Stored in the library database because
+// it belongs to its directory hashes.
+const QString kWatchedUntilKey = "mixxx.libraryscanner.watched_until";
+
+// Directories modified this long before the watched until time are scanned
+// as well, because some file systems store coarse modification times.
+const qint64 kWatchedUntilMarginMillis = 2000;
 
 LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collection)
               : m_pCollection(collection),
@@ -45,7 +70,9 @@ LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collecti
                 m_analysisDao(m_database, collection->getConfig()),
                 m_trackDao(m_database, m_cueDao, m_playlistDao,
                            m_crateDao, m_analysisDao, m_libraryHashDao,
-                           collection->getConfig()) {
+                           collection->getConfig()),
+                m_bWatching(false),
+                m_scanStartedMSecs(0) {
     // Don't initialize m_database here, we need to do it in run() so the DB
     // conn is in the right thread.
     qDebug() << "Starting LibraryScanner thread.";
@@ -54,6 +81,8 @@ LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collecti
     // queue to our event loop.
     moveToThread(this);
     m_pool.moveToThread(this);
+    m_watcher.moveToThread(this);
+    m_changedDirectoriesTimer.moveToThread(this);
 
     unsigned static id = 0; // the id of this LibraryScanner, for debugging purposes
     setObjectName(QString("LibraryScanner %1").arg(++id));
@@ -64,6 +93,15 @@ LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collecti
     // connect them to our slots to run the command on the scanner thread.
     connect(this, SIGNAL(startScan()),
             this, SLOT(slotStartScan()));
+    connect(this, SIGNAL(watchDirectoriesChanged(bool)),
+            this, SLOT(slotSetWatchDirectories(bool)));
+
+    m_changedDirectoriesTimer.setSingleShot(true);
+    m_changedDirectoriesTimer.setInterval(kChangedDirectoriesScanDelayMillis);
+    connect(&m_watcher, SIGNAL(directoryChanged(QString)),
+            this, SLOT(slotDirectoryChanged(QString)));
+    connect(&m_changedDirectoriesTimer, SIGNAL(timeout()),
+            this, SLOT(slotScanChangedDirectories()));
 
     // Force the GUI thread's TrackInfoObject cache to be cleared when a library
     // scan is finished, because we might have modified the database directly
@@ -71,8 +109,8 @@ LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collecti
     // files would then have the wrong track location.
     connect(this, SIGNAL(scanFinished()),
             &(collection->getTrackDAO()), SLOT(clearCache()));
-    connect(this, SIGNAL(trackAdded(TrackPointer)),
-            &(collection->getTrackDAO()), SLOT(databaseTrackAdded(TrackPointer)));
+    connect(this, SIGNAL(tracksAdded(QSet<int>)),
+            &(collection->getTrackDAO()), SLOT(databaseTracksAdded(QSet<int>)));
     connect(this, SIGNAL(tracksMoved(QSet<int>, QSet<int>)),
             &(collection->getTrackDAO()), SLOT(databaseTracksMoved(QSet<int>, QSet<int>)));
     connect(this, SIGNAL(tracksChanged(QSet<int>)),
@@ -84,6 +122,8 @@ LibraryScanner::LibraryScanner(QWidget* pParentWidget, TrackCollection* collecti
             pProgress, SLOT(slotUpdate(QString)));
     connect(this, SIGNAL(progressHashing(QString)),
             pProgress, SLOT(slotUpdate(QString)));
+    connect(this, SIGNAL(progressFilesScanned(int)),
+            pProgress, SLOT(slotUpdateFilesScanned(int)));
     connect(this, SIGNAL(scanStarted()),
             pProgress, SLOT(slotScanStarted()));
     connect(this, SIGNAL(scanFinished()),
@@ -116,6 +156,11 @@ LibraryScanner::~LibraryScanner() {
     // Wait for thread to finish
     wait();
 
+    // The scanner thread is gone, so its connection can be used here.
+    if (m_bWatching && m_scannerGlobal.isNull()) {
+        saveWatchedUntil(QDateTime::currentMSecsSinceEpoch());
+    }
+
     // There should never be an outstanding transaction when this code is
     // called. If there is, it means we probably aren't committing a transaction
     // somewhere that should be.
@@ -168,8 +213,7 @@ void LibraryScanner::run() {
     qDebug() << "LibraryScanner event loop stopped.";
 }
 
-void LibraryScanner::slotStartScan() {
-    qDebug() << "LibraryScanner::slotStartScan";
+void LibraryScanner::createScannerGlobal() {
     QSet<QString> trackLocations = m_trackDao.getTrackLocations();
     QHash<QString, int> directoryHashes = m_libraryHashDao.getDirectoryHashes();
     QRegExp extensionFilter(SoundSourceProxy::getSupportedFileNameRegex());
@@ -182,7 +226,12 @@ void LibraryScanner::slotStartScan() {
         new ScannerGlobal(trackLocations, directoryHashes, extensionFilter,
                           coverExtensionFilter, directoryBlacklist));
     m_scannerGlobal->startTimer();
+    m_scanStartedMSecs = QDateTime::currentMSecsSinceEpoch();
+}
 
+void LibraryScanner::slotStartScan() {
+    qDebug() << "LibraryScanner::slotStartScan";
+    createScannerGlobal();
     emit(scanStarted());
 
     // Try to upgrade the library from 1.7 (XML) to 1.8+ (DB) if needed. If the
@@ -217,10 +266,6 @@ void LibraryScanner::slotStartScan() {
 
     qDebug() << "Recursively scanning library.";
 
-    // Start scanning the library. This prepares insertion queries in TrackDAO
-    // (must be called before calling addTracksAdd) and begins a transaction.
-    m_trackDao.addTracksPrepare();
-
     // Recursivly scan each directory in the directories table.
     QStringList dirs = m_directoryDao.getDirs();
 
@@ -264,10 +309,13 @@ void LibraryScanner::slotFinishScan() {
         qDebug() << "Recursive scanning interrupted by the user.";
     }
 
-    // Finish adding the tracks -- rollback the transaction if the scan did not
-    // finish cleanly and the user did not cancel the transaction.
-    m_trackDao.addTracksFinish(!m_scannerGlobal->shouldCancel() &&
-                               !bScanFinishedCleanly);
+    // Write the remaining tracks -- drop them if the scan did not finish
+    // cleanly and the user did not cancel the scan. Batches that have been
+    // written already stay in the library. A directory hash is written in
+    // the same or a later batch than the tracks of the directory, so the
+    // next scan picks up any directory whose tracks are missing.
+    writePendingChanges(!m_scannerGlobal->shouldCancel() &&
+                        !bScanFinishedCleanly);
 
     QStringList verifiedTracks = m_scannerGlobal->verifiedTracks();
     QStringList verifiedDirectories = m_scannerGlobal->verifiedDirectories();
@@ -328,22 +376,32 @@ void LibraryScanner::slotFinishScan() {
         emit(tracksMoved(tracksMovedSetOld, tracksMovedSetNew));
         emit(tracksChanged(coverArtTracksChanged));
 
+        // Changes during the scan are waiting in m_changedDirectories.
+        if (m_bWatching) {
+            saveWatchedUntil(m_scanStartedMSecs);
+        }
+
         qDebug() << "Scan finished cleanly";
     } else {
         qDebug() << "Scan cancelled";
     }
 
     // TODO(XXX) doesn't take into account verifyRemainingTracks.
+    const qint64 elapsed = m_scannerGlobal->timerElapsed();
     qDebug("Scan took: %lld ns. "
            "%d unchanged directories. "
            "%d changed/added directories. "
            "%d tracks verified from changed/added directories. "
-           "%d new tracks.",
-           m_scannerGlobal->timerElapsed(),
+           "%d new tracks. "
+           "%.1f files/s on %d threads.",
+           elapsed,
            verifiedDirectories.size(),
            m_scannerGlobal->numScannedDirectories(),
            verifiedTracks.size(),
-           m_scannerGlobal->numAddedTracks());
+           m_scannerGlobal->numAddedTracks(),
+           elapsed > 0 ?
+                   m_scannerGlobal->numScannedFiles() * 1e9 / elapsed : 0.0,
+           m_pool.maxThreadCount());
 
     emit(scanFinished());
     m_scannerGlobal.clear();
@@ -357,6 +415,146 @@ void LibraryScanner::scan() {
     emit(startScan());
 }
 
+void LibraryScanner::setWatchDirectories(bool watch) {
+    emit(watchDirectoriesChanged(watch));
+}
+
+void LibraryScanner::slotSetWatchDirectories(bool watch) {
+    qDebug() << "LibraryScanner::slotSetWatchDirectories" << watch;
+    if (watch == m_bWatching) {
+        return;
+    }
+    if (!watch) {
+        if (m_scannerGlobal.isNull()) {
+            saveWatchedUntil(QDateTime::currentMSecsSinceEpoch());
+        }
+        m_bWatching = false;
+        if (!m_watchedDirectories.isEmpty()) {
+            m_watcher.removePaths(m_watchedDirectories.toList());
+        }
+        m_watchedDirectories.clear();
+        m_changedDirectories.clear();
+        m_changedDirectoriesTimer.stop();
+        return;
+    }
+    m_bWatching = true;
+
+    SettingsDAO settings(m_database);
+    bool validWatchedUntil = false;
+    const qint64 watchedUntil = settings.getValue(kWatchedUntilKey)
+            .toLongLong(&validWatchedUntil);
+
+    // Only look at the modification time of the known directories instead of
+    // listing their files. Adding, removing or renaming an entry modifies the
+    // directory.
+    const QStringList directories = m_libraryHashDao.getDirectoryHashes().keys();
+    QSet<QString> changedDirectories;
+    foreach (const QString& directoryPath, directories) {
+        const QFileInfo directoryInfo(directoryPath);
+        if (!directoryInfo.isDir()) {
+            changedDirectories.insert(directoryPath);
+            continue;
+        }
+        watchDirectory(directoryPath);
+        if (directoryInfo.lastModified().toMSecsSinceEpoch() >=
+                watchedUntil - kWatchedUntilMarginMillis) {
+            changedDirectories.insert(directoryPath);
+        }
+    }
+
+    if (!validWatchedUntil || m_scannerGlobal) {
+        // Nothing is known about the changes while the directories were not
+        // watched, so the whole library is scanned once. A scan that is in
+        // progress, e.g. the rescan on start-up, looks at every directory
+        // anyway.
+        if (m_scannerGlobal.isNull()) {
+            slotStartScan();
+        }
+        return;
+    }
+    m_changedDirectories.unite(changedDirectories);
+    qDebug() << "LibraryScanner:" << changedDirectories.size() << "of"
+             << directories.size()
+             << "directories changed while they were not watched";
+    slotScanChangedDirectories();
+}
+
+void LibraryScanner::saveWatchedUntil(qint64 msecsSinceEpoch) {
+    if (!m_changedDirectories.isEmpty()) {
+        return;
+    }
+    SettingsDAO settings(m_database);
+    settings.setValue(kWatchedUntilKey, msecsSinceEpoch);
+}
+
+void LibraryScanner::watchDirectory(const QString& directoryPath) {
+    if (!m_bWatching) {
+        return;
+    }
+    // Every directory has its own inotify watch, which are limited by
+    // /proc/sys/fs/inotify/max_user_watches.
+    if (!m_watchedDirectories.contains(directoryPath)) {
+        m_watchedDirectories.insert(directoryPath);
+        m_watcher.addPath(directoryPath);
+    }
+}
+
+void LibraryScanner::slotDirectoryChanged(const QString& directoryPath) {
+    //qDebug() << "LibraryScanner::slotDirectoryChanged" << directoryPath;
+    if (!QDir(directoryPath).exists()) {
+        // The watch of a deleted directory is gone. Watch it again if it is
+        // created again.
+        m_watchedDirectories.remove(directoryPath);
+    }
+    m_changedDirectories.insert(directoryPath);
+    m_changedDirectoriesTimer.start();
+}
+
+void LibraryScanner::slotScanChangedDirectories() {
+    if (m_scannerGlobal) {
+        // Try again when the running scan has finished.
+        m_changedDirectoriesTimer.start();
+        return;
+    }
+    QStringList changedDirectories = m_changedDirectories.toList();
+    m_changedDirectories.clear();
+    if (changedDirectories.isEmpty()) {
+        return;
+    }
+    qDebug() << "LibraryScanner::slotScanChangedDirectories"
+             << changedDirectories.size() << "directories";
+
+    createScannerGlobal();
+    emit(scanStarted());
+
+    // Only the changed directories and their tracks need verification.
+    // Directories that no longer exist stay unverified and are marked as
+    // deleted together with their tracks when the scan has finished.
+    m_libraryHashDao.updateDirectoryStatuses(changedDirectories, false, false);
+    m_trackDao.invalidateTrackLocationsInDirectories(changedDirectories);
+
+    QList<MDir> existingDirectories;
+    foreach (const QString& dirPath, changedDirectories) {
+        if (QDir(dirPath).exists()) {
+            existingDirectories.append(MDir(dirPath));
+        }
+    }
+    if (existingDirectories.isEmpty()) {
+        slotFinishScan();
+        return;
+    }
+
+    TaskWatcher* pWatcher = &m_scannerGlobal->getTaskWatcher();
+    connect(pWatcher, SIGNAL(allTasksDone()),
+            this, SLOT(slotFinishScan()));
+    for (int i = 0; i < existingDirectories.size(); ++i) {
+        MDir& dir = existingDirectories[i];
+        queueTask(new RecursiveScanDirectoryTask(this, m_scannerGlobal,
+                                                 dir.dir(), dir.token(),
+                                                 false));
+    }
+}
+
 void LibraryScanner::cancel() {
     if (m_scannerGlobal) {
         m_scannerGlobal->setShouldCancel(true);
@@ -411,11 +609,17 @@ void LibraryScanner::directoryHashedAndScanned(const QString& directoryPath,
     if (m_scannerGlobal) {
         m_scannerGlobal->directoryScanned();
     }
-
-    if (newDirectory) {
-        m_libraryHashDao.saveDirectoryHash(directoryPath, hash);
-    } else {
-        m_libraryHashDao.updateDirectoryHash(directoryPath, hash, 0);
+    watchDirectory(directoryPath);
+
+    // The hash is written after the tracks of the directory, which were
+    // queued before this signal.
+    DirectoryHash directoryHash;
+    directoryHash.directoryPath = directoryPath;
+    directoryHash.newDirectory = newDirectory;
+    directoryHash.hash = hash;
+    m_pendingDirectoryHashes.append(directoryHash);
+    if (m_pendingDirectoryHashes.size() >= kScannerWriteBatchSize) {
+        writePendingChanges(false);
     }
     emit(progressHashing(directoryPath));
 }
@@ -426,6 +630,7 @@ void LibraryScanner::directoryUnchanged(const QString& directoryPath) {
     if (m_scannerGlobal) {
         m_scannerGlobal->addVerifiedDirectory(directoryPath);
     }
+    watchDirectory(directoryPath);
     emit(progressHashing(directoryPath));
 }
 
@@ -435,6 +640,7 @@ void LibraryScanner::trackExists(const QString& trackPath) {
     if (m_scannerGlobal) {
         m_scannerGlobal->addVerifiedTrack(trackPath);
     }
+    fileScanned();
 }
 
 void LibraryScanner::addNewTrack(TrackPointer pTrack) {
@@ -444,12 +650,64 @@ void LibraryScanner::addNewTrack(TrackPointer pTrack) {
     if (m_scannerGlobal) {
         m_scannerGlobal->trackAdded();
     }
-    if (m_trackDao.addTracksAdd(pTrack.data(), false)) {
-        // Successfully added. Signal the main instance of TrackDAO,
-        // that there is a new track in the database.
-        emit(trackAdded(pTrack));
-        emit(progressLoading(pTrack->getLocation()));
-    } else {
-        qWarning() << "Track ("+pTrack->getLocation()+") could not be added";
+    m_pendingTracks.append(pTrack);
+    if (m_pendingTracks.size() >= kScannerWriteBatchSize) {
+        writePendingChanges(false);
+    }
+    fileScanned();
+}
+
+void LibraryScanner::fileScanned() {
+    if (m_scannerGlobal) {
+        m_scannerGlobal->fileScanned();
+        const int numFiles = m_scannerGlobal->numScannedFiles();
+        if (numFiles % kFilesScannedProgressInterval == 0) {
+            emit(progressFilesScanned(numFiles));
+        }
+    }
+}
+
+void LibraryScanner::writePendingChanges(bool rollback) {
+    ScopedTimer timer("LibraryScanner::writePendingChanges");
+    if (rollback) {
+        m_pendingTracks.clear();
+        m_pendingDirectoryHashes.clear();
+        return;
+    }
+    if (m_pendingTracks.isEmpty() && m_pendingDirectoryHashes.isEmpty()) {
+        return;
+    }
+
+    // Prepares the insertion queries in TrackDAO and begins a transaction.
+    m_trackDao.addTracksPrepare();
+    QList<TrackInfoObject*> tracks;
+    foreach (const TrackPointer& pTrack, m_pendingTracks) {
+        tracks.append(pTrack.data());
+    }
+    QSet<int> addedTrackIds = m_trackDao.addTracksAddBatch(tracks, false);
+    if (addedTrackIds.size() < tracks.size()) {
+        qWarning() << tracks.size() - addedTrackIds.size()
+                   << "tracks could not be added";
+    }
+    foreach (const DirectoryHash& directoryHash, m_pendingDirectoryHashes) {
+        if (directoryHash.newDirectory) {
+            m_libraryHashDao.saveDirectoryHash(directoryHash.directoryPath,
+                                               directoryHash.hash);
+        } else {
+            m_libraryHashDao.updateDirectoryHash(directoryHash.directoryPath,
+                                                 directoryHash.hash, 0);
+        }
+    }
+    m_trackDao.addTracksFinish(false);
+    const QString lastLocation = m_pendingTracks.isEmpty() ?
+            QString() : m_pendingTracks.last()->getLocation();
+    m_pendingTracks.clear();
+    m_pendingDirectoryHashes.clear();
+
+    if (!addedTrackIds.isEmpty()) {
+        // Signal the main instance of TrackDAO that there are new tracks in
+        // the database, once for the whole batch.
+        emit(tracksAdded(addedTrackIds));
+        emit(progressLoading(lastLocation));
     }
 }
@@ -20,6 +20,9 @@
 
 #include <QThread>
 #include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QTimer>
 #include <QList>
 #include <QString>
 #include <QList>
@@ -54,6 +57,13 @@ class LibraryScanner : public QThread {
     // in progress.
     void scan();
 
+    // Call from any thread to start or stop watching the library directories
+    // for changes. Changed directories are scanned without their known
+    // sub-directories. When watching starts, the known directories that have
+    // been modified since the last time they were watched are scanned the
+    // same way. Without such a time the whole library is scanned once.
+    void setWatchDirectories(bool watch);
+
   public slots:
     // Call from any thread to cancel the scan.
     void cancel();
@@ -64,13 +74,17 @@ class LibraryScanner : public QThread {
     void progressHashing(QString);
     void progressLoading(QString path);
     void progressCoverArt(QString file);
-    void trackAdded(TrackPointer pTrack);
+    // The number of files looked at by the scan so far.
+    void progressFilesScanned(int numFiles);
+    void tracksAdded(QSet<int> addedTrackIds);
     void tracksMoved(QSet<int> oldTrackIds, QSet<int> newTrackIds);
     void tracksChanged(QSet<int> changedTrackIds);
 
     // Emitted by scan() to invoke slotStartScan in the scanner thread's event
     // loop.
     void startScan();
+    // Emitted by setWatchDirectories().
+    void watchDirectoriesChanged(bool watch);
 
   protected:
     void run();
@@ -81,6 +95,9 @@ class LibraryScanner : public QThread {
   private slots:
     void slotStartScan();
     void slotFinishScan();
+    void slotSetWatchDirectories(bool watch);
+    void slotDirectoryChanged(const QString& directoryPath);
+    void slotScanChangedDirectories();
 
     // ScannerTask signal handlers.
     void taskDone(bool success);
@@ -91,6 +108,24 @@ class LibraryScanner : public QThread {
     void addNewTrack(TrackPointer pTrack);
 
   private:
+    // A directory hash that is written together with the next batch of
+    // tracks.
+    struct DirectoryHash {
+        QString directoryPath;
+        bool newDirectory;
+        int hash;
+    };
+
+    // Writes the pending tracks and directory hashes in one transaction. The
+    // pending changes are dropped if rollback is true.
+    void writePendingChanges(bool rollback);
+    void fileScanned();
+    void createScannerGlobal();
+    void watchDirectory(const QString& directoryPath);
+    // Stores that all changes before msecsSinceEpoch have been scanned,
+    // unless changes are still waiting for a scan.
+    void saveWatchedUntil(qint64 msecsSinceEpoch);
+
     // The library trackcollection. Do not touch this from the library scanner
     // thread.
     TrackCollection* m_pCollection;
@@ -112,6 +147,22 @@ class LibraryScanner : public QThread {
 
     // Global scanner state for scan currently in progress.
     ScannerGlobalPointer m_scannerGlobal;
+
+    // The worker tasks only read files. All database writes of a scan are
+    // batched here, in the library scanner thread.
+    QList<TrackPointer> m_pendingTracks;
+    QList<DirectoryHash> m_pendingDirectoryHashes;
+
+    // Uses inotify on Linux.
+    QFileSystemWatcher m_watcher;
+    bool m_bWatching;
+    QSet<QString> m_watchedDirectories;
+    // Changes are collected until nothing has changed for a while, e.g.
+    // while files are being copied.
+    QSet<QString> m_changedDirectories;
+    QTimer m_changedDirectoriesTimer;
+    // The start of the scan in progress in milliseconds since the epoch.
+    qint64 m_scanStartedMSecs;
 };
 
 #endif
@@ -47,6 +47,11 @@ LibraryScannerDlg::LibraryScannerDlg(QWidget* parent, Qt::WindowFlags f)
     connect(this, SIGNAL(progress(QString)),
             pCurrent, SLOT(setText(QString)));
     pLayout->addWidget(pCurrent);
+
+    QLabel* pFilesScanned = new QLabel(this);
+    connect(this, SIGNAL(progressFilesScanned(QString)),
+            pFilesScanned, SLOT(setText(QString)));
+    pLayout->addWidget(pFilesScanned);
     setLayout(pLayout);
 }
 
@@ -79,6 +84,16 @@ void LibraryScannerDlg::slotUpdateCover(QString path) {
     }
 }
 
+void LibraryScannerDlg::slotUpdateFilesScanned(int numFiles) {
+    if (isVisible()) {
+        const double seconds = m_timer.elapsed() / 1000.0;
+        const double filesPerSecond = seconds > 0 ? numFiles / seconds : 0.0;
+        emit(progressFilesScanned(tr("%1 files scanned (%2 files/s)")
+                                  .arg(numFiles)
+                                  .arg(filesPerSecond, 0, 'f', 0)));
+    }
+}
+
 void LibraryScannerDlg::slotCancel() {
     qDebug() << "Cancelling library scan...";
     m_bCancelled = true;
@@ -89,6 +104,7 @@ void LibraryScannerDlg::slotCancel() {
 void LibraryScannerDlg::slotScanStarted() {
     m_bCancelled = false;
     m_timer.start();
+    emit(progressFilesScanned(QString()));
 }
 
 void LibraryScannerDlg::slotScanFinished() {
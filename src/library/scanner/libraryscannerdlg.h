@@ -33,6 +33,7 @@ class LibraryScannerDlg : public QWidget {
   public slots:
     void slotUpdate(QString path);
     void slotUpdateCover(QString path);
+    void slotUpdateFilesScanned(int numFiles);
     void slotCancel();
     void slotScanFinished();
     void slotScanStarted();
@@ -40,6 +41,7 @@ class LibraryScannerDlg : public QWidget {
   signals:
     void scanCancelled();
     void progress(QString);
+    void progressFilesScanned(QString);
 
   private:
     QTime m_timer;
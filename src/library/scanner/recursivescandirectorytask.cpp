@@ -8,10 +8,11 @@
 
 RecursiveScanDirectoryTask::RecursiveScanDirectoryTask(
     LibraryScanner* pScanner, const ScannerGlobalPointer scannerGlobal,
-    const QDir& dir, SecurityTokenPointer pToken)
+    const QDir& dir, SecurityTokenPointer pToken, bool scanKnownSubdirectories)
         : ScannerTask(pScanner, scannerGlobal),
           m_dir(dir),
-          m_pToken(pToken) {
+          m_pToken(pToken),
+          m_scanKnownSubdirectories(scanKnownSubdirectories) {
 }
 
 void RecursiveScanDirectoryTask::run() {
@@ -81,7 +82,7 @@ void RecursiveScanDirectoryTask::run() {
         // we return immediately.
         if (!filesToImport.isEmpty()) {
             m_pScanner->queueTask(new ImportFilesTask(m_pScanner, m_scannerGlobal,
-                                                    dirPath, newHash, prevHashExists,
+                                                    dirPath, prevHashExists, newHash,
                                                     filesToImport, possibleCovers,
                                                     m_pToken));
         } else {
@@ -93,6 +94,11 @@ void RecursiveScanDirectoryTask::run() {
 
     // Process all of the sub-directories.
     foreach (const QDir& nextDir, dirsToScan) {
+        // Known sub-directories are watched on their own.
+        if (!m_scanKnownSubdirectories &&
+                m_scannerGlobal->directoryHashInDatabase(nextDir.path()) != -1) {
+            continue;
+        }
         m_pScanner->queueTask(new RecursiveScanDirectoryTask(
             m_pScanner, m_scannerGlobal, nextDir, m_pToken));
     }
@@ -11,6 +11,10 @@
 // performing a hash of the directory's file list, and those hashes are stored
 // in the database. Successful if the scan completed without being
 // cancelled. False if the scan was cancelled part-way through.
+//
+// If scanKnownSubdirectories is false, subdirectories that have a hash in the
+// database are skipped. This is used for scanning the directories that the
+// library watcher reported as changed.
 class RecursiveScanDirectoryTask : public ScannerTask {
     Q_OBJECT
   public:
@@ -18,7 +22,8 @@ class RecursiveScanDirectoryTask : public ScannerTask {
     RecursiveScanDirectoryTask(LibraryScanner* pScanner,
                                const ScannerGlobalPointer scannerGlobal,
                                const QDir& dir,
-                               SecurityTokenPointer pToken);
+                               SecurityTokenPointer pToken,
+                               bool scanKnownSubdirectories = true);
     virtual ~RecursiveScanDirectoryTask() {}
 
     virtual void run();
@@ -26,6 +31,7 @@ class RecursiveScanDirectoryTask : public ScannerTask {
   private:
     QDir m_dir;
     SecurityTokenPointer m_pToken;
+    const bool m_scanKnownSubdirectories;
 };
 
 #endif /* RECURSIVESCANDIRECTORYTASK_H */
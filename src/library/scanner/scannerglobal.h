@@ -28,7 +28,8 @@ class ScannerGlobal {
               m_scanFinishedCleanly(true),
               m_shouldCancel(false),
               m_numAddedTracks(0),
-              m_numScannedDirectories(0) {
+              m_numScannedDirectories(0),
+              m_numScannedFiles(0) {
     }
 
     TaskWatcher& getTaskWatcher() {
@@ -128,6 +129,14 @@ class ScannerGlobal {
         m_numScannedDirectories++;
     }
 
+    // The number of files that have been found to be new or existing tracks.
+    int numScannedFiles() const {
+        return m_numScannedFiles;
+    }
+    void fileScanned() {
+        m_numScannedFiles++;
+    }
+
 
   private:
     TaskWatcher m_watcher;
@@ -159,6 +168,7 @@ class ScannerGlobal {
     PerformanceTimer m_timer;
     int m_numAddedTracks;
     int m_numScannedDirectories;
+    int m_numScannedFiles;
 };
 
 typedef QSharedPointer<ScannerGlobal> ScannerGlobalPointer;
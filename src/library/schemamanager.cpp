@@ -1,6 +1,7 @@
 // schemamanager.cpp
 // Created 12/29/2009 by RJ Ryan (rryan@mit.edu)
 
+#include <QRegExp>
 #include <QtDebug>
 
 #include "library/schemamanager.h"
@@ -11,6 +12,14 @@
 const QString SchemaManager::SETTINGS_VERSION_STRING = "mixxx.schema.version";
 const QString SchemaManager::SETTINGS_MINCOMPATIBLE_STRING = "mixxx.schema.min_compatible_version";
 
+namespace {
+
+const QRegExp kCreateTrigger("^CREATE\\s+(TEMP\\s+|TEMPORARY\\s+)?TRIGGER\\b",
+                             Qt::CaseInsensitive);
+const QRegExp kTriggerEnd("\\bEND$", Qt::CaseInsensitive);
+
+}  // anonymous namespace
+
 // static
 SchemaManager::Result SchemaManager::upgradeToSchemaVersion(
         const QString& schemaFilename,
@@ -103,29 +112,22 @@ SchemaManager::Result SchemaManager::upgradeToSchemaVersion(
         qDebug() << "Applying version" << thisTarget << ":"
                  << description.trimmed();
 
-        ScopedTransaction transaction(db);
-
-        // TODO(XXX) We can't have semicolons in schema.xml for anything other
-        // than statement separators.
-        QStringList sqlStatements = sql.split(";");
-
-        QStringListIterator it(sqlStatements);
-
-        QSqlQuery query(db);
-        bool result = true;
-        while (result && it.hasNext()) {
-            QString statement = it.next().trimmed();
-            if (statement.isEmpty()) {
-                continue;
-            }
-            result = result && query.exec(statement);
-            if (!result) {
-                qDebug() << "Failed query:"
-                         << statement
-                         << query.lastError();
-            }
+        // The optional probe checks that the SQLite build supports what the
+        // revision needs, e.g. a module. If it fails the upgrade stops here
+        // without recording the revision, so it is tried again on the next
+        // start, e.g. with a newer SQLite. The features that need it have to
+        // check for the tables they use.
+        QDomElement eProbe = revision.firstChildElement("probe");
+        if (!eProbe.isNull() && !executeStatements(db, eProbe.text(), false)) {
+            qWarning() << "Staying at version" << currentVersion
+                       << "because this SQLite build does not support version"
+                       << thisTarget;
+            return RESULT_OK;
         }
 
+        ScopedTransaction transaction(db);
+        const bool result = executeStatements(db, sql, true);
+
         if (result) {
             currentVersion = thisTarget;
             settings.setValue(SETTINGS_VERSION_STRING, thisTarget);
@@ -141,6 +143,40 @@ SchemaManager::Result SchemaManager::upgradeToSchemaVersion(
     return RESULT_OK;
 }
 
+// static
+bool SchemaManager::executeStatements(QSqlDatabase& db, const QString& sql,
+                                      bool logErrors) {
+    // TODO(XXX) We can't have semicolons in schema.xml for anything other
+    // than statement separators and the statements of a trigger body.
+    QStringList sqlStatements = sql.split(";");
+
+    QStringListIterator it(sqlStatements);
+
+    QSqlQuery query(db);
+    while (it.hasNext()) {
+        QString statement = it.next().trimmed();
+        // The statements between BEGIN and END of a trigger are part of
+        // the CREATE TRIGGER statement.
+        if (statement.contains(kCreateTrigger)) {
+            while (!statement.contains(kTriggerEnd) && it.hasNext()) {
+                statement += ";\n" + it.next().trimmed();
+            }
+        }
+        if (statement.isEmpty()) {
+            continue;
+        }
+        if (!query.exec(statement)) {
+            if (logErrors) {
+                qDebug() << "Failed query:"
+                         << statement
+                         << query.lastError();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
 // static
 int SchemaManager::getCurrentSchemaVersion(SettingsDAO& settings) {
     QString currentSchemaVersion = settings.getValue(SETTINGS_VERSION_STRING);
@@ -25,6 +25,9 @@ class SchemaManager {
     static const QString SETTINGS_MINCOMPATIBLE_STRING;
 
   private:
+    // Executes the statements of a revision, separated by semicolons.
+    static bool executeStatements(QSqlDatabase& db, const QString& sql,
+                                  bool logErrors);
     static bool isBackwardsCompatible(SettingsDAO& settings,
                                       int currentVersion,
                                       int targetVersion);
@@ -1,3 +1,4 @@
+#include <QVarLengthArray>
 #include <QtDebug>
 
 #include "library/searchquery.h"
@@ -5,6 +6,7 @@
 #include "library/queryutil.h"
 #include "track/keyutils.h"
 #include "library/dao/trackdao.h"
+#include "util/math.h"
 
 QVariant getTrackValueForColumn(const TrackPointer& pTrack, const QString& column) {
     if (column == LIBRARYTABLE_ARTIST) {
@@ -72,6 +74,15 @@ QString QueryNode::concatSqlClauses(
     }
 }
 
+bool GroupNode::canEvaluateNodes(const TrackSearchIndex& index) const {
+    for (const auto& pNode: m_nodes) {
+        if (!pNode->canEvaluate(index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool AndNode::match(const TrackPointer& pTrack) const {
     for (const auto& pNode: m_nodes) {
         if (!pNode->match(pTrack)) {
@@ -95,6 +106,24 @@ QString AndNode::toSql() const {
     return concatSqlClauses(queryFragments, "AND");
 }
 
+bool AndNode::canEvaluate(const TrackSearchIndex& index) const {
+    return canEvaluateNodes(index);
+}
+
+void AndNode::evaluate(const TrackSearchIndex& index, int begin, int end,
+                       qint8* pMatches) const {
+    const int count = end - begin;
+    std::fill(pMatches, pMatches + count, TrackSearchIndex::MATCH_TRUE);
+    QVarLengthArray<qint8, TrackSearchIndex::kBlockSize> nodeMatches(count);
+    for (const auto& pNode: m_nodes) {
+        pNode->evaluate(index, begin, end, nodeMatches.data());
+        for (int i = 0; i < count; ++i) {
+            pMatches[i] = TrackSearchIndex::matchAnd(
+                    pMatches[i], nodeMatches[i]);
+        }
+    }
+}
+
 bool OrNode::match(const TrackPointer& pTrack) const {
     // An empty OR node would always evaluate to false
     // which is inconsistent with the generated SQL query!
@@ -124,6 +153,25 @@ QString OrNode::toSql() const {
     return concatSqlClauses(queryFragments, "OR");
 }
 
+bool OrNode::canEvaluate(const TrackSearchIndex& index) const {
+    // An empty OR node is left out of the generated SQL query.
+    return !m_nodes.empty() && canEvaluateNodes(index);
+}
+
+void OrNode::evaluate(const TrackSearchIndex& index, int begin, int end,
+                      qint8* pMatches) const {
+    const int count = end - begin;
+    std::fill(pMatches, pMatches + count, TrackSearchIndex::MATCH_FALSE);
+    QVarLengthArray<qint8, TrackSearchIndex::kBlockSize> nodeMatches(count);
+    for (const auto& pNode: m_nodes) {
+        pNode->evaluate(index, begin, end, nodeMatches.data());
+        for (int i = 0; i < count; ++i) {
+            pMatches[i] = TrackSearchIndex::matchOr(
+                    pMatches[i], nodeMatches[i]);
+        }
+    }
+}
+
 bool NotNode::match(const TrackPointer& pTrack) const {
     return !m_pNode->match(pTrack);
 }
@@ -140,6 +188,18 @@ QString NotNode::toSql() const {
     }
 }
 
+bool NotNode::canEvaluate(const TrackSearchIndex& index) const {
+    return m_pNode->canEvaluate(index);
+}
+
+void NotNode::evaluate(const TrackSearchIndex& index, int begin, int end,
+                       qint8* pMatches) const {
+    m_pNode->evaluate(index, begin, end, pMatches);
+    for (int i = 0; i < end - begin; ++i) {
+        pMatches[i] = TrackSearchIndex::matchNot(pMatches[i]);
+    }
+}
+
 bool TextFilterNode::match(const TrackPointer& pTrack) const {
     for (const auto& sqlColumn: m_sqlColumns) {
         QVariant value = getTrackValueForColumn(pTrack, sqlColumn);
@@ -165,6 +225,94 @@ QString TextFilterNode::toSql() const {
     return concatSqlClauses(searchClauses, "OR");
 }
 
+bool TextFilterNode::canEvaluate(const TrackSearchIndex& index) const {
+    // Wildcards in the argument are left to SQLite.
+    if (m_argument.contains('%') || m_argument.contains('_')) {
+        return false;
+    }
+    for (const auto& sqlColumn: m_sqlColumns) {
+        if (index.textColumn(sqlColumn) < 0) {
+            return false;
+        }
+    }
+    return !m_sqlColumns.isEmpty();
+}
+
+void TextFilterNode::evaluate(const TrackSearchIndex& index, int begin,
+                              int end, qint8* pMatches) const {
+    const int count = end - begin;
+    std::fill(pMatches, pMatches + count, TrackSearchIndex::MATCH_FALSE);
+    for (const auto& sqlColumn: m_sqlColumns) {
+        const QString* pValues =
+                index.textValues(index.textColumn(sqlColumn)).constData() + begin;
+        for (int i = 0; i < count; ++i) {
+            qint8 match;
+            if (pValues[i].isNull()) {
+                match = TrackSearchIndex::MATCH_NULL;
+            } else if (pValues[i].contains(m_foldedArgument)) {
+                match = TrackSearchIndex::MATCH_TRUE;
+            } else {
+                match = TrackSearchIndex::MATCH_FALSE;
+            }
+            pMatches[i] = TrackSearchIndex::matchOr(pMatches[i], match);
+        }
+    }
+}
+
+bool FullTextFilterNode::match(const TrackPointer& pTrack) const {
+    for (const auto& sqlColumn: m_sqlColumns) {
+        QVariant value = getTrackValueForColumn(pTrack, sqlColumn);
+        if (!value.isValid() || !qVariantCanConvert<QString>(value)) {
+            continue;
+        }
+
+        if (TrackSearchIndex::containsWordPrefix(
+                TrackSearchIndex::foldText(value.toString()),
+                m_foldedArgument)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString FullTextFilterNode::toSql() const {
+    QStringList matchTerms;
+    for (const auto& sqlColumn: m_sqlColumns) {
+        matchTerms << QString("%1:%2*").arg(sqlColumn, m_foldedArgument);
+    }
+    FieldEscaper escaper(m_database);
+    return QString("%1 IN (SELECT docid FROM %2 WHERE %2 MATCH %3)").arg(
+            m_idColumn, m_fullTextTable,
+            escaper.escapeString(matchTerms.join(" OR ")));
+}
+
+bool FullTextFilterNode::canEvaluate(const TrackSearchIndex& index) const {
+    for (const auto& sqlColumn: m_sqlColumns) {
+        if (index.textColumn(sqlColumn) < 0) {
+            return false;
+        }
+    }
+    return !m_sqlColumns.isEmpty();
+}
+
+void FullTextFilterNode::evaluate(const TrackSearchIndex& index, int begin,
+                                  int end, qint8* pMatches) const {
+    const int count = end - begin;
+    // The id is never NULL, so neither is the result.
+    std::fill(pMatches, pMatches + count, TrackSearchIndex::MATCH_FALSE);
+    for (const auto& sqlColumn: m_sqlColumns) {
+        const QString* pValues =
+                index.textValues(index.textColumn(sqlColumn)).constData() + begin;
+        for (int i = 0; i < count; ++i) {
+            if (pMatches[i] == TrackSearchIndex::MATCH_FALSE &&
+                    TrackSearchIndex::containsWordPrefix(pValues[i],
+                                                         m_foldedArgument)) {
+                pMatches[i] = TrackSearchIndex::MATCH_TRUE;
+            }
+        }
+    }
+}
+
 NumericFilterNode::NumericFilterNode(const QStringList& sqlColumns)
         : m_sqlColumns(sqlColumns),
           m_bOperatorQuery(false),
@@ -262,6 +410,55 @@ QString NumericFilterNode::toSql() const {
     return QString();
 }
 
+bool NumericFilterNode::canEvaluate(const TrackSearchIndex& index) const {
+    // A node without a valid argument is left out of the generated SQL query.
+    if (!m_bOperatorQuery && !m_bRangeQuery) {
+        return false;
+    }
+    for (const auto& sqlColumn: m_sqlColumns) {
+        if (index.numericColumn(sqlColumn) < 0) {
+            return false;
+        }
+    }
+    return !m_sqlColumns.isEmpty();
+}
+
+void NumericFilterNode::evaluate(const TrackSearchIndex& index, int begin,
+                                 int end, qint8* pMatches) const {
+    // Compare with the numbers as they are written into the SQL query.
+    const double argument = QString::number(m_dOperatorArgument).toDouble();
+    const double rangeLow = QString::number(m_dRangeLow).toDouble();
+    const double rangeHigh = QString::number(m_dRangeHigh).toDouble();
+    const bool less = m_operator.startsWith("<");
+    const bool greater = m_operator.startsWith(">");
+    const bool equal = m_operator.endsWith("=");
+
+    const int count = end - begin;
+    std::fill(pMatches, pMatches + count, TrackSearchIndex::MATCH_FALSE);
+    for (const auto& sqlColumn: m_sqlColumns) {
+        const double* pValues = index.numericValues(
+                index.numericColumn(sqlColumn)).constData() + begin;
+        for (int i = 0; i < count; ++i) {
+            const double value = pValues[i];
+            qint8 match;
+            if (isnan(value)) {
+                match = TrackSearchIndex::MATCH_NULL;
+            } else if (m_bOperatorQuery) {
+                match = ((less && value < argument) ||
+                         (greater && value > argument) ||
+                         (equal && value == argument)) ?
+                        TrackSearchIndex::MATCH_TRUE :
+                        TrackSearchIndex::MATCH_FALSE;
+            } else {
+                match = (value >= rangeLow && value <= rangeHigh) ?
+                        TrackSearchIndex::MATCH_TRUE :
+                        TrackSearchIndex::MATCH_FALSE;
+            }
+            pMatches[i] = TrackSearchIndex::matchOr(pMatches[i], match);
+        }
+    }
+}
+
 DurationFilterNode::DurationFilterNode(
         const QStringList& sqlColumns, const QString& argument)
         : NumericFilterNode(sqlColumns) {
@@ -320,3 +517,23 @@ QString KeyFilterNode::toSql() const {
     }
     return concatSqlClauses(searchClauses, "OR");
 }
+
+bool KeyFilterNode::canEvaluate(const TrackSearchIndex& index) const {
+    return index.numericColumn(LIBRARYTABLE_KEY_ID) >= 0;
+}
+
+void KeyFilterNode::evaluate(const TrackSearchIndex& index, int begin,
+                             int end, qint8* pMatches) const {
+    const double* pValues = index.numericValues(
+            index.numericColumn(LIBRARYTABLE_KEY_ID)).constData() + begin;
+    for (int i = 0; i < end - begin; ++i) {
+        // IS never evaluates to NULL.
+        pMatches[i] = TrackSearchIndex::MATCH_FALSE;
+        for (const auto& matchKey: m_matchKeys) {
+            if (pValues[i] == matchKey) {
+                pMatches[i] = TrackSearchIndex::MATCH_TRUE;
+                break;
+            }
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #ifndef SEARCHQUERY_H
 #define SEARCHQUERY_H
 
+#include <algorithm>
 #include <vector>
 
 #include <QList>
@@ -10,6 +11,7 @@
 #include <QStringList>
 
 #include "trackinfoobject.h"
+#include "library/tracksearchindex.h"
 #include "proto/keys.pb.h"
 #include "util/assert.h"
 #include "util/memory.h"
@@ -24,6 +26,14 @@ class QueryNode {
     virtual bool match(const TrackPointer& pTrack) const = 0;
     virtual QString toSql() const = 0;
 
+    // Returns true if evaluate() can be used with the columns of the index.
+    virtual bool canEvaluate(const TrackSearchIndex& index) const = 0;
+    // Evaluates the node for the rows [begin, end) of the index the same way
+    // SQLite evaluates toSql(). Writes a TrackSearchIndex::Match per row to
+    // pMatches.
+    virtual void evaluate(const TrackSearchIndex& index, int begin, int end,
+                          qint8* pMatches) const = 0;
+
   protected:
     QueryNode() {}
 
@@ -38,6 +48,8 @@ class GroupNode : public QueryNode {
     }
 
   protected:
+    bool canEvaluateNodes(const TrackSearchIndex& index) const;
+
     // NOTE(uklotzde): std::vector is more suitable (efficiency)
     // than a QList for a private member. And QList from Qt 4
     // does not support std::unique_ptr yet.
@@ -48,12 +60,18 @@ class OrNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 };
 
 class AndNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 };
 
 class NotNode : public QueryNode {
@@ -65,6 +83,9 @@ class NotNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 
   private:
     std::unique_ptr<QueryNode> m_pNode;
@@ -77,16 +98,54 @@ class TextFilterNode : public QueryNode {
                    const QString& argument)
             : m_database(database),
               m_sqlColumns(sqlColumns),
-              m_argument(argument) {
+              m_argument(argument),
+              m_foldedArgument(TrackSearchIndex::foldText(argument)) {
     }
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 
   private:
     QSqlDatabase m_database;
     QStringList m_sqlColumns;
     QString m_argument;
+    QString m_foldedArgument;
+};
+
+// Matches tracks that have a word starting with the argument in one of the
+// columns. The SQL query uses the full-text index of the library, which only
+// knows about words, so "ouse" does not match "house" like it does with
+// TextFilterNode. SearchQueryParser only creates it for terms that ask for
+// a word prefix, e.g. "hous*".
+class FullTextFilterNode : public QueryNode {
+  public:
+    FullTextFilterNode(const QSqlDatabase& database,
+                       const QString& fullTextTable,
+                       const QString& idColumn,
+                       const QStringList& sqlColumns,
+                       const QString& argument)
+            : m_database(database),
+              m_fullTextTable(fullTextTable),
+              m_idColumn(idColumn),
+              m_sqlColumns(sqlColumns),
+              m_foldedArgument(TrackSearchIndex::foldText(argument)) {
+    }
+
+    bool match(const TrackPointer& pTrack) const override;
+    QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
+
+  private:
+    QSqlDatabase m_database;
+    QString m_fullTextTable;
+    QString m_idColumn;
+    QStringList m_sqlColumns;
+    QString m_foldedArgument;
 };
 
 class NumericFilterNode : public QueryNode {
@@ -95,6 +154,9 @@ class NumericFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 
   protected:
     // Single argument constructor for that does not call init()
@@ -132,6 +194,9 @@ class KeyFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool canEvaluate(const TrackSearchIndex& index) const override;
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override;
 
   private:
     QList<mixxx::track::io::key::ChromaticKey> m_matchKeys;
@@ -157,6 +222,20 @@ class SqlNode : public QueryNode {
         return m_sql;
     }
 
+    bool canEvaluate(const TrackSearchIndex& index) const override {
+        // Arbitrary SQL can only be evaluated by SQLite.
+        Q_UNUSED(index);
+        return false;
+    }
+
+    void evaluate(const TrackSearchIndex& index, int begin, int end,
+                  qint8* pMatches) const override {
+        Q_UNUSED(index);
+        DEBUG_ASSERT(false);
+        std::fill(pMatches, pMatches + (end - begin),
+                  TrackSearchIndex::MATCH_TRUE);
+    }
+
   private:
     QString m_sql;
 };
@@ -4,6 +4,7 @@
 
 const char* kNegatePrefix = "-";
 const char* kFuzzyPrefix = "~";
+const char* kWordPrefixSuffix = "*";
 
 SearchQueryParser::SearchQueryParser(QSqlDatabase& database)
         : m_database(database) {
@@ -44,6 +45,17 @@ SearchQueryParser::SearchQueryParser(QSqlDatabase& database)
     m_fieldToSqlColumns["rating"] << "rating";
     m_fieldToSqlColumns["location"] << "location";
 
+    // The columns of library_fts, see schema.xml.
+    m_fullTextColumns << "artist"
+                      << "album_artist"
+                      << "album"
+                      << "title"
+                      << "genre"
+                      << "composer"
+                      << "grouping"
+                      << "comment"
+                      << "location";
+
     m_allFilters.append(m_textFilters);
     m_allFilters.append(m_numericFilters);
     m_allFilters.append(m_specialFilters);
@@ -57,6 +69,44 @@ SearchQueryParser::SearchQueryParser(QSqlDatabase& database)
 SearchQueryParser::~SearchQueryParser() {
 }
 
+void SearchQueryParser::setFullTextTable(const QString& fullTextTable,
+                                         const QString& idColumn) {
+    m_fullTextTable = fullTextTable;
+    m_fullTextIdColumn = idColumn;
+}
+
+std::unique_ptr<QueryNode> SearchQueryParser::createTextFilterNode(
+        const QStringList& sqlColumns, const QString& argument) const {
+    // A single word followed by a star, e.g. "hous*", asks for the words
+    // starting with it. Everything else is a substring search, so "mix"
+    // still finds "Remix".
+    QString word = argument;
+    bool wordPrefix = word.endsWith(kWordPrefixSuffix);
+    if (wordPrefix) {
+        word.chop(1);
+        wordPrefix = !word.isEmpty();
+    }
+    for (int i = 0; wordPrefix && i < word.size(); ++i) {
+        wordPrefix = word.at(i).isLetterOrNumber();
+    }
+    if (!wordPrefix) {
+        return std::make_unique<TextFilterNode>(m_database, sqlColumns, argument);
+    }
+
+    bool useFullText = !m_fullTextTable.isEmpty() && !sqlColumns.isEmpty();
+    for (const auto& sqlColumn: sqlColumns) {
+        useFullText = useFullText && m_fullTextColumns.contains(sqlColumn);
+    }
+    if (useFullText) {
+        return std::make_unique<FullTextFilterNode>(
+                m_database, m_fullTextTable, m_fullTextIdColumn,
+                sqlColumns, word);
+    }
+    // Without the full-text index the word is searched as a substring,
+    // which finds a superset of the word prefix matches.
+    return std::make_unique<TextFilterNode>(m_database, sqlColumns, word);
+}
+
 QString SearchQueryParser::getTextArgument(QString argument,
                                            QStringList* tokens) const {
     // If the argument is empty, assume the user placed a space after an
@@ -118,8 +168,8 @@ void SearchQueryParser::parseTokens(QStringList tokens,
                 m_textFilterMatcher.cap(2), &tokens).trimmed();
 
             if (!argument.isEmpty()) {
-                std::unique_ptr<QueryNode> pNode(std::make_unique<TextFilterNode>(
-                    m_database, m_fieldToSqlColumns[field], argument));
+                std::unique_ptr<QueryNode> pNode(createTextFilterNode(
+                    m_fieldToSqlColumns[field], argument));
                 if (negate) {
                     pNode = std::make_unique<NotNode>(std::move(pNode));
                 }
@@ -178,8 +228,7 @@ void SearchQueryParser::parseTokens(QStringList tokens,
             // Don't trigger on a lone minus sign.
             if (!token.isEmpty()) {
                 std::unique_ptr<QueryNode> pNode(
-                        std::make_unique<TextFilterNode>(
-                                m_database, searchColumns, token));
+                        createTextFilterNode(searchColumns, token));
                 if (negate) {
                     pNode = std::make_unique<NotNode>(std::move(pNode));
                 }
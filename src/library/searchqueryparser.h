@@ -19,6 +19,12 @@ class SearchQueryParser {
             const QStringList& searchColumns,
             const QString& extraFilter) const;
 
+    // Word prefix terms in text searches, e.g. "hous*", are looked up in
+    // the full-text table, whose document ids are the values of idColumn.
+    // Other terms are still searched as a substring with LIKE.
+    void setFullTextTable(const QString& fullTextTable,
+                          const QString& idColumn);
+
   private:
     void parseTokens(QStringList tokens,
                      QStringList searchColumns,
@@ -27,6 +33,10 @@ class SearchQueryParser {
     QString getTextArgument(QString argument,
                             QStringList* tokens) const;
 
+    std::unique_ptr<QueryNode> createTextFilterNode(
+            const QStringList& sqlColumns,
+            const QString& argument) const;
+
     QSqlDatabase m_database;
     QStringList m_textFilters;
     QStringList m_numericFilters;
@@ -34,6 +44,10 @@ class SearchQueryParser {
     QStringList m_allFilters;
     QHash<QString, QStringList> m_fieldToSqlColumns;
 
+    QString m_fullTextTable;
+    QString m_fullTextIdColumn;
+    QStringList m_fullTextColumns;
+
     QRegExp m_fuzzyMatcher;
     QRegExp m_textFilterMatcher;
     QRegExp m_numericFilterMatcher;
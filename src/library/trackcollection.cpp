@@ -9,12 +9,13 @@
 
 #include "library/librarytablemodel.h"
 #include "library/schemamanager.h"
+#include "library/workerdatabase.h"
 #include "trackinfoobject.h"
 #include "util/xml.h"
 #include "util/assert.h"
 
 // static
-const int TrackCollection::kRequiredSchemaVersion = 24;
+const int TrackCollection::kRequiredSchemaVersion = 25;
 
 TrackCollection::TrackCollection(ConfigObject<ConfigValue>* pConfig)
         : m_pConfig(pConfig),
@@ -58,6 +59,7 @@ TrackCollection::~TrackCollection() {
                     << "There is a logic error somewhere.";
         }
         m_db.close();
+        resetWorkerThreadDatabases();
     } else {
         qDebug() << "ERROR: The main database connection was closed before TrackCollection closed it."
                 << "There is a logic error somewhere.";
@@ -163,6 +165,18 @@ void TrackCollection::setTrackSource(QSharedPointer<BaseTrackCache> trackSource)
     m_defaultTrackSource = trackSource;
 }
 
+//static
+void TrackCollection::makeLatinLow(QChar* c, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (c[i].decompositionTag() != QChar::NoDecomposition) {
+            c[i] = c[i].decomposition()[0];
+        }
+        if (c[i].isUpper()) {
+            c[i] = c[i].toLower();
+        }
+    }
+}
+
 #ifdef __SQLITE3__
 // from public domain code
 // http://www.archivum.info/qt-interest@trolltech.com/2008-12/00584/Re-%28Qt-interest%29-Qt-Sqlite-UserDefinedFunction.html
@@ -269,18 +283,6 @@ void TrackCollection::sqliteLike(sqlite3_context *context,
     return;
 }
 
-//static
-void TrackCollection::makeLatinLow(QChar* c, int count) {
-    for (int i = 0; i < count; ++i) {
-        if (c[i].decompositionTag() != QChar::NoDecomposition) {
-            c[i] = c[i].decomposition()[0];
-        }
-        if (c[i].isUpper()) {
-            c[i] = c[i].toLower();
-        }
-    }
-}
-
 //static
 int TrackCollection::likeCompareLatinLow(
         QString* pattern,
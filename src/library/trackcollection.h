@@ -71,6 +71,10 @@ class TrackCollection : public QObject {
         return m_pConfig;
     }
 
+    // Folds the characters to their lower case base letters, the way the
+    // LIKE operator of the library database compares them.
+    static void makeLatinLow(QChar* c, int count);
+
   protected:
 #ifdef __SQLITE3__
     void installSorting(QSqlDatabase &db);
@@ -80,7 +84,6 @@ class TrackCollection : public QObject {
     static void sqliteLike(sqlite3_context *p,
                           int aArgc,
                           sqlite3_value **aArgv);
-    static void makeLatinLow(QChar* c, int count);
     static int likeCompareLatinLow(
             QString* pattern,
             QString* string,
@@ -59,6 +59,25 @@ class TrackModel {
     // Gets the track ID of the track at the given QModelIndex
     virtual int getTrackId(const QModelIndex& index) const = 0;
 
+    // Gets the ID of the track at the given QModelIndex in the library table,
+    // or -1 if the track does not come from the library table. Tracks with a
+    // library ID can be loaded in the background with
+    // TrackDAO::requestTrack().
+    virtual int getLibraryTrackId(const QModelIndex& index) const {
+        Q_UNUSED(index);
+        return -1;
+    }
+
+    // Tells the model which rows the view shows, so that it can load the
+    // covers of the rows around them in the background before they are
+    // scrolled into view. coverWidth is the width of the cover art column.
+    virtual void prefetchCovers(int firstVisibleRow, int lastVisibleRow,
+                                int coverWidth) {
+        Q_UNUSED(firstVisibleRow);
+        Q_UNUSED(lastVisibleRow);
+        Q_UNUSED(coverWidth);
+    }
+
     // Gets the row of the track in the current result set. Returns -1 if the
     // track ID is not present in the result set.
     virtual const QLinkedList<int> getTrackRows(int trackId) const = 0;
@@ -0,0 +1,193 @@
+#include <limits>
+
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include "library/tracksearchindex.h"
+
+#include "library/searchquery.h"
+#include "library/trackcollection.h"
+#include "util/assert.h"
+#include "util/math.h"
+
+namespace {
+
+// Below this number of blocks the index is evaluated on the calling thread.
+const int kMinBlocksPerThread = 4;
+
+void evaluateRows(const TrackSearchIndex* pIndex, const QueryNode* pQuery,
+                  int begin, int end, qint8* pMatches) {
+    for (int row = begin; row < end; row += TrackSearchIndex::kBlockSize) {
+        const int blockEnd = math_min(end, row + TrackSearchIndex::kBlockSize);
+        pQuery->evaluate(*pIndex, row, blockEnd, pMatches + row);
+    }
+}
+
+}  // anonymous namespace
+
+TrackSearchIndex::TrackSearchIndex() {
+}
+
+TrackSearchIndex::~TrackSearchIndex() {
+}
+
+void TrackSearchIndex::addTextColumn(const QString& name, int fieldIndex) {
+    DEBUG_ASSERT_AND_HANDLE(m_trackIds.isEmpty() && fieldIndex >= 0) {
+        return;
+    }
+    Column<QString> column;
+    column.fieldIndex = fieldIndex;
+    m_textColumnForName[name] = m_textColumns.size();
+    m_textColumns.append(column);
+}
+
+void TrackSearchIndex::addNumericColumn(const QString& name, int fieldIndex) {
+    DEBUG_ASSERT_AND_HANDLE(m_trackIds.isEmpty() && fieldIndex >= 0) {
+        return;
+    }
+    Column<double> column;
+    column.fieldIndex = fieldIndex;
+    m_numericColumnForName[name] = m_numericColumns.size();
+    m_numericColumns.append(column);
+}
+
+void TrackSearchIndex::clear() {
+    for (int i = 0; i < m_textColumns.size(); ++i) {
+        m_textColumns[i].values.clear();
+    }
+    for (int i = 0; i < m_numericColumns.size(); ++i) {
+        m_numericColumns[i].values.clear();
+    }
+    m_trackIds.clear();
+    m_rowForTrackId.clear();
+}
+
+void TrackSearchIndex::updateTrack(int trackId,
+                                   const QVector<QVariant>& record) {
+    int row = m_rowForTrackId.value(trackId, -1);
+    if (row < 0) {
+        row = m_trackIds.size();
+        m_trackIds.append(trackId);
+        m_rowForTrackId.insert(trackId, row);
+        for (int i = 0; i < m_textColumns.size(); ++i) {
+            m_textColumns[i].values.append(QString());
+        }
+        for (int i = 0; i < m_numericColumns.size(); ++i) {
+            m_numericColumns[i].values.append(0.0);
+        }
+    }
+
+    for (int i = 0; i < m_textColumns.size(); ++i) {
+        Column<QString>& column = m_textColumns[i];
+        const QVariant value = record.value(column.fieldIndex);
+        column.values[row] = value.isNull() ?
+                QString() : foldText(value.toString());
+    }
+    for (int i = 0; i < m_numericColumns.size(); ++i) {
+        Column<double>& column = m_numericColumns[i];
+        column.values[row] = toNumber(record.value(column.fieldIndex));
+    }
+}
+
+void TrackSearchIndex::removeTrack(int trackId) {
+    const int row = m_rowForTrackId.value(trackId, -1);
+    if (row < 0) {
+        return;
+    }
+    m_rowForTrackId.remove(trackId);
+
+    // Move the last row into the place of the removed one.
+    const int lastRow = m_trackIds.size() - 1;
+    if (row != lastRow) {
+        const int lastTrackId = m_trackIds[lastRow];
+        m_trackIds[row] = lastTrackId;
+        m_rowForTrackId[lastTrackId] = row;
+        for (int i = 0; i < m_textColumns.size(); ++i) {
+            QVector<QString>& values = m_textColumns[i].values;
+            values[row] = values[lastRow];
+        }
+        for (int i = 0; i < m_numericColumns.size(); ++i) {
+            QVector<double>& values = m_numericColumns[i].values;
+            values[row] = values[lastRow];
+        }
+    }
+    m_trackIds.resize(lastRow);
+    for (int i = 0; i < m_textColumns.size(); ++i) {
+        m_textColumns[i].values.resize(lastRow);
+    }
+    for (int i = 0; i < m_numericColumns.size(); ++i) {
+        m_numericColumns[i].values.resize(lastRow);
+    }
+}
+
+bool TrackSearchIndex::evaluate(const QueryNode& query,
+                                QVector<qint8>* pMatches) const {
+    if (!query.canEvaluate(*this)) {
+        return false;
+    }
+
+    const int rows = rowCount();
+    pMatches->resize(rows);
+    if (rows == 0) {
+        return true;
+    }
+    qint8* pData = pMatches->data();
+
+    const int blocks = (rows + kBlockSize - 1) / kBlockSize;
+    const int threads = math_clamp(blocks / kMinBlocksPerThread,
+                                   1, QThread::idealThreadCount());
+    if (threads <= 1) {
+        evaluateRows(this, &query, 0, rows, pData);
+        return true;
+    }
+
+    // Every thread evaluates a range of whole blocks. The last range is
+    // evaluated on this thread.
+    const int blocksPerThread = (blocks + threads - 1) / threads;
+    QList<QFuture<void> > futures;
+    int begin = 0;
+    for (int i = 0; i < threads - 1 && begin < rows; ++i) {
+        const int end = math_min(rows, begin + blocksPerThread * kBlockSize);
+        futures.append(QtConcurrent::run(evaluateRows, this, &query,
+                                         begin, end, pData));
+        begin = end;
+    }
+    evaluateRows(this, &query, begin, rows, pData);
+    for (int i = 0; i < futures.size(); ++i) {
+        futures[i].waitForFinished();
+    }
+    return true;
+}
+
+// static
+QString TrackSearchIndex::foldText(const QString& text) {
+    if (text.isNull()) {
+        return QString();
+    }
+    QString folded(text);
+    TrackCollection::makeLatinLow(folded.data(), folded.length());
+    return folded;
+}
+
+// static
+bool TrackSearchIndex::containsWordPrefix(const QString& text,
+                                          const QString& prefix) {
+    int from = 0;
+    int position;
+    while ((position = text.indexOf(prefix, from)) >= 0) {
+        if (position == 0 || !text.at(position - 1).isLetterOrNumber()) {
+            return true;
+        }
+        from = position + 1;
+    }
+    return false;
+}
+
+// static
+double TrackSearchIndex::toNumber(const QVariant& value) {
+    bool ok = false;
+    const double number = value.isNull() ? 0.0 : value.toDouble(&ok);
+    return ok ? number : std::numeric_limits<double>::quiet_NaN();
+}
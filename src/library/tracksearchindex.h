@@ -0,0 +1,122 @@
+#ifndef TRACKSEARCHINDEX_H
+#define TRACKSEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class QueryNode;
+
+// TrackSearchIndex is a columnar copy of the searchable columns of a
+// BaseTrackCache. Text columns are stored folded the same way the LIKE
+// operator of the library database folds them (see
+// TrackCollection::makeLatinLow), numeric columns as doubles. This allows
+// evaluating most search queries without going to SQL.
+//
+// Each track is stored in a row. Rows are not stable: removing a track moves
+// the last row into its place.
+class TrackSearchIndex {
+  public:
+    // The result of evaluating a query node for a row. Like in SQL a
+    // comparison with NULL is neither true nor false, so e.g. NOT (artist LIKE
+    // '%a%') does not match tracks without an artist.
+    enum Match {
+        MATCH_FALSE = 0,
+        MATCH_TRUE = 1,
+        MATCH_NULL = 2
+    };
+
+    // Queries are evaluated in blocks of rows.
+    static const int kBlockSize = 4096;
+
+    TrackSearchIndex();
+    virtual ~TrackSearchIndex();
+
+    // Columns must be added before the first track is added. fieldIndex is
+    // the index of the column in the records passed to updateTrack().
+    void addTextColumn(const QString& name, int fieldIndex);
+    void addNumericColumn(const QString& name, int fieldIndex);
+
+    void clear();
+    void updateTrack(int trackId, const QVector<QVariant>& record);
+    void removeTrack(int trackId);
+
+    int rowCount() const {
+        return m_trackIds.size();
+    }
+    int trackId(int row) const {
+        return m_trackIds[row];
+    }
+    // Returns -1 if the track is not in the index.
+    int row(int trackId) const {
+        return m_rowForTrackId.value(trackId, -1);
+    }
+
+    // Return -1 if the column is not in the index.
+    int textColumn(const QString& name) const {
+        return m_textColumnForName.value(name, -1);
+    }
+    int numericColumn(const QString& name) const {
+        return m_numericColumnForName.value(name, -1);
+    }
+    // The folded text. It is a null QString if the value is NULL.
+    const QVector<QString>& textValues(int column) const {
+        return m_textColumns[column].values;
+    }
+    // NaN if the value is NULL or not a number.
+    const QVector<double>& numericValues(int column) const {
+        return m_numericColumns[column].values;
+    }
+
+    // Writes a Match per row to pMatches. Large indexes are evaluated on
+    // several threads. Returns false if the query can not be evaluated with
+    // the columns of this index.
+    bool evaluate(const QueryNode& query, QVector<qint8>* pMatches) const;
+
+    static QString foldText(const QString& text);
+    // Returns true if a word of the folded text starts with the folded
+    // prefix. Words are separated by anything but letters and digits, like
+    // the tokenizer of the full-text index does.
+    static bool containsWordPrefix(const QString& text, const QString& prefix);
+
+    static qint8 matchAnd(qint8 match1, qint8 match2) {
+        if (match1 == MATCH_FALSE || match2 == MATCH_FALSE) {
+            return MATCH_FALSE;
+        }
+        return (match1 == MATCH_NULL || match2 == MATCH_NULL) ?
+                MATCH_NULL : MATCH_TRUE;
+    }
+    static qint8 matchOr(qint8 match1, qint8 match2) {
+        if (match1 == MATCH_TRUE || match2 == MATCH_TRUE) {
+            return MATCH_TRUE;
+        }
+        return (match1 == MATCH_NULL || match2 == MATCH_NULL) ?
+                MATCH_NULL : MATCH_FALSE;
+    }
+    static qint8 matchNot(qint8 match) {
+        if (match == MATCH_NULL) {
+            return MATCH_NULL;
+        }
+        return match == MATCH_TRUE ? MATCH_FALSE : MATCH_TRUE;
+    }
+
+  private:
+    template <typename T>
+    struct Column {
+        int fieldIndex;
+        QVector<T> values;
+    };
+
+    static double toNumber(const QVariant& value);
+
+    QHash<QString, int> m_textColumnForName;
+    QHash<QString, int> m_numericColumnForName;
+    QVector<Column<QString> > m_textColumns;
+    QVector<Column<double> > m_numericColumns;
+
+    QVector<int> m_trackIds;
+    QHash<int, int> m_rowForTrackId;
+};
+
+#endif /* TRACKSEARCHINDEX_H */
@@ -0,0 +1,338 @@
+#include <algorithm>
+
+#include "library/tracksortindex.h"
+
+#include "util/assert.h"
+#include "util/math.h"
+
+namespace {
+
+// SQLite's lower() only folds ASCII letters.
+QString asciiLower(const QString& text) {
+    QString result(text);
+    QChar* pData = result.data();
+    for (int i = 0; i < result.size(); ++i) {
+        const ushort c = pData[i].unicode();
+        if (c >= 'A' && c <= 'Z') {
+            pData[i] = QChar(c + ('a' - 'A'));
+        }
+    }
+    return result;
+}
+
+// CAST(text AS INTEGER) uses the longest prefix that is an integer and 0 if
+// there is none.
+double textToInteger(const QString& text) {
+    int i = 0;
+    while (i < text.size() && text.at(i).isSpace()) {
+        ++i;
+    }
+    double sign = 1.0;
+    if (i < text.size() && (text.at(i) == '-' || text.at(i) == '+')) {
+        sign = text.at(i) == '-' ? -1.0 : 1.0;
+        ++i;
+    }
+    double result = 0.0;
+    while (i < text.size() && text.at(i) >= '0' && text.at(i) <= '9') {
+        result = result * 10.0 + (text.at(i).unicode() - '0');
+        ++i;
+    }
+    return sign * result;
+}
+
+bool isNumber(const QVariant& value) {
+    switch (value.type()) {
+        case QVariant::Bool:
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QVariant::Double:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // anonymous namespace
+
+TrackSortIndex::TrackSortIndex(const ColumnCache& columnCache,
+                               const QHash<int, QVector<QVariant> >& trackInfo)
+        : m_columnCache(columnCache),
+          m_trackInfo(trackInfo),
+          m_bSortedTrackIdsValid(false) {
+}
+
+TrackSortIndex::~TrackSortIndex() {
+}
+
+void TrackSortIndex::clear() {
+    m_columnOrders.clear();
+    m_bSortedTrackIdsValid = false;
+}
+
+void TrackSortIndex::updateTrack(int trackId) {
+    QHash<int, QVector<QVariant> >::const_iterator it =
+            m_trackInfo.constFind(trackId);
+    for (QHash<int, ColumnOrder>::iterator order = m_columnOrders.begin();
+            order != m_columnOrders.end(); ++order) {
+        removeTrack(&order.value(), trackId);
+        if (it != m_trackInfo.constEnd()) {
+            insertTrack(order.key(), &order.value(), trackId, it.value());
+        }
+    }
+    m_bSortedTrackIdsValid = false;
+}
+
+void TrackSortIndex::removeTrack(int trackId) {
+    for (QHash<int, ColumnOrder>::iterator order = m_columnOrders.begin();
+            order != m_columnOrders.end(); ++order) {
+        removeTrack(&order.value(), trackId);
+    }
+    m_bSortedTrackIdsValid = false;
+}
+
+const QVector<int>& TrackSortIndex::sortedTrackIds(
+        const QList<SortColumn>& sortColumns) {
+    if (m_bSortedTrackIdsValid && sortColumns == m_sortColumns) {
+        return m_sortedTrackIds;
+    }
+    m_sortColumns = sortColumns;
+    m_bSortedTrackIdsValid = true;
+    m_sortedTrackIds.resize(0);
+    DEBUG_ASSERT_AND_HANDLE(!sortColumns.isEmpty()) {
+        return m_sortedTrackIds;
+    }
+
+    const SortColumn& primary = sortColumns.first();
+    const ColumnOrder& primaryOrder = columnOrder(primary.column);
+    if (sortColumns.size() == 1 && primary.order == Qt::AscendingOrder) {
+        m_sortedTrackIds = primaryOrder.trackIds;
+        return m_sortedTrackIds;
+    }
+
+    // Find the ranges of tracks that are equal in the primary column.
+    const QHash<int, int>& primaryRanks = columnRanks(primary.column);
+    QVector<int> groupStarts;
+    int lastRank = -1;
+    for (int i = 0; i < primaryOrder.trackIds.size(); ++i) {
+        const int rank = primaryRanks.value(primaryOrder.trackIds[i]);
+        if (rank != lastRank) {
+            groupStarts.append(i);
+            lastRank = rank;
+        }
+    }
+    groupStarts.append(primaryOrder.trackIds.size());
+
+    QList<QPair<const QHash<int, int>*, bool> > tieRanks;
+    for (int i = 1; i < sortColumns.size(); ++i) {
+        tieRanks.append(qMakePair(&columnRanks(sortColumns[i].column),
+                                  sortColumns[i].order == Qt::DescendingOrder));
+    }
+    // Sorts ties by the ranks of the other columns. Tracks that are equal in
+    // all columns stay in the order of their ids.
+    auto lessThan = [&tieRanks](int trackId1, int trackId2) {
+        for (int i = 0; i < tieRanks.size(); ++i) {
+            const int rank1 = tieRanks[i].first->value(trackId1);
+            const int rank2 = tieRanks[i].first->value(trackId2);
+            if (rank1 != rank2) {
+                return tieRanks[i].second ? rank1 > rank2 : rank1 < rank2;
+            }
+        }
+        return false;
+    };
+
+    m_sortedTrackIds.reserve(primaryOrder.trackIds.size());
+    const int groupCount = groupStarts.size() - 1;
+    for (int i = 0; i < groupCount; ++i) {
+        const int group = primary.order == Qt::AscendingOrder ?
+                i : groupCount - 1 - i;
+        const int start = m_sortedTrackIds.size();
+        for (int j = groupStarts[group]; j < groupStarts[group + 1]; ++j) {
+            m_sortedTrackIds.append(primaryOrder.trackIds[j]);
+        }
+        if (!tieRanks.isEmpty() && m_sortedTrackIds.size() - start > 1) {
+            std::stable_sort(m_sortedTrackIds.begin() + start,
+                             m_sortedTrackIds.end(), lessThan);
+        }
+    }
+    return m_sortedTrackIds;
+}
+
+// static
+int TrackSortIndex::compareValues(ColumnCache::SortType sortType,
+                                  const QVariant& value1,
+                                  const QVariant& value2) {
+    return compareKeys(sortKey(sortType, value1), sortKey(sortType, value2));
+}
+
+// static
+TrackSortIndex::SortKey TrackSortIndex::sortKey(
+        ColumnCache::SortType sortType, const QVariant& value) {
+    SortKey key;
+    key.type = SortKey::TYPE_NULL;
+    key.number = 0.0;
+    if (value.isNull()) {
+        return key;
+    }
+
+    switch (sortType) {
+        case ColumnCache::SORT_NO_CASE:
+            key.type = SortKey::TYPE_TEXT;
+            key.text = asciiLower(value.toString());
+            break;
+        case ColumnCache::SORT_INTEGER:
+            key.type = SortKey::TYPE_NUMBER;
+            if (isNumber(value)) {
+                // Casting a real to an integer truncates it.
+                const double number = value.toDouble();
+                key.number = number < 0.0 ? ceil(number) : floor(number);
+            } else {
+                key.number = textToInteger(value.toString());
+            }
+            break;
+        case ColumnCache::SORT_VALUE:
+        default:
+            if (isNumber(value)) {
+                key.type = SortKey::TYPE_NUMBER;
+                key.number = value.toDouble();
+            } else if (value.type() == QVariant::ByteArray) {
+                key.type = SortKey::TYPE_BLOB;
+                key.text = QString::fromLatin1(value.toByteArray());
+            } else {
+                key.type = SortKey::TYPE_TEXT;
+                key.text = value.toString();
+            }
+            break;
+    }
+    return key;
+}
+
+// static
+int TrackSortIndex::compareKeys(const SortKey& key1, const SortKey& key2) {
+    if (key1.type != key2.type) {
+        return key1.type < key2.type ? -1 : 1;
+    }
+    switch (key1.type) {
+        case SortKey::TYPE_NUMBER:
+            if (key1.number == key2.number) {
+                return 0;
+            }
+            return key1.number < key2.number ? -1 : 1;
+        case SortKey::TYPE_TEXT:
+#ifdef __SQLITE3__
+            // BaseSqlTableModel sorts with COLLATE localeAwareCompare.
+            return QString::localeAwareCompare(key1.text, key2.text);
+#else
+            return key1.text.compare(key2.text);
+#endif
+        case SortKey::TYPE_BLOB:
+            return key1.text.compare(key2.text);
+        case SortKey::TYPE_NULL:
+        default:
+            return 0;
+    }
+}
+
+TrackSortIndex::ColumnOrder& TrackSortIndex::columnOrder(int column) {
+    QHash<int, ColumnOrder>::iterator it = m_columnOrders.find(column);
+    if (it != m_columnOrders.end()) {
+        return it.value();
+    }
+
+    const ColumnCache::SortType sortType =
+            m_columnCache.columnSortTypeForFieldIndex(column);
+    QVector<QPair<SortKey, int> > entries;
+    entries.reserve(m_trackInfo.size());
+    for (QHash<int, QVector<QVariant> >::const_iterator track =
+            m_trackInfo.constBegin(); track != m_trackInfo.constEnd(); ++track) {
+        entries.append(qMakePair(sortKey(sortType, track.value().value(column)),
+                                 track.key()));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const QPair<SortKey, int>& entry1,
+                 const QPair<SortKey, int>& entry2) {
+        const int compare = compareKeys(entry1.first, entry2.first);
+        return compare != 0 ? compare < 0 : entry1.second < entry2.second;
+    });
+
+    ColumnOrder& order = m_columnOrders[column];
+    order.trackIds.reserve(entries.size());
+    order.keys.reserve(entries.size());
+    order.trackKeys.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        order.keys.append(entries[i].first);
+        order.trackIds.append(entries[i].second);
+        order.trackKeys.insert(entries[i].second, entries[i].first);
+    }
+    return order;
+}
+
+const QHash<int, int>& TrackSortIndex::columnRanks(int column) {
+    ColumnOrder& order = columnOrder(column);
+    if (order.ranksValid) {
+        return order.ranks;
+    }
+    order.ranks.clear();
+    order.ranks.reserve(order.trackIds.size());
+    int rank = 0;
+    for (int i = 0; i < order.trackIds.size(); ++i) {
+        if (i > 0 && compareKeys(order.keys[i - 1], order.keys[i]) != 0) {
+            ++rank;
+        }
+        order.ranks.insert(order.trackIds[i], rank);
+    }
+    order.ranksValid = true;
+    return order.ranks;
+}
+
+void TrackSortIndex::insertTrack(int column, ColumnOrder* pOrder, int trackId,
+                                 const QVector<QVariant>& record) {
+    const SortKey key = sortKey(
+            m_columnCache.columnSortTypeForFieldIndex(column),
+            record.value(column));
+
+    const int index = lowerBound(*pOrder, key, trackId);
+    pOrder->trackIds.insert(index, trackId);
+    pOrder->keys.insert(index, key);
+    pOrder->trackKeys.insert(trackId, key);
+    pOrder->ranksValid = false;
+}
+
+// static
+void TrackSortIndex::removeTrack(ColumnOrder* pOrder, int trackId) {
+    QHash<int, SortKey>::iterator it = pOrder->trackKeys.find(trackId);
+    if (it == pOrder->trackKeys.end()) {
+        return;
+    }
+    const int index = lowerBound(*pOrder, it.value(), trackId);
+    pOrder->trackKeys.erase(it);
+    DEBUG_ASSERT_AND_HANDLE(index < pOrder->trackIds.size() &&
+                            pOrder->trackIds[index] == trackId) {
+        return;
+    }
+    pOrder->trackIds.remove(index);
+    pOrder->keys.remove(index);
+    pOrder->ranksValid = false;
+}
+
+// static
+int TrackSortIndex::lowerBound(const ColumnOrder& order, const SortKey& key,
+                               int trackId) {
+    int min = 0;
+    int max = order.trackIds.size();
+    while (min < max) {
+        const int mid = min + (max - min) / 2;
+        int compare = compareKeys(order.keys[mid], key);
+        if (compare == 0) {
+            compare = order.trackIds[mid] < trackId ? -1 :
+                    (order.trackIds[mid] > trackId ? 1 : 0);
+        }
+        if (compare < 0) {
+            min = mid + 1;
+        } else {
+            max = mid;
+        }
+    }
+    return min;
+}
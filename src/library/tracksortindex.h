@@ -0,0 +1,117 @@
+#ifndef TRACKSORTINDEX_H
+#define TRACKSORTINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "library/columncache.h"
+
+// TrackSortIndex keeps the track ids of a BaseTrackCache sorted by every
+// column that has been sorted by. Tracks are ordered like SQLite orders them
+// for the ORDER BY clauses of BaseSqlTableModel, i.e. by the sort expression
+// of the column (see ColumnCache::SortType) and with the localeAwareCompare
+// collation. Changed tracks are moved to their new place with a binary
+// search, so sorting by another column or by the same columns again does
+// not need the database.
+class TrackSortIndex {
+  public:
+    struct SortColumn {
+        SortColumn(int column, Qt::SortOrder order)
+                : column(column),
+                  order(order) {
+        }
+        bool operator==(const SortColumn& other) const {
+            return column == other.column && order == other.order;
+        }
+
+        // The field index in the BaseTrackCache.
+        int column;
+        Qt::SortOrder order;
+    };
+
+    // The values of the tracks are read from trackInfo, which is the record
+    // cache of a BaseTrackCache.
+    TrackSortIndex(const ColumnCache& columnCache,
+                   const QHash<int, QVector<QVariant> >& trackInfo);
+    virtual ~TrackSortIndex();
+
+    // Forgets all columns. They are sorted again when they are needed.
+    void clear();
+    // Moves the track to its new place after its record in trackInfo has
+    // changed.
+    void updateTrack(int trackId);
+    void removeTrack(int trackId);
+
+    // Returns all track ids sorted by the columns. Ties of the first column
+    // are sorted by the next one.
+    const QVector<int>& sortedTrackIds(const QList<SortColumn>& sortColumns);
+
+    // Compares two values like SQLite compares the results of the sort
+    // expression. Returns a negative number, zero or a positive number.
+    static int compareValues(ColumnCache::SortType sortType,
+                             const QVariant& value1, const QVariant& value2);
+
+  private:
+    // The result of the sort expression for a value.
+    struct SortKey {
+        // SQLite sorts NULL before numbers, numbers before text and text
+        // before blobs.
+        enum Type {
+            TYPE_NULL = 0,
+            TYPE_NUMBER,
+            TYPE_TEXT,
+            TYPE_BLOB
+        };
+
+        Type type;
+        double number;
+        // Blobs are stored as Latin-1, which keeps their byte order.
+        QString text;
+    };
+
+    struct ColumnOrder {
+        ColumnOrder()
+                : ranksValid(false) {
+        }
+
+        // Sorted ascending, ties by track id.
+        QVector<int> trackIds;
+        QVector<SortKey> keys;
+        // The key each track is sorted by, so it can be found with a binary
+        // search after its value has changed.
+        QHash<int, SortKey> trackKeys;
+        // Equal keys have the same rank. Only needed to sort ties of another
+        // column, so it is built on demand.
+        QHash<int, int> ranks;
+        bool ranksValid;
+    };
+
+    static SortKey sortKey(ColumnCache::SortType sortType,
+                           const QVariant& value);
+    static int compareKeys(const SortKey& key1, const SortKey& key2);
+    // Returns the index of the first track that does not sort before the
+    // track with key and trackId.
+    static int lowerBound(const ColumnOrder& order, const SortKey& key,
+                          int trackId);
+
+    ColumnOrder& columnOrder(int column);
+    const QHash<int, int>& columnRanks(int column);
+    void insertTrack(int column, ColumnOrder* pOrder, int trackId,
+                     const QVector<QVariant>& record);
+    static void removeTrack(ColumnOrder* pOrder, int trackId);
+
+    const ColumnCache& m_columnCache;
+    const QHash<int, QVector<QVariant> >& m_trackInfo;
+
+    QHash<int, ColumnOrder> m_columnOrders;
+
+    // The result of the last call to sortedTrackIds().
+    QList<SortColumn> m_sortColumns;
+    QVector<int> m_sortedTrackIds;
+    bool m_bSortedTrackIdsValid;
+};
+
+#endif /* TRACKSORTINDEX_H */
@@ -0,0 +1,71 @@
+#include <QAtomicInt>
+#include <QSqlError>
+#include <QThreadStorage>
+#include <QtDebug>
+
+#include "library/workerdatabase.h"
+#include "util/compatibility.h"
+
+namespace {
+
+class WorkerConnection {
+  public:
+    WorkerConnection(const QString& driverName,
+                     const QString& databaseName,
+                     int generation)
+            : m_connectionName(QString("LIBRARY_WORKER_%1").arg(
+                      s_connectionCount.fetchAndAddRelaxed(1))),
+              m_generation(generation) {
+        m_database = QSqlDatabase::addDatabase(driverName, m_connectionName);
+        m_database.setDatabaseName(databaseName);
+        if (!m_database.open()) {
+            qWarning() << "Failed to open database in worker thread"
+                       << m_database.lastError();
+        }
+    }
+
+    ~WorkerConnection() {
+        m_database.close();
+        m_database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+
+    const QSqlDatabase& database() const {
+        return m_database;
+    }
+
+    int generation() const {
+        return m_generation;
+    }
+
+  private:
+    static QAtomicInt s_connectionCount;
+    const QString m_connectionName;
+    const int m_generation;
+    QSqlDatabase m_database;
+};
+
+QAtomicInt WorkerConnection::s_connectionCount;
+
+// Incremented by resetWorkerThreadDatabases().
+QAtomicInt s_generation;
+
+QThreadStorage<WorkerConnection*> s_workerConnections;
+
+}  // anonymous namespace
+
+QSqlDatabase workerThreadDatabase(const QString& driverName,
+                                  const QString& databaseName) {
+    const int generation = load_atomic(s_generation);
+    if (!s_workerConnections.hasLocalData() ||
+            s_workerConnections.localData()->generation() != generation) {
+        // Replacing the connection deletes the old one.
+        s_workerConnections.setLocalData(
+                new WorkerConnection(driverName, databaseName, generation));
+    }
+    return s_workerConnections.localData()->database();
+}
+
+void resetWorkerThreadDatabases() {
+    s_generation.fetchAndAddRelease(1);
+}
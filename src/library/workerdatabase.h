@@ -0,0 +1,21 @@
+#ifndef WORKERDATABASE_H
+#define WORKERDATABASE_H
+
+#include <QSqlDatabase>
+#include <QString>
+
+// Returns a connection to the database databaseName for the calling thread.
+// A QSqlDatabase connection must only be used by the thread that created it,
+// so library code that queries the database from QtConcurrent worker threads
+// uses these connections. Each thread opens its connection when it asks for
+// it the first time, and the connection is closed when the thread exits.
+// Check isOpen() on the result, opening the database may have failed.
+QSqlDatabase workerThreadDatabase(const QString& driverName,
+                                  const QString& databaseName);
+
+// Makes all threads open a new connection the next time they call
+// workerThreadDatabase(). Called when the database is closed, because it may
+// be replaced with a new file before it is opened again.
+void resetWorkerThreadDatabases();
+
+#endif /* WORKERDATABASE_H */
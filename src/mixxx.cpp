@@ -63,6 +63,7 @@
 #include "widget/wwidget.h"
 #include "widget/wspinny.h"
 #include "sharedglcontext.h"
+#include "util/callbackbudget.h"
 #include "util/debug.h"
 #include "util/statsmanager.h"
 #include "util/timer.h"
@@ -133,6 +134,7 @@ MixxxMainWindow::MixxxMainWindow(QApplication* pApp, const CmdlineArgs& args)
     // Only record stats in developer mode.
     if (m_cmdLineArgs.getDeveloper()) {
         StatsManager::create();
+        CallbackBudget::create();
     }
 
     QString resourcePath = m_pConfig->getResourcePath();
@@ -281,7 +283,9 @@ MixxxMainWindow::MixxxMainWindow(QApplication* pApp, const CmdlineArgs& args)
     delete pModplugPrefs; // not needed anymore
 #endif
 
-    CoverArtCache::create();
+    CoverArtCache* pCoverArtCache = CoverArtCache::create();
+    pCoverArtCache->setDiskCacheFile(
+            m_pConfig->getSettingsPath().append("/coverart_thumbnails.pack"));
 
     m_pLibrary = new Library(this, m_pConfig,
                              m_pPlayerManager,
@@ -432,6 +436,12 @@ MixxxMainWindow::MixxxMainWindow(QApplication* pApp, const CmdlineArgs& args)
     if (rescan || hasChanged_MusicDir || upgrader.rescanLibrary()) {
         m_pLibraryScanner->scan();
     }
+    // Catches up with the changes made while Mixxx was not running by only
+    // scanning the directories that have been modified since.
+    if (m_pConfig->getValueString(
+            ConfigKey("[Library]", "WatchDirectories")).toInt()) {
+        m_pLibraryScanner->setWatchDirectories(true);
+    }
     slotNumDecksChanged(m_pNumDecks->get());
 
     // Try open player device If that fails, the preference panel is opened.
@@ -629,6 +639,7 @@ MixxxMainWindow::~MixxxMainWindow() {
     t.elapsed(true);
     // Report the total time we have been running.
     m_runtime_timer.elapsed(true);
+    CallbackBudget::destroy();
     StatsManager::destroy();
 }
 
@@ -2178,6 +2189,10 @@ void MixxxMainWindow::slotScanLibrary() {
     m_pLibraryScanner->scan();
 }
 
+void MixxxMainWindow::slotWatchLibraryDirectories(bool watch) {
+    m_pLibraryScanner->setWatchDirectories(watch);
+}
+
 void MixxxMainWindow::slotEnableRescanLibraryAction() {
     m_pLibraryRescan->setEnabled(true);
     emit(libraryScanFinished());
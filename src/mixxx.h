@@ -110,6 +110,8 @@ class MixxxMainWindow : public QMainWindow {
     void slotHelpTranslation();
     // Scan or rescan the music library directory
     void slotScanLibrary();
+    // Start or stop watching the music library directories for changes
+    void slotWatchLibraryDirectories(bool watch);
     // Enables the "Rescan Library" menu item. This gets disabled when a scan is running.
     void slotEnableRescanLibraryAction();
     //Updates the checkboxes for Recording and Livebroadcasting when connection drops, or lame is not available
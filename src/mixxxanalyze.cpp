@@ -0,0 +1,230 @@
+// mixxx-analyze: Analyses tracks of a Mixxx library from the command line.
+//
+// Usage: mixxx-analyze [--settingsPath PATH] [--threads N] [FILE|DIR ...]
+//
+// Without any files or directories all tracks of the library are analysed.
+
+#include <stdio.h>
+
+#include <QDir>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtDebug>
+
+#include "mixxxanalyze.h"
+#include "analyserqueue.h"
+#include "library/dao/trackdao.h"
+#include "library/trackcollection.h"
+#include "playerinfo.h"
+#include "soundsourceproxy.h"
+#include "util/cmdlineargs.h"
+#include "util/console.h"
+
+#ifdef __FFMPEGFILE__
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+#endif
+
+BatchAnalyzer::BatchAnalyzer(ConfigObject<ConfigValue>* pConfig,
+                             TrackCollection* pTrackCollection)
+        : m_pConfig(pConfig),
+          m_pTrackCollection(pTrackCollection),
+          m_pAnalyserQueue(NULL),
+          m_queuedTracks(0),
+          m_finishedTracks(0),
+          m_bFinished(false) {
+}
+
+BatchAnalyzer::~BatchAnalyzer() {
+    delete m_pAnalyserQueue;
+}
+
+int BatchAnalyzer::queueTracks(const QStringList& locations) {
+    QList<int> trackIds = locations.isEmpty() ?
+            getLibraryTrackIds() : addTracks(locations);
+    if (trackIds.isEmpty()) {
+        return 0;
+    }
+
+    // Same as the analysis feature: always detect the BPM.
+    m_pConfig->set(ConfigKey("[BPM]","BPMDetectionEnabled"), ConfigValue(1));
+
+    m_pAnalyserQueue = AnalyserQueue::createBatchAnalyserQueue(
+            m_pConfig, m_pTrackCollection);
+    connect(m_pAnalyserQueue, SIGNAL(trackFinished(int)),
+            this, SLOT(slotTrackFinished(int)));
+    connect(m_pAnalyserQueue, SIGNAL(queueEmpty()),
+            this, SLOT(slotQueueEmpty()));
+
+    m_time.start();
+    // The same file may be given more than once, directly and through its
+    // directory.
+    TrackDAO& trackDao = m_pTrackCollection->getTrackDAO();
+    QSet<int> uniqueTrackIds;
+    QList<TrackPointer> tracks;
+    foreach (int trackId, trackIds) {
+        if (uniqueTrackIds.contains(trackId)) {
+            continue;
+        }
+        uniqueTrackIds.insert(trackId);
+        TrackPointer pTrack = trackDao.getTrack(trackId);
+        if (pTrack) {
+            tracks.append(pTrack);
+        }
+    }
+    m_queuedTracks = tracks.size();
+    m_pAnalyserQueue->queueAnalyseTracks(tracks);
+    printf("Analyzing %d tracks with %d threads\n", m_queuedTracks,
+           AnalyserQueue::analysisThreadCount(m_pConfig));
+    fflush(stdout);
+    return m_queuedTracks;
+}
+
+QList<int> BatchAnalyzer::getLibraryTrackIds() {
+    QList<int> trackIds;
+    QSqlQuery query(m_pTrackCollection->getDatabase());
+    query.prepare(QString("SELECT id FROM %1 WHERE %2=0")
+                  .arg(LIBRARY_TABLE, LIBRARYTABLE_MIXXXDELETED));
+    if (!query.exec()) {
+        qWarning() << "Failed to query the library" << query.lastError();
+        return trackIds;
+    }
+    while (query.next()) {
+        trackIds.append(query.value(0).toInt());
+    }
+    return trackIds;
+}
+
+QList<int> BatchAnalyzer::addTracks(const QStringList& locations) {
+    QList<QFileInfo> files;
+    foreach (const QString& location, locations) {
+        QFileInfo fileInfo(location);
+        if (fileInfo.isDir()) {
+            QDirIterator it(fileInfo.absoluteFilePath(), QDir::Files,
+                            QDirIterator::Subdirectories |
+                            QDirIterator::FollowSymlinks);
+            while (it.hasNext()) {
+                it.next();
+                if (SoundSourceProxy::isFileNameSupported(it.fileName())) {
+                    files.append(it.fileInfo());
+                }
+            }
+        } else if (fileInfo.isFile() &&
+                SoundSourceProxy::isFileNameSupported(fileInfo.fileName())) {
+            files.append(fileInfo);
+        } else {
+            qWarning() << "Skipping unsupported location" << location;
+        }
+    }
+    // Adds missing tracks and unremoves deleted ones, like dropping the
+    // files onto the analysis feature does.
+    return m_pTrackCollection->getTrackDAO().addTracks(files, true);
+}
+
+void BatchAnalyzer::slotTrackFinished(int queueSize) {
+    Q_UNUSED(queueSize);
+    ++m_finishedTracks;
+    const int elapsedMillis = m_time.elapsed();
+    const double tracksPerMinute = elapsedMillis > 0 ?
+            m_finishedTracks * 60000.0 / elapsedMillis : 0.0;
+    printf("Analyzed %d/%d tracks (%.1f tracks/min)\n",
+           m_finishedTracks, m_queuedTracks, tracksPerMinute);
+    fflush(stdout);
+}
+
+void BatchAnalyzer::slotQueueEmpty() {
+    // The queue may run empty while the tracks are still being queued.
+    // Another queueEmpty() signal follows in that case.
+    if (m_bFinished || !m_pAnalyserQueue->isEmpty()) {
+        return;
+    }
+    m_bFinished = true;
+    printf("Finished analyzing %d tracks in %.1f s\n",
+           m_finishedTracks, m_time.elapsed() / 1000.0);
+    fflush(stdout);
+    emit(finished());
+}
+
+namespace {
+
+void printUsage() {
+    printf("Usage: mixxx-analyze [--settingsPath PATH] [--threads N] [FILE|DIR ...]\n\n"
+           "Analyzes BPM, key, ReplayGain and waveforms of the given files and\n"
+           "directories, which are added to the library if necessary. Without\n"
+           "any files or directories all tracks of the library are analyzed.\n\n"
+           "--settingsPath PATH  Use the library and settings in PATH\n"
+           "--threads N          Number of tracks to analyze in parallel,\n"
+           "                     defaults to the number of cores\n");
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    Console console;
+
+    QString settingsPath = CmdlineArgs::Instance().getSettingsPath();
+    int threadCount = QThread::idealThreadCount();
+    QStringList locations;
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--settingsPath" && i + 1 < argc) {
+            settingsPath = QString::fromLocal8Bit(argv[++i]);
+            if (!settingsPath.endsWith("/")) {
+                settingsPath.append("/");
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else {
+            locations.append(arg);
+        }
+    }
+    if (threadCount < 1) {
+        printUsage();
+        return 1;
+    }
+
+    QThread::currentThread()->setObjectName("Main");
+    // No GUI, so the tool runs on servers without a display.
+    QCoreApplication app(argc, argv);
+
+#ifdef __FFMPEGFILE__
+    av_register_all();
+    avcodec_register_all();
+#endif
+
+    SoundSourceProxy::loadPlugins();
+
+    // The configuration is never saved, the settings below only apply to
+    // this run.
+    ConfigObject<ConfigValue> config(settingsPath + SETTINGS_FILE);
+    config.set(ConfigKey("[Library]", "AnalysisThreadCount"),
+               ConfigValue(threadCount));
+
+    // The analysis workers ask PlayerInfo for loaded tracks. It is a
+    // QObject with a timer, so it has to be created on this thread.
+    PlayerInfo::instance();
+
+    int result = 0;
+    {
+        TrackCollection trackCollection(&config);
+        BatchAnalyzer analyzer(&config, &trackCollection);
+        QObject::connect(&analyzer, SIGNAL(finished()), &app, SLOT(quit()));
+        if (analyzer.queueTracks(locations) > 0) {
+            result = app.exec();
+        } else {
+            printf("Nothing to analyze\n");
+        }
+    }
+    PlayerInfo::destroy();
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef MIXXXANALYZE_H
+#define MIXXXANALYZE_H
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTime>
+
+#include "configobject.h"
+#include "trackinfoobject.h"
+
+class AnalyserQueue;
+class TrackCollection;
+
+// BatchAnalyzer drives the mixxx-analyze tool. It analyses BPM, key,
+// ReplayGain and waveforms of either the whole library or of the tracks
+// found in a list of files and directories, without starting the GUI or
+// the sound engine. Results are stored in the library database just like
+// the analysis feature does it.
+class BatchAnalyzer : public QObject {
+    Q_OBJECT
+  public:
+    BatchAnalyzer(ConfigObject<ConfigValue>* pConfig,
+                  TrackCollection* pTrackCollection);
+    virtual ~BatchAnalyzer();
+
+    // Queues the tracks of all given files and directories. Tracks that are
+    // not in the library yet are added to it. With an empty list all tracks
+    // of the library are queued. Returns the number of queued tracks.
+    int queueTracks(const QStringList& locations);
+
+  signals:
+    void finished();
+
+  private slots:
+    void slotTrackFinished(int queueSize);
+    void slotQueueEmpty();
+
+  private:
+    QList<int> getLibraryTrackIds();
+    QList<int> addTracks(const QStringList& locations);
+
+    ConfigObject<ConfigValue>* m_pConfig;
+    TrackCollection* m_pTrackCollection;
+    AnalyserQueue* m_pAnalyserQueue;
+    QTime m_time;
+    int m_queuedTracks;
+    int m_finishedTracks;
+    bool m_bFinished;
+};
+
+#endif /* MIXXXANALYZE_H */
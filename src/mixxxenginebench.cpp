@@ -0,0 +1,518 @@
+// mixxx-enginebench: Renders decks through EngineMaster faster than real
+// time and reports how long each callback took.
+//
+// Usage: mixxx-enginebench [--decks N] [--scaler linear|soundtouch|rubberband]
+//                          [--tempo T] [--no-eq] [--effect-units N]
+//                          [--channel-threads N] [--samplerate HZ]
+//                          [--frames N] [--seconds S] [--max-xruns N]
+
+#include <stdio.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QtAlgorithms>
+#include <QtDebug>
+
+#include "mixxxenginebench.h"
+#include "controlobject.h"
+#include "effects/effectrack.h"
+#include "effects/effectsmanager.h"
+#include "effects/native/nativebackend.h"
+#include "engine/enginebuffer.h"
+#include "engine/enginedeck.h"
+#include "engine/enginemaster.h"
+#include "playermanager.h"
+#include "soundsourceproxy.h"
+#include "trackinfoobject.h"
+#include "util/callbackbudget.h"
+#include "util/callbackbudgetmodel.h"
+#include "util/console.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+#include "util/sleepableqthread.h"
+#include "util/types.h"
+
+namespace {
+
+// Same as the engine tests.
+const double kRateRange = 4.0;
+const double kRateDir = 1.0;
+
+const char* kEqualizerEffectId = "org.mixxx.effects.bessel8lvmixeq";
+const int kMaxEffectUnits = 4;
+
+// The stage records are read this often, well before the FIFO of
+// CallbackBudget fills up.
+const int kStagesUpdateCallbacks = 512;
+
+// Writes a little endian integer of the given number of bytes.
+void writeLittleEndian(QFile* pFile, quint32 value, int bytes) {
+    char data[4];
+    for (int i = 0; i < bytes; ++i) {
+        data[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    pFile->write(data, bytes);
+}
+
+} // anonymous namespace
+
+EngineBench::Options::Options()
+        : decks(4),
+          scaler(SCALER_LINEAR),
+          tempo(1.03),
+          eq(true),
+          effectUnits(0),
+          channelThreads(0),
+          sampleRate(44100),
+          framesPerBuffer(256),
+          seconds(60.0),
+          warmupSeconds(1.0) {
+}
+
+EngineBench::Result::Result()
+        : budgetNanos(0),
+          totalNanos(0),
+          overBudgetCallbacks(0) {
+}
+
+EngineBench::EngineBench(ConfigObject<ConfigValue>* pConfig,
+                         const Options& options)
+        : m_pConfig(pConfig),
+          m_options(options),
+          m_iBufferSize(options.framesPerBuffer * 2),
+          m_pNumDecks(NULL),
+          m_pEffectsManager(NULL),
+          m_pEngineMaster(NULL) {
+}
+
+EngineBench::~EngineBench() {
+    teardownEngine();
+}
+
+// static
+QString EngineBench::scalerName(Scaler scaler) {
+    switch (scaler) {
+        case SCALER_SOUNDTOUCH:
+            return "soundtouch";
+        case SCALER_RUBBERBAND:
+            return "rubberband";
+        case SCALER_LINEAR:
+        default:
+            return "linear";
+    }
+}
+
+// static
+bool EngineBench::writeTestTrack(const QString& path, int sampleRate,
+                                 double seconds) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not write test track" << path;
+        return false;
+    }
+    const int kChannels = 2;
+    const int kBytesPerSample = 2;
+    const quint32 frames = static_cast<quint32>(sampleRate * seconds);
+    const quint32 dataBytes = frames * kChannels * kBytesPerSample;
+
+    file.write("RIFF", 4);
+    writeLittleEndian(&file, 36 + dataBytes, 4);
+    file.write("WAVE", 4);
+    file.write("fmt ", 4);
+    writeLittleEndian(&file, 16, 4);
+    writeLittleEndian(&file, 1, 2); // PCM
+    writeLittleEndian(&file, kChannels, 2);
+    writeLittleEndian(&file, sampleRate, 4);
+    writeLittleEndian(&file, sampleRate * kChannels * kBytesPerSample, 4);
+    writeLittleEndian(&file, kChannels * kBytesPerSample, 2);
+    writeLittleEndian(&file, 8 * kBytesPerSample, 2);
+    file.write("data", 4);
+    writeLittleEndian(&file, dataBytes, 4);
+
+    // A kick at 120 BPM, two tones and some noise from a fixed seed, so the
+    // scalers, EQs and effects have something to chew on.
+    quint32 seed = 12345;
+    QVector<SAMPLE> block(2 * 4096);
+    quint32 frame = 0;
+    while (frame < frames) {
+        const int blockFrames = math_min(frames - frame, quint32(4096));
+        for (int i = 0; i < blockFrames; ++i, ++frame) {
+            const double t = static_cast<double>(frame) / sampleRate;
+            const double beatTime = fmod(t, 0.5);
+            const double kick = exp(-beatTime * 20.0) *
+                    sin(2 * M_PI * 55.0 * beatTime);
+            const double tones = 0.2 * sin(2 * M_PI * 440.0 * t) +
+                    0.1 * sin(2 * M_PI * 3520.0 * t);
+            seed = seed * 1664525 + 1013904223;
+            const double noise = 0.05 * ((seed >> 16) / 32768.0 - 1.0);
+            const double left = 0.5 * kick + tones + noise;
+            const double right = 0.5 * kick + tones - noise;
+            block[2 * i] = static_cast<SAMPLE>(left * 0.5 * SAMPLE_MAX);
+            block[2 * i + 1] = static_cast<SAMPLE>(right * 0.5 * SAMPLE_MAX);
+        }
+        // WAV samples are little endian, like all platforms Mixxx runs on.
+        file.write(reinterpret_cast<const char*>(block.constData()),
+                   blockFrames * kChannels * kBytesPerSample);
+    }
+    file.close();
+    return true;
+}
+
+void EngineBench::setupEngine() {
+    m_pConfig->set(ConfigKey("[Master]", "channel_worker_threads"),
+                   ConfigValue(m_options.channelThreads));
+
+    m_pNumDecks = new ControlObject(ConfigKey("[Master]", "num_decks"));
+    m_pEffectsManager = new EffectsManager(NULL, m_pConfig);
+    m_pEngineMaster = new EngineMaster(m_pConfig, "[Master]",
+                                       m_pEffectsManager, false, true);
+    m_pEffectsManager->addEffectsBackend(
+            new NativeBackend(m_pEffectsManager));
+    m_pEffectsManager->setupDefaults();
+
+    ControlObject::set(ConfigKey("[Master]", "samplerate"),
+                       m_options.sampleRate);
+    ControlObject::set(ConfigKey("[Master]", "enabled"), 1.0);
+    ControlObject::set(ConfigKey("[Master]", "keylock_engine"),
+                       static_cast<double>(
+                               m_options.scaler == SCALER_RUBBERBAND ?
+                               EngineBuffer::RUBBERBAND :
+                               EngineBuffer::SOUNDTOUCH));
+
+    for (int i = 0; i < m_options.decks; ++i) {
+        const QString group = PlayerManager::groupForDeck(i);
+        EngineDeck* pDeck = new EngineDeck(
+                m_pEngineMaster->registerChannelGroup(group), m_pConfig,
+                m_pEngineMaster, m_pEffectsManager,
+                i % 2 == 0 ? EngineChannel::LEFT : EngineChannel::RIGHT);
+        m_pEngineMaster->addChannel(pDeck);
+        m_decks.append(pDeck);
+        m_pNumDecks->set(m_pNumDecks->get() + 1);
+
+        ControlObject::set(ConfigKey(group, "master"), 1.0);
+        ControlObject::set(ConfigKey(group, "rate_dir"), kRateDir);
+        ControlObject::set(ConfigKey(group, "rateRange"), kRateRange);
+        setupEffects(pDeck);
+    }
+}
+
+void EngineBench::setupEffects(EngineDeck* pDeck) {
+    const QString& group = pDeck->getGroup();
+    if (m_options.eq) {
+        EqualizerRackPointer pEqRack = m_pEffectsManager->getEqualizerRack(0);
+        if (pEqRack) {
+            pEqRack->addEffectChainSlotForGroup(group);
+            pEqRack->loadEffectToGroup(
+                    group, m_pEffectsManager->instantiateEffect(
+                            kEqualizerEffectId));
+        }
+    }
+
+    for (int unit = 0; unit < m_options.effectUnits; ++unit) {
+        const QString unitGroup =
+                StandardEffectRack::formatEffectChainSlotGroupString(0, unit);
+        // Every unit gets a different chain: the first loads the first chain,
+        // the second the second and so on.
+        if (pDeck == m_decks.first()) {
+            for (int i = 0; i <= unit; ++i) {
+                ControlObject::set(ConfigKey(unitGroup, "next_chain"), 1.0);
+                ControlObject::set(ConfigKey(unitGroup, "next_chain"), 0.0);
+            }
+            ControlObject::set(ConfigKey(unitGroup, "mix"), 1.0);
+        }
+        ControlObject::set(
+                ConfigKey(unitGroup, QString("group_%1_enable").arg(group)),
+                1.0);
+    }
+}
+
+bool EngineBench::loadTrack(EngineDeck* pDeck, const QString& trackPath) {
+    TrackPointer pTrack(new TrackInfoObject(trackPath));
+    EngineBuffer* pBuffer = pDeck->getEngineBuffer();
+    pBuffer->slotLoadTrack(pTrack, false);
+
+    // The track is loaded by the reader worker, which is woken up at the
+    // end of every callback.
+    for (int i = 0; i < 1000 && !pBuffer->isTrackLoaded(); ++i) {
+        m_pEngineMaster->process(m_iBufferSize);
+        QCoreApplication::processEvents();
+        SleepableQThread::msleep(10);
+    }
+    return pBuffer->isTrackLoaded();
+}
+
+void EngineBench::teardownEngine() {
+    m_decks.clear();
+    // Deletes all EngineChannels added to it.
+    delete m_pEngineMaster;
+    m_pEngineMaster = NULL;
+    delete m_pEffectsManager;
+    m_pEffectsManager = NULL;
+    delete m_pNumDecks;
+    m_pNumDecks = NULL;
+}
+
+bool EngineBench::run(const QString& trackPath, Result* pResult,
+                      CallbackBudgetModel* pStages) {
+    setupEngine();
+    foreach (EngineDeck* pDeck, m_decks) {
+        if (!loadTrack(pDeck, trackPath)) {
+            qWarning() << "Could not load" << trackPath;
+            return false;
+        }
+        const QString& group = pDeck->getGroup();
+        ControlObject::set(ConfigKey(group, "repeat"), 1.0);
+        ControlObject::set(ConfigKey(group, "keylock"),
+                           m_options.scaler == SCALER_LINEAR ? 0.0 : 1.0);
+        ControlObject::set(ConfigKey(group, "rate"),
+                           (m_options.tempo - 1.0) / (kRateRange * kRateDir));
+        ControlObject::set(ConfigKey(group, "play"), 1.0);
+    }
+
+    const double callbacksPerSecond =
+            static_cast<double>(m_options.sampleRate) / m_options.framesPerBuffer;
+    const int warmupCallbacks =
+            static_cast<int>(m_options.warmupSeconds * callbacksPerSecond);
+    const int callbacks =
+            static_cast<int>(m_options.seconds * callbacksPerSecond);
+
+    // Lets the effect requests reach the engine and fills the read caches.
+    for (int i = 0; i < warmupCallbacks; ++i) {
+        m_pEngineMaster->process(m_iBufferSize);
+    }
+
+    pResult->budgetNanos = static_cast<qint64>(1e9 / callbacksPerSecond);
+    pResult->callbackNanos.resize(callbacks);
+    pResult->totalNanos = 0;
+    pResult->overBudgetCallbacks = 0;
+
+    CallbackBudget* pBudget = CallbackBudget::isEnabled() ?
+            CallbackBudget::instance() : NULL;
+    if (pBudget) {
+        pBudget->discardRecords();
+    }
+
+    bool previousOverBudget = false;
+    PerformanceTimer timer;
+    for (int i = 0; i < callbacks; ++i) {
+        timer.start();
+        m_pEngineMaster->process(m_iBufferSize);
+        const qint64 elapsed = timer.elapsed();
+
+        pResult->callbackNanos[i] = static_cast<qint32>(
+                math_min(elapsed, qint64(1 << 30)));
+        pResult->totalNanos += elapsed;
+        const bool overBudget = elapsed > pResult->budgetNanos;
+        if (overBudget) {
+            ++pResult->overBudgetCallbacks;
+        }
+        if (pBudget) {
+            // A sound card reports the xrun in the following callback.
+            pBudget->finishCallback(elapsed, pResult->budgetNanos,
+                                    previousOverBudget);
+        }
+        previousOverBudget = overBudget;
+        if (pStages && (i + 1) % kStagesUpdateCallbacks == 0) {
+            pStages->update();
+        }
+    }
+    if (pStages) {
+        pStages->update();
+    }
+    return true;
+}
+
+namespace {
+
+void printUsage() {
+    printf("Usage: mixxx-enginebench [OPTIONS]\n\n"
+           "Renders decks through the Mixxx engine as fast as possible and\n"
+           "reports the time of each callback compared to its budget.\n\n"
+           "--decks N            Number of playing decks (default 4)\n"
+           "--scaler NAME        linear, soundtouch or rubberband (default linear)\n"
+           "--tempo T            Playback speed of the decks (default 1.03)\n"
+           "--no-eq              Do not load an equalizer on the decks\n"
+           "--effect-units N     Enable N effect units on every deck (0-4)\n"
+           "--channel-threads N  Additional threads processing the decks\n"
+           "--samplerate HZ      Sample rate (default 44100)\n"
+           "--frames N           Frames per callback (default 256)\n"
+           "--seconds S          Seconds of audio to render (default 60)\n"
+           "--max-xruns N        Exit with 1 if more than N callbacks are\n"
+           "                     over budget\n");
+}
+
+void printReport(const EngineBench::Options& options,
+                 const EngineBench::Result& result) {
+    QVector<qint32> sorted = result.callbackNanos;
+    qSort(sorted);
+    const int count = sorted.size();
+    const double renderedSeconds = options.seconds;
+    const double elapsedSeconds = result.totalNanos / 1e9;
+
+    printf("Rendered %.1f s with %d decks (%s scaler, tempo %.2f, %s, "
+           "%d effect units, %d channel threads) in %.2f s, %.1fx real time\n",
+           renderedSeconds, options.decks,
+           EngineBench::scalerName(options.scaler).toLocal8Bit().constData(),
+           options.tempo, options.eq ? "EQ" : "no EQ", options.effectUnits,
+           options.channelThreads, elapsedSeconds,
+           elapsedSeconds > 0 ? renderedSeconds / elapsedSeconds : 0.0);
+    printf("Callback budget: %.1f us (%d frames at %d Hz)\n",
+           result.budgetNanos / 1000.0, options.framesPerBuffer,
+           options.sampleRate);
+    printf("Callback time (us): mean %.1f, p50 %.1f, p99 %.1f, p99.9 %.1f, "
+           "max %.1f\n",
+           count > 0 ? result.totalNanos / 1000.0 / count : 0.0,
+           CallbackBudgetModel::percentile(sorted, 0.5) / 1000.0,
+           CallbackBudgetModel::percentile(sorted, 0.99) / 1000.0,
+           CallbackBudgetModel::percentile(sorted, 0.999) / 1000.0,
+           count > 0 ? sorted.last() / 1000.0 : 0.0);
+    printf("Callbacks over budget (xrun equivalents): %d of %d\n",
+           result.overBudgetCallbacks, count);
+
+    // The share of the budget used, in 10% buckets.
+    QVector<int> histogram(CallbackBudgetModel::kHistogramBuckets, 0);
+    foreach (qint32 nanos, result.callbackNanos) {
+        const int bucket = static_cast<int>(10 * nanos / result.budgetNanos);
+        ++histogram[math_min(bucket, histogram.size() - 1)];
+    }
+    for (int i = 0; i < histogram.size(); ++i) {
+        if (i + 1 < histogram.size()) {
+            printf("  %3d-%3d%% %8d\n", 10 * i, 10 * (i + 1), histogram[i]);
+        } else {
+            printf("     >%3d%% %8d\n", 10 * i, histogram[i]);
+        }
+    }
+}
+
+void printStages(const CallbackBudgetModel& model) {
+    if (model.windowCallbackCount() == 0) {
+        return;
+    }
+    printf("Stages over the last %d callbacks (us):\n",
+           model.windowCallbackCount());
+    if (model.droppedRecordCount() > 0) {
+        printf("  %d callbacks were not recorded\n",
+               model.droppedRecordCount());
+    }
+    printf("  %-40s %9s %9s %9s %9s\n", "", "mean", "p50", "p99", "max");
+    for (int row = 0; row < model.rowCount(); ++row) {
+        printf("  %-40s %9s %9s %9s %9s\n",
+               model.data(model.index(row, CallbackBudgetModel::COLUMN_NAME))
+                       .toString().toLocal8Bit().constData(),
+               model.data(model.index(row, CallbackBudgetModel::COLUMN_MEAN))
+                       .toString().toLocal8Bit().constData(),
+               model.data(model.index(row, CallbackBudgetModel::COLUMN_P50))
+                       .toString().toLocal8Bit().constData(),
+               model.data(model.index(row, CallbackBudgetModel::COLUMN_P99))
+                       .toString().toLocal8Bit().constData(),
+               model.data(model.index(row, CallbackBudgetModel::COLUMN_MAX))
+                       .toString().toLocal8Bit().constData());
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    Console console;
+
+    EngineBench::Options options;
+    int maxXruns = -1;
+    bool validArgs = true;
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--no-eq") {
+            options.eq = false;
+        } else if (!hasValue) {
+            validArgs = false;
+        } else if (arg == "--decks") {
+            options.decks = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--scaler") {
+            const QString scaler = QString::fromLocal8Bit(argv[++i]);
+            if (scaler == "linear") {
+                options.scaler = EngineBench::SCALER_LINEAR;
+            } else if (scaler == "soundtouch") {
+                options.scaler = EngineBench::SCALER_SOUNDTOUCH;
+            } else if (scaler == "rubberband") {
+                options.scaler = EngineBench::SCALER_RUBBERBAND;
+            } else {
+                validArgs = false;
+            }
+        } else if (arg == "--tempo") {
+            options.tempo = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--effect-units") {
+            options.effectUnits = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--channel-threads") {
+            options.channelThreads = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--samplerate") {
+            options.sampleRate = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--frames") {
+            options.framesPerBuffer = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--seconds") {
+            options.seconds = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--max-xruns") {
+            maxXruns = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs || options.decks < 1 ||
+            options.decks > CallbackBudget::kMaxChannels ||
+            options.tempo <= 0.0 ||
+            options.effectUnits < 0 || options.effectUnits > kMaxEffectUnits ||
+            options.channelThreads < 0 || options.sampleRate <= 0 ||
+            options.framesPerBuffer <= 0 ||
+            options.framesPerBuffer * 2 > MAX_BUFFER_LEN ||
+            options.seconds <= 0.0) {
+        printUsage();
+        return 1;
+    }
+
+    QThread::currentThread()->setObjectName("Main");
+    // No GUI, so the benchmark runs on servers without a display.
+    QCoreApplication app(argc, argv);
+    SoundSourceProxy::loadPlugins();
+
+    // Neither the user's settings nor library are touched. The configuration
+    // is never saved.
+    const QString tempPath = QDir::temp().filePath(
+            QString("mixxx-enginebench-%1").arg(
+                    QCoreApplication::applicationPid()));
+    ConfigObject<ConfigValue> config(tempPath + ".cfg");
+
+    // The track is shorter than the rendered audio and repeats. Long enough
+    // that the read cache has to follow the play position.
+    const QString trackPath = tempPath + ".wav";
+    if (!EngineBench::writeTestTrack(trackPath, options.sampleRate,
+                                     math_min(options.seconds, 30.0) + 1.0)) {
+        return 1;
+    }
+
+    // Records the time of the engine stages.
+    CallbackBudget::create();
+
+    int result = 0;
+    {
+        EngineBench bench(&config, options);
+        EngineBench::Result benchResult;
+        CallbackBudgetModel stages;
+        if (bench.run(trackPath, &benchResult, &stages)) {
+            printReport(options, benchResult);
+            printStages(stages);
+            if (maxXruns >= 0 && benchResult.overBudgetCallbacks > maxXruns) {
+                result = 1;
+            }
+        } else {
+            result = 1;
+        }
+    }
+
+    CallbackBudget::destroy();
+    QFile::remove(trackPath);
+    return result;
+}
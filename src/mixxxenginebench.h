@@ -0,0 +1,90 @@
+#ifndef MIXXXENGINEBENCH_H
+#define MIXXXENGINEBENCH_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "configobject.h"
+
+class CallbackBudgetModel;
+class ControlObject;
+class EffectsManager;
+class EngineDeck;
+class EngineMaster;
+
+// EngineBench drives the mixxx-enginebench tool. It sets up EngineMaster
+// with a number of playing decks the same way MockedEngineBackendTest and
+// SignalPathTest do, but without a sound device, and renders a generated
+// track as fast as possible. The time of every callback is compared to the
+// time the callback would have had with a real sound card.
+class EngineBench {
+  public:
+    enum Scaler {
+        SCALER_LINEAR = 0,
+        SCALER_SOUNDTOUCH,
+        SCALER_RUBBERBAND
+    };
+
+    struct Options {
+        Options();
+
+        int decks;
+        Scaler scaler;
+        // Playback speed of all decks. 1.0 does not exercise the scalers.
+        double tempo;
+        bool eq;
+        // The number of standard effect units enabled on every deck.
+        int effectUnits;
+        int channelThreads;
+        int sampleRate;
+        int framesPerBuffer;
+        double seconds;
+        // Rendered before measuring, so the tracks and effects are loaded.
+        double warmupSeconds;
+    };
+
+    struct Result {
+        Result();
+
+        // Nanoseconds of each measured callback.
+        QVector<qint32> callbackNanos;
+        qint64 budgetNanos;
+        qint64 totalNanos;
+        int overBudgetCallbacks;
+    };
+
+    EngineBench(ConfigObject<ConfigValue>* pConfig, const Options& options);
+    virtual ~EngineBench();
+
+    static QString scalerName(Scaler scaler);
+
+    // Creates the engine, loads the track and renders. Returns false if the
+    // track could not be loaded. pStages, if given, reads the records of
+    // CallbackBudget while rendering, so it ends up with the stages of the
+    // last callbacks.
+    bool run(const QString& trackPath, Result* pResult,
+             CallbackBudgetModel* pStages = NULL);
+
+    // Writes a stereo 16 bit WAV file with a deterministic mix of tones and
+    // noise, so every run renders the same audio.
+    static bool writeTestTrack(const QString& path, int sampleRate,
+                               double seconds);
+
+  private:
+    void setupEngine();
+    void setupEffects(EngineDeck* pDeck);
+    bool loadTrack(EngineDeck* pDeck, const QString& trackPath);
+    void teardownEngine();
+
+    ConfigObject<ConfigValue>* m_pConfig;
+    const Options m_options;
+    const int m_iBufferSize;
+
+    ControlObject* m_pNumDecks;
+    EffectsManager* m_pEffectsManager;
+    EngineMaster* m_pEngineMaster;
+    QList<EngineDeck*> m_decks;
+};
+
+#endif /* MIXXXENGINEBENCH_H */
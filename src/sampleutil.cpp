@@ -4,6 +4,7 @@
 #include <cstdlib>
 
 #include "sampleutil.h"
+#include "sampleutil_simd.h"
 #include "util/math.h"
 
 #ifdef __WINDOWS__
@@ -29,6 +30,56 @@ static inline bool useAlignedAlloc() {
             sizeof(CSAMPLE*) == sizeof(size_t));
 }
 
+namespace {
+
+SampleUtil::SimdLevel detectSimdLevel() {
+#ifdef SAMPLEUTIL_AVX2
+    if (SampleUtilAVX2::isSupported()) {
+        return SampleUtil::SIMD_AVX2;
+    }
+#endif
+#ifdef SAMPLEUTIL_SSE2
+    return SampleUtil::SIMD_SSE2;
+#else
+    return SampleUtil::SIMD_NONE;
+#endif
+}
+
+const SampleUtil::SimdLevel s_supportedSimdLevel = detectSimdLevel();
+// Zero initialized before the detection runs, so anything that is called
+// during static initialization uses the plain loops.
+SampleUtil::SimdLevel s_simdLevel = s_supportedSimdLevel;
+
+} // anonymous namespace
+
+// Calls the kernel of the selected instruction set and returns its result.
+// Falls through to the plain loop that follows if there is none.
+#if defined(SAMPLEUTIL_AVX2)
+#define SAMPLEUTIL_DISPATCH(call) \
+    if (s_simdLevel == SIMD_AVX2) { \
+        return SampleUtilAVX2::call; \
+    } else if (s_simdLevel == SIMD_SSE2) { \
+        return SampleUtilSSE2::call; \
+    }
+#elif defined(SAMPLEUTIL_SSE2)
+#define SAMPLEUTIL_DISPATCH(call) \
+    if (s_simdLevel == SIMD_SSE2) { \
+        return SampleUtilSSE2::call; \
+    }
+#else
+#define SAMPLEUTIL_DISPATCH(call)
+#endif
+
+// static
+SampleUtil::SimdLevel SampleUtil::simdLevel() {
+    return s_simdLevel;
+}
+
+// static
+void SampleUtil::setSimdLevel(SimdLevel level) {
+    s_simdLevel = math_min(level, s_supportedSimdLevel);
+}
+
 // static
 CSAMPLE* SampleUtil::alloc(int size) {
     // To speed up vectorization we align our sample buffers to 16-byte (128
@@ -123,6 +174,8 @@ void SampleUtil::applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN old_gain,
             / CSAMPLE_GAIN(iNumSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
+        SAMPLEUTIL_DISPATCH(applyRampingGain(
+                pBuffer, start_gain, gain_delta, iNumSamples / 2));
         // note: LOOP VECTORIZED.
         for (int i = 0; i < iNumSamples / 2; ++i) {
             const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
@@ -160,6 +213,7 @@ void SampleUtil::addWithGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _RESTRICT
         return;
     }
 
+    SAMPLEUTIL_DISPATCH(addWithGain(pDest, pSrc, gain, iNumSamples));
     // note: LOOP VECTORIZED.
     for (int i = 0; i < iNumSamples; ++i) {
         pDest[i] += pSrc[i] * gain;
@@ -177,6 +231,8 @@ void SampleUtil::addWithRampingGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _RE
             / CSAMPLE_GAIN(iNumSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
+        SAMPLEUTIL_DISPATCH(addWithRampingGain(
+                pDest, pSrc, start_gain, gain_delta, iNumSamples / 2));
         // note: LOOP VECTORIZED.
         for (int i = 0; i < iNumSamples / 2; ++i) {
             const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
@@ -184,6 +240,7 @@ void SampleUtil::addWithRampingGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _RE
             pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
         }
     } else {
+        SAMPLEUTIL_DISPATCH(addWithGain(pDest, pSrc, old_gain, iNumSamples));
         // note: LOOP VECTORIZED.
         for (int i = 0; i < iNumSamples; ++i) {
             pDest[i] += pSrc[i] * old_gain;
@@ -237,6 +294,7 @@ void SampleUtil::copyWithGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _RESTRICT
         return;
     }
 
+    SAMPLEUTIL_DISPATCH(copyWithGain(pDest, pSrc, gain, iNumSamples));
     // note: LOOP VECTORIZED.
     for (int i = 0; i < iNumSamples; ++i) {
         pDest[i] = pSrc[i] * gain;
@@ -263,6 +321,8 @@ void SampleUtil::copyWithRampingGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _R
             / CSAMPLE_GAIN(iNumSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
+        SAMPLEUTIL_DISPATCH(copyWithRampingGain(
+                pDest, pSrc, start_gain, gain_delta, iNumSamples / 2));
         // note: LOOP VECTORIZED.
         for (int i = 0; i < iNumSamples / 2; ++i) {
             const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
@@ -270,6 +330,7 @@ void SampleUtil::copyWithRampingGain(CSAMPLE* _RESTRICT pDest, const CSAMPLE* _R
             pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
         }
     } else {
+        SAMPLEUTIL_DISPATCH(copyWithGain(pDest, pSrc, old_gain, iNumSamples));
         // note: LOOP VECTORIZED.
         for (int i = 0; i < iNumSamples; ++i) {
             pDest[i] = pSrc[i] * old_gain;
@@ -288,6 +349,7 @@ void SampleUtil::convertS16ToFloat32(CSAMPLE* _RESTRICT pDest, const SAMPLE* _RE
     // is the highest valid sample. Note that this means that although some
     // sample values convert to -1.0, none will convert to +1.0.
     DEBUG_ASSERT(-SAMPLE_MIN >= SAMPLE_MAX);
+    SAMPLEUTIL_DISPATCH(convertS16ToFloat32(pDest, pSrc, iNumSamples));
     const CSAMPLE kConversionFactor = -SAMPLE_MIN;
     // note: LOOP VECTORIZED.
     for (int i = 0; i < iNumSamples; ++i) {
@@ -308,6 +370,10 @@ void SampleUtil::convertFloat32ToS16(SAMPLE* pDest, const CSAMPLE* pSrc,
 // static
 bool SampleUtil::sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
         const CSAMPLE* pBuffer, int iNumSamples) {
+    // The kernels sum up in a different order, the sums may differ in the
+    // last bits.
+    SAMPLEUTIL_DISPATCH(sumAbsPerChannel(
+            pfAbsL, pfAbsR, pBuffer, iNumSamples / 2));
     CSAMPLE fAbsL = CSAMPLE_ZERO;
     CSAMPLE fAbsR = CSAMPLE_ZERO;
     CSAMPLE clipped = 0;
@@ -377,6 +443,7 @@ void SampleUtil::linearCrossfadeBuffers(CSAMPLE* pDest,
 // static
 void SampleUtil::mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc,
         int iNumSamples) {
+    SAMPLEUTIL_DISPATCH(mixStereoToMono(pDest, pSrc, iNumSamples / 2));
     const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE
             / (CSAMPLE_GAIN_ONE + CSAMPLE_GAIN_ONE);
     // note: LOOP VECTORIZED
@@ -43,6 +43,23 @@
 // A group of utilities for working with samples.
 class SampleUtil {
   public:
+    // Instruction sets for the hand-written kernels of the hot functions,
+    // see sampleutil_simd.h.
+    enum SimdLevel {
+        SIMD_NONE = 0,
+        SIMD_SSE2,
+        SIMD_AVX2,
+    };
+
+    // Returns the instruction set that is used. It is detected once at
+    // startup.
+    static SimdLevel simdLevel();
+
+    // Overrides the detected instruction set. Levels that are not supported
+    // by the CPU or the build fall back to the best supported one. Only
+    // meant for tests and benchmarks.
+    static void setSimdLevel(SimdLevel level);
+
     // Allocated a buffer of CSAMPLE's with length size. Ensures that the buffer
     // is 16-byte aligned for SSE enhancement.
     static CSAMPLE* alloc(int size);
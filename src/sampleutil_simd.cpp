@@ -0,0 +1,376 @@
+// sampleutil_simd.cpp
+// See sampleutil_simd.h. The loops at the end of every kernel process the
+// samples that don't fill a whole register with the same math as the
+// vectorized part.
+
+#include <cmath>
+
+#include "sampleutil_simd.h"
+
+#ifdef SAMPLEUTIL_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SAMPLEUTIL_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SAMPLEUTIL_TARGET_AVX2
+#else
+#define SAMPLEUTIL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifdef SAMPLEUTIL_SSE2
+namespace SampleUtilSSE2 {
+
+void applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta, int numFrames) {
+    // Two stereo frames per register, both channels share the gain.
+    const __m128 delta = _mm_set1_ps(gainDelta);
+    const __m128 start = _mm_set1_ps(startGain);
+    const __m128 step = _mm_set1_ps(2.0f);
+    __m128 frame = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    int i = 0;
+    for (; i + 2 <= numFrames; i += 2) {
+        const __m128 gain = _mm_add_ps(start, _mm_mul_ps(delta, frame));
+        _mm_storeu_ps(pBuffer + i * 2,
+                _mm_mul_ps(_mm_loadu_ps(pBuffer + i * 2), gain));
+        frame = _mm_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+void copyWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames) {
+    const __m128 delta = _mm_set1_ps(gainDelta);
+    const __m128 start = _mm_set1_ps(startGain);
+    const __m128 step = _mm_set1_ps(2.0f);
+    __m128 frame = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    int i = 0;
+    for (; i + 2 <= numFrames; i += 2) {
+        const __m128 gain = _mm_add_ps(start, _mm_mul_ps(delta, frame));
+        _mm_storeu_ps(pDest + i * 2,
+                _mm_mul_ps(_mm_loadu_ps(pSrc + i * 2), gain));
+        frame = _mm_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void addWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames) {
+    const __m128 delta = _mm_set1_ps(gainDelta);
+    const __m128 start = _mm_set1_ps(startGain);
+    const __m128 step = _mm_set1_ps(2.0f);
+    __m128 frame = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    int i = 0;
+    for (; i + 2 <= numFrames; i += 2) {
+        const __m128 gain = _mm_add_ps(start, _mm_mul_ps(delta, frame));
+        const __m128 src = _mm_mul_ps(_mm_loadu_ps(pSrc + i * 2), gain);
+        _mm_storeu_ps(pDest + i * 2,
+                _mm_add_ps(_mm_loadu_ps(pDest + i * 2), src));
+        frame = _mm_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void copyWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples) {
+    const __m128 vgain = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= iNumSamples; i += 4) {
+        _mm_storeu_ps(pDest + i, _mm_mul_ps(_mm_loadu_ps(pSrc + i), vgain));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+void addWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples) {
+    const __m128 vgain = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= iNumSamples; i += 4) {
+        const __m128 src = _mm_mul_ps(_mm_loadu_ps(pSrc + i), vgain);
+        _mm_storeu_ps(pDest + i, _mm_add_ps(_mm_loadu_ps(pDest + i), src));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+void convertS16ToFloat32(CSAMPLE* pDest, const SAMPLE* pSrc,
+        int iNumSamples) {
+    // Dividing by 32768 and multiplying by 2^-15 give identical results.
+    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
+    const __m128 scale = _mm_set1_ps(CSAMPLE_ONE / kConversionFactor);
+    int i = 0;
+    for (; i + 8 <= iNumSamples; i += 8) {
+        const __m128i s16 = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(pSrc + i));
+        // Sign extend by unpacking into the upper half and shifting back.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        _mm_storeu_ps(pDest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(pDest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] = CSAMPLE(pSrc[i]) / kConversionFactor;
+    }
+}
+
+bool sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+        const CSAMPLE* pBuffer, int numFrames) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 peak = _mm_set1_ps(CSAMPLE_PEAK);
+    __m128 sum = _mm_setzero_ps();
+    __m128 clipped = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 2 <= numFrames; i += 2) {
+        const __m128 absSamples = _mm_and_ps(
+                _mm_loadu_ps(pBuffer + i * 2), absMask);
+        sum = _mm_add_ps(sum, absSamples);
+        clipped = _mm_or_ps(clipped, _mm_cmpgt_ps(absSamples, peak));
+    }
+    CSAMPLE sums[4];
+    _mm_storeu_ps(sums, sum);
+    CSAMPLE fAbsL = sums[0] + sums[2];
+    CSAMPLE fAbsR = sums[1] + sums[3];
+    bool bClipped = _mm_movemask_ps(clipped) != 0;
+    for (; i < numFrames; ++i) {
+        const CSAMPLE absl = fabs(pBuffer[i * 2]);
+        const CSAMPLE absr = fabs(pBuffer[i * 2 + 1]);
+        fAbsL += absl;
+        fAbsR += absr;
+        bClipped = bClipped || absl > CSAMPLE_PEAK || absr > CSAMPLE_PEAK;
+    }
+    *pfAbsL = fAbsL;
+    *pfAbsR = fAbsR;
+    return bClipped;
+}
+
+void mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, int numFrames) {
+    const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE
+            / (CSAMPLE_GAIN_ONE + CSAMPLE_GAIN_ONE);
+    const __m128 scale = _mm_set1_ps(mixScale);
+    int i = 0;
+    for (; i + 2 <= numFrames; i += 2) {
+        const __m128 lr = _mm_loadu_ps(pSrc + i * 2);
+        // (R, L) + (L, R) gives L + R in both channels.
+        const __m128 rl = _mm_shuffle_ps(lr, lr, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(pDest + i * 2, _mm_mul_ps(_mm_add_ps(lr, rl), scale));
+    }
+    for (; i < numFrames; ++i) {
+        pDest[i * 2] = (pSrc[i * 2] + pSrc[i * 2 + 1]) * mixScale;
+        pDest[i * 2 + 1] = pDest[i * 2];
+    }
+}
+
+} // namespace SampleUtilSSE2
+#endif
+
+#ifdef SAMPLEUTIL_AVX2
+namespace SampleUtilAVX2 {
+
+bool isSupported() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // The OS must save the YMM registers on context switches.
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    // Also checks that the OS saves the YMM registers.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta, int numFrames) {
+    // Four stereo frames per register, both channels share the gain.
+    const __m256 delta = _mm256_set1_ps(gainDelta);
+    const __m256 start = _mm256_set1_ps(startGain);
+    const __m256 step = _mm256_set1_ps(4.0f);
+    __m256 frame = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f,
+                                  2.0f, 2.0f, 3.0f, 3.0f);
+    int i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m256 gain = _mm256_add_ps(start, _mm256_mul_ps(delta, frame));
+        _mm256_storeu_ps(pBuffer + i * 2,
+                _mm256_mul_ps(_mm256_loadu_ps(pBuffer + i * 2), gain));
+        frame = _mm256_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void copyWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames) {
+    const __m256 delta = _mm256_set1_ps(gainDelta);
+    const __m256 start = _mm256_set1_ps(startGain);
+    const __m256 step = _mm256_set1_ps(4.0f);
+    __m256 frame = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f,
+                                  2.0f, 2.0f, 3.0f, 3.0f);
+    int i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m256 gain = _mm256_add_ps(start, _mm256_mul_ps(delta, frame));
+        _mm256_storeu_ps(pDest + i * 2,
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc + i * 2), gain));
+        frame = _mm256_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void addWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames) {
+    const __m256 delta = _mm256_set1_ps(gainDelta);
+    const __m256 start = _mm256_set1_ps(startGain);
+    const __m256 step = _mm256_set1_ps(4.0f);
+    __m256 frame = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f,
+                                  2.0f, 2.0f, 3.0f, 3.0f);
+    int i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m256 gain = _mm256_add_ps(start, _mm256_mul_ps(delta, frame));
+        const __m256 src = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i * 2), gain);
+        _mm256_storeu_ps(pDest + i * 2,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i * 2), src));
+        frame = _mm256_add_ps(frame, step);
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void copyWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples) {
+    const __m256 vgain = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= iNumSamples; i += 8) {
+        _mm256_storeu_ps(pDest + i,
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), vgain));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void addWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples) {
+    const __m256 vgain = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= iNumSamples; i += 8) {
+        const __m256 src = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), vgain);
+        _mm256_storeu_ps(pDest + i,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i), src));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void convertS16ToFloat32(CSAMPLE* pDest, const SAMPLE* pSrc,
+        int iNumSamples) {
+    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
+    const __m256 scale = _mm256_set1_ps(CSAMPLE_ONE / kConversionFactor);
+    int i = 0;
+    for (; i + 8 <= iNumSamples; i += 8) {
+        const __m256i s32 = _mm256_cvtepi16_epi32(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(pSrc + i)));
+        _mm256_storeu_ps(pDest + i,
+                _mm256_mul_ps(_mm256_cvtepi32_ps(s32), scale));
+    }
+    for (; i < iNumSamples; ++i) {
+        pDest[i] = CSAMPLE(pSrc[i]) / kConversionFactor;
+    }
+}
+
+SAMPLEUTIL_TARGET_AVX2
+bool sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+        const CSAMPLE* pBuffer, int numFrames) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 peak = _mm256_set1_ps(CSAMPLE_PEAK);
+    __m256 sum = _mm256_setzero_ps();
+    __m256 clipped = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m256 absSamples = _mm256_and_ps(
+                _mm256_loadu_ps(pBuffer + i * 2), absMask);
+        sum = _mm256_add_ps(sum, absSamples);
+        clipped = _mm256_or_ps(clipped,
+                _mm256_cmp_ps(absSamples, peak, _CMP_GT_OQ));
+    }
+    CSAMPLE sums[8];
+    _mm256_storeu_ps(sums, sum);
+    CSAMPLE fAbsL = (sums[0] + sums[2]) + (sums[4] + sums[6]);
+    CSAMPLE fAbsR = (sums[1] + sums[3]) + (sums[5] + sums[7]);
+    bool bClipped = _mm256_movemask_ps(clipped) != 0;
+    for (; i < numFrames; ++i) {
+        const CSAMPLE absl = fabs(pBuffer[i * 2]);
+        const CSAMPLE absr = fabs(pBuffer[i * 2 + 1]);
+        fAbsL += absl;
+        fAbsR += absr;
+        bClipped = bClipped || absl > CSAMPLE_PEAK || absr > CSAMPLE_PEAK;
+    }
+    *pfAbsL = fAbsL;
+    *pfAbsR = fAbsR;
+    return bClipped;
+}
+
+SAMPLEUTIL_TARGET_AVX2
+void mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, int numFrames) {
+    const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE
+            / (CSAMPLE_GAIN_ONE + CSAMPLE_GAIN_ONE);
+    const __m256 scale = _mm256_set1_ps(mixScale);
+    int i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m256 lr = _mm256_loadu_ps(pSrc + i * 2);
+        // Swaps the channels of each frame, frames never cross the lanes.
+        const __m256 rl = _mm256_permute_ps(lr, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm256_storeu_ps(pDest + i * 2,
+                _mm256_mul_ps(_mm256_add_ps(lr, rl), scale));
+    }
+    for (; i < numFrames; ++i) {
+        pDest[i * 2] = (pSrc[i * 2] + pSrc[i * 2 + 1]) * mixScale;
+        pDest[i * 2 + 1] = pDest[i * 2];
+    }
+}
+
+} // namespace SampleUtilAVX2
+#endif
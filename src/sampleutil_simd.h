@@ -0,0 +1,77 @@
+// sampleutil_simd.h
+// Hand-written SSE2 and AVX2 versions of the hot SampleUtil loops.
+//
+// Only SampleUtil calls these. It picks the widest version the CPU supports
+// at runtime, so a portable (SSE2) build still uses AVX2 where available.
+// All kernels produce the same results as the plain C++ loops in
+// sampleutil.cpp, except for sumAbsPerChannel() which sums in a different
+// order.
+
+#ifndef SAMPLEUTIL_SIMD_H
+#define SAMPLEUTIL_SIMD_H
+
+#include "util/types.h"
+
+// MSVC never defines __SSE2__. SSE2 is always there on x64 and /arch:SSE2
+// (the default since VS2012) reports itself through _M_IX86_FP on x86.
+#if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLEUTIL_SSE2
+// The AVX2 kernels are compiled with a function level target attribute, so
+// no special compiler flags are required. Older compilers don't support
+// AVX2 intrinsics in such functions.
+#if defined(__clang__) || \
+        (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || \
+        (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define SAMPLEUTIL_AVX2
+#endif
+#endif
+
+#ifdef SAMPLEUTIL_SSE2
+namespace SampleUtilSSE2 {
+
+void applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta, int numFrames);
+void copyWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames);
+void addWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames);
+void copyWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples);
+void addWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples);
+void convertS16ToFloat32(CSAMPLE* pDest, const SAMPLE* pSrc,
+        int iNumSamples);
+bool sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+        const CSAMPLE* pBuffer, int numFrames);
+void mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, int numFrames);
+
+} // namespace SampleUtilSSE2
+#endif
+
+#ifdef SAMPLEUTIL_AVX2
+namespace SampleUtilAVX2 {
+
+// Returns true if the CPU and the operating system support AVX2.
+bool isSupported();
+
+void applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta, int numFrames);
+void copyWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames);
+void addWithRampingGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN startGain, CSAMPLE_GAIN gainDelta, int numFrames);
+void copyWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples);
+void addWithGain(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        CSAMPLE_GAIN gain, int iNumSamples);
+void convertS16ToFloat32(CSAMPLE* pDest, const SAMPLE* pSrc,
+        int iNumSamples);
+bool sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+        const CSAMPLE* pBuffer, int numFrames);
+void mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc, int numFrames);
+
+} // namespace SampleUtilAVX2
+#endif
+
+#endif /* SAMPLEUTIL_SIMD_H */
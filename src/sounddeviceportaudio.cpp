@@ -31,6 +31,7 @@
 #include "soundmanagerutil.h"
 #include "controlobject.h"
 #include "visualplayposition.h"
+#include "util/callbackbudget.h"
 #include "util/timer.h"
 #include "util/trace.h"
 #include "vinylcontrol/defs_vinylcontrol.h"
@@ -849,7 +850,13 @@ int SoundDevicePortAudio::callbackProcessClkRef(const unsigned int framesPerBuff
 
     m_pSoundManager->writeProcess();
 
-    m_nsInAudioCb += timer.elapsed();
+    const qint64 elapsed = timer.elapsed();
+    m_nsInAudioCb += elapsed;
+    if (CallbackBudget::isEnabled() && m_dSampleRate > 0) {
+        CallbackBudget::instance()->finishCallback(
+                elapsed, static_cast<qint64>(framesPerBuffer * 1e9 / m_dSampleRate),
+                statusFlags & (paOutputUnderflow | paInputOverflow));
+    }
     return paContinue;
 }
 
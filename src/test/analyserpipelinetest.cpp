@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <QtDebug>
+#include <QTest>
+
+#include "analyserpipeline.h"
+#include "sampleutil.h"
+
+namespace {
+
+const SINT kSamplesPerBlock = 256;
+
+// Records the first left and right sample of every block it sees.
+class RecordingAnalyser : public Analyser {
+  public:
+    RecordingAnalyser(int delayMillis = 0)
+            : m_delayMillis(delayMillis) {
+    }
+
+    bool initialise(TrackPointer tio, int sampleRate, int totalSamples) {
+        Q_UNUSED(tio);
+        Q_UNUSED(sampleRate);
+        Q_UNUSED(totalSamples);
+        return true;
+    }
+    bool loadStored(TrackPointer tio) const {
+        Q_UNUSED(tio);
+        return false;
+    }
+    void process(const CSAMPLE* pIn, const int iLen) {
+        Q_UNUSED(pIn);
+        Q_UNUSED(iLen);
+        ADD_FAILURE() << "The pipeline must provide the split channels";
+    }
+    void processStereo(const CSAMPLE* pIn, const CSAMPLE* pLeft,
+                       const CSAMPLE* pRight, const int iLen) {
+        EXPECT_EQ(kSamplesPerBlock, iLen);
+        for (int i = 0; i < iLen / 2; ++i) {
+            EXPECT_EQ(pIn[2 * i], pLeft[i]);
+            EXPECT_EQ(pIn[2 * i + 1], pRight[i]);
+        }
+        m_left.append(pLeft[0]);
+        m_right.append(pRight[0]);
+        if (m_delayMillis > 0) {
+            QTest::qSleep(m_delayMillis);
+        }
+    }
+    void cleanup(TrackPointer tio) {
+        Q_UNUSED(tio);
+    }
+    void finalise(TrackPointer tio) {
+        Q_UNUSED(tio);
+    }
+
+    QList<CSAMPLE> m_left;
+    QList<CSAMPLE> m_right;
+
+  private:
+    int m_delayMillis;
+};
+
+void fillBlock(CSAMPLE* pBlock, int blockIndex) {
+    for (int i = 0; i < kSamplesPerBlock / 2; ++i) {
+        pBlock[2 * i] = blockIndex;
+        pBlock[2 * i + 1] = -blockIndex;
+    }
+}
+
+TEST(AnalyserPipelineTest, EveryAnalyserSeesEveryBlockInOrder) {
+    RecordingAnalyser fast;
+    RecordingAnalyser slow(1);
+    QList<Analyser*> analysers;
+    analysers << &fast << &slow;
+
+    // Push more blocks than the ring holds so that the slow analyser has to
+    // throttle the decoder.
+    const int kBlocks = 5 * AnalyserPipeline::kBlockCount;
+    AnalyserPipeline pipeline(analysers, kSamplesPerBlock);
+    for (int i = 0; i < kBlocks; ++i) {
+        fillBlock(pipeline.nextBlock(), i);
+        pipeline.pushBlock(kSamplesPerBlock);
+    }
+    pipeline.drain();
+
+    ASSERT_EQ(kBlocks, fast.m_left.size());
+    ASSERT_EQ(kBlocks, slow.m_left.size());
+    for (int i = 0; i < kBlocks; ++i) {
+        EXPECT_EQ(i, fast.m_left[i]);
+        EXPECT_EQ(-i, fast.m_right[i]);
+        EXPECT_EQ(i, slow.m_left[i]);
+        EXPECT_EQ(-i, slow.m_right[i]);
+    }
+}
+
+TEST(AnalyserPipelineTest, DrainWithUnpushedBlock) {
+    RecordingAnalyser analyser;
+    QList<Analyser*> analysers;
+    analysers << &analyser;
+
+    AnalyserPipeline pipeline(analysers, kSamplesPerBlock);
+    fillBlock(pipeline.nextBlock(), 0);
+    pipeline.pushBlock(kSamplesPerBlock);
+    // A short block at the end of a track is requested but not pushed.
+    pipeline.nextBlock();
+    pipeline.drain();
+    EXPECT_EQ(1, analyser.m_left.size());
+
+    // The pipeline is reusable for the next track.
+    fillBlock(pipeline.nextBlock(), 1);
+    pipeline.pushBlock(kSamplesPerBlock);
+    pipeline.drain();
+    ASSERT_EQ(2, analyser.m_left.size());
+    EXPECT_EQ(1, analyser.m_left[1]);
+}
+
+}  // namespace
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <QDir>
+#include <QTest>
+#include <QVector>
+
+#include "test/mixxxtest.h"
+#include "cachingreader.h"
+#include "cachingreaderchunkindex.h"
+#include "engine/engineworkerscheduler.h"
+#include "sampleutil.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+class CachingReaderChunkIndexTest : public testing::Test {
+  protected:
+    virtual void SetUp() {
+        m_chunks.resize(CachingReader::maximumChunksInMemory);
+        for (int i = 0; i < m_chunks.size(); ++i) {
+            m_chunks[i].chunk_number = -1;
+        }
+    }
+
+    Chunk* chunk(int index, int chunkNumber) {
+        m_chunks[index].chunk_number = chunkNumber;
+        return &m_chunks[index];
+    }
+
+    QVector<Chunk> m_chunks;
+};
+
+TEST_F(CachingReaderChunkIndexTest, InsertLookupRemove) {
+    CachingReaderChunkIndex index(m_chunks.size());
+    EXPECT_GE(index.capacity(), 4 * m_chunks.size());
+    EXPECT_EQ(static_cast<Chunk*>(NULL), index.lookup(0));
+    EXPECT_EQ(static_cast<Chunk*>(NULL), index.lookup(-1));
+
+    Chunk* pChunk = chunk(0, 42);
+    EXPECT_TRUE(index.insert(pChunk));
+    EXPECT_FALSE(index.insert(pChunk));
+    EXPECT_EQ(pChunk, index.lookup(42));
+    EXPECT_EQ(1, index.size());
+
+    index.remove(pChunk);
+    EXPECT_EQ(static_cast<Chunk*>(NULL), index.lookup(42));
+    EXPECT_EQ(0, index.size());
+}
+
+TEST_F(CachingReaderChunkIndexTest, RemoveOnlyMatchingChunk) {
+    CachingReaderChunkIndex index(m_chunks.size());
+    Chunk* pIndexed = chunk(0, 7);
+    Chunk* pStale = chunk(1, 7);
+    EXPECT_TRUE(index.insert(pIndexed));
+    index.remove(pStale);
+    EXPECT_EQ(pIndexed, index.lookup(7));
+}
+
+TEST_F(CachingReaderChunkIndexTest, FullIndexAndBackwardShift) {
+    CachingReaderChunkIndex index(m_chunks.size());
+    // Fill the index with chunk numbers spread like hotcues across a long
+    // track and check that removals in arbitrary order keep every remaining
+    // entry reachable.
+    QVector<Chunk*> inserted;
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        Chunk* pChunk = chunk(i, (i * 37) % 1000 + (i % 3) * 4096);
+        if (index.insert(pChunk)) {
+            inserted.push_back(pChunk);
+        }
+    }
+    EXPECT_EQ(inserted.size(), index.size());
+    EXPECT_EQ(m_chunks.size(), inserted.size());
+
+    for (int i = 0; i < inserted.size(); i += 2) {
+        index.remove(inserted[i]);
+    }
+    for (int i = 0; i < inserted.size(); ++i) {
+        Chunk* pExpected = (i % 2 == 0) ? NULL : inserted[i];
+        EXPECT_EQ(pExpected, index.lookup(inserted[i]->chunk_number));
+    }
+
+    index.clear();
+    EXPECT_EQ(0, index.size());
+    for (int i = 0; i < inserted.size(); ++i) {
+        EXPECT_EQ(static_cast<Chunk*>(NULL), index.lookup(inserted[i]->chunk_number));
+    }
+}
+
+class CachingReaderBenchmarkTest : public MixxxTest {
+  protected:
+    virtual void SetUp() {
+        m_pScheduler = new EngineWorkerScheduler();
+        m_pScheduler->start(QThread::HighPriority);
+        m_pReader = new CachingReader("[Benchmark]", config());
+        m_pReader->setScheduler(m_pScheduler);
+    }
+
+    virtual void TearDown() {
+        delete m_pReader;
+        delete m_pScheduler;
+    }
+
+    bool loadTrack(const QString& location) {
+        m_pReader->newTrack(TrackPointer(new TrackInfoObject(location)));
+        m_pScheduler->runWorkers();
+        CSAMPLE buffer[2];
+        for (int i = 0; i < 1000; ++i) {
+            m_pReader->process();
+            if (m_pReader->read(0, 2, buffer) == 2) {
+                return true;
+            }
+            QTest::qSleep(10);
+        }
+        return false;
+    }
+
+    EngineWorkerScheduler* m_pScheduler;
+    CachingReader* m_pReader;
+};
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+// Reports the per-callback cost of hintAndMaybeWake() and read() while the
+// play position jumps to random positions like hotcue juggling does.
+TEST_F(CachingReaderBenchmarkTest, DISABLED_RandomSeekCallbackCost) {
+    ASSERT_TRUE(loadTrack(QDir::currentPath() + "/src/test/sine-30.wav"));
+
+    const int kCallbacks = 20000;
+    const int kFramesPerCallback = 256;
+    const int kSamplesPerCallback =
+            kFramesPerCallback * CachingReaderWorker::kChunkChannels;
+    // 30 seconds at 44.1 kHz
+    const int kTrackFrames = 30 * 44100;
+    CSAMPLE* pBuffer = SampleUtil::alloc(kSamplesPerCallback);
+
+    qint64 hintTotal = 0;
+    qint64 hintMax = 0;
+    qint64 readTotal = 0;
+    qint64 readMax = 0;
+    int frame = 0;
+    PerformanceTimer timer;
+    for (int i = 0; i < kCallbacks; ++i) {
+        // Jump somewhere else every 64 callbacks, play linearly otherwise.
+        if (i % 64 == 0) {
+            frame = qrand() % (kTrackFrames - kFramesPerCallback);
+        }
+        const int sample = frame * CachingReaderWorker::kChunkChannels;
+
+        HintVector hints;
+        Hint hint;
+        hint.sample = sample;
+        hint.length = 0;
+        hint.priority = 1;
+        hints.append(hint);
+        hint.length = -1;
+        hints.append(hint);
+
+        timer.start();
+        m_pReader->hintAndMaybeWake(hints);
+        const qint64 hintElapsed = timer.restart();
+        m_pReader->read(sample, kSamplesPerCallback, pBuffer);
+        const qint64 readElapsed = timer.elapsed();
+
+        m_pScheduler->runWorkers();
+        hintTotal += hintElapsed;
+        hintMax = math_max(hintMax, hintElapsed);
+        readTotal += readElapsed;
+        readMax = math_max(readMax, readElapsed);
+        frame += kFramesPerCallback;
+    }
+
+    qDebug() << "hintAndMaybeWake avg" << hintTotal / kCallbacks
+             << "ns max" << hintMax << "ns";
+    qDebug() << "read avg" << readTotal / kCallbacks
+             << "ns max" << readMax << "ns";
+    SampleUtil::free(pBuffer);
+}
+
+}  // namespace
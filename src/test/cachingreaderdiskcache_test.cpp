@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include "test/mixxxtest.h"
+#include "cachingreaderdiskcache.h"
+#include "sampleutil.h"
+
+namespace {
+
+const SINT kFramesPerChunk = 1024;
+const SINT kChannels = 2;
+const SINT kSamplesPerChunk = kFramesPerChunk * kChannels;
+
+class CachingReaderDiskCacheTest : public MixxxTest {
+  protected:
+    virtual void SetUp() {
+        config()->set(ConfigKey("[Config]", "DecodedAudioCacheSizeMB"),
+                      ConfigValue(1));
+        m_pTrackFile.reset(makeTemporaryFile("not really audio"));
+        m_pTrack = TrackPointer(new TrackInfoObject(
+                m_pTrackFile->fileName(), SecurityTokenPointer(), false));
+        m_pChunk = SampleUtil::alloc(kSamplesPerChunk);
+        m_pRead = SampleUtil::alloc(kSamplesPerChunk);
+        for (SINT i = 0; i < kSamplesPerChunk; ++i) {
+            m_pChunk[i] = static_cast<CSAMPLE>(i) / kSamplesPerChunk;
+        }
+    }
+
+    virtual void TearDown() {
+        SampleUtil::free(m_pChunk);
+        SampleUtil::free(m_pRead);
+        QDir cacheDir(config()->getSettingsPath() + "/decodedaudiocache");
+        foreach (const QFileInfo& entry,
+                 cacheDir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot)) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+
+    ScopedTemporaryFile m_pTrackFile;
+    TrackPointer m_pTrack;
+    CSAMPLE* m_pChunk;
+    CSAMPLE* m_pRead;
+};
+
+TEST_F(CachingReaderDiskCacheTest, DisabledByDefault) {
+    config()->set(ConfigKey("[Config]", "DecodedAudioCacheSizeMB"),
+                  ConfigValue(0));
+    CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+    EXPECT_FALSE(cache.create(m_pTrack, 3 * kFramesPerChunk, 44100));
+    EXPECT_FALSE(cache.isOpen());
+}
+
+TEST_F(CachingReaderDiskCacheTest, MissThenHit) {
+    CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+    ASSERT_TRUE(cache.create(m_pTrack, 3 * kFramesPerChunk, 44100));
+
+    SINT frameCount = 0;
+    EXPECT_FALSE(cache.readChunk(1, m_pRead, &frameCount));
+
+    cache.writeChunk(1, m_pChunk, kFramesPerChunk);
+    ASSERT_TRUE(cache.readChunk(1, m_pRead, &frameCount));
+    EXPECT_EQ(kFramesPerChunk, frameCount);
+    for (SINT i = 0; i < kSamplesPerChunk; ++i) {
+        EXPECT_FLOAT_EQ(m_pChunk[i], m_pRead[i]);
+    }
+    EXPECT_FALSE(cache.readChunk(0, m_pRead, &frameCount));
+}
+
+TEST_F(CachingReaderDiskCacheTest, PartialChunksAreNotCached) {
+    CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+    ASSERT_TRUE(cache.create(m_pTrack, 2 * kFramesPerChunk + 10, 44100));
+
+    SINT frameCount = 0;
+    cache.writeChunk(0, m_pChunk, kFramesPerChunk / 2);
+    EXPECT_FALSE(cache.readChunk(0, m_pRead, &frameCount));
+
+    // The last chunk of the track is short.
+    cache.writeChunk(2, m_pChunk, 10);
+    ASSERT_TRUE(cache.readChunk(2, m_pRead, &frameCount));
+    EXPECT_EQ(10, frameCount);
+}
+
+TEST_F(CachingReaderDiskCacheTest, PersistsAcrossSessions) {
+    {
+        CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+        EXPECT_FALSE(cache.open(m_pTrack));
+        ASSERT_TRUE(cache.create(m_pTrack, 3 * kFramesPerChunk, 48000));
+        cache.writeChunk(2, m_pChunk, kFramesPerChunk);
+    }
+
+    CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+    ASSERT_TRUE(cache.open(m_pTrack));
+    EXPECT_EQ(3 * kFramesPerChunk, cache.getFrameCount());
+    EXPECT_EQ(48000, cache.getFrameRate());
+    SINT frameCount = 0;
+    EXPECT_TRUE(cache.readChunk(2, m_pRead, &frameCount));
+    EXPECT_FALSE(cache.readChunk(1, m_pRead, &frameCount));
+
+    // A cache with a different chunk layout must not use the entry.
+    CachingReaderDiskCache otherCache(config(), 2 * kFramesPerChunk, kChannels);
+    EXPECT_FALSE(otherCache.open(m_pTrack));
+}
+
+TEST_F(CachingReaderDiskCacheTest, EvictsLeastRecentlyUsed) {
+    // Each entry is roughly 0.6 MB, so only one of them fits into 1 MB.
+    const SINT frameCount = 80 * 1024;
+    ScopedTemporaryFile pOtherFile(makeTemporaryFile("other"));
+    TrackPointer pOtherTrack(new TrackInfoObject(
+            pOtherFile->fileName(), SecurityTokenPointer(), false));
+
+    CachingReaderDiskCache cache(config(), kFramesPerChunk, kChannels);
+    ASSERT_TRUE(cache.create(m_pTrack, frameCount, 44100));
+    cache.close();
+    ASSERT_TRUE(cache.create(pOtherTrack, frameCount, 44100));
+    cache.close();
+
+    EXPECT_TRUE(cache.open(pOtherTrack));
+    EXPECT_FALSE(cache.open(m_pTrack));
+}
+
+}  // namespace
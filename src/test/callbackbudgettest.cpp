@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <QtDebug>
+
+#include "util/callbackbudget.h"
+#include "util/callbackbudgetmodel.h"
+
+namespace {
+
+class CallbackBudgetTest : public testing::Test {
+  protected:
+    CallbackBudget::Record makeRecord(qint32 callbackNanos, bool xrun) {
+        CallbackBudget::Record record;
+        memset(&record, 0, sizeof(record));
+        record.budgetNanos = 1000000;
+        record.stageNanos[CallbackBudget::SOUND_DEVICE_CALLBACK] = callbackNanos;
+        record.xrun = xrun;
+        return record;
+    }
+
+    QString cell(const CallbackBudgetModel& model, int row, int column) {
+        return model.data(model.index(row, column)).toString();
+    }
+};
+
+TEST_F(CallbackBudgetTest, EnabledWhileInstanceExists) {
+    EXPECT_FALSE(CallbackBudget::isEnabled());
+    {
+        CallbackBudget budget;
+        EXPECT_TRUE(CallbackBudget::isEnabled());
+    }
+    EXPECT_FALSE(CallbackBudget::isEnabled());
+}
+
+TEST_F(CallbackBudgetTest, OneRecordPerCallback) {
+    CallbackBudget budget;
+    budget.addStageTime(CallbackBudget::ENGINE_MASTER, 500);
+    budget.addStageTime(CallbackBudget::ENGINE_CHANNEL, 100, 1);
+    budget.addStageTime(CallbackBudget::ENGINE_CHANNEL, 200, 2);
+    budget.addStageTime(CallbackBudget::SCALER, 50, 2);
+    budget.finishCallback(1000, 2900000, false);
+    budget.addStageTime(CallbackBudget::ENGINE_MASTER, 700);
+    budget.finishCallback(900, 2900000, true);
+
+    CallbackBudget::Record records[4];
+    ASSERT_EQ(2, budget.readRecords(records, 4));
+
+    EXPECT_EQ(2900000, records[0].budgetNanos);
+    EXPECT_FALSE(records[0].xrun);
+    EXPECT_EQ(1000, records[0].stageNanos[CallbackBudget::SOUND_DEVICE_CALLBACK]);
+    EXPECT_EQ(500, records[0].stageNanos[CallbackBudget::ENGINE_MASTER]);
+    EXPECT_EQ(300, records[0].stageNanos[CallbackBudget::ENGINE_CHANNEL]);
+    EXPECT_EQ(100, records[0].channelNanos[1]);
+    EXPECT_EQ(200, records[0].channelNanos[2]);
+    EXPECT_EQ(50, records[0].scalerNanos[2]);
+    EXPECT_EQ(0, records[0].scalerNanos[1]);
+
+    // The counters start from zero for every callback.
+    EXPECT_TRUE(records[1].xrun);
+    EXPECT_EQ(700, records[1].stageNanos[CallbackBudget::ENGINE_MASTER]);
+    EXPECT_EQ(0, records[1].stageNanos[CallbackBudget::ENGINE_CHANNEL]);
+    EXPECT_EQ(0, records[1].channelNanos[2]);
+
+    EXPECT_EQ(0, budget.readRecords(records, 4));
+}
+
+TEST_F(CallbackBudgetTest, MarksSilentChannels) {
+    // Nothing is recorded without an instance.
+    CallbackBudget::markChannelSilent(1);
+
+    CallbackBudget budget;
+    CallbackBudget::markChannelSilent(2);
+    CallbackBudget::markChannelSilent(CallbackBudget::kMaxChannels);
+    budget.finishCallback(1000, 2900000, false);
+    budget.finishCallback(1000, 2900000, false);
+
+    CallbackBudget::Record records[2];
+    ASSERT_EQ(2, budget.readRecords(records, 2));
+    EXPECT_FALSE(records[0].channelSilent[1]);
+    EXPECT_TRUE(records[0].channelSilent[2]);
+    EXPECT_FALSE(records[1].channelSilent[2]);
+}
+
+TEST_F(CallbackBudgetTest, ChannelOutOfRangeOnlyCountsTotal) {
+    CallbackBudget budget;
+    budget.addStageTime(CallbackBudget::ENGINE_CHANNEL, 100,
+                        CallbackBudget::kMaxChannels);
+    budget.finishCallback(1000, 2900000, false);
+
+    CallbackBudget::Record record;
+    ASSERT_EQ(1, budget.readRecords(&record, 1));
+    EXPECT_EQ(100, record.stageNanos[CallbackBudget::ENGINE_CHANNEL]);
+}
+
+TEST_F(CallbackBudgetTest, FullFifoDropsRecords) {
+    CallbackBudget budget;
+    for (int i = 0; i < 3000; ++i) {
+        budget.finishCallback(1000, 2900000, false);
+    }
+    CallbackBudget::Record record;
+    int count = 0;
+    while (budget.readRecords(&record, 1) == 1) {
+        ++count;
+    }
+    EXPECT_EQ(3000, count + budget.takeDroppedRecords());
+    EXPECT_EQ(0, budget.takeDroppedRecords());
+
+    budget.finishCallback(1000, 2900000, false);
+    budget.discardRecords();
+    EXPECT_EQ(0, budget.readRecords(&record, 1));
+}
+
+TEST_F(CallbackBudgetTest, Percentile) {
+    QVector<qint32> values;
+    EXPECT_EQ(0, CallbackBudgetModel::percentile(values, 0.5));
+    for (int i = 1; i <= 100; ++i) {
+        values.append(i);
+    }
+    EXPECT_EQ(1, CallbackBudgetModel::percentile(values, 0.0));
+    EXPECT_EQ(50, CallbackBudgetModel::percentile(values, 0.5));
+    EXPECT_EQ(99, CallbackBudgetModel::percentile(values, 0.99));
+    EXPECT_EQ(100, CallbackBudgetModel::percentile(values, 1.0));
+}
+
+TEST_F(CallbackBudgetTest, ModelStatistics) {
+    CallbackBudgetModel model;
+    QVector<CallbackBudget::Record> records;
+    for (int i = 0; i < 99; ++i) {
+        records.append(makeRecord(100000, false));
+    }
+    // The callback before an xrun report is the one that took too long.
+    records.append(makeRecord(1500000, false));
+    records.append(makeRecord(100000, true));
+    model.addRecords(records.constData(), records.size());
+
+    EXPECT_EQ(101, model.windowCallbackCount());
+    EXPECT_EQ(1, model.windowXrunCount());
+    ASSERT_EQ(CallbackBudget::NUM_STAGES, model.rowCount());
+
+    const int row = CallbackBudget::SOUND_DEVICE_CALLBACK;
+    EXPECT_EQ(QString("100.0"), cell(model, row, CallbackBudgetModel::COLUMN_P50));
+    EXPECT_EQ(QString("1500.0"), cell(model, row, CallbackBudgetModel::COLUMN_MAX));
+    EXPECT_EQ(QString("1500.0"),
+              cell(model, row, CallbackBudgetModel::COLUMN_MEAN_BEFORE_XRUN));
+
+    const QVector<int>& histogram = model.callbackHistogram();
+    ASSERT_EQ(CallbackBudgetModel::kHistogramBuckets, histogram.size());
+    EXPECT_EQ(100, histogram[1]);
+    EXPECT_EQ(1, histogram[CallbackBudgetModel::kHistogramBuckets - 1]);
+}
+
+TEST_F(CallbackBudgetTest, ModelWindowIsBounded) {
+    CallbackBudgetModel model;
+    QVector<CallbackBudget::Record> records(
+            CallbackBudgetModel::kWindowSize + 10, makeRecord(100000, false));
+    model.addRecords(records.constData(), records.size());
+    model.addRecords(records.constData(), 1);
+    EXPECT_EQ(CallbackBudgetModel::kWindowSize, model.windowCallbackCount());
+}
+
+TEST_F(CallbackBudgetTest, ModelShowsActiveChannels) {
+    CallbackBudgetModel model;
+    CallbackBudget::Record record = makeRecord(100000, false);
+    record.channelNanos[3] = 20000;
+    record.scalerNanos[3] = 10000;
+    model.addRecords(&record, 1);
+    ASSERT_EQ(CallbackBudget::NUM_STAGES + 2, model.rowCount());
+    EXPECT_EQ(QString("20.0"), cell(model, CallbackBudget::NUM_STAGES,
+                                    CallbackBudgetModel::COLUMN_MEAN));
+    EXPECT_EQ(QString("10.0"), cell(model, CallbackBudget::NUM_STAGES + 1,
+                                    CallbackBudgetModel::COLUMN_MEAN));
+}
+
+TEST_F(CallbackBudgetTest, ModelShowsSilentShare) {
+    CallbackBudgetModel model;
+    CallbackBudget::Record records[4];
+    for (int i = 0; i < 4; ++i) {
+        records[i] = makeRecord(100000, false);
+        records[i].channelNanos[1] = 20000;
+    }
+    records[0].channelSilent[1] = true;
+    model.addRecords(records, 4);
+    ASSERT_EQ(CallbackBudget::NUM_STAGES + 1, model.rowCount());
+    EXPECT_EQ(QString("25.0"), cell(model, CallbackBudget::NUM_STAGES,
+                                    CallbackBudgetModel::COLUMN_SILENT));
+    // Only the channels have a silent share.
+    EXPECT_EQ(QString(), cell(model, CallbackBudget::ENGINE_MASTER,
+                              CallbackBudgetModel::COLUMN_SILENT));
+}
+
+}  // namespace
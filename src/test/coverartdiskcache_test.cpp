@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <QColor>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QTemporaryFile>
+
+#include "library/coverartdiskcache.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+const QString kTrackA = "/music/a.mp3";
+const QString kTrackB = "/music/b.mp3";
+
+class CoverArtDiskCacheTest : public MixxxTest {
+  protected:
+    virtual void SetUp() {
+        QTemporaryFile file;
+        ASSERT_TRUE(file.open());
+        m_packFilePath = file.fileName() + ".pack";
+    }
+
+    virtual void TearDown() {
+        QFile::remove(m_packFilePath);
+    }
+
+    static QImage makeImage(int width, QColor color) {
+        QImage image(width, width, QImage::Format_RGB32);
+        image.fill(color.rgb());
+        return image;
+    }
+
+    static QImage makeNoiseImage(int width) {
+        QImage image(width, width, QImage::Format_RGB32);
+        for (int y = 0; y < width; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.setPixel(x, y, qRgb(qrand() % 256, qrand() % 256,
+                                          qrand() % 256));
+            }
+        }
+        return image;
+    }
+
+    QString m_packFilePath;
+};
+
+TEST_F(CoverArtDiskCacheTest, SaveAndLoad) {
+    CoverArtDiskCache cache(m_packFilePath);
+    ASSERT_TRUE(cache.isOpen());
+    EXPECT_EQ(0, cache.count());
+    EXPECT_TRUE(cache.load(kTrackA, 1234, 50).isNull());
+
+    EXPECT_TRUE(cache.save(kTrackA, 1234, 50, makeImage(50, Qt::red)));
+    EXPECT_TRUE(cache.save(kTrackA, 1234, 0, makeImage(300, Qt::blue)));
+    EXPECT_TRUE(cache.contains(kTrackA, 1234, 50));
+    EXPECT_TRUE(cache.contains(kTrackA, 1234, 0));
+    EXPECT_FALSE(cache.contains(kTrackA, 1234, 100));
+    EXPECT_FALSE(cache.contains(kTrackB, 4321, 50));
+
+    QImage image = cache.load(kTrackA, 1234, 50);
+    ASSERT_FALSE(image.isNull());
+    EXPECT_EQ(50, image.width());
+    // Covers are stored as JPEG, so the colors are not exact.
+    EXPECT_LT(200, qRed(image.pixel(25, 25)));
+    EXPECT_GT(50, qBlue(image.pixel(25, 25)));
+
+    image = cache.load(kTrackA, 1234, 0);
+    ASSERT_FALSE(image.isNull());
+    EXPECT_EQ(300, image.width());
+    EXPECT_LT(200, qBlue(image.pixel(150, 150)));
+}
+
+TEST_F(CoverArtDiskCacheTest, Persists) {
+    {
+        CoverArtDiskCache cache(m_packFilePath);
+        ASSERT_TRUE(cache.save(kTrackA, 1, 50, makeImage(50, Qt::red)));
+        ASSERT_TRUE(cache.save(kTrackB, 2, 50, makeImage(50, Qt::green)));
+    }
+    CoverArtDiskCache cache(m_packFilePath);
+    EXPECT_EQ(2, cache.count());
+    QImage image = cache.load(kTrackB, 2, 50);
+    ASSERT_FALSE(image.isNull());
+    EXPECT_LT(200, qGreen(image.pixel(25, 25)));
+
+    cache.clear();
+    EXPECT_EQ(0, cache.count());
+    EXPECT_TRUE(cache.load(kTrackB, 2, 50).isNull());
+}
+
+TEST_F(CoverArtDiskCacheTest, DropsIncompleteCover) {
+    {
+        CoverArtDiskCache cache(m_packFilePath);
+        ASSERT_TRUE(cache.save(kTrackA, 1, 50, makeImage(50, Qt::red)));
+        ASSERT_TRUE(cache.save(kTrackB, 2, 50, makeImage(50, Qt::green)));
+    }
+    // Cut off the end of the last cover, like a crash while writing it.
+    QFile file(m_packFilePath);
+    ASSERT_TRUE(file.resize(file.size() - 10));
+
+    CoverArtDiskCache cache(m_packFilePath);
+    EXPECT_EQ(1, cache.count());
+    EXPECT_FALSE(cache.load(kTrackA, 1, 50).isNull());
+    EXPECT_FALSE(cache.contains(kTrackB, 2, 50));
+
+    // New covers are appended after the last complete one.
+    EXPECT_TRUE(cache.save(kTrackB, 2, 50, makeImage(50, Qt::green)));
+    EXPECT_FALSE(cache.load(kTrackB, 2, 50).isNull());
+}
+
+TEST_F(CoverArtDiskCacheTest, ChecksLocationAndHash) {
+    {
+        CoverArtDiskCache cache(m_packFilePath);
+        ASSERT_TRUE(cache.save(kTrackA, 1, 50, makeImage(50, Qt::red)));
+    }
+    CoverArtDiskCache cache(m_packFilePath);
+    // A different cover with the same hash is not mixed up after a restart.
+    EXPECT_FALSE(cache.contains(kTrackB, 1, 50));
+    EXPECT_TRUE(cache.load(kTrackB, 1, 50).isNull());
+    // A cover that has changed since it was stored is not used.
+    EXPECT_FALSE(cache.contains(kTrackA, 2, 50));
+    EXPECT_TRUE(cache.load(kTrackA, 2, 50).isNull());
+
+    // Storing the changed cover replaces the old one.
+    EXPECT_TRUE(cache.save(kTrackA, 2, 50, makeImage(50, Qt::green)));
+    EXPECT_EQ(1, cache.count());
+    QImage image = cache.load(kTrackA, 2, 50);
+    ASSERT_FALSE(image.isNull());
+    EXPECT_LT(200, qGreen(image.pixel(25, 25)));
+    EXPECT_FALSE(cache.contains(kTrackA, 1, 50));
+}
+
+TEST_F(CoverArtDiskCacheTest, ResetsInvalidFile) {
+    {
+        QFile file(m_packFilePath);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("this is not a pack file");
+    }
+    CoverArtDiskCache cache(m_packFilePath);
+    ASSERT_TRUE(cache.isOpen());
+    EXPECT_EQ(0, cache.count());
+    EXPECT_TRUE(cache.save(kTrackA, 1, 50, makeImage(50, Qt::red)));
+}
+
+TEST_F(CoverArtDiskCacheTest, LimitsFileSize) {
+    CoverArtDiskCache cache(m_packFilePath, 4096);
+    EXPECT_FALSE(cache.save(kTrackA, 1, 300, makeNoiseImage(300)));
+    EXPECT_FALSE(cache.contains(kTrackA, 1, 300));
+    EXPECT_TRUE(cache.save(kTrackB, 2, 8, makeImage(8, Qt::red)));
+
+    // Once the file is full, the old covers make room for new ones.
+    quint16 hash = 3;
+    QString location;
+    int previousCount;
+    do {
+        previousCount = cache.count();
+        location = QString("/music/%1.mp3").arg(hash);
+        ASSERT_TRUE(cache.save(location, hash++, 8, makeImage(8, Qt::green)));
+    } while (cache.count() > previousCount && hash < 100);
+    EXPECT_EQ(1, cache.count());
+    EXPECT_FALSE(cache.contains(kTrackB, 2, 8));
+    EXPECT_FALSE(cache.load(location, hash - 1, 8).isNull());
+    EXPECT_GE(4096, QFile(m_packFilePath).size());
+}
+
+}  // namespace
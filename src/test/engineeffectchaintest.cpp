@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <QPair>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+#include "engine/effects/engineeffect.h"
+#include "engine/effects/engineeffectchain.h"
+#include "engine/scratchbufferpool.h"
+#include "sampleutil.h"
+#include "test/baseeffecttest.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::_;
+
+namespace {
+
+const int kBufferSize = 64;
+
+void halve(const ChannelHandle& handle, const CSAMPLE* pInput,
+           CSAMPLE* pOutput, const unsigned int numSamples,
+           const unsigned int sampleRate,
+           const EffectProcessor::EnableState enableState,
+           const GroupFeatureState& groupFeatures) {
+    Q_UNUSED(handle);
+    Q_UNUSED(sampleRate);
+    Q_UNUSED(enableState);
+    Q_UNUSED(groupFeatures);
+    for (unsigned int i = 0; i < numSamples; ++i) {
+        pOutput[i] = pInput[i] * 0.5f;
+    }
+}
+
+EffectProcessor* createHalvingProcessor(EngineEffect* pEngineEffect,
+                                        const EffectManifest& manifest) {
+    Q_UNUSED(pEngineEffect);
+    Q_UNUSED(manifest);
+    NiceMock<MockEffectProcessor>* pProcessor =
+            new NiceMock<MockEffectProcessor>();
+    ON_CALL(*pProcessor, process(_, _, _, _, _, _, _))
+            .WillByDefault(Invoke(halve));
+    return pProcessor;
+}
+
+class EngineEffectChainTest : public testing::Test {
+  protected:
+    EngineEffectChainTest()
+            : m_handle(m_factory.getOrCreateHandle("[Channel1]")),
+              m_chain("org.mixxx.test.chain"),
+              m_pInput(SampleUtil::alloc(kBufferSize)),
+              m_pBuffer(SampleUtil::alloc(kBufferSize)) {
+        QPair<EffectsRequestPipe*, EffectsResponsePipe*> pipes =
+                TwoWayMessagePipe<EffectsRequest*, EffectsResponse>::makeTwoWayMessagePipe(
+                    64, 64, false, false);
+        m_pRequestPipe.reset(pipes.first);
+        m_pResponsePipe.reset(pipes.second);
+
+        MockEffectInstantiator* pInstantiator = new MockEffectInstantiator();
+        ON_CALL(*pInstantiator, instantiate(_, _))
+                .WillByDefault(Invoke(createHalvingProcessor));
+        m_pInstantiator = EffectInstantiatorPointer(pInstantiator);
+        m_manifest.setId("org.mixxx.test.halve");
+
+        for (int i = 0; i < kBufferSize; ++i) {
+            m_pInput[i] = 1.0f;
+        }
+    }
+
+    virtual ~EngineEffectChainTest() {
+        qDeleteAll(m_effects);
+        SampleUtil::free(m_pInput);
+        SampleUtil::free(m_pBuffer);
+    }
+
+    // Sends the messages EffectsManager sends for a chain that is enabled
+    // for m_handle and runs effectCount halving effects.
+    void setUpChain(int effectCount, EffectChain::InsertionType insertionType,
+                    double mix) {
+        for (int i = 0; i < effectCount; ++i) {
+            EngineEffect* pEffect = new EngineEffect(
+                    m_manifest, QSet<ChannelHandleAndGroup>(), m_pInstantiator);
+            m_effects.append(pEffect);
+            EffectsRequest request;
+            request.type = EffectsRequest::ADD_EFFECT_TO_CHAIN;
+            request.AddEffectToChain.pEffect = pEffect;
+            request.AddEffectToChain.iIndex = i;
+            sendRequest(&request);
+        }
+
+        EffectsRequest parameters;
+        parameters.type = EffectsRequest::SET_EFFECT_CHAIN_PARAMETERS;
+        parameters.SetEffectChainParameters.enabled = true;
+        parameters.SetEffectChainParameters.insertion_type = insertionType;
+        parameters.SetEffectChainParameters.mix = mix;
+        sendRequest(&parameters);
+
+        EffectsRequest enable;
+        enable.type = EffectsRequest::ENABLE_EFFECT_CHAIN_FOR_CHANNEL;
+        enable.channel = m_handle;
+        sendRequest(&enable);
+        m_chain.updatePlan();
+    }
+
+    void sendRequest(EffectsRequest* pRequest) {
+        ASSERT_TRUE(m_chain.processEffectsRequest(*pRequest,
+                                                  m_pResponsePipe.data()));
+        EffectsResponse response;
+        ASSERT_EQ(1, m_pRequestPipe->readMessages(&response, 1));
+        ASSERT_TRUE(response.success);
+    }
+
+    // Processes m_pInput into m_pBuffer like a callback of the engine.
+    void processCallback(ScratchBufferPool* pScratch) {
+        SampleUtil::copy(m_pBuffer, m_pInput, kBufferSize);
+        m_chain.process(m_handle, m_pBuffer, kBufferSize, 44100,
+                        GroupFeatureState(), pScratch);
+        if (m_chain.planOutdated()) {
+            m_chain.updatePlan();
+        }
+    }
+
+    ChannelHandleFactory m_factory;
+    ChannelHandle m_handle;
+    EngineEffectChain m_chain;
+    QScopedPointer<EffectsRequestPipe> m_pRequestPipe;
+    QScopedPointer<EffectsResponsePipe> m_pResponsePipe;
+    EffectInstantiatorPointer m_pInstantiator;
+    EffectManifest m_manifest;
+    QList<EngineEffect*> m_effects;
+    CSAMPLE* m_pInput;
+    CSAMPLE* m_pBuffer;
+};
+
+TEST_F(EngineEffectChainTest, FullyWetRunsInPlace) {
+    setUpChain(3, EffectChain::INSERT, 1.0);
+    ScratchBufferPool scratch(2, kBufferSize);
+    // The effects ramp in, so they are faded against their input and the
+    // first sample is still dry.
+    processCallback(&scratch);
+    EXPECT_FLOAT_EQ(1.0f, m_pBuffer[0]);
+    EXPECT_EQ(2, scratch.available());
+
+    // The chain ramps to the wet gain in the first callback. After that no
+    // scratch buffer is needed.
+    ScratchBufferPool empty(0, kBufferSize);
+    processCallback(&empty);
+    processCallback(&empty);
+    for (int i = 0; i < kBufferSize; ++i) {
+        EXPECT_FLOAT_EQ(0.125f, m_pBuffer[i]);
+    }
+}
+
+TEST_F(EngineEffectChainTest, InsertMixesDryAndWet) {
+    setUpChain(2, EffectChain::INSERT, 0.5);
+    ScratchBufferPool scratch(2, kBufferSize);
+    processCallback(&scratch);
+    processCallback(&scratch);
+    EXPECT_EQ(2, scratch.available());
+    for (int i = 0; i < kBufferSize; ++i) {
+        EXPECT_FLOAT_EQ(0.5f + 0.25f * 0.5f, m_pBuffer[i]);
+    }
+}
+
+TEST_F(EngineEffectChainTest, SendAddsWet) {
+    setUpChain(1, EffectChain::SEND, 0.5);
+    ScratchBufferPool scratch(1, kBufferSize);
+    processCallback(&scratch);
+    processCallback(&scratch);
+    EXPECT_EQ(1, scratch.available());
+    for (int i = 0; i < kBufferSize; ++i) {
+        EXPECT_FLOAT_EQ(1.0f + 0.5f * 0.5f, m_pBuffer[i]);
+    }
+}
+
+TEST_F(EngineEffectChainTest, DisabledEffectsLeaveThePlan) {
+    setUpChain(2, EffectChain::INSERT, 1.0);
+    ScratchBufferPool scratch(2, kBufferSize);
+    processCallback(&scratch);
+    processCallback(&scratch);
+
+    EffectsRequest disable;
+    disable.type = EffectsRequest::SET_EFFECT_PARAMETERS;
+    disable.SetEffectParameters.enabled = false;
+    ASSERT_TRUE(m_effects[1]->processEffectsRequest(disable,
+                                                     m_pResponsePipe.data()));
+    EffectsResponse response;
+    ASSERT_EQ(1, m_pRequestPipe->readMessages(&response, 1));
+    m_chain.updatePlan();
+    EXPECT_TRUE(m_chain.planOutdated());
+
+    // Ramping out, then only the first effect is left.
+    processCallback(&scratch);
+    EXPECT_FALSE(m_chain.planOutdated());
+    processCallback(&scratch);
+    for (int i = 0; i < kBufferSize; ++i) {
+        EXPECT_FLOAT_EQ(0.5f, m_pBuffer[i]);
+    }
+}
+
+TEST_F(EngineEffectChainTest, RampsUntilProcessed) {
+    setUpChain(1, EffectChain::INSERT, 1.0);
+    ChannelHandle other = m_factory.getOrCreateHandle("[Channel2]");
+    EXPECT_TRUE(m_chain.rampsForChannel(m_handle));
+    EXPECT_FALSE(m_chain.rampsForChannel(other));
+
+    ScratchBufferPool scratch(2, kBufferSize);
+    processCallback(&scratch);
+    EXPECT_FALSE(m_chain.rampsForChannel(m_handle));
+
+    EffectsRequest disable;
+    disable.type = EffectsRequest::DISABLE_EFFECT_CHAIN_FOR_CHANNEL;
+    disable.channel = m_handle;
+    sendRequest(&disable);
+    EXPECT_TRUE(m_chain.rampsForChannel(m_handle));
+    processCallback(&scratch);
+    EXPECT_FALSE(m_chain.rampsForChannel(m_handle));
+}
+
+TEST(ScratchBufferPoolTest, AcquireAndRelease) {
+    ScratchBufferPool pool(2, kBufferSize);
+    EXPECT_EQ(kBufferSize, pool.bufferSize());
+    CSAMPLE* pFirst = pool.acquire();
+    CSAMPLE* pSecond = pool.acquire();
+    ASSERT_TRUE(pFirst != NULL);
+    ASSERT_TRUE(pSecond != NULL);
+    EXPECT_NE(pFirst, pSecond);
+    EXPECT_TRUE(pool.acquire() == NULL);
+    pool.release(pFirst);
+    EXPECT_EQ(1, pool.available());
+    EXPECT_EQ(pFirst, pool.acquire());
+    pool.release(pFirst);
+    pool.release(pSecond);
+    EXPECT_EQ(2, pool.available());
+}
+
+}  // namespace
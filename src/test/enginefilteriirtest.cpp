@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <cmath>
+
+#include "engine/enginefilterbessel4.h"
+#include "engine/enginefilterbessel8.h"
+#include "engine/enginefilterbiquad1.h"
+#include "engine/enginefilterbutterworth4.h"
+#include "engine/enginefilterbutterworth8.h"
+#include "engine/enginefilterlinkwitzriley8.h"
+#include "sampleutil.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const int kSampleRate = 44100;
+const int kBufferSize = 1024;
+
+class EngineFilterIIRTest : public testing::Test {
+  protected:
+    virtual void SetUp() {
+        m_simdLevel = SampleUtil::simdLevel();
+        m_pInput = SampleUtil::alloc(kBufferSize);
+        m_pExpected = SampleUtil::alloc(kBufferSize);
+        m_pOutput = SampleUtil::alloc(kBufferSize);
+    }
+
+    virtual void TearDown() {
+        SampleUtil::free(m_pInput);
+        SampleUtil::free(m_pExpected);
+        SampleUtil::free(m_pOutput);
+        SampleUtil::setSimdLevel(m_simdLevel);
+    }
+
+    static bool simdSupported() {
+        const SampleUtil::SimdLevel current = SampleUtil::simdLevel();
+        SampleUtil::setSimdLevel(SampleUtil::SIMD_SSE2);
+        const bool supported = SampleUtil::simdLevel() != SampleUtil::SIMD_NONE;
+        SampleUtil::setSimdLevel(current);
+        return supported;
+    }
+
+    // A sine sweep with some deterministic noise on top, different for
+    // the two channels and for every buffer.
+    void fillInput(int buffer) {
+        for (int i = 0; i < kBufferSize; i += 2) {
+            const double t = (buffer * kBufferSize + i) / 2.0;
+            const CSAMPLE noise = ((i * 7919) % 2003) / 5000.0f - 0.2f;
+            m_pInput[i] = 0.7 * sin(t * t * 1e-8) + noise;
+            m_pInput[i + 1] = 0.7 * sin(t * 0.05) - noise;
+        }
+    }
+
+    // Runs the same input through the filter with the plain loop and
+    // through its copy with both channels in SIMD lanes.
+    template<typename Filter>
+    void expectSimdMatchesPlain(Filter* pPlain, Filter* pSimd, int buffers) {
+        for (int b = 0; b < buffers; ++b) {
+            processBuffer(pPlain, pSimd, b);
+        }
+    }
+
+    template<typename Filter>
+    void processBuffer(Filter* pPlain, Filter* pSimd, int buffer) {
+        fillInput(buffer);
+        SampleUtil::setSimdLevel(SampleUtil::SIMD_NONE);
+        pPlain->process(m_pInput, m_pExpected, kBufferSize);
+        SampleUtil::setSimdLevel(SampleUtil::SIMD_SSE2);
+        // In place, like the effects do it.
+        SampleUtil::copy(m_pOutput, m_pInput, kBufferSize);
+        pSimd->process(m_pOutput, m_pOutput, kBufferSize);
+        expectSameOutput(m_pExpected, m_pOutput, buffer);
+    }
+
+    static void expectSameOutput(const CSAMPLE* pExpected,
+                                 const CSAMPLE* pOutput, int buffer) {
+        for (int i = 0; i < kBufferSize; ++i) {
+#ifdef __FAST_MATH__
+            // The compiler may reorder the math of the two paths
+            // differently.
+            EXPECT_NEAR(pExpected[i], pOutput[i], 1e-6)
+                    << "buffer " << buffer << " index " << i;
+#else
+            EXPECT_EQ(pExpected[i], pOutput[i])
+                    << "buffer " << buffer << " index " << i;
+#endif
+        }
+    }
+
+    // Processes kBufferSize samples count times and returns the time per
+    // buffer in ns.
+    template<typename Filter>
+    qint64 benchmark(Filter* pFilter, SampleUtil::SimdLevel level, int count) {
+        SampleUtil::setSimdLevel(level);
+        fillInput(0);
+        pFilter->process(m_pInput, m_pOutput, kBufferSize);
+        PerformanceTimer timer;
+        timer.start();
+        for (int i = 0; i < count; ++i) {
+            pFilter->process(m_pOutput, m_pOutput, kBufferSize);
+        }
+        return timer.elapsed() / count;
+    }
+
+    template<typename Filter>
+    void benchmarkFilter(const char* name, Filter* pPlain, Filter* pSimd) {
+        const int kCount = 10000;
+        const qint64 plain = benchmark(pPlain, SampleUtil::SIMD_NONE, kCount);
+        const qint64 simd = benchmark(pSimd, m_simdLevel, kCount);
+        qDebug() << name << "plain" << plain << "ns, SIMD" << simd
+                 << "ns per" << kBufferSize << "samples, speedup"
+                 << static_cast<double>(plain) / simd;
+    }
+
+    SampleUtil::SimdLevel m_simdLevel;
+    CSAMPLE* m_pInput;
+    CSAMPLE* m_pExpected;
+    CSAMPLE* m_pOutput;
+};
+
+TEST_F(EngineFilterIIRTest, SimdMatchesPlainBessel) {
+    if (!simdSupported()) {
+        return;
+    }
+    EngineFilterBessel4Low low4(kSampleRate, 246);
+    EngineFilterBessel4Low low4Simd(kSampleRate, 246);
+    expectSimdMatchesPlain(&low4, &low4Simd, 8);
+    EngineFilterBessel4Band band4(kSampleRate, 246, 2484);
+    EngineFilterBessel4Band band4Simd(kSampleRate, 246, 2484);
+    expectSimdMatchesPlain(&band4, &band4Simd, 8);
+    EngineFilterBessel4High high4(kSampleRate, 2484);
+    EngineFilterBessel4High high4Simd(kSampleRate, 2484);
+    expectSimdMatchesPlain(&high4, &high4Simd, 8);
+    EngineFilterBessel8Low low8(kSampleRate, 246);
+    EngineFilterBessel8Low low8Simd(kSampleRate, 246);
+    expectSimdMatchesPlain(&low8, &low8Simd, 8);
+    EngineFilterBessel8Band band8(kSampleRate, 246, 2484);
+    EngineFilterBessel8Band band8Simd(kSampleRate, 246, 2484);
+    expectSimdMatchesPlain(&band8, &band8Simd, 8);
+    EngineFilterBessel8High high8(kSampleRate, 2484);
+    EngineFilterBessel8High high8Simd(kSampleRate, 2484);
+    expectSimdMatchesPlain(&high8, &high8Simd, 8);
+}
+
+TEST_F(EngineFilterIIRTest, SimdMatchesPlainButterworthLinkwitzRiley) {
+    if (!simdSupported()) {
+        return;
+    }
+    EngineFilterButterworth4Band band4(kSampleRate, 246, 2484);
+    EngineFilterButterworth4Band band4Simd(kSampleRate, 246, 2484);
+    expectSimdMatchesPlain(&band4, &band4Simd, 8);
+    EngineFilterButterworth8Band band8(kSampleRate, 246, 2484);
+    EngineFilterButterworth8Band band8Simd(kSampleRate, 246, 2484);
+    expectSimdMatchesPlain(&band8, &band8Simd, 8);
+    EngineFilterLinkwtzRiley8Low low8(kSampleRate, 246);
+    EngineFilterLinkwtzRiley8Low low8Simd(kSampleRate, 246);
+    expectSimdMatchesPlain(&low8, &low8Simd, 8);
+    EngineFilterLinkwtzRiley8High high8(kSampleRate, 2484);
+    EngineFilterLinkwtzRiley8High high8Simd(kSampleRate, 2484);
+    expectSimdMatchesPlain(&high8, &high8Simd, 8);
+}
+
+TEST_F(EngineFilterIIRTest, SimdMatchesPlainBiquad) {
+    if (!simdSupported()) {
+        return;
+    }
+    EngineFilterBiquad1Peaking peaking(kSampleRate, 1000, 1.75);
+    EngineFilterBiquad1Peaking peakingSimd(kSampleRate, 1000, 1.75);
+    peaking.setFrequencyCorners(kSampleRate, 1000, 1.75, 6.0);
+    peakingSimd.setFrequencyCorners(kSampleRate, 1000, 1.75, 6.0);
+    expectSimdMatchesPlain(&peaking, &peakingSimd, 8);
+    EngineFilterBiquad1Low low(kSampleRate, 500, 0.707106781, false);
+    EngineFilterBiquad1Low lowSimd(kSampleRate, 500, 0.707106781, false);
+    expectSimdMatchesPlain(&low, &lowSimd, 8);
+    EngineFilterBiquad1Band band(kSampleRate, 500, 0.707106781);
+    EngineFilterBiquad1Band bandSimd(kSampleRate, 500, 0.707106781);
+    expectSimdMatchesPlain(&band, &bandSimd, 8);
+    EngineFilterBiquad1High high(kSampleRate, 500, 0.707106781, false);
+    EngineFilterBiquad1High highSimd(kSampleRate, 500, 0.707106781, false);
+    expectSimdMatchesPlain(&high, &highSimd, 8);
+}
+
+TEST_F(EngineFilterIIRTest, SimdMatchesPlainAfterRamping) {
+    if (!simdSupported()) {
+        return;
+    }
+    // The cross fade to new coefficients hands over the filter state to the
+    // SIMD loop.
+    EngineFilterBessel8Low filter(kSampleRate, 246);
+    EngineFilterBessel8Low filterSimd(kSampleRate, 246);
+    expectSimdMatchesPlain(&filter, &filterSimd, 2);
+    filter.setFrequencyCorners(kSampleRate, 1200);
+    filterSimd.setFrequencyCorners(kSampleRate, 1200);
+    expectSimdMatchesPlain(&filter, &filterSimd, 4);
+    filter.pauseFilter();
+    filterSimd.pauseFilter();
+    expectSimdMatchesPlain(&filter, &filterSimd, 4);
+}
+
+TEST_F(EngineFilterIIRTest, ProcessBatchMatchesProcess) {
+    // Six decks, one with other coefficients and, after a while, one that
+    // is ramping to new ones, so the batch is split up.
+    const int kDecks = 6;
+    EngineFilterBessel8Low* filters[kDecks];
+    EngineFilterBessel8Low* batchFilters[kDecks];
+    CSAMPLE* pExpected[kDecks];
+    CSAMPLE* pBuffers[kDecks];
+    for (int i = 0; i < kDecks; ++i) {
+        const double freq = i == 2 ? 1200 : 246;
+        filters[i] = new EngineFilterBessel8Low(kSampleRate, freq);
+        batchFilters[i] = new EngineFilterBessel8Low(kSampleRate, freq);
+        pExpected[i] = SampleUtil::alloc(kBufferSize);
+        pBuffers[i] = SampleUtil::alloc(kBufferSize);
+    }
+
+    for (int b = 0; b < 4; ++b) {
+        if (b == 2) {
+            filters[4]->setFrequencyCorners(kSampleRate, 600);
+            batchFilters[4]->setFrequencyCorners(kSampleRate, 600);
+        }
+        for (int i = 0; i < kDecks; ++i) {
+            fillInput(b * kDecks + i);
+            filters[i]->process(m_pInput, pExpected[i], kBufferSize);
+            SampleUtil::copy(pBuffers[i], m_pInput, kBufferSize);
+        }
+        // In place, like the effects do it.
+        EngineFilterBessel8Low::processBatch(batchFilters, pBuffers, pBuffers,
+                                             kDecks, kBufferSize);
+        for (int i = 0; i < kDecks; ++i) {
+            expectSameOutput(pExpected[i], pBuffers[i], b);
+        }
+    }
+
+    for (int i = 0; i < kDecks; ++i) {
+        delete filters[i];
+        delete batchFilters[i];
+        SampleUtil::free(pExpected[i]);
+        SampleUtil::free(pBuffers[i]);
+    }
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(EngineFilterIIRTest, DISABLED_SimdBenchmark) {
+    EngineFilterBessel4Low bessel4(kSampleRate, 246);
+    EngineFilterBessel4Low bessel4Simd(kSampleRate, 246);
+    benchmarkFilter("Bessel4 low", &bessel4, &bessel4Simd);
+    EngineFilterBessel8Low bessel8(kSampleRate, 246);
+    EngineFilterBessel8Low bessel8Simd(kSampleRate, 246);
+    benchmarkFilter("Bessel8 low", &bessel8, &bessel8Simd);
+    EngineFilterBessel8Band bessel8Band(kSampleRate, 246, 2484);
+    EngineFilterBessel8Band bessel8BandSimd(kSampleRate, 246, 2484);
+    benchmarkFilter("Bessel8 band", &bessel8Band, &bessel8BandSimd);
+    EngineFilterLinkwtzRiley8High lr8(kSampleRate, 2484);
+    EngineFilterLinkwtzRiley8High lr8Simd(kSampleRate, 2484);
+    benchmarkFilter("LinkwitzRiley8 high", &lr8, &lr8Simd);
+    EngineFilterBiquad1Peaking peaking(kSampleRate, 1000, 1.75);
+    EngineFilterBiquad1Peaking peakingSimd(kSampleRate, 1000, 1.75);
+    benchmarkFilter("Biquad1 peaking", &peaking, &peakingSimd);
+}
+
+}  // namespace
@@ -13,6 +13,7 @@
 #include "test/mixxxtest.h"
 
 using ::testing::Return;
+using ::testing::Sequence;
 using ::testing::_;
 
 namespace {
@@ -35,7 +36,9 @@ class EngineChannelMock : public EngineChannel {
     MOCK_CONST_METHOD0(isMasterEnabled, bool());
     MOCK_CONST_METHOD0(isPflEnabled, bool());
     MOCK_METHOD2(process, void(CSAMPLE* pInOut, const int iBufferSize));
+    MOCK_METHOD2(processIsolated, bool(CSAMPLE* pInOut, const int iBufferSize));
     MOCK_METHOD1(postProcess, void(const int iBufferSize));
+    MOCK_CONST_METHOD0(isSilent, bool());
 };
 
 class EngineMasterTest : public MixxxTest {
@@ -75,6 +78,15 @@ class EngineMasterTest : public MixxxTest {
     ControlObjectSlave* m_pMasterEnabled;
 };
 
+class EngineMasterParallelTest : public EngineMasterTest {
+  protected:
+    virtual void SetUp() {
+        config()->set(ConfigKey("[Master]", "channel_worker_threads"),
+                      ConfigValue(2));
+        EngineMasterTest::SetUp();
+    }
+};
+
 TEST_F(EngineMasterTest, SingleChannelOutputWorks) {
     EngineChannelMock* pChannel = new EngineChannelMock(
             "[Test1]", EngineChannel::CENTER, m_pMaster);
@@ -169,6 +181,48 @@ TEST_F(EngineMasterTest, TwoChannelOutputWorks) {
     AssertWholeBufferEquals(pHeadphoneBuffer, 0.0f, MAX_BUFFER_LEN);
 }
 
+TEST_F(EngineMasterTest, SilentChannelIsNotMixed) {
+    EngineChannelMock* pChannel1 = new EngineChannelMock(
+            "[Test1]", EngineChannel::CENTER, m_pMaster);
+    m_pMaster->addChannel(pChannel1);
+    EngineChannelMock* pChannel2 = new EngineChannelMock(
+            "[Test2]", EngineChannel::CENTER, m_pMaster);
+    m_pMaster->addChannel(pChannel2);
+
+    CSAMPLE* pChannel1Buffer = const_cast<CSAMPLE*>(m_pMaster->getChannelBuffer("[Test1]"));
+    CSAMPLE* pChannel2Buffer = const_cast<CSAMPLE*>(m_pMaster->getChannelBuffer("[Test2]"));
+    FillBuffer(pChannel1Buffer, 0.1f, MAX_BUFFER_LEN);
+    // Channel 2 claims to be silent, so its buffer is not even read.
+    FillBuffer(pChannel2Buffer, 0.2f, MAX_BUFFER_LEN);
+
+    EXPECT_CALL(*pChannel1, isActive())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel1, isMasterEnabled())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel1, isPflEnabled())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel1, isSilent())
+            .WillRepeatedly(Return(false));
+    EXPECT_CALL(*pChannel2, isActive())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel2, isMasterEnabled())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel2, isPflEnabled())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel2, isSilent())
+            .WillRepeatedly(Return(true));
+    EXPECT_CALL(*pChannel1, process(_, MAX_BUFFER_LEN))
+            .WillRepeatedly(Return());
+    EXPECT_CALL(*pChannel2, process(_, MAX_BUFFER_LEN))
+            .WillRepeatedly(Return());
+
+    m_pMaster->process(MAX_BUFFER_LEN);
+
+    AssertWholeBufferEquals(m_pMaster->getMasterBuffer(), 0.1f, MAX_BUFFER_LEN);
+    AssertWholeBufferEquals(m_pMaster->getHeadphoneBuffer(), 0.1f,
+                            MAX_BUFFER_LEN);
+}
+
 TEST_F(EngineMasterTest, TwoChannelPFLOutputWorks) {
     EngineChannelMock* pChannel1 = new EngineChannelMock(
             "[Test1]", EngineChannel::CENTER, m_pMaster);
@@ -415,4 +469,73 @@ TEST_F(EngineMasterTest, SingleChannelPFLOutputWorks) {
     AssertWholeBufferEquals(pHeadphoneBuffer, 0.1f, MAX_BUFFER_LEN);
 }
 
+TEST_F(EngineMasterParallelTest, ThreeChannelOutputWorks) {
+    const int kChannels = 3;
+    EngineChannelMock* channels[kChannels];
+    Sequence sequences[kChannels];
+    for (int i = 0; i < kChannels; ++i) {
+        const QString group = QString("[Test%1]").arg(i + 1);
+        channels[i] = new EngineChannelMock(
+                group, EngineChannel::CENTER, m_pMaster);
+        m_pMaster->addChannel(channels[i]);
+        CSAMPLE* pBuffer = const_cast<CSAMPLE*>(
+                m_pMaster->getChannelBuffer(group));
+        FillBuffer(pBuffer, 0.1f * (i + 1), MAX_BUFFER_LEN);
+
+        EXPECT_CALL(*channels[i], isActive())
+                .Times(1)
+                .WillOnce(Return(true));
+        EXPECT_CALL(*channels[i], isMasterEnabled())
+                .Times(1)
+                .WillOnce(Return(true));
+        EXPECT_CALL(*channels[i], isPflEnabled())
+                .Times(1)
+                .WillOnce(Return(false));
+
+        // The isolated part runs on the worker threads, the rest afterwards.
+        EXPECT_CALL(*channels[i], processIsolated(pBuffer, MAX_BUFFER_LEN))
+                .Times(1)
+                .InSequence(sequences[i])
+                .WillOnce(Return(true));
+        EXPECT_CALL(*channels[i], process(pBuffer, MAX_BUFFER_LEN))
+                .Times(1)
+                .InSequence(sequences[i])
+                .WillOnce(Return());
+    }
+
+    m_pMaster->process(MAX_BUFFER_LEN);
+
+    // Check that the master output contains the sum of the channel data.
+    const CSAMPLE* pMasterBuffer = m_pMaster->getMasterBuffer();
+    AssertWholeBufferEquals(pMasterBuffer, 0.6f, MAX_BUFFER_LEN);
+}
+
+TEST_F(EngineMasterParallelTest, SingleChannelIsProcessedSerially) {
+    EngineChannelMock* pChannel = new EngineChannelMock(
+            "[Test1]", EngineChannel::CENTER, m_pMaster);
+    m_pMaster->addChannel(pChannel);
+    CSAMPLE* pChannelBuffer = const_cast<CSAMPLE*>(m_pMaster->getChannelBuffer("[Test1]"));
+    FillBuffer(pChannelBuffer, 0.1f, MAX_BUFFER_LEN);
+
+    EXPECT_CALL(*pChannel, isActive())
+            .Times(1)
+            .WillOnce(Return(true));
+    EXPECT_CALL(*pChannel, isMasterEnabled())
+            .Times(1)
+            .WillOnce(Return(true));
+    EXPECT_CALL(*pChannel, isPflEnabled())
+            .Times(1)
+            .WillOnce(Return(false));
+    EXPECT_CALL(*pChannel, processIsolated(_, _))
+            .Times(0);
+    EXPECT_CALL(*pChannel, process(_, MAX_BUFFER_LEN))
+            .Times(1)
+            .WillOnce(Return());
+
+    m_pMaster->process(MAX_BUFFER_LEN);
+
+    const CSAMPLE* pMasterBuffer = m_pMaster->getMasterBuffer();
+    AssertWholeBufferEquals(pMasterBuffer, 0.1f, MAX_BUFFER_LEN);
+}
+
 }  // namespace
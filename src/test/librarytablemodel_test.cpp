@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <QDir>
+#include <QImage>
+#include <QMap>
+#include <QScrollBar>
+#include <QSqlQuery>
+
+#include "library/basetrackcache.h"
+#include "library/librarytablemodel.h"
+#include "library/queryutil.h"
+#include "test/librarytest.h"
+#include "track/keyutils.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+#include "util/time.h"
+#include "widget/wtracktableview.h"
+
+namespace {
+
+class LibraryTableModelTest : public LibraryTest {
+  protected:
+    LibraryTableModelTest() {
+        // The track source of the Mixxx library, like MixxxLibraryFeature
+        // creates it.
+        QStringList columns;
+        columns << "library." + LIBRARYTABLE_ID
+                << "library." + LIBRARYTABLE_PLAYED
+                << "library." + LIBRARYTABLE_TIMESPLAYED
+                << "library." + LIBRARYTABLE_ALBUMARTIST
+                << "library." + LIBRARYTABLE_ALBUM
+                << "library." + LIBRARYTABLE_ARTIST
+                << "library." + LIBRARYTABLE_TITLE
+                << "library." + LIBRARYTABLE_YEAR
+                << "library." + LIBRARYTABLE_RATING
+                << "library." + LIBRARYTABLE_GENRE
+                << "library." + LIBRARYTABLE_TRACKNUMBER
+                << "library." + LIBRARYTABLE_KEY
+                << "library." + LIBRARYTABLE_KEY_ID
+                << "library." + LIBRARYTABLE_BPM
+                << "library." + LIBRARYTABLE_BPM_LOCK
+                << "library." + LIBRARYTABLE_DURATION
+                << "library." + LIBRARYTABLE_BITRATE
+                << "library." + LIBRARYTABLE_DATETIMEADDED
+                << "track_locations.location"
+                << "track_locations.fs_deleted"
+                << "library." + LIBRARYTABLE_MIXXXDELETED;
+
+        QSqlQuery query(collection()->getDatabase());
+        const QString tableName = "library_cache_view";
+        query.prepare(QString(
+                "CREATE TEMPORARY VIEW IF NOT EXISTS %1 AS "
+                "SELECT %2 FROM library "
+                "INNER JOIN track_locations ON library.location = track_locations.id")
+                      .arg(tableName, columns.join(",")));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+        }
+        columns.replaceInStrings("library.", "");
+        columns.replaceInStrings("track_locations.", "");
+
+        QSharedPointer<BaseTrackCache> pTrackSource(new BaseTrackCache(
+                collection(), tableName, LIBRARYTABLE_ID, columns, true));
+        collection()->setTrackSource(pTrackSource);
+    }
+
+    virtual void TearDown() {
+        // make sure we clean up the db
+        QSqlQuery query(collection()->getDatabase());
+        query.exec("DELETE FROM library");
+        query.exec("DELETE FROM track_locations");
+        // Back to the default notation.
+        KeyUtils::setNotation(
+                QMap<mixxx::track::io::key::ChromaticKey, QString>());
+    }
+
+    // The files don't need to exist, the headers of the tracks are not
+    // parsed.
+    void addTracks(int count) {
+        const int kBatchSize = 1000;
+        for (int first = 0; first < count; first += kBatchSize) {
+            QList<TrackInfoObject*> tracks;
+            for (int i = first; i < qMin(first + kBatchSize, count); ++i) {
+                TrackInfoObject* pTrack = new TrackInfoObject(
+                        QDir::tempPath() +
+                                QString("/LibraryTableModelTest/%1.mp3").arg(i),
+                        SecurityTokenPointer(), false);
+                pTrack->setArtist(
+                        QString("Artist %1").arg(i % 1000, 4, 10, QChar('0')));
+                pTrack->setTitle(QString("Title %1").arg(i));
+                pTrack->setDuration(60 + i % 600);
+                pTrack->setBitrate(i % 2 == 0 ? 320 : 0);
+                pTrack->setBpm(100.0 + i % 50);
+                pTrack->setKey(static_cast<mixxx::track::io::key::ChromaticKey>(
+                        1 + i % 24), mixxx::track::io::key::USER);
+                tracks.append(pTrack);
+            }
+            trackDao().addTracksPrepare();
+            trackDao().addTracksAddBatch(tracks, false);
+            trackDao().addTracksFinish(false);
+            qDeleteAll(tracks);
+        }
+    }
+
+    TrackDAO& trackDao() {
+        return collection()->getTrackDAO();
+    }
+
+    static void setKeyNotation(KeyUtils::KeyNotation notation) {
+        QMap<mixxx::track::io::key::ChromaticKey, QString> notationMap;
+        for (int i = mixxx::track::io::key::C_MAJOR;
+                i <= mixxx::track::io::key::B_MINOR; ++i) {
+            mixxx::track::io::key::ChromaticKey key =
+                    static_cast<mixxx::track::io::key::ChromaticKey>(i);
+            notationMap.insert(key, KeyUtils::keyToString(key, notation));
+        }
+        KeyUtils::setNotation(notationMap);
+    }
+};
+
+TEST_F(LibraryTableModelTest, FormatsDisplayValues) {
+    addTracks(2);
+    LibraryTableModel model(NULL, collection(), "mixxx.db.model.library");
+    ASSERT_EQ(2, model.rowCount());
+
+    const int durationColumn =
+            model.fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_DURATION);
+    const int bitrateColumn =
+            model.fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_BITRATE);
+    const int titleColumn =
+            model.fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_TITLE);
+    // Sorted by artist
+    EXPECT_EQ(QString("Title 0"), model.index(0, titleColumn).data().toString());
+    EXPECT_EQ(QString("Title 1"), model.index(1, titleColumn).data().toString());
+
+    // The second read of a value comes from the display value cache.
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(Time::formatSeconds(60, false),
+                  model.index(0, durationColumn).data().toString());
+        EXPECT_EQ(QString("320"),
+                  model.index(0, bitrateColumn).data().toString());
+        // Invalid values are not displayed.
+        EXPECT_EQ(QString(), model.index(1, bitrateColumn).data().toString());
+    }
+    // The raw value is still available for editing.
+    EXPECT_EQ(61, model.index(1, durationColumn).data(Qt::EditRole).toInt());
+    EXPECT_EQ(model.getTrackId(model.index(0, titleColumn)),
+              model.index(0, model.fieldIndex(LIBRARYTABLE_ID)).data().toInt());
+}
+
+TEST_F(LibraryTableModelTest, RendersKeysWithCurrentNotation) {
+    addTracks(1);
+    LibraryTableModel model(NULL, collection(), "mixxx.db.model.library");
+    ASSERT_EQ(1, model.rowCount());
+    const QModelIndex keyIndex = model.index(
+            0, model.fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_KEY));
+
+    setKeyNotation(KeyUtils::OPEN_KEY);
+    EXPECT_EQ(KeyUtils::keyToString(mixxx::track::io::key::C_MAJOR,
+                                    KeyUtils::OPEN_KEY),
+              keyIndex.data().toString());
+
+    setKeyNotation(KeyUtils::LANCELOT);
+    EXPECT_EQ(KeyUtils::keyToString(mixxx::track::io::key::C_MAJOR,
+                                    KeyUtils::LANCELOT),
+              keyIndex.data().toString());
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(LibraryTableModelTest, DISABLED_ScrollBenchmark) {
+    const int kTracks = 100000;
+    addTracks(kTracks);
+
+    PerformanceTimer timer;
+    timer.start();
+    LibraryTableModel model(NULL, collection(), "mixxx.db.model.library");
+    qDebug() << model.rowCount() << "rows: loading the model took"
+             << timer.elapsed() / 1000000.0 << "ms";
+
+    WTrackTableView view(NULL, config(), collection(), true);
+    view.loadTrackModel(&model);
+    view.resize(1280, 800);
+    QImage frame(view.size(), QImage::Format_ARGB32_Premultiplied);
+
+    // Scroll down page by page and back up again, the second pass paints
+    // rows that have been painted before.
+    QScrollBar* pScrollBar = view.verticalScrollBar();
+    const int kFrames = 400;
+    const qint64 kFrameBudget = 1000000000 / 60;
+    for (int pass = 0; pass < 2; ++pass) {
+        qint64 total = 0;
+        qint64 slowest = 0;
+        int framesOverBudget = 0;
+        for (int i = 0; i < kFrames; ++i) {
+            const int page = pass == 0 ? i : kFrames - 1 - i;
+            timer.start();
+            pScrollBar->setValue(page * pScrollBar->pageStep());
+            view.render(&frame);
+            const qint64 elapsed = timer.elapsed();
+            total += elapsed;
+            slowest = math_max(slowest, elapsed);
+            if (elapsed > kFrameBudget) {
+                ++framesOverBudget;
+            }
+        }
+        qDebug() << (pass == 0 ? "first pass:" : "second pass:")
+                 << kFrames << "frames, average"
+                 << total / kFrames / 1000000.0 << "ms, slowest"
+                 << slowest / 1000000.0 << "ms," << framesOverBudget
+                 << "frames over the 60 fps budget";
+    }
+}
+
+}  // namespace
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <cmath>
+
+#include "effects/native/lvmixeqbase.h"
+#include "engine/enginefilterbessel4.h"
+#include "engine/enginefilterbessel8.h"
+#include "sampleutil.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const unsigned int kSampleRate = 44100;
+const double kLoFreq = 246;
+const double kHiFreq = 2484;
+// 64 frames, the buffer size of a low latency setup.
+const int kBufferSize = 128;
+const int kDecks = 4;
+
+class LVMixEQBatchTest : public testing::Test {
+  protected:
+    virtual void SetUp() {
+        for (int i = 0; i < kDecks; ++i) {
+            m_pInput[i] = SampleUtil::alloc(kBufferSize);
+            m_pExpected[i] = SampleUtil::alloc(kBufferSize);
+            m_pOutput[i] = SampleUtil::alloc(kBufferSize);
+        }
+    }
+
+    virtual void TearDown() {
+        for (int i = 0; i < kDecks; ++i) {
+            SampleUtil::free(m_pInput[i]);
+            SampleUtil::free(m_pExpected[i]);
+            SampleUtil::free(m_pOutput[i]);
+        }
+    }
+
+    // Different noise for every deck and buffer.
+    void fillInput(int buffer) {
+        for (int d = 0; d < kDecks; ++d) {
+            for (int i = 0; i < kBufferSize; i += 2) {
+                const double t = (buffer * kBufferSize + i) / 2.0;
+                const CSAMPLE noise =
+                        (((i + d * 31) * 7919) % 2003) / 5000.0f - 0.2f;
+                m_pInput[d][i] = 0.7 * sin(t * (0.01 + d * 0.02)) + noise;
+                m_pInput[d][i + 1] = 0.7 * sin(t * 0.05) - noise;
+            }
+        }
+    }
+
+    CSAMPLE* m_pInput[kDecks];
+    CSAMPLE* m_pExpected[kDecks];
+    CSAMPLE* m_pOutput[kDecks];
+};
+
+TEST_F(LVMixEQBatchTest, BatchMatchesSingleChannels) {
+    typedef LVMixEQEffectGroupState<EngineFilterBessel4Low> State;
+    State* states[kDecks];
+    State* batchStates[kDecks];
+    for (int d = 0; d < kDecks; ++d) {
+        states[d] = new State();
+        batchStates[d] = new State();
+    }
+    // Deck 1 kills the low, deck 2 boosts the mid and deck 3 turns the
+    // high down after a while, which ramps.
+    double fLow[kDecks] = { 1.0, 0.0, 1.0, 1.0 };
+    double fMid[kDecks] = { 1.0, 1.0, 2.0, 1.0 };
+    double fHigh[kDecks] = { 1.0, 1.0, 1.0, 1.0 };
+
+    for (int b = 0; b < 8; ++b) {
+        if (b == 3) {
+            fHigh[3] = 0.25;
+        }
+        fillInput(b);
+        for (int d = 0; d < kDecks; ++d) {
+            states[d]->processChannel(m_pInput[d], m_pExpected[d],
+                                      kBufferSize, kSampleRate,
+                                      fLow[d], fMid[d], fHigh[d],
+                                      kLoFreq, kHiFreq);
+            SampleUtil::copy(m_pOutput[d], m_pInput[d], kBufferSize);
+        }
+        // In place, like the effects do it.
+        State::processChannels(batchStates, m_pOutput, m_pOutput,
+                               fLow, fMid, fHigh, kDecks,
+                               kBufferSize, kSampleRate, kLoFreq, kHiFreq);
+        for (int d = 0; d < kDecks; ++d) {
+            for (int i = 0; i < kBufferSize; ++i) {
+#ifdef __FAST_MATH__
+                // The compiler may reorder the math of the two paths
+                // differently.
+                EXPECT_NEAR(m_pExpected[d][i], m_pOutput[d][i], 1e-6)
+                        << "buffer " << b << " deck " << d << " index " << i;
+#else
+                EXPECT_EQ(m_pExpected[d][i], m_pOutput[d][i])
+                        << "buffer " << b << " deck " << d << " index " << i;
+#endif
+            }
+        }
+    }
+
+    for (int d = 0; d < kDecks; ++d) {
+        delete states[d];
+        delete batchStates[d];
+    }
+}
+
+template<class LPF>
+void benchmarkEQ(const char* name, CSAMPLE* const* pInput,
+                 CSAMPLE* const* pOutput) {
+    typedef LVMixEQEffectGroupState<LPF> State;
+    State* states[kDecks];
+    for (int d = 0; d < kDecks; ++d) {
+        states[d] = new State();
+    }
+    // Bands with the same gain are not filtered, so all differ.
+    const double fLow[kDecks] = { 1.5, 0.5, 1.2, 2.0 };
+    const double fMid[kDecks] = { 1.0, 0.8, 0.5, 1.0 };
+    const double fHigh[kDecks] = { 0.7, 1.0, 0.9, 0.5 };
+    const int kBuffers = 20000;
+
+    PerformanceTimer timer;
+    timer.start();
+    for (int b = 0; b < kBuffers; ++b) {
+        states[0]->processChannel(pInput[0], pOutput[0], kBufferSize,
+                                  kSampleRate, fLow[0], fMid[0], fHigh[0],
+                                  kLoFreq, kHiFreq);
+    }
+    const qint64 oneDeck = timer.restart() / kBuffers;
+    for (int b = 0; b < kBuffers; ++b) {
+        for (int d = 0; d < kDecks; ++d) {
+            states[d]->processChannel(pInput[d], pOutput[d], kBufferSize,
+                                      kSampleRate, fLow[d], fMid[d], fHigh[d],
+                                      kLoFreq, kHiFreq);
+        }
+    }
+    const qint64 oneByOne = timer.restart() / kBuffers;
+    for (int b = 0; b < kBuffers; ++b) {
+        State::processChannels(states, pInput, pOutput,
+                               fLow, fMid, fHigh, kDecks,
+                               kBufferSize, kSampleRate, kLoFreq, kHiFreq);
+    }
+    const qint64 batched = timer.elapsed() / kBuffers;
+    qDebug() << name << "per" << kBufferSize << "samples: 1 deck" << oneDeck
+             << "ns," << kDecks << "decks one by one" << oneByOne << "ns,"
+             << kDecks << "decks batched" << batched << "ns";
+
+    for (int d = 0; d < kDecks; ++d) {
+        delete states[d];
+    }
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(LVMixEQBatchTest, DISABLED_BatchBenchmark) {
+    fillInput(0);
+    benchmarkEQ<EngineFilterBessel4Low>("Bessel4 LV-Mix EQ",
+                                        m_pInput, m_pOutput);
+    benchmarkEQ<EngineFilterBessel8Low>("Bessel8 LV-Mix EQ",
+                                        m_pInput, m_pOutput);
+}
+
+}  // namespace
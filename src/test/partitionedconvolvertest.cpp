@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+
+#include <QVector>
+#include <QtDebug>
+#include <algorithm>
+#include <cmath>
+
+#include "effects/native/convolutionreverbeffect.h"
+#include "engine/convolutionworker.h"
+#include "engine/partitionedconvolver.h"
+#include "util/fft.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const int kHeadBlockSize = 16;
+const int kTailBlockSize = 64;
+// Long enough for a tail of several partitions and a partial one.
+const int kImpulseLength = 1000;
+const int kSignalLength = 4000;
+
+QVector<float> makeSignal(int length, quint32 seed) {
+    QVector<float> signal(length);
+    for (int i = 0; i < length; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        signal[i] = (seed >> 8) / float(1 << 24) - 0.5f;
+    }
+    return signal;
+}
+
+}  // namespace
+
+// Outside of the anonymous namespace, PartitionedConvolver is friends with
+// it.
+class PartitionedConvolverTest : public testing::Test {
+  protected:
+    PartitionedConvolverTest()
+            : m_impulse(makeSignal(kImpulseLength, 1)),
+              m_input(makeSignal(kSignalLength, 2)),
+              m_pKernel(new ConvolutionKernel(m_impulse.constData(),
+                                              kImpulseLength,
+                                              kHeadBlockSize,
+                                              kTailBlockSize)) {
+    }
+
+    // Feeds m_input in buffers of changing size, not aligned to the blocks
+    // of the convolver. With stallWorker, a worker picks up each tail block
+    // and never finishes it.
+    QVector<float> convolve(PartitionedConvolver* pConvolver,
+                            bool stallWorker = false) {
+        QVector<float> output = m_input;
+        float* pOutput = output.data();
+        int position = 0;
+        int bufferSize = 1;
+        while (position < kSignalLength) {
+            const int count = math_min(bufferSize, kSignalLength - position);
+            pConvolver->process(pOutput + position, pOutput + position,
+                                count, 1);
+            position += count;
+            if (stallWorker) {
+                stallTailBlocks(pConvolver);
+            }
+            bufferSize = bufferSize * 3 % 37 + 1;
+        }
+        return output;
+    }
+
+    // The direct convolution, delayed by a head block.
+    void expectConvolution(const QVector<float>& output) {
+        for (int i = 0; i < kSignalLength; ++i) {
+            const int last = i - kHeadBlockSize;
+            double expected = 0.0;
+            for (int j = 0; j < kImpulseLength && j <= last; ++j) {
+                expected += m_impulse[j] * m_input[last - j];
+            }
+            ASSERT_NEAR(expected, output[i], 1e-4) << "sample " << i;
+        }
+    }
+
+    static void stallTailBlocks(PartitionedConvolver* pConvolver) {
+        for (int i = 0; i < PartitionedConvolver::kTailSlots; ++i) {
+            pConvolver->m_tailSlots[i].state.testAndSetOrdered(
+                    PartitionedConvolver::TAIL_PENDING,
+                    PartitionedConvolver::TAIL_RUNNING);
+        }
+    }
+
+    // Lets the stalled worker finish its blocks.
+    static void resumeTailBlocks(PartitionedConvolver* pConvolver) {
+        for (int i = 0; i < PartitionedConvolver::kTailSlots; ++i) {
+            PartitionedConvolver::TailSlot* pSlot =
+                    &pConvolver->m_tailSlots[i];
+            if (pSlot->state.testAndSetOrdered(
+                        PartitionedConvolver::TAIL_RUNNING,
+                        PartitionedConvolver::TAIL_RUNNING) ||
+                    pSlot->state.testAndSetOrdered(
+                        PartitionedConvolver::TAIL_ABORTED,
+                        PartitionedConvolver::TAIL_ABORTED)) {
+                pConvolver->runTailBlock(pSlot);
+            }
+        }
+    }
+
+    static int countTailSlots(PartitionedConvolver* pConvolver, int state) {
+        int count = 0;
+        for (int i = 0; i < PartitionedConvolver::kTailSlots; ++i) {
+            if (pConvolver->m_tailSlots[i].state.testAndSetOrdered(
+                        state, state)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static int tailSlots() {
+        return PartitionedConvolver::kTailSlots;
+    }
+
+    static int abortedTailSlots(PartitionedConvolver* pConvolver) {
+        return countTailSlots(pConvolver, PartitionedConvolver::TAIL_ABORTED);
+    }
+
+    static int freeTailSlots(PartitionedConvolver* pConvolver) {
+        return countTailSlots(pConvolver, PartitionedConvolver::TAIL_FREE);
+    }
+
+    QVector<float> m_impulse;
+    QVector<float> m_input;
+    QSharedPointer<const ConvolutionKernel> m_pKernel;
+};
+
+TEST(RealFFTTest, MatchesDft) {
+    const int sizes[] = { 4, 8, 64, 1024 };
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        const int size = sizes[s];
+        RealFFT fft(size);
+        ASSERT_EQ(size / 2 + 1, fft.bins());
+        const QVector<float> input = makeSignal(size, size);
+        QVector<float> re(fft.bins());
+        QVector<float> im(fft.bins());
+        fft.forward(input.constData(), re.data(), im.data());
+        for (int k = 0; k < fft.bins(); ++k) {
+            double expectedRe = 0.0;
+            double expectedIm = 0.0;
+            for (int i = 0; i < size; ++i) {
+                const double phase = 2.0 * M_PI * k * i / size;
+                expectedRe += input[i] * cos(phase);
+                expectedIm -= input[i] * sin(phase);
+            }
+            EXPECT_NEAR(expectedRe, re[k], 1e-4 * size)
+                    << "size " << size << " bin " << k;
+            EXPECT_NEAR(expectedIm, im[k], 1e-4 * size)
+                    << "size " << size << " bin " << k;
+        }
+
+        QVector<float> output(size);
+        fft.inverse(re.constData(), im.constData(), output.data());
+        for (int i = 0; i < size; ++i) {
+            EXPECT_NEAR(input[i], output[i] / size, 1e-5)
+                    << "size " << size << " sample " << i;
+        }
+    }
+}
+
+TEST_F(PartitionedConvolverTest, KernelPartitions) {
+    // The head covers 2 tail blocks, 128 samples in 8 partitions, the tail
+    // the remaining 872 samples in 14 partitions.
+    EXPECT_EQ(8, m_pKernel->headPartitions());
+    EXPECT_EQ(14, m_pKernel->tailPartitions());
+}
+
+TEST_F(PartitionedConvolverTest, MatchesDirectConvolution) {
+    PartitionedConvolver convolver(m_pKernel,
+                                   QSharedPointer<ConvolutionWorker>());
+    expectConvolution(convolve(&convolver));
+}
+
+TEST_F(PartitionedConvolverTest, WorkerMatchesDirectConvolution) {
+    // The test runs faster than real time, so some of the tail blocks are
+    // computed by process() and some by the worker.
+    PartitionedConvolver convolver(m_pKernel,
+                                   ConvolutionWorker::sharedWorker());
+    expectConvolution(convolve(&convolver));
+}
+
+TEST_F(PartitionedConvolverTest, IdleWorkerDoesNotBlock) {
+    QSharedPointer<ConvolutionWorker> pWorker =
+            ConvolutionWorker::sharedWorker();
+    PartitionedConvolver convolver(m_pKernel, pWorker);
+    // The worker never gets to the tail blocks, process() computes all of
+    // them but the one posted last.
+    pWorker->removeConvolver(&convolver);
+    expectConvolution(convolve(&convolver));
+    EXPECT_EQ(kSignalLength / kTailBlockSize - 1, convolver.lateTailBlocks());
+}
+
+TEST_F(PartitionedConvolverTest, StalledWorkerDoesNotBlock) {
+    QSharedPointer<ConvolutionWorker> pWorker =
+            ConvolutionWorker::sharedWorker();
+    PartitionedConvolver convolver(m_pKernel, pWorker);
+    pWorker->removeConvolver(&convolver);
+    // Would hang if process() waited for the stalled worker.
+    expectConvolution(convolve(&convolver, true));
+    EXPECT_EQ(kSignalLength / kTailBlockSize - 1, convolver.lateTailBlocks());
+    // process() has given up on the blocks the worker holds and posts no
+    // more while it holds the slots.
+    EXPECT_EQ(tailSlots(), abortedTailSlots(&convolver));
+
+    // The worker drops the blocks process() has given up on and the slots
+    // are used again.
+    resumeTailBlocks(&convolver);
+    EXPECT_EQ(tailSlots(), freeTailSlots(&convolver));
+    convolver.reset();
+    expectConvolution(convolve(&convolver));
+    EXPECT_EQ(0, abortedTailSlots(&convolver));
+}
+
+TEST_F(PartitionedConvolverTest, ResetForgetsInput) {
+    PartitionedConvolver convolver(m_pKernel,
+                                   QSharedPointer<ConvolutionWorker>());
+    convolve(&convolver);
+    convolver.reset();
+    expectConvolution(convolve(&convolver));
+}
+
+TEST_F(PartitionedConvolverTest, ReverbSharesKernels) {
+    QSharedPointer<const ConvolutionKernel> pLeft =
+            ConvolutionReverbEffect::sharedKernel(0);
+    EXPECT_EQ(pLeft.data(), ConvolutionReverbEffect::sharedKernel(0).data());
+    EXPECT_NE(pLeft.data(), ConvolutionReverbEffect::sharedKernel(1).data());
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST(PartitionedConvolverBenchmark, DISABLED_ImpulseLengths) {
+    // Like ConvolutionReverbEffect, a stereo instance at 64 frame buffers.
+    const int kSampleRate = 44100;
+    const int kFrames = 64;
+    const int kTailFrames = 1024;
+    const int kBuffers = 10 * kSampleRate / kFrames;
+    const double kBufferNs = 1e9 * kFrames / kSampleRate;
+    const int seconds[] = { 1, 4, 10 };
+    for (unsigned int s = 0; s < sizeof(seconds) / sizeof(seconds[0]); ++s) {
+        const int length = seconds[s] * kSampleRate;
+        QVector<float> impulse =
+                ConvolutionReverbEffect::makeImpulse(0, length);
+        QSharedPointer<const ConvolutionKernel> pKernel(new ConvolutionKernel(
+                impulse.constData(), length, kFrames, kTailFrames));
+        // Without a worker, so the tail blocks can be timed too.
+        PartitionedConvolver left(pKernel, QSharedPointer<ConvolutionWorker>());
+        PartitionedConvolver right(pKernel,
+                                   QSharedPointer<ConvolutionWorker>());
+        const QVector<float> signal = makeSignal(2 * kFrames, 3);
+        QVector<float> buffer(2 * kFrames);
+        float* pBuffer = buffer.data();
+
+        qint64 total = 0;
+        qint64 head = 0;
+        qint64 worst = 0;
+        int headBuffers = 0;
+        PerformanceTimer timer;
+        for (int i = 0; i < kBuffers; ++i) {
+            std::copy(signal.constBegin(), signal.constEnd(), pBuffer);
+            timer.start();
+            left.process(pBuffer, pBuffer, kFrames, 2);
+            right.process(pBuffer + 1, pBuffer + 1, kFrames, 2);
+            const qint64 elapsed = timer.elapsed();
+            total += elapsed;
+            // The other buffers complete a tail block, which the worker
+            // would do.
+            if ((i + 1) * kFrames % kTailFrames != 0) {
+                head += elapsed;
+                worst = math_max(worst, elapsed);
+                ++headBuffers;
+            }
+        }
+        qDebug() << seconds[s] << "s impulse: engine thread"
+                 << 100.0 * head / headBuffers / kBufferNs
+                 << "% of the callback on average," << 100.0 * worst / kBufferNs
+                 << "% at worst, engine and worker"
+                 << 100.0 * total / kBuffers / kBufferNs
+                 << "% of one core per instance";
+    }
+}
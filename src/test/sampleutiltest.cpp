@@ -5,6 +5,7 @@
 #include <QPair>
 
 #include "util/timer.h"
+#include "util/performancetimer.h"
 #include "sampleutil.h"
 
 namespace {
@@ -12,6 +13,7 @@ namespace {
 class SampleUtilTest : public testing::Test {
   protected:
     virtual void SetUp() {
+        simdLevel = SampleUtil::simdLevel();
         sizes.append(1024);
         sizes.append(1025);
         sizes.append(1026);
@@ -34,6 +36,7 @@ class SampleUtilTest : public testing::Test {
         buffers.clear();
         evenBuffers.clear();
         sizes.clear();
+        SampleUtil::setSimdLevel(simdLevel);
     }
 
     void ClearBuffer(CSAMPLE* pBuffer, int length) {
@@ -50,11 +53,36 @@ class SampleUtilTest : public testing::Test {
         }
     }
 
+    // Fills the buffer with a deterministic pattern that covers both signs
+    // and values above CSAMPLE_PEAK.
+    void FillNoise(CSAMPLE* pBuffer, int length) {
+        for (int i = 0; i < length; ++i) {
+            pBuffer[i] = ((i * 7919) % 2003) / 1000.0f - 1.0f;
+        }
+    }
+
     QList<int> sizes;
     QList<CSAMPLE*> buffers;
     QList<int> evenBuffers;
+    SampleUtil::SimdLevel simdLevel;
 };
 
+// The instruction sets the CPU supports, SIMD_NONE first.
+QList<SampleUtil::SimdLevel> supportedSimdLevels() {
+    QList<SampleUtil::SimdLevel> levels;
+    levels.append(SampleUtil::SIMD_NONE);
+    const SampleUtil::SimdLevel current = SampleUtil::simdLevel();
+    for (int level = SampleUtil::SIMD_SSE2; level <= SampleUtil::SIMD_AVX2;
+            ++level) {
+        SampleUtil::setSimdLevel(static_cast<SampleUtil::SimdLevel>(level));
+        if (SampleUtil::simdLevel() == level) {
+            levels.append(SampleUtil::simdLevel());
+        }
+    }
+    SampleUtil::setSimdLevel(current);
+    return levels;
+}
+
 TEST_F(SampleUtilTest, allocIs16ByteAligned) {
     foreach (CSAMPLE* buffer, buffers) {
         ASSERT_EQ(0U, reinterpret_cast<quintptr>(buffer) % 16);
@@ -631,4 +659,168 @@ TEST_F(SampleUtilTest, copy3WithRampingGainSpeed) {
     SampleUtil::free(buffer3);
 }
 
+// Runs the kernel for all supported instruction sets and checks that the
+// results match the plain loops.
+#define EXPECT_SIMD_MATCHES_PLAIN(call) \
+    for (int i = 0; i < buffers.size(); ++i) { \
+        const int size = sizes[i]; \
+        QList<SampleUtil::SimdLevel> levels = supportedSimdLevels(); \
+        CSAMPLE* pSrc = SampleUtil::alloc(size); \
+        CSAMPLE* pExpected = SampleUtil::alloc(size); \
+        CSAMPLE* pDest = buffers[i]; \
+        FillNoise(pSrc, size); \
+        for (int l = 0; l < levels.size(); ++l) { \
+            SampleUtil::setSimdLevel(levels[l]); \
+            FillBuffer(pDest, 0.5f, size); \
+            call; \
+            if (l == 0) { \
+                SampleUtil::copy(pExpected, pDest, size); \
+                continue; \
+            } \
+            for (int j = 0; j < size; ++j) { \
+                EXPECT_FLOAT_EQ(pExpected[j], pDest[j]) \
+                        << "level " << levels[l] << " size " << size \
+                        << " index " << j; \
+            } \
+        } \
+        SampleUtil::free(pSrc); \
+        SampleUtil::free(pExpected); \
+    }
+
+TEST_F(SampleUtilTest, simdApplyRampingGain) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::copy(pDest, pSrc, size);
+            SampleUtil::applyRampingGain(pDest, 0.2f, 0.9f, size));
+}
+
+TEST_F(SampleUtilTest, simdCopyWithRampingGain) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::copyWithRampingGain(pDest, pSrc, 0.9f, 0.2f, size));
+}
+
+TEST_F(SampleUtilTest, simdAddWithRampingGain) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::addWithRampingGain(pDest, pSrc, 0.3f, 0.7f, size));
+}
+
+TEST_F(SampleUtilTest, simdCopyWithGain) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::copyWithGain(pDest, pSrc, 0.7f, size));
+}
+
+TEST_F(SampleUtilTest, simdAddWithGain) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::addWithGain(pDest, pSrc, 0.7f, size));
+}
+
+TEST_F(SampleUtilTest, simdMixStereoToMono) {
+    EXPECT_SIMD_MATCHES_PLAIN(
+            SampleUtil::mixStereoToMono(pDest, pSrc, size));
+}
+
+TEST_F(SampleUtilTest, simdConvertS16ToFloat32) {
+    for (int i = 0; i < buffers.size(); ++i) {
+        const int size = sizes[i];
+        CSAMPLE* buffer = buffers[i];
+        SAMPLE* s16 = new SAMPLE[size];
+        for (int j = 0; j < size; ++j) {
+            s16[j] = SAMPLE_MIN + (j * 64) % (SAMPLE_MAX - SAMPLE_MIN);
+        }
+        foreach (SampleUtil::SimdLevel level, supportedSimdLevels()) {
+            SampleUtil::setSimdLevel(level);
+            SampleUtil::convertS16ToFloat32(buffer, s16, size);
+            for (int j = 0; j < size; ++j) {
+                EXPECT_FLOAT_EQ(s16[j] / 32768.0f, buffer[j]);
+            }
+        }
+        delete [] s16;
+    }
+}
+
+TEST_F(SampleUtilTest, simdSumAbsPerChannel) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        const int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        const int size = sizes[j];
+        FillNoise(buffer, size);
+        buffer[size - 1] = 1.5f;
+        SampleUtil::setSimdLevel(SampleUtil::SIMD_NONE);
+        CSAMPLE fExpectedL = 0, fExpectedR = 0;
+        bool expectedClipped = SampleUtil::sumAbsPerChannel(
+                &fExpectedL, &fExpectedR, buffer, size);
+        EXPECT_TRUE(expectedClipped);
+        foreach (SampleUtil::SimdLevel level, supportedSimdLevels()) {
+            SampleUtil::setSimdLevel(level);
+            CSAMPLE fSumL = 0, fSumR = 0;
+            EXPECT_EQ(expectedClipped, SampleUtil::sumAbsPerChannel(
+                    &fSumL, &fSumR, buffer, size));
+            // The summing order differs, allow some rounding.
+            EXPECT_NEAR(fExpectedL, fSumL, fExpectedL * 1e-5);
+            EXPECT_NEAR(fExpectedR, fSumR, fExpectedR * 1e-5);
+        }
+        // No clipping below the peak.
+        SampleUtil::applyGain(buffer, 0.5f, size);
+        foreach (SampleUtil::SimdLevel level, supportedSimdLevels()) {
+            SampleUtil::setSimdLevel(level);
+            CSAMPLE fSumL = 0, fSumR = 0;
+            EXPECT_FALSE(SampleUtil::sumAbsPerChannel(
+                    &fSumL, &fSumR, buffer, size));
+        }
+    }
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+// Reports the cost of the hot kernels in ns per sample for all instruction
+// sets the CPU supports.
+TEST_F(SampleUtilTest, DISABLED_simdKernelSpeed) {
+    const int kSize = 1024;
+    const int kRounds = 10000;
+    CSAMPLE* pSrc = SampleUtil::alloc(kSize);
+    CSAMPLE* pDest = SampleUtil::alloc(kSize);
+    SAMPLE* s16 = new SAMPLE[kSize];
+    FillNoise(pSrc, kSize);
+    FillBuffer(pDest, 0.0f, kSize);
+    for (int i = 0; i < kSize; ++i) {
+        s16[i] = i;
+    }
+    CSAMPLE fSumL, fSumR;
+
+#define BENCHMARK_KERNEL(name, call) { \
+        call; \
+        PerformanceTimer timer; \
+        timer.start(); \
+        for (int r = 0; r < kRounds; ++r) { \
+            call; \
+        } \
+        const double nsPerSample = \
+                static_cast<double>(timer.elapsed()) / kRounds / kSize; \
+        qDebug() << name << "level" << level << nsPerSample << "ns/sample"; \
+    }
+
+    foreach (SampleUtil::SimdLevel level, supportedSimdLevels()) {
+        SampleUtil::setSimdLevel(level);
+        BENCHMARK_KERNEL("applyRampingGain",
+                SampleUtil::applyRampingGain(pDest, 1.0f, 0.99f, kSize));
+        BENCHMARK_KERNEL("copyWithRampingGain",
+                SampleUtil::copyWithRampingGain(pDest, pSrc, 0.5f, 0.6f, kSize));
+        BENCHMARK_KERNEL("addWithRampingGain",
+                SampleUtil::addWithRampingGain(pDest, pSrc, 0.5f, 0.6f, kSize));
+        BENCHMARK_KERNEL("copyWithGain",
+                SampleUtil::copyWithGain(pDest, pSrc, 0.5f, kSize));
+        BENCHMARK_KERNEL("addWithGain",
+                SampleUtil::addWithGain(pDest, pSrc, 0.5f, kSize));
+        BENCHMARK_KERNEL("convertS16ToFloat32",
+                SampleUtil::convertS16ToFloat32(pDest, s16, kSize));
+        BENCHMARK_KERNEL("sumAbsPerChannel",
+                SampleUtil::sumAbsPerChannel(&fSumL, &fSumR, pSrc, kSize));
+        BENCHMARK_KERNEL("mixStereoToMono",
+                SampleUtil::mixStereoToMono(pDest, pSrc, kSize));
+    }
+#undef BENCHMARK_KERNEL
+
+    delete [] s16;
+    SampleUtil::free(pSrc);
+    SampleUtil::free(pDest);
+}
+
 }
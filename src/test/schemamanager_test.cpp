@@ -97,3 +97,85 @@ TEST_F(SchemaManagerTest, FailedUpgrade) {
             ":/schema.xml", m_db, TrackCollection::kRequiredSchemaVersion);
     EXPECT_EQ(SchemaManager::RESULT_UPGRADE_FAILED, result);
 }
+
+TEST_F(SchemaManagerTest, StopsAtRevisionWithFailedProbe) {
+    const char* kSchema =
+            "<schema>\n"
+            "  <revision version=\"1\">\n"
+            "    <sql>CREATE TABLE settings (name TEXT UNIQUE NOT NULL,\n"
+            "      value TEXT, locked INTEGER DEFAULT 0,\n"
+            "      hidden INTEGER DEFAULT 0)</sql>\n"
+            "  </revision>\n"
+            "  <revision version=\"2\">\n"
+            "    <probe>%1</probe>\n"
+            "    <sql>CREATE TABLE probed (x INTEGER)</sql>\n"
+            "  </revision>\n"
+            "  <revision version=\"3\">\n"
+            "    <sql>CREATE TABLE applied (x INTEGER)</sql>\n"
+            "  </revision>\n"
+            "</schema>\n";
+    QTemporaryFile schemaFile;
+    ASSERT_TRUE(schemaFile.open());
+    schemaFile.write(QString(kSchema).arg(
+            "CREATE VIRTUAL TABLE temp.probe USING no_such_module(x)").toUtf8());
+    schemaFile.close();
+
+    SchemaManager::Result result = SchemaManager::upgradeToSchemaVersion(
+            schemaFile.fileName(), m_db, 3);
+    EXPECT_EQ(SchemaManager::RESULT_OK, result);
+    EXPECT_FALSE(m_db.tables().contains("probed"));
+    EXPECT_FALSE(m_db.tables().contains("applied"));
+    SettingsDAO settings(m_db);
+    EXPECT_EQ("1", settings.getValue(SchemaManager::SETTINGS_VERSION_STRING));
+
+    // The revision is applied once the probe succeeds.
+    QTemporaryFile supportedSchemaFile;
+    ASSERT_TRUE(supportedSchemaFile.open());
+    supportedSchemaFile.write(QString(kSchema).arg("SELECT 1").toUtf8());
+    supportedSchemaFile.close();
+
+    result = SchemaManager::upgradeToSchemaVersion(
+            supportedSchemaFile.fileName(), m_db, 3);
+    EXPECT_EQ(SchemaManager::RESULT_OK, result);
+    EXPECT_TRUE(m_db.tables().contains("probed"));
+    EXPECT_TRUE(m_db.tables().contains("applied"));
+    EXPECT_EQ("3", settings.getValue(SchemaManager::SETTINGS_VERSION_STRING));
+}
+
+TEST_F(SchemaManagerTest, FullTextIndexFollowsLibrary) {
+    SchemaManager::Result result = SchemaManager::upgradeToSchemaVersion(
+            ":/schema.xml", m_db, TrackCollection::kRequiredSchemaVersion);
+    ASSERT_EQ(SchemaManager::RESULT_OK, result);
+
+    QSqlQuery query(m_db);
+    ASSERT_TRUE(query.exec(
+            "INSERT INTO track_locations (id, location) "
+            "VALUES (7, '/music/Deep House/track.mp3')"));
+    ASSERT_TRUE(query.exec(
+            "INSERT INTO library (id, artist, title, location) "
+            "VALUES (3, 'Artist', 'Sunrise', 7)"));
+
+    const QString matchQuery(
+            "SELECT docid FROM library_fts WHERE library_fts MATCH '%1'");
+    ASSERT_TRUE(query.exec(matchQuery.arg("title:sun*")));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(3, query.value(0).toInt());
+    ASSERT_TRUE(query.exec(matchQuery.arg("location:deep*")));
+    EXPECT_TRUE(query.next());
+
+    ASSERT_TRUE(query.exec("UPDATE library SET title = 'Sunset' WHERE id = 3"));
+    ASSERT_TRUE(query.exec(matchQuery.arg("sunrise")));
+    EXPECT_FALSE(query.next());
+    ASSERT_TRUE(query.exec(matchQuery.arg("sunset")));
+    EXPECT_TRUE(query.next());
+
+    ASSERT_TRUE(query.exec(
+            "UPDATE track_locations SET location = '/music/Techno/track.mp3' "
+            "WHERE id = 7"));
+    ASSERT_TRUE(query.exec(matchQuery.arg("location:techno")));
+    EXPECT_TRUE(query.next());
+
+    ASSERT_TRUE(query.exec("DELETE FROM library WHERE id = 3"));
+    ASSERT_TRUE(query.exec(matchQuery.arg("sunset")));
+    EXPECT_FALSE(query.next());
+}
@@ -668,3 +668,59 @@ TEST_F(SearchQueryParserTest, HumanReadableDurationSearchwithRangeFilter) {
         qPrintable(QString("(duration >= 150) AND (duration <= 200)")),
         qPrintable(pQuery->toSql()));
 }
+
+TEST_F(SearchQueryParserTest, FullTextWords) {
+    m_parser.setFullTextTable("library_fts", "id");
+    QStringList searchColumns;
+    searchColumns << "artist"
+                  << "album";
+
+    auto pQuery(
+        m_parser.parseQuery("Deep* -hous*", searchColumns, ""));
+
+    TrackPointer pTrack(new TrackInfoObject());
+    pTrack->setArtist("Deeper Love");
+    EXPECT_TRUE(pQuery->match(pTrack));
+    pTrack->setAlbum("Best of House");
+    EXPECT_FALSE(pQuery->match(pTrack));
+    // Only words that start with the term match.
+    pTrack->setAlbum("Lighthouse");
+    EXPECT_TRUE(pQuery->match(pTrack));
+
+    EXPECT_STREQ(
+        qPrintable(QString(
+            "(id IN (SELECT docid FROM library_fts WHERE library_fts MATCH "
+            "'artist:deep* OR album:deep*')) "
+            "AND (NOT (id IN (SELECT docid FROM library_fts WHERE library_fts "
+            "MATCH 'artist:hous* OR album:hous*')))")),
+        qPrintable(pQuery->toSql()));
+}
+
+TEST_F(SearchQueryParserTest, FullTextFallsBackToLike) {
+    m_parser.setFullTextTable("library_fts", "id");
+    QStringList searchColumns;
+    searchColumns << "artist";
+
+    // Not a word prefix term, which keeps the substring match.
+    auto pQuery(
+        m_parser.parseQuery("mix", searchColumns, ""));
+    EXPECT_STREQ(
+        qPrintable(QString("artist LIKE '%mix%'")),
+        qPrintable(pQuery->toSql()));
+    TrackPointer pTrack(new TrackInfoObject());
+    pTrack->setArtist("Remix");
+    EXPECT_TRUE(pQuery->match(pTrack));
+
+    // Not a single word.
+    pQuery = m_parser.parseQuery("drum&bass*", searchColumns, "");
+    EXPECT_STREQ(
+        qPrintable(QString("artist LIKE '%drum&bass*%'")),
+        qPrintable(pQuery->toSql()));
+
+    // Not a column of the full-text table.
+    searchColumns << "year";
+    pQuery = m_parser.parseQuery("asdf*", searchColumns, "");
+    EXPECT_STREQ(
+        qPrintable(QString("(artist LIKE '%asdf%') OR (year LIKE '%asdf%')")),
+        qPrintable(pQuery->toSql()));
+}
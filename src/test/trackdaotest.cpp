@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QThread>
+
+#include "library/dao/trackdao.h"
+#include "test/librarytest.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+class TrackDAOTest : public LibraryTest {
+  protected:
+    virtual void TearDown() {
+        // make sure we clean up the db
+        QSqlQuery query(collection()->getDatabase());
+        query.exec("DELETE FROM library");
+        query.exec("DELETE FROM track_locations");
+        qDeleteAll(m_tracks);
+        m_tracks.clear();
+    }
+
+    TrackDAO& trackDao() {
+        return collection()->getTrackDAO();
+    }
+
+    // The files don't need to exist, the headers of the tracks are not
+    // parsed.
+    TrackInfoObject* newTrack(int index) {
+        TrackInfoObject* pTrack = new TrackInfoObject(
+                QDir::tempPath() + QString("/TrackDAOTest/%1.mp3").arg(index),
+                SecurityTokenPointer(), false);
+        pTrack->setArtist(QString("Artist %1").arg(index % 100));
+        pTrack->setTitle(QString("Title %1").arg(index));
+        pTrack->setBpm(100.0 + index % 50);
+        m_tracks.append(pTrack);
+        return pTrack;
+    }
+
+    QList<TrackInfoObject*> newTracks(int first, int count) {
+        QList<TrackInfoObject*> tracks;
+        for (int i = first; i < first + count; ++i) {
+            tracks.append(newTrack(i));
+        }
+        return tracks;
+    }
+
+    int countRows(const QString& table) {
+        QSqlQuery query(collection()->getDatabase());
+        if (!query.exec("SELECT COUNT(*) FROM " + table) || !query.next()) {
+            return -1;
+        }
+        return query.value(0).toInt();
+    }
+
+    QList<TrackInfoObject*> m_tracks;
+};
+
+TEST_F(TrackDAOTest, AddTracksAddBatch) {
+    // More tracks than fit into one multi-row statement.
+    QList<TrackInfoObject*> tracks = newTracks(0, 100);
+    QSignalSpy spy(&trackDao(), SIGNAL(tracksAdded(QSet<int>)));
+
+    trackDao().addTracksPrepare();
+    QSet<int> trackIds = trackDao().addTracksAddBatch(tracks, false);
+    trackDao().addTracksFinish(false);
+
+    EXPECT_EQ(100, trackIds.size());
+    EXPECT_EQ(100, countRows("library"));
+    EXPECT_EQ(100, countRows("track_locations"));
+    foreach (TrackInfoObject* pTrack, tracks) {
+        EXPECT_TRUE(trackIds.contains(pTrack->getId()));
+        EXPECT_EQ(pTrack->getId(), trackDao().getTrackId(pTrack->getLocation()));
+        EXPECT_FALSE(pTrack->isDirty());
+    }
+    // One signal for all tracks.
+    EXPECT_EQ(1, spy.count());
+
+    TrackPointer pTrack = trackDao().getTrack(tracks[42]->getId());
+    ASSERT_FALSE(pTrack.isNull());
+    EXPECT_EQ(tracks[42]->getArtist(), pTrack->getArtist());
+    EXPECT_EQ(tracks[42]->getTitle(), pTrack->getTitle());
+    EXPECT_DOUBLE_EQ(tracks[42]->getBpm(), pTrack->getBpm());
+}
+
+TEST_F(TrackDAOTest, AddTracksAddBatchSkipsExistingTracks) {
+    TrackInfoObject* pExisting = newTrack(0);
+    trackDao().addTracksPrepare();
+    ASSERT_TRUE(trackDao().addTracksAdd(pExisting, false));
+    trackDao().addTracksFinish(false);
+    const int existingId = pExisting->getId();
+
+    QList<TrackInfoObject*> tracks;
+    tracks << newTrack(0) << newTrack(1) << newTrack(1) << newTrack(2);
+    trackDao().addTracksPrepare();
+    QSet<int> trackIds = trackDao().addTracksAddBatch(tracks, false);
+    trackDao().addTracksFinish(false);
+
+    EXPECT_EQ(2, trackIds.size());
+    EXPECT_EQ(3, countRows("library"));
+    EXPECT_EQ(existingId, tracks[0]->getId());
+    EXPECT_FALSE(trackIds.contains(existingId));
+    EXPECT_TRUE(trackIds.contains(tracks[1]->getId()));
+    EXPECT_EQ(tracks[1]->getId(), tracks[2]->getId());
+    EXPECT_TRUE(trackIds.contains(tracks[3]->getId()));
+}
+
+TEST_F(TrackDAOTest, AddTracksAddBatchUnremoves) {
+    QList<TrackInfoObject*> tracks = newTracks(0, 2);
+    trackDao().addTracksPrepare();
+    trackDao().addTracksAddBatch(tracks, false);
+    trackDao().addTracksFinish(false);
+    trackDao().hideTracks(QList<int>() << tracks[0]->getId()
+                                       << tracks[1]->getId());
+
+    QList<TrackInfoObject*> unremoved;
+    unremoved << newTrack(0);
+    trackDao().addTracksPrepare();
+    trackDao().addTracksAddBatch(unremoved, true);
+    trackDao().addTracksFinish(false);
+
+    QSqlQuery query(collection()->getDatabase());
+    ASSERT_TRUE(query.exec("SELECT id FROM library WHERE mixxx_deleted=0"));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(tracks[0]->getId(), query.value(0).toInt());
+    EXPECT_FALSE(query.next());
+}
+
+TEST_F(TrackDAOTest, RequestTrack) {
+    QList<TrackInfoObject*> tracks = newTracks(0, 2);
+    trackDao().addTracksPrepare();
+    trackDao().addTracksAddBatch(tracks, false);
+    trackDao().addTracksFinish(false);
+
+    qRegisterMetaType<TrackPointer>("TrackPointer");
+    QSignalSpy spy(&trackDao(), SIGNAL(trackLoaded(int, TrackPointer)));
+    const int trackId = tracks[1]->getId();
+    EXPECT_TRUE(trackDao().requestTrack(trackId).isNull());
+    // A second request while the track is loading does not load it again.
+    EXPECT_TRUE(trackDao().requestTrack(trackId).isNull());
+
+    QElapsedTimer timer;
+    timer.start();
+    while (spy.count() == 0 && timer.elapsed() < 5000) {
+        QCoreApplication::processEvents();
+    }
+    ASSERT_EQ(1, spy.count());
+    EXPECT_EQ(trackId, spy.at(0).at(0).toInt());
+
+    // The loaded track is cached and is the one getTrack() returns.
+    TrackPointer pTrack = trackDao().requestTrack(trackId);
+    ASSERT_FALSE(pTrack.isNull());
+    EXPECT_EQ(pTrack, trackDao().getTrack(trackId));
+    EXPECT_EQ(QThread::currentThread(), pTrack->thread());
+    EXPECT_EQ(tracks[1]->getTitle(), pTrack->getTitle());
+    EXPECT_EQ(tracks[1]->getArtist(), pTrack->getArtist());
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(TrackDAOTest, DISABLED_ImportBenchmark) {
+    const int kTracks = 10000;
+    QList<TrackInfoObject*> tracks = newTracks(0, kTracks);
+
+    PerformanceTimer timer;
+    timer.start();
+    trackDao().addTracksPrepare();
+    foreach (TrackInfoObject* pTrack, tracks) {
+        trackDao().addTracksAdd(pTrack, false);
+    }
+    trackDao().addTracksFinish(false);
+    qint64 elapsed = timer.elapsed();
+    qDebug() << kTracks << "tracks: importing track by track took"
+             << elapsed / 1000000.0 << "ms,"
+             << kTracks / (elapsed / 1000000000.0) << "tracks/s";
+
+    tracks = newTracks(kTracks, kTracks);
+    timer.start();
+    trackDao().addTracksPrepare();
+    trackDao().addTracksAddBatch(tracks, false);
+    trackDao().addTracksFinish(false);
+    elapsed = timer.elapsed();
+    qDebug() << kTracks << "tracks: importing in batches took"
+             << elapsed / 1000000.0 << "ms,"
+             << kTracks / (elapsed / 1000000000.0) << "tracks/s";
+
+    timer.start();
+    QSqlQuery query(collection()->getDatabase());
+    query.exec("SELECT * FROM library INNER JOIN track_locations "
+               "ON library.location = track_locations.id");
+    int rows = 0;
+    while (query.next()) {
+        ++rows;
+    }
+    elapsed = timer.elapsed();
+    qDebug() << rows << "tracks: loading the library table took"
+             << elapsed / 1000000.0 << "ms,"
+             << rows / (elapsed / 1000000000.0) << "tracks/s";
+
+    timer.start();
+    foreach (TrackInfoObject* pTrack, tracks) {
+        trackDao().getTrack(pTrack->getId());
+    }
+    elapsed = timer.elapsed();
+    qDebug() << kTracks << "tracks: loading TrackInfoObjects took"
+             << elapsed / 1000000.0 << "ms,"
+             << kTracks / (elapsed / 1000000000.0) << "tracks/s";
+}
+
+}  // namespace
@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+#include <QtDebug>
+#include <QSqlQuery>
+#include <QTemporaryFile>
+
+#include "library/searchqueryparser.h"
+#include "library/tracksearchindex.h"
+#include "util/assert.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+enum Field {
+    FIELD_ARTIST = 0,
+    FIELD_ALBUM_ARTIST,
+    FIELD_TITLE,
+    FIELD_ALBUM,
+    FIELD_GENRE,
+    FIELD_COMMENT,
+    FIELD_KEY,
+    FIELD_BPM,
+    FIELD_DURATION,
+    FIELD_KEY_ID,
+    FIELD_YEAR,
+    NUM_FIELDS
+};
+
+class TrackSearchIndexTest : public testing::Test {
+  protected:
+    TrackSearchIndexTest()
+            : m_database(QSqlDatabase::addDatabase("QSQLITE")),
+              m_parser(m_database) {
+        QTemporaryFile databaseFile("mixxxdb.sqlite");
+        RELEASE_ASSERT(databaseFile.open());
+        m_database.setDatabaseName(databaseFile.fileName());
+        RELEASE_ASSERT(m_database.open());
+
+        m_searchColumns << "artist" << "title" << "album" << "genre"
+                        << "comment";
+        m_index.addTextColumn("artist", FIELD_ARTIST);
+        m_index.addTextColumn("album_artist", FIELD_ALBUM_ARTIST);
+        m_index.addTextColumn("title", FIELD_TITLE);
+        m_index.addTextColumn("album", FIELD_ALBUM);
+        m_index.addTextColumn("genre", FIELD_GENRE);
+        m_index.addTextColumn("comment", FIELD_COMMENT);
+        m_index.addTextColumn("key", FIELD_KEY);
+        m_index.addNumericColumn("bpm", FIELD_BPM);
+        m_index.addNumericColumn("duration", FIELD_DURATION);
+        m_index.addNumericColumn("key_id", FIELD_KEY_ID);
+    }
+
+    QVector<QVariant> makeRecord(const QVariant& artist,
+                                 const QVariant& title,
+                                 const QVariant& bpm = QVariant(),
+                                 const QVariant& duration = QVariant(),
+                                 const QVariant& keyId = QVariant()) {
+        QVector<QVariant> record(NUM_FIELDS);
+        record[FIELD_ARTIST] = artist;
+        record[FIELD_TITLE] = title;
+        record[FIELD_BPM] = bpm;
+        record[FIELD_DURATION] = duration;
+        record[FIELD_KEY_ID] = keyId;
+        return record;
+    }
+
+    // Returns the ids of the tracks that match, or an empty list containing
+    // -1 if the query can not be evaluated in memory.
+    QList<int> search(const QString& query) {
+        auto pQuery = m_parser.parseQuery(query, m_searchColumns, QString());
+        QVector<qint8> matches;
+        if (!m_index.evaluate(*pQuery, &matches)) {
+            return QList<int>() << -1;
+        }
+        QList<int> trackIds;
+        for (int row = 0; row < matches.size(); ++row) {
+            if (matches[row] == TrackSearchIndex::MATCH_TRUE) {
+                trackIds.append(m_index.trackId(row));
+            }
+        }
+        qSort(trackIds);
+        return trackIds;
+    }
+
+    QSqlDatabase m_database;
+    SearchQueryParser m_parser;
+    QStringList m_searchColumns;
+    TrackSearchIndex m_index;
+};
+
+TEST_F(TrackSearchIndexTest, TextIsFolded) {
+    m_index.updateTrack(1, makeRecord(QString::fromUtf8("Björk"), "Army of Me"));
+    m_index.updateTrack(2, makeRecord("Bjorn", "Bjork"));
+    m_index.updateTrack(3, makeRecord("Aphex Twin", "Xtal"));
+
+    EXPECT_EQ(QList<int>() << 1 << 2, search("BJORK"));
+    EXPECT_EQ(QList<int>() << 1, search(QString::fromUtf8("artist:björk")));
+    EXPECT_EQ(QList<int>() << 1 << 2 << 3, search(""));
+    EXPECT_EQ(QList<int>(), search("autechre"));
+}
+
+TEST_F(TrackSearchIndexTest, NullDoesNotMatchNegation) {
+    m_index.updateTrack(1, makeRecord("Artist", QString("")));
+    m_index.updateTrack(2, makeRecord("Artist", QVariant()));
+    m_index.updateTrack(3, makeRecord("Artist", "Title"));
+
+    // NOT (NULL LIKE '%x%') is NULL in SQL.
+    EXPECT_EQ(QList<int>() << 1, search("-title:title"));
+    EXPECT_EQ(QList<int>() << 3, search("title:title"));
+    // One non-NULL column that matches is enough.
+    EXPECT_EQ(QList<int>() << 1 << 2 << 3, search("artist"));
+}
+
+TEST_F(TrackSearchIndexTest, Numeric) {
+    m_index.updateTrack(1, makeRecord("a", "a", 120.0, 180));
+    m_index.updateTrack(2, makeRecord("a", "a", 128.0, 300));
+    m_index.updateTrack(3, makeRecord("a", "a", QVariant(), 240));
+
+    EXPECT_EQ(QList<int>() << 2, search("bpm:>120"));
+    EXPECT_EQ(QList<int>() << 1 << 2, search("bpm:>=120"));
+    EXPECT_EQ(QList<int>() << 1, search("bpm:120"));
+    EXPECT_EQ(QList<int>() << 1 << 2, search("bpm:100-130"));
+    EXPECT_EQ(QList<int>() << 2, search("-bpm:<=120"));
+    EXPECT_EQ(QList<int>() << 2 << 3, search("duration:>3:00"));
+    EXPECT_EQ(QList<int>() << 3, search("duration:4m"));
+}
+
+TEST_F(TrackSearchIndexTest, Key) {
+    m_index.updateTrack(1, makeRecord("a", "a", QVariant(), QVariant(),
+                                      mixxx::track::io::key::C_MAJOR));
+    m_index.updateTrack(2, makeRecord("a", "a", QVariant(), QVariant(),
+                                      mixxx::track::io::key::A_MINOR));
+    m_index.updateTrack(3, makeRecord("a", "a"));
+
+    EXPECT_EQ(QList<int>() << 1, search("key:C"));
+    EXPECT_EQ(QList<int>() << 1 << 2, search("~key:C"));
+    // key_id IS n is never NULL.
+    EXPECT_EQ(QList<int>() << 2 << 3, search("-key:C"));
+}
+
+TEST_F(TrackSearchIndexTest, LeavesUnsupportedQueriesToSql) {
+    m_index.updateTrack(1, makeRecord("a", "a"));
+    EXPECT_EQ(QList<int>() << -1, search("a%b"));
+    EXPECT_EQ(QList<int>() << -1, search("year:2000"));
+
+    auto pQuery = m_parser.parseQuery("a", m_searchColumns, "id IN (1)");
+    QVector<qint8> matches;
+    EXPECT_FALSE(m_index.evaluate(*pQuery, &matches));
+}
+
+TEST_F(TrackSearchIndexTest, UpdateAndRemove) {
+    m_index.updateTrack(1, makeRecord("one", "a"));
+    m_index.updateTrack(2, makeRecord("two", "a"));
+    m_index.updateTrack(3, makeRecord("three", "a"));
+
+    m_index.removeTrack(1);
+    EXPECT_EQ(2, m_index.rowCount());
+    EXPECT_EQ(-1, m_index.row(1));
+    EXPECT_EQ(QList<int>() << 3, search("three"));
+
+    m_index.updateTrack(2, makeRecord("three", "a"));
+    EXPECT_EQ(QList<int>() << 2 << 3, search("three"));
+
+    m_index.clear();
+    EXPECT_EQ(0, m_index.rowCount());
+    EXPECT_EQ(QList<int>(), search("three"));
+}
+
+TEST_F(TrackSearchIndexTest, FullTextWords) {
+    m_parser.setFullTextTable("library_fts", "id");
+    m_index.updateTrack(1, makeRecord("Deep House", QVariant()));
+    m_index.updateTrack(2, makeRecord("Lighthouse", "Deeper"));
+    m_index.updateTrack(3, makeRecord(QVariant(), QVariant()));
+
+    EXPECT_EQ(QList<int>() << 1, search("hous*"));
+    EXPECT_EQ(QList<int>() << 1 << 2, search("deep*"));
+    // The document id is never NULL, so negation matches empty tracks.
+    EXPECT_EQ(QList<int>() << 2 << 3, search("-hous*"));
+    // Without the star it is a substring search.
+    EXPECT_EQ(QList<int>() << 1 << 2, search("hous"));
+}
+
+TEST_F(TrackSearchIndexTest, EvaluatesLikeSqlite) {
+    QSqlQuery query(m_database);
+    ASSERT_TRUE(query.exec(
+            "CREATE TABLE tracks (id INTEGER PRIMARY KEY, artist TEXT, "
+            "title TEXT, album TEXT, genre TEXT, comment TEXT, bpm REAL, "
+            "duration INTEGER)"));
+    ASSERT_TRUE(query.prepare(
+            "INSERT INTO tracks VALUES (:id, :artist, :title, :album, :genre, "
+            ":comment, :bpm, :duration)"));
+
+    // Plain ASCII, so SQLite's LIKE folds like makeLatinLow.
+    const char* kWords[] = { "Deep", "house", "TECHNO", "dub", "" };
+    const int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+    for (int id = 1; id <= 200; ++id) {
+        QVector<QVariant> record(NUM_FIELDS);
+        // Every 7th value is NULL.
+        for (int field = FIELD_ARTIST; field <= FIELD_COMMENT; ++field) {
+            if ((id + field) % 7 != 0) {
+                record[field] = QString("%1 %2").arg(
+                        kWords[(id * (field + 1)) % kWordCount],
+                        kWords[(id + field) % kWordCount]);
+            }
+        }
+        if (id % 5 != 0) {
+            record[FIELD_BPM] = 100.0 + id % 40;
+        }
+        if (id % 9 != 0) {
+            record[FIELD_DURATION] = 120 + id;
+        }
+        m_index.updateTrack(id, record);
+
+        query.bindValue(":id", id);
+        query.bindValue(":artist", record[FIELD_ARTIST]);
+        query.bindValue(":title", record[FIELD_TITLE]);
+        query.bindValue(":album", record[FIELD_ALBUM]);
+        query.bindValue(":genre", record[FIELD_GENRE]);
+        query.bindValue(":comment", record[FIELD_COMMENT]);
+        query.bindValue(":bpm", record[FIELD_BPM]);
+        query.bindValue(":duration", record[FIELD_DURATION]);
+        ASSERT_TRUE(query.exec());
+    }
+
+    QStringList searches;
+    searches << "house" << "-house" << "deep -techno" << "title:dub"
+             << "-genre:\"p h\"" << "bpm:>120" << "-bpm:110-120"
+             << "house bpm:<=115 -duration:>2:30";
+    foreach (const QString& search, searches) {
+        auto pQuery = m_parser.parseQuery(search, m_searchColumns, QString());
+        QVector<qint8> matches;
+        ASSERT_TRUE(m_index.evaluate(*pQuery, &matches));
+        QSet<int> indexTrackIds;
+        for (int row = 0; row < matches.size(); ++row) {
+            if (matches[row] == TrackSearchIndex::MATCH_TRUE) {
+                indexTrackIds.insert(m_index.trackId(row));
+            }
+        }
+
+        QString filter = pQuery->toSql();
+        ASSERT_TRUE(query.exec(QString("SELECT id FROM tracks %1").arg(
+                filter.isEmpty() ? QString() : "WHERE " + filter)));
+        QSet<int> sqlTrackIds;
+        while (query.next()) {
+            sqlTrackIds.insert(query.value(0).toInt());
+        }
+        EXPECT_EQ(sqlTrackIds, indexTrackIds) << qPrintable(search);
+    }
+}
+
+TEST_F(TrackSearchIndexTest, LargeIndexUsesAllRows) {
+    // Large enough to be evaluated on several threads.
+    const int kTracks = 20 * TrackSearchIndex::kBlockSize + 17;
+    for (int id = 1; id <= kTracks; ++id) {
+        m_index.updateTrack(id, makeRecord(
+                id % 3 == 0 ? "match" : "other", "a", id % 200));
+    }
+    QList<int> trackIds = search("match bpm:<100");
+    int expected = 0;
+    for (int id = 1; id <= kTracks; ++id) {
+        if (id % 3 == 0 && id % 200 < 100) {
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, trackIds.size());
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(TrackSearchIndexTest, DISABLED_SearchBenchmark) {
+    const char* kWords[] = { "deep", "house", "techno", "dub", "ambient",
+                             "remix", "original", "mix", "live", "edit",
+                             "feat", "vocal", "dark", "acid", "minimal" };
+    const int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+    QStringList searches;
+    searches << "a" << "house" << "deep techno" << "-remix"
+             << "artist:acid bpm:120-130" << "bpm:>125" << "~key:Am";
+
+    const int kSizes[] = { 10000, 100000, 500000 };
+    for (unsigned int size = 0; size < sizeof(kSizes) / sizeof(kSizes[0]); ++size) {
+        m_index.clear();
+        for (int id = 1; id <= kSizes[size]; ++id) {
+            QVector<QVariant> record(NUM_FIELDS);
+            for (int field = FIELD_ARTIST; field <= FIELD_COMMENT; ++field) {
+                record[field] = QString("%1 %2 %3").arg(
+                        kWords[(id * (field + 3)) % kWordCount],
+                        kWords[(id / (field + 2)) % kWordCount],
+                        QString::number(id));
+            }
+            record[FIELD_BPM] = 90.0 + id % 60;
+            record[FIELD_DURATION] = 120 + id % 400;
+            record[FIELD_KEY_ID] = 1 + id % 24;
+            m_index.updateTrack(id, record);
+        }
+
+        foreach (const QString& search, searches) {
+            auto pQuery = m_parser.parseQuery(search, m_searchColumns,
+                                              QString());
+            QVector<qint8> matches;
+            const int kRepetitions = 10;
+            PerformanceTimer timer;
+            timer.start();
+            for (int i = 0; i < kRepetitions; ++i) {
+                m_index.evaluate(*pQuery, &matches);
+            }
+            qDebug() << kSizes[size] << "tracks" << search << ":"
+                     << timer.elapsed() / kRepetitions / 1000000.0
+                     << "ms per query";
+        }
+    }
+}
+
+}  // namespace
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <QtDebug>
+#include <QSqlQuery>
+#include <QTemporaryFile>
+
+#include "library/columncache.h"
+#include "library/tracksortindex.h"
+#include "util/assert.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+enum Field {
+    FIELD_ID = 0,
+    FIELD_ARTIST,
+    FIELD_TITLE,
+    FIELD_TRACKNUMBER,
+    FIELD_BPM,
+    NUM_FIELDS
+};
+
+typedef TrackSortIndex::SortColumn SortColumn;
+
+class TrackSortIndexTest : public testing::Test {
+  protected:
+    TrackSortIndexTest()
+            : m_columnCache(QStringList() << "id" << "artist" << "title"
+                                          << "tracknumber" << "bpm"),
+              m_index(m_columnCache, m_trackInfo) {
+    }
+
+    void setTrack(int trackId, const QVariant& artist,
+                  const QVariant& trackNumber = QVariant(),
+                  const QVariant& bpm = QVariant()) {
+        QVector<QVariant> record(NUM_FIELDS);
+        record[FIELD_ID] = trackId;
+        record[FIELD_ARTIST] = artist;
+        record[FIELD_TITLE] = QString("Title %1").arg(trackId);
+        record[FIELD_TRACKNUMBER] = trackNumber;
+        record[FIELD_BPM] = bpm;
+        m_trackInfo[trackId] = record;
+        m_index.updateTrack(trackId);
+    }
+
+    void removeTrack(int trackId) {
+        m_trackInfo.remove(trackId);
+        m_index.removeTrack(trackId);
+    }
+
+    QVector<int> sorted(int column, Qt::SortOrder order = Qt::AscendingOrder) {
+        return m_index.sortedTrackIds(
+                QList<SortColumn>() << SortColumn(column, order));
+    }
+
+    ColumnCache m_columnCache;
+    QHash<int, QVector<QVariant> > m_trackInfo;
+    TrackSortIndex m_index;
+};
+
+QVector<int> ids(const QList<int>& trackIds) {
+    return trackIds.toVector();
+}
+
+TEST_F(TrackSortIndexTest, CompareValues) {
+    // NULL sorts first, numbers before text.
+    EXPECT_GT(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_VALUE, QVariant(), 1));
+    EXPECT_GT(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_VALUE, 100, QString("1")));
+    EXPECT_GT(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_VALUE, 2, 10.5));
+    EXPECT_EQ(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_VALUE, 2, 2.0));
+
+    // lower() only folds ASCII.
+    EXPECT_EQ(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_NO_CASE, QString("ABC"), QString("abc")));
+    EXPECT_GT(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_NO_CASE, QVariant(), QString("")));
+
+    // cast(x as integer) uses the leading integer and 0 otherwise.
+    EXPECT_EQ(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_INTEGER, QString("12/14"), 12));
+    EXPECT_EQ(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_INTEGER, QString("A1"), 0));
+    EXPECT_EQ(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_INTEGER, 3.9, 3));
+    EXPECT_GT(0, TrackSortIndex::compareValues(
+            ColumnCache::SORT_INTEGER, QString("9"), QString("10")));
+}
+
+TEST_F(TrackSortIndexTest, SortsColumns) {
+    setTrack(1, "b", "10", 128.0);
+    setTrack(2, "A", "9", 120.0);
+    setTrack(3, QVariant(), "1", QVariant());
+    setTrack(4, "c", QVariant(), 125.0);
+
+    EXPECT_EQ(ids(QList<int>() << 3 << 2 << 1 << 4), sorted(FIELD_ARTIST));
+    EXPECT_EQ(ids(QList<int>() << 4 << 1 << 2 << 3),
+              sorted(FIELD_ARTIST, Qt::DescendingOrder));
+    EXPECT_EQ(ids(QList<int>() << 4 << 3 << 2 << 1),
+              sorted(FIELD_TRACKNUMBER));
+    EXPECT_EQ(ids(QList<int>() << 3 << 2 << 4 << 1), sorted(FIELD_BPM));
+}
+
+TEST_F(TrackSortIndexTest, UpdatesIncrementally) {
+    setTrack(1, "b");
+    setTrack(2, "d");
+    setTrack(3, "f");
+    EXPECT_EQ(ids(QList<int>() << 1 << 2 << 3), sorted(FIELD_ARTIST));
+
+    setTrack(4, "a");
+    setTrack(2, "g");
+    EXPECT_EQ(ids(QList<int>() << 4 << 1 << 3 << 2), sorted(FIELD_ARTIST));
+
+    removeTrack(1);
+    EXPECT_EQ(ids(QList<int>() << 4 << 3 << 2), sorted(FIELD_ARTIST));
+
+    m_index.clear();
+    EXPECT_EQ(ids(QList<int>() << 4 << 3 << 2), sorted(FIELD_ARTIST));
+}
+
+TEST_F(TrackSortIndexTest, UpdatesTracksWithEqualValues) {
+    for (int trackId = 1; trackId <= 6; ++trackId) {
+        setTrack(trackId, "a");
+    }
+    EXPECT_EQ(ids(QList<int>() << 1 << 2 << 3 << 4 << 5 << 6),
+              sorted(FIELD_ARTIST));
+
+    // Finds each track among its equals.
+    setTrack(4, "b");
+    setTrack(2, "b");
+    removeTrack(5);
+    EXPECT_EQ(ids(QList<int>() << 1 << 3 << 6 << 2 << 4),
+              sorted(FIELD_ARTIST));
+}
+
+TEST_F(TrackSortIndexTest, SortsTiesByNextColumn) {
+    setTrack(1, "a", "2");
+    setTrack(2, "b", "1");
+    setTrack(3, "a", "1");
+    setTrack(4, "b", "2");
+    setTrack(5, "a", "2");
+
+    QList<SortColumn> sortColumns;
+    sortColumns << SortColumn(FIELD_ARTIST, Qt::AscendingOrder)
+                << SortColumn(FIELD_TRACKNUMBER, Qt::DescendingOrder);
+    // Tracks that are equal in all columns are sorted by id.
+    EXPECT_EQ(ids(QList<int>() << 1 << 5 << 3 << 4 << 2),
+              m_index.sortedTrackIds(sortColumns));
+
+    sortColumns.clear();
+    sortColumns << SortColumn(FIELD_ARTIST, Qt::DescendingOrder)
+                << SortColumn(FIELD_TRACKNUMBER, Qt::AscendingOrder);
+    EXPECT_EQ(ids(QList<int>() << 2 << 4 << 3 << 1 << 5),
+              m_index.sortedTrackIds(sortColumns));
+
+    // A single column in descending order also keeps ties sorted by id.
+    EXPECT_EQ(ids(QList<int>() << 2 << 4 << 1 << 3 << 5),
+              sorted(FIELD_ARTIST, Qt::DescendingOrder));
+}
+
+TEST_F(TrackSortIndexTest, SortsLikeSqlite) {
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE");
+    QTemporaryFile databaseFile("mixxxdb.sqlite");
+    ASSERT_TRUE(databaseFile.open());
+    database.setDatabaseName(databaseFile.fileName());
+    ASSERT_TRUE(database.open());
+
+    QSqlQuery query(database);
+    ASSERT_TRUE(query.exec("CREATE TABLE library (id INTEGER PRIMARY KEY, "
+                           "artist TEXT, tracknumber TEXT, bpm FLOAT)"));
+    const char* kArtists[] = { "abc", "ABD", "b", "", "zz", "Abc" };
+    const char* kTrackNumbers[] = { "1", "10", "2/12", "x", "02", "" };
+    for (int id = 1; id <= 60; ++id) {
+        QVariant artist = id % 7 == 0 ?
+                QVariant(QVariant::String) : QVariant(kArtists[id % 6]);
+        QVariant trackNumber = id % 5 == 0 ?
+                QVariant(QVariant::String) : QVariant(kTrackNumbers[id % 6]);
+        QVariant bpm = id % 4 == 0 ?
+                QVariant(QVariant::Double) : QVariant(100.0 + id % 9);
+        query.prepare("INSERT INTO library (id, artist, tracknumber, bpm) "
+                      "VALUES (:id, :artist, :tracknumber, :bpm)");
+        query.bindValue(":id", id);
+        query.bindValue(":artist", artist);
+        query.bindValue(":tracknumber", trackNumber);
+        query.bindValue(":bpm", bpm);
+        ASSERT_TRUE(query.exec());
+        setTrack(id, artist, trackNumber, bpm);
+    }
+
+    QList<QPair<QString, QList<SortColumn> > > orders;
+    orders << qMakePair(QString("lower(artist) ASC"), QList<SortColumn>()
+                        << SortColumn(FIELD_ARTIST, Qt::AscendingOrder));
+    orders << qMakePair(QString("cast(tracknumber as integer) DESC, "
+                                "lower(artist) ASC"), QList<SortColumn>()
+                        << SortColumn(FIELD_TRACKNUMBER, Qt::DescendingOrder)
+                        << SortColumn(FIELD_ARTIST, Qt::AscendingOrder));
+    orders << qMakePair(QString("bpm ASC, cast(tracknumber as integer) ASC, "
+                                "lower(artist) DESC"), QList<SortColumn>()
+                        << SortColumn(FIELD_BPM, Qt::AscendingOrder)
+                        << SortColumn(FIELD_TRACKNUMBER, Qt::AscendingOrder)
+                        << SortColumn(FIELD_ARTIST, Qt::DescendingOrder));
+    for (int i = 0; i < orders.size(); ++i) {
+        // Ties are broken by id, which is what SQLite does when scanning
+        // the table in id order.
+        ASSERT_TRUE(query.exec(QString("SELECT id FROM library ORDER BY %1, "
+                                       "id ASC").arg(orders[i].first)));
+        QVector<int> expected;
+        while (query.next()) {
+            expected.append(query.value(0).toInt());
+        }
+        EXPECT_EQ(expected, m_index.sortedTrackIds(orders[i].second))
+                << orders[i].first.toStdString();
+    }
+}
+
+// Benchmark only, it cannot fail. Run with --gtest_also_run_disabled_tests.
+TEST_F(TrackSortIndexTest, DISABLED_SortBenchmark) {
+    const int kTracks = 100000;
+    for (int id = 1; id <= kTracks; ++id) {
+        setTrack(id, QString("Artist %1").arg((id * 7919) % 5000),
+                 QString::number(id % 20), 80.0 + (id * 31) % 100);
+    }
+
+    PerformanceTimer timer;
+    timer.start();
+    sorted(FIELD_ARTIST);
+    sorted(FIELD_TRACKNUMBER);
+    sorted(FIELD_BPM);
+    qDebug() << kTracks << "tracks: sorting three columns took"
+             << timer.elapsed() / 1000000.0 << "ms";
+
+    QList<SortColumn> sortColumns;
+    sortColumns << SortColumn(FIELD_BPM, Qt::DescendingOrder)
+                << SortColumn(FIELD_ARTIST, Qt::AscendingOrder)
+                << SortColumn(FIELD_TRACKNUMBER, Qt::AscendingOrder);
+    timer.start();
+    m_index.sortedTrackIds(sortColumns);
+    qDebug() << kTracks << "tracks: sorting by three columns took"
+             << timer.elapsed() / 1000000.0 << "ms";
+
+    const int kUpdates = 100;
+    timer.start();
+    for (int i = 0; i < kUpdates; ++i) {
+        const int id = 1 + (i * 997) % kTracks;
+        setTrack(id, QString("Artist %1").arg(i), QString::number(i), 100.0);
+        m_index.sortedTrackIds(sortColumns);
+    }
+    qDebug() << kTracks << "tracks: updating a track and sorting again took"
+             << timer.elapsed() / kUpdates / 1000000.0 << "ms";
+}
+
+}  // namespace
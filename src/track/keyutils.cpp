@@ -5,6 +5,7 @@
 #include <QRegExp>
 
 #include "track/keyutils.h"
+#include "util/compatibility.h"
 #include "util/math.h"
 
 using mixxx::track::io::key::ChromaticKey;
@@ -66,6 +67,7 @@ const ChromaticKey s_letterToMajorKey[] = {
 QMutex KeyUtils::s_notationMutex;
 QMap<ChromaticKey, QString> KeyUtils::s_notation;
 QMap<QString, ChromaticKey> KeyUtils::s_reverseNotation;
+QAtomicInt KeyUtils::s_notationRevision;
 
 // Lancelot notation is OpenKey notation rotated counter-clockwise by 5.
 inline int openKeyNumberToLancelotNumber(const int okNumber)  {
@@ -111,6 +113,12 @@ void KeyUtils::setNotation(const QMap<ChromaticKey, QString>& notation) {
         }
         s_reverseNotation.insert(it.value(), it.key());
     }
+    s_notationRevision.fetchAndAddRelease(1);
+}
+
+// static
+int KeyUtils::notationRevision() {
+    return load_atomic(s_notationRevision);
 }
 
 // static
@@ -1,6 +1,7 @@
 #ifndef KEYUTILS_H
 #define KEYUTILS_H
 
+#include <QAtomicInt>
 #include <QString>
 #include <QList>
 
@@ -75,6 +76,10 @@ class KeyUtils {
     static void setNotation(
         const QMap<mixxx::track::io::key::ChromaticKey, QString>& notation);
 
+    // Incremented by every call to setNotation(). Lets callers that cache
+    // keyToString() results notice that the default notation has changed.
+    static int notationRevision();
+
     // Returns pow(2, octaveChange)
     static inline double octaveChangeToPowerOf2(const double& octaveChange) {
         // Some libraries (e.g. SoundTouch) calculate pow(2, octaveChange)
@@ -154,6 +159,7 @@ class KeyUtils {
     static QMutex s_notationMutex;
     static QMap<mixxx::track::io::key::ChromaticKey, QString> s_notation;
     static QMap<QString, mixxx::track::io::key::ChromaticKey> s_reverseNotation;
+    static QAtomicInt s_notationRevision;
 };
 
 #endif /* KEYUTILS_H */
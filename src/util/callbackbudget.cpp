@@ -0,0 +1,117 @@
+#include <QMutexLocker>
+
+#include "util/callbackbudget.h"
+#include "util/math.h"
+
+// About 6 seconds at 128 frames per callback and 44.1 kHz. The developer
+// tools read the records twice per second.
+const int kRecordCount = 2048;
+
+// static
+QAtomicInt CallbackBudget::s_enabled(0);
+
+// static
+QString CallbackBudget::stageName(Stage stage) {
+    switch (stage) {
+        case SOUND_DEVICE_CALLBACK:
+            return "SoundDevicePortAudio callback";
+        case ENGINE_MASTER:
+            return "EngineMaster::process";
+        case ENGINE_CHANNEL:
+            return "EngineChannel::process";
+        case ENGINE_EFFECTS:
+            return "EngineEffectsManager::process";
+        case SCALER:
+            return "EngineBufferScale::getScaled";
+        case CACHING_READER_READ:
+            return "CachingReader::read";
+        case SIDECHAIN_WRITE:
+            return "EngineSideChain::writeSamples";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+CallbackBudget::CallbackBudget()
+        : m_records(kRecordCount),
+          m_droppedRecords(0) {
+    s_enabled.fetchAndStoreOrdered(1);
+}
+
+CallbackBudget::~CallbackBudget() {
+    s_enabled.fetchAndStoreOrdered(0);
+}
+
+void CallbackBudget::addStageTime(Stage stage, qint64 nanos, int channel) {
+    // A single stage never takes seconds, clamping keeps the sums in range.
+    const int clampedNanos = static_cast<int>(math_min(nanos, qint64(1 << 30)));
+    m_stageNanos[stage].fetchAndAddRelaxed(clampedNanos);
+    if (channel < 0 || channel >= kMaxChannels) {
+        return;
+    }
+    if (stage == ENGINE_CHANNEL) {
+        m_channelNanos[channel].fetchAndAddRelaxed(clampedNanos);
+    } else if (stage == SCALER) {
+        m_scalerNanos[channel].fetchAndAddRelaxed(clampedNanos);
+    }
+}
+
+// static
+void CallbackBudget::markChannelSilent(int channel) {
+    if (!isEnabled() || channel < 0 || channel >= kMaxChannels) {
+        return;
+    }
+    CallbackBudget* pBudget = instance();
+    if (pBudget) {
+        pBudget->m_channelSilent[channel].fetchAndStoreRelaxed(1);
+    }
+}
+
+void CallbackBudget::finishCallback(qint64 callbackNanos, qint64 budgetNanos,
+                                    bool xrun) {
+    addStageTime(SOUND_DEVICE_CALLBACK, callbackNanos);
+
+    Record record;
+    record.budgetNanos = static_cast<qint32>(budgetNanos);
+    record.xrun = xrun;
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        record.stageNanos[i] = m_stageNanos[i].fetchAndStoreRelaxed(0);
+    }
+    for (int i = 0; i < kMaxChannels; ++i) {
+        record.channelNanos[i] = m_channelNanos[i].fetchAndStoreRelaxed(0);
+        record.scalerNanos[i] = m_scalerNanos[i].fetchAndStoreRelaxed(0);
+        record.channelSilent[i] = m_channelSilent[i].fetchAndStoreRelaxed(0) != 0;
+    }
+    if (m_records.write(&record, 1) != 1) {
+        m_droppedRecords.fetchAndAddRelaxed(1);
+    }
+}
+
+int CallbackBudget::readRecords(Record* pRecords, int maxCount) {
+    return m_records.read(pRecords, maxCount);
+}
+
+int CallbackBudget::takeDroppedRecords() {
+    return m_droppedRecords.fetchAndStoreRelaxed(0);
+}
+
+void CallbackBudget::discardRecords() {
+    m_records.releaseReadRegions(m_records.readAvailable());
+    m_droppedRecords.fetchAndStoreRelaxed(0);
+}
+
+void CallbackBudget::setChannelName(int channel, const QString& name) {
+    if (channel < 0 || channel >= kMaxChannels) {
+        return;
+    }
+    QMutexLocker locker(&m_channelNamesMutex);
+    m_channelNames[channel] = name;
+}
+
+QString CallbackBudget::channelName(int channel) const {
+    if (channel < 0 || channel >= kMaxChannels) {
+        return QString();
+    }
+    QMutexLocker locker(&m_channelNamesMutex);
+    return m_channelNames[channel];
+}
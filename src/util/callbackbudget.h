@@ -0,0 +1,139 @@
+#ifndef CALLBACKBUDGET_H
+#define CALLBACKBUDGET_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+
+#include "util/compatibility.h"
+#include "util/fifo.h"
+#include "util/performancetimer.h"
+#include "util/singleton.h"
+
+// Records how much of each audio callback is spent in the stages of the
+// engine. Unlike Stat and Timer this is real-time safe: the audio threads
+// only add up nanoseconds in atomic counters, and once per callback the
+// sums are written into a preallocated lock-free FIFO. Nothing is allocated
+// and no QString is touched while recording.
+//
+// The stages nest: ENGINE_MASTER is part of SOUND_DEVICE_CALLBACK, the
+// channels are part of ENGINE_MASTER and so on. With channel worker threads
+// the channel times are summed over all threads and may add up to more than
+// ENGINE_MASTER.
+//
+// Only created in developer mode. DlgDeveloperTools reads the records.
+class CallbackBudget : public Singleton<CallbackBudget> {
+  public:
+    enum Stage {
+        SOUND_DEVICE_CALLBACK = 0,
+        ENGINE_MASTER,
+        ENGINE_CHANNEL,
+        ENGINE_EFFECTS,
+        SCALER,
+        CACHING_READER_READ,
+        SIDECHAIN_WRITE,
+        NUM_STAGES
+    };
+
+    static QString stageName(Stage stage);
+
+    // Channels are identified by their ChannelHandle. Channels with higher
+    // handles are only counted in the totals.
+    static const int kMaxChannels = 32;
+
+    // The times of one callback, in nanoseconds.
+    struct Record {
+        qint32 budgetNanos;
+        qint32 stageNanos[NUM_STAGES];
+        // The ENGINE_CHANNEL and SCALER times of each channel.
+        qint32 channelNanos[kMaxChannels];
+        qint32 scalerNanos[kMaxChannels];
+        // The channel was silent and skipped most of its processing, see
+        // EngineChannel::isSilent().
+        bool channelSilent[kMaxChannels];
+        // PortAudio reported an underflow at the start of this callback,
+        // which means that a previous callback missed its deadline.
+        bool xrun;
+    };
+
+    explicit CallbackBudget();
+    virtual ~CallbackBudget();
+
+    // True while an instance exists. Checked before anything is recorded.
+    static bool isEnabled() {
+        return load_atomic(s_enabled) != 0;
+    }
+
+    // Adds the time spent in a stage during the current callback. May be
+    // called from any engine thread. channel is a ChannelHandle or -1.
+    void addStageTime(Stage stage, qint64 nanos, int channel = -1);
+
+    // Records that a channel was silent in the current callback. Does
+    // nothing if CallbackBudget is disabled.
+    static void markChannelSilent(int channel);
+
+    // Closes the current callback. Called by the sound device that drives
+    // the engine at the end of its callback.
+    void finishCallback(qint64 callbackNanos, qint64 budgetNanos, bool xrun);
+
+    // Reads up to maxCount records in callback order. Returns the number of
+    // records read. Must only be called from one thread.
+    int readRecords(Record* pRecords, int maxCount);
+
+    // Returns the number of records that were dropped since the last call
+    // because the FIFO was full.
+    int takeDroppedRecords();
+
+    // Throws away all pending records, e.g. the stale ones that piled up
+    // while nobody was reading. Same thread as readRecords.
+    void discardRecords();
+
+    void setChannelName(int channel, const QString& name);
+    QString channelName(int channel) const;
+
+  private:
+    // Set by the GUI thread, read by the engine threads.
+    static QAtomicInt s_enabled;
+
+    QAtomicInt m_stageNanos[NUM_STAGES];
+    QAtomicInt m_channelNanos[kMaxChannels];
+    QAtomicInt m_scalerNanos[kMaxChannels];
+    QAtomicInt m_channelSilent[kMaxChannels];
+    FIFO<Record> m_records;
+    QAtomicInt m_droppedRecords;
+
+    mutable QMutex m_channelNamesMutex;
+    QString m_channelNames[kMaxChannels];
+};
+
+// Adds the time from construction to destruction to a stage of the current
+// callback. Does nothing if CallbackBudget is disabled.
+class ScopedCallbackBudget {
+  public:
+    explicit ScopedCallbackBudget(CallbackBudget::Stage stage,
+                                  int channel = -1)
+            : m_stage(stage),
+              m_channel(channel),
+              m_bActive(CallbackBudget::isEnabled()) {
+        if (m_bActive) {
+            m_timer.start();
+        }
+    }
+
+    ~ScopedCallbackBudget() {
+        if (m_bActive) {
+            CallbackBudget* pBudget = CallbackBudget::instance();
+            if (pBudget) {
+                pBudget->addStageTime(m_stage, m_timer.elapsed(), m_channel);
+            }
+        }
+    }
+
+  private:
+    const CallbackBudget::Stage m_stage;
+    const int m_channel;
+    const bool m_bActive;
+    PerformanceTimer m_timer;
+};
+
+#endif /* CALLBACKBUDGET_H */
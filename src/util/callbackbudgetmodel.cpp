@@ -0,0 +1,269 @@
+#include <QtAlgorithms>
+
+#include "util/callbackbudgetmodel.h"
+#include "util/math.h"
+
+namespace {
+
+const int kReadChunk = 256;
+
+}  // anonymous namespace
+
+CallbackBudgetModel::CallbackBudgetModel(QObject* pParent)
+        : QAbstractTableModel(pParent),
+          m_histogram(kHistogramBuckets, 0),
+          m_xrunCount(0),
+          m_droppedRecords(0) {
+    setHeaderData(COLUMN_NAME, Qt::Horizontal, tr("Stage"));
+    setHeaderData(COLUMN_MEAN, Qt::Horizontal, tr("Mean (us)"));
+    setHeaderData(COLUMN_P50, Qt::Horizontal, tr("Median (us)"));
+    setHeaderData(COLUMN_P99, Qt::Horizontal, tr("99th Percentile (us)"));
+    setHeaderData(COLUMN_MAX, Qt::Horizontal, tr("Max (us)"));
+    setHeaderData(COLUMN_P99_BUDGET, Qt::Horizontal, tr("99th Percentile (% of Budget)"));
+    setHeaderData(COLUMN_MEAN_BEFORE_XRUN, Qt::Horizontal, tr("Mean Before Xrun (us)"));
+    setHeaderData(COLUMN_SILENT, Qt::Horizontal, tr("Silent (% of Callbacks)"));
+}
+
+CallbackBudgetModel::~CallbackBudgetModel() {
+}
+
+void CallbackBudgetModel::update() {
+    CallbackBudget* pBudget = CallbackBudget::isEnabled() ?
+            CallbackBudget::instance() : NULL;
+    if (pBudget == NULL) {
+        return;
+    }
+    m_droppedRecords += pBudget->takeDroppedRecords();
+    CallbackBudget::Record records[kReadChunk];
+    int count;
+    bool changed = false;
+    while ((count = pBudget->readRecords(records, kReadChunk)) > 0) {
+        for (int i = 0; i < count; ++i) {
+            m_window.append(records[i]);
+        }
+        changed = true;
+    }
+    if (changed) {
+        while (m_window.size() > kWindowSize) {
+            m_window.removeFirst();
+        }
+        recompute();
+    }
+}
+
+void CallbackBudgetModel::addRecords(const CallbackBudget::Record* pRecords,
+                                     int count) {
+    for (int i = 0; i < count; ++i) {
+        m_window.append(pRecords[i]);
+    }
+    while (m_window.size() > kWindowSize) {
+        m_window.removeFirst();
+    }
+    recompute();
+}
+
+// static
+qint32 CallbackBudgetModel::percentile(const QVector<qint32>& sortedValues,
+                                       double fraction) {
+    if (sortedValues.isEmpty()) {
+        return 0;
+    }
+    // Nearest rank method.
+    int rank = static_cast<int>(ceil(fraction * sortedValues.size())) - 1;
+    rank = math_clamp(rank, 0, sortedValues.size() - 1);
+    return sortedValues[rank];
+}
+
+CallbackBudgetModel::Row CallbackBudgetModel::computeRow(
+        const QString& name, QVector<qint32> values, double budgetNanos) const {
+    Row row;
+    row.name = name;
+
+    // A callback that is followed by an xrun report took too long.
+    double sumBeforeXrun = 0.0;
+    int countBeforeXrun = 0;
+    double sum = 0.0;
+    for (int i = 0; i < values.size(); ++i) {
+        sum += values[i];
+        if (i + 1 < m_window.size() && m_window[i + 1].xrun) {
+            sumBeforeXrun += values[i];
+            ++countBeforeXrun;
+        }
+    }
+    qSort(values);
+
+    row.mean = values.isEmpty() ? 0.0 : sum / values.size() / 1000.0;
+    row.p50 = percentile(values, 0.5) / 1000.0;
+    row.p99 = percentile(values, 0.99) / 1000.0;
+    row.max = values.isEmpty() ? 0.0 : values.last() / 1000.0;
+    row.p99Budget = budgetNanos > 0.0 ?
+            100.0 * percentile(values, 0.99) / budgetNanos : 0.0;
+    row.meanBeforeXrun = countBeforeXrun > 0 ?
+            sumBeforeXrun / countBeforeXrun / 1000.0 : 0.0;
+    row.silentPercent = -1.0;
+    return row;
+}
+
+void CallbackBudgetModel::recompute() {
+    m_histogram.fill(0);
+    m_xrunCount = 0;
+    double budgetSum = 0.0;
+    bool channelActive[CallbackBudget::kMaxChannels] = { false };
+    bool scalerActive[CallbackBudget::kMaxChannels] = { false };
+    foreach (const CallbackBudget::Record& record, m_window) {
+        budgetSum += record.budgetNanos;
+        if (record.xrun) {
+            ++m_xrunCount;
+        }
+        if (record.budgetNanos > 0) {
+            const int bucket = static_cast<int>(
+                    10 * record.stageNanos[CallbackBudget::SOUND_DEVICE_CALLBACK] /
+                    static_cast<qint64>(record.budgetNanos));
+            ++m_histogram[math_min(bucket, kHistogramBuckets - 1)];
+        }
+        for (int i = 0; i < CallbackBudget::kMaxChannels; ++i) {
+            channelActive[i] = channelActive[i] || record.channelNanos[i] > 0;
+            scalerActive[i] = scalerActive[i] || record.scalerNanos[i] > 0;
+        }
+    }
+    const double budgetNanos = m_window.isEmpty() ?
+            0.0 : budgetSum / m_window.size();
+
+    CallbackBudget* pBudget = CallbackBudget::isEnabled() ?
+            CallbackBudget::instance() : NULL;
+    QVector<qint32> values(m_window.size());
+
+    beginResetModel();
+    m_rows.clear();
+    for (int stage = 0; stage < CallbackBudget::NUM_STAGES; ++stage) {
+        for (int i = 0; i < m_window.size(); ++i) {
+            values[i] = m_window[i].stageNanos[stage];
+        }
+        m_rows.append(computeRow(CallbackBudget::stageName(
+                static_cast<CallbackBudget::Stage>(stage)), values, budgetNanos));
+    }
+    for (int channel = 0; channel < CallbackBudget::kMaxChannels; ++channel) {
+        if (!channelActive[channel] && !scalerActive[channel]) {
+            continue;
+        }
+        QString channelName = pBudget ? pBudget->channelName(channel) : QString();
+        if (channelName.isEmpty()) {
+            channelName = QString::number(channel);
+        }
+        if (channelActive[channel]) {
+            for (int i = 0; i < m_window.size(); ++i) {
+                values[i] = m_window[i].channelNanos[channel];
+            }
+            Row row = computeRow(QString("  %1 %2").arg(
+                    CallbackBudget::stageName(CallbackBudget::ENGINE_CHANNEL),
+                    channelName), values, budgetNanos);
+            int silentCount = 0;
+            for (int i = 0; i < m_window.size(); ++i) {
+                if (m_window[i].channelSilent[channel]) {
+                    ++silentCount;
+                }
+            }
+            row.silentPercent = 100.0 * silentCount / m_window.size();
+            m_rows.append(row);
+        }
+        if (scalerActive[channel]) {
+            for (int i = 0; i < m_window.size(); ++i) {
+                values[i] = m_window[i].scalerNanos[channel];
+            }
+            m_rows.append(computeRow(QString("  %1 %2").arg(
+                    CallbackBudget::stageName(CallbackBudget::SCALER),
+                    channelName), values, budgetNanos));
+        }
+    }
+    endResetModel();
+}
+
+int CallbackBudgetModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+int CallbackBudgetModel::columnCount(const QModelIndex& parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+    return NUM_COLUMNS;
+}
+
+QVariant CallbackBudgetModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || (role != Qt::DisplayRole &&
+                             role != Qt::EditRole)) {
+        return QVariant();
+    }
+
+    int row = index.row();
+    if (row < 0 || row >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const Row& rowData = m_rows.at(row);
+    switch (index.column()) {
+        case COLUMN_NAME:
+            return rowData.name;
+        case COLUMN_MEAN:
+            return QString::number(rowData.mean, 'f', 1);
+        case COLUMN_P50:
+            return QString::number(rowData.p50, 'f', 1);
+        case COLUMN_P99:
+            return QString::number(rowData.p99, 'f', 1);
+        case COLUMN_MAX:
+            return QString::number(rowData.max, 'f', 1);
+        case COLUMN_P99_BUDGET:
+            return QString::number(rowData.p99Budget, 'f', 1);
+        case COLUMN_MEAN_BEFORE_XRUN:
+            return QString::number(rowData.meanBeforeXrun, 'f', 1);
+        case COLUMN_SILENT:
+            if (rowData.silentPercent < 0.0) {
+                return QString();
+            }
+            return QString::number(rowData.silentPercent, 'f', 1);
+    }
+    return QVariant();
+}
+
+bool CallbackBudgetModel::setHeaderData(int section,
+                                        Qt::Orientation orientation,
+                                        const QVariant& value,
+                                        int role) {
+    int numColumns = columnCount();
+    if (section < 0 || section >= numColumns) {
+        return false;
+    }
+
+    if (orientation != Qt::Horizontal) {
+        // We only care about horizontal headers.
+        return false;
+    }
+
+    if (m_headerInfo.size() != numColumns) {
+        m_headerInfo.resize(numColumns);
+    }
+
+    m_headerInfo[section][role] = value;
+    emit(headerDataChanged(orientation, section, section));
+    return true;
+}
+
+QVariant CallbackBudgetModel::headerData(int section,
+                                         Qt::Orientation orientation,
+                                         int role) const {
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        QVariant headerValue = m_headerInfo.value(section).value(role);
+        if (!headerValue.isValid()) {
+            // Try EditRole if DisplayRole wasn't present
+            headerValue = m_headerInfo.value(section).value(Qt::EditRole);
+        }
+        if (!headerValue.isValid()) {
+            headerValue = QVariant(section).toString();
+        }
+        return headerValue;
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
@@ -0,0 +1,104 @@
+#ifndef CALLBACKBUDGETMODEL_H
+#define CALLBACKBUDGETMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QModelIndex>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "util/callbackbudget.h"
+
+// Shows the stage times of the last callbacks recorded by CallbackBudget.
+// There is a row for each stage and for each channel and scaler that was
+// active in that window.
+class CallbackBudgetModel : public QAbstractTableModel {
+    Q_OBJECT
+  public:
+    enum CallbackBudgetColumn {
+        COLUMN_NAME = 0,
+        COLUMN_MEAN,
+        COLUMN_P50,
+        COLUMN_P99,
+        COLUMN_MAX,
+        COLUMN_P99_BUDGET,
+        COLUMN_MEAN_BEFORE_XRUN,
+        COLUMN_SILENT,
+        NUM_COLUMNS
+    };
+
+    // The number of callbacks the statistics are computed over.
+    static const int kWindowSize = 2048;
+    // The callback time histogram has buckets of 10% of the budget. The
+    // last one counts all callbacks that took longer than the budget.
+    static const int kHistogramBuckets = 11;
+
+    CallbackBudgetModel(QObject* pParent=NULL);
+    virtual ~CallbackBudgetModel();
+
+    // Adds records to the window and recomputes the statistics.
+    void addRecords(const CallbackBudget::Record* pRecords, int count);
+    // Reads all pending records of CallbackBudget, if it exists.
+    void update();
+
+    // The number of SOUND_DEVICE_CALLBACK times per histogram bucket.
+    const QVector<int>& callbackHistogram() const {
+        return m_histogram;
+    }
+    int windowCallbackCount() const {
+        return m_window.size();
+    }
+    int windowXrunCount() const {
+        return m_xrunCount;
+    }
+    int droppedRecordCount() const {
+        return m_droppedRecords;
+    }
+
+    // Returns the value below which the given fraction of the sorted values
+    // lie, e.g. 0.99 for the 99th percentile.
+    static qint32 percentile(const QVector<qint32>& sortedValues,
+                             double fraction);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // QAbstractItemModel methods
+    ////////////////////////////////////////////////////////////////////////////
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    bool setHeaderData(int section, Qt::Orientation orientation,
+                       const QVariant& value, int role = Qt::EditRole);
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const;
+
+  private:
+    struct Row {
+        QString name;
+        // All in microseconds.
+        double mean;
+        double p50;
+        double p99;
+        double max;
+        double p99Budget;
+        double meanBeforeXrun;
+        // The share of callbacks in which a channel was silent, in percent.
+        // Negative for the other rows.
+        double silentPercent;
+    };
+
+    // Computes a row from the values of all callbacks in the window.
+    Row computeRow(const QString& name, QVector<qint32> values,
+                   double budgetNanos) const;
+    void recompute();
+
+    QVector<QHash<int, QVariant> > m_headerInfo;
+    QList<CallbackBudget::Record> m_window;
+    QList<Row> m_rows;
+    QVector<int> m_histogram;
+    int m_xrunCount;
+    int m_droppedRecords;
+};
+
+#endif /* CALLBACKBUDGETMODEL_H */
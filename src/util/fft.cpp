@@ -0,0 +1,138 @@
+#include "util/fft.h"
+
+#include "util/assert.h"
+#include "util/math.h"
+
+// The real transform of m_size points is computed by a complex FFT of
+// m_size / 2 points that takes the even samples as real and the odd samples
+// as imaginary parts, followed by a pass that splits the two spectra again.
+
+RealFFT::RealFFT(int size)
+        : m_size(size) {
+    DEBUG_ASSERT(size >= 4 && (size & (size - 1)) == 0);
+    const int half = size / 2;
+
+    int bits = 0;
+    while ((1 << bits) < half) {
+        ++bits;
+    }
+    m_bitReverse.resize(half);
+    for (int i = 0; i < half; ++i) {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; ++bit) {
+            if (i & (1 << bit)) {
+                reversed |= 1 << (bits - 1 - bit);
+            }
+        }
+        m_bitReverse[i] = reversed;
+    }
+
+    m_cos.resize(half / 2);
+    m_sin.resize(half / 2);
+    for (int i = 0; i < half / 2; ++i) {
+        const double phase = 2.0 * M_PI * i / half;
+        m_cos[i] = static_cast<float>(cos(phase));
+        m_sin[i] = static_cast<float>(sin(phase));
+    }
+
+    m_splitCos.resize(half);
+    m_splitSin.resize(half);
+    for (int i = 0; i < half; ++i) {
+        const double phase = 2.0 * M_PI * i / size;
+        m_splitCos[i] = static_cast<float>(cos(phase));
+        m_splitSin[i] = static_cast<float>(sin(phase));
+    }
+
+    m_re.resize(half);
+    m_im.resize(half);
+}
+
+RealFFT::~RealFFT() {
+}
+
+void RealFFT::forward(const float* pInput, float* pRe, float* pIm) {
+    const int half = m_size / 2;
+    float* re = m_re.data();
+    float* im = m_im.data();
+    for (int i = 0; i < half; ++i) {
+        const int j = m_bitReverse[i];
+        re[j] = pInput[2 * i];
+        im[j] = pInput[2 * i + 1];
+    }
+    transform(false);
+
+    pRe[0] = re[0] + im[0];
+    pIm[0] = 0.0f;
+    pRe[half] = re[0] - im[0];
+    pIm[half] = 0.0f;
+    for (int k = 1; k < half; ++k) {
+        // The spectra of the even samples e and of the odd samples o.
+        const float ar = re[k];
+        const float ai = im[k];
+        const float br = re[half - k];
+        const float bi = -im[half - k];
+        const float er = 0.5f * (ar + br);
+        const float ei = 0.5f * (ai + bi);
+        const float or_ = 0.5f * (ai - bi);
+        const float oi = -0.5f * (ar - br);
+        const float c = m_splitCos[k];
+        const float s = m_splitSin[k];
+        pRe[k] = er + c * or_ + s * oi;
+        pIm[k] = ei + c * oi - s * or_;
+    }
+}
+
+void RealFFT::inverse(const float* pRe, const float* pIm, float* pOutput) {
+    const int half = m_size / 2;
+    float* re = m_re.data();
+    float* im = m_im.data();
+    for (int k = 0; k < half; ++k) {
+        const float xr = pRe[k];
+        const float xi = pIm[k];
+        const float yr = pRe[half - k];
+        const float yi = -pIm[half - k];
+        // Twice the spectra of the even and of the odd samples.
+        const float er = xr + yr;
+        const float ei = xi + yi;
+        const float dr = xr - yr;
+        const float di = xi - yi;
+        const float c = m_splitCos[k];
+        const float s = m_splitSin[k];
+        const float or_ = dr * c - di * s;
+        const float oi = dr * s + di * c;
+        const int j = m_bitReverse[k];
+        re[j] = er - oi;
+        im[j] = ei + or_;
+    }
+    transform(true);
+
+    for (int i = 0; i < half; ++i) {
+        pOutput[2 * i] = re[i];
+        pOutput[2 * i + 1] = im[i];
+    }
+}
+
+void RealFFT::transform(bool inverse) {
+    const int half = m_size / 2;
+    float* re = m_re.data();
+    float* im = m_im.data();
+    const float sign = inverse ? 1.0f : -1.0f;
+    for (int length = 2; length <= half; length <<= 1) {
+        const int span = length / 2;
+        const int step = half / length;
+        for (int start = 0; start < half; start += length) {
+            for (int j = 0; j < span; ++j) {
+                const float wr = m_cos[j * step];
+                const float wi = sign * m_sin[j * step];
+                const int a = start + j;
+                const int b = a + span;
+                const float tr = wr * re[b] - wi * im[b];
+                const float ti = wr * im[b] + wi * re[b];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+#include "util.h"
+
+// A radix-2 FFT of real signals. The spectra are kept as separate real and
+// imaginary arrays of bins() values each, which lets the multiply-accumulate
+// loops of a convolution run straight over the arrays.
+//
+// The tables are computed by the constructor and transform() does not
+// allocate, so it is real-time safe. An instance keeps scratch buffers and
+// must only be used by one thread at a time.
+class RealFFT {
+  public:
+    // size must be a power of 2 and at least 4.
+    explicit RealFFT(int size);
+    virtual ~RealFFT();
+
+    int size() const {
+        return m_size;
+    }
+
+    // The number of bins of a spectrum, DC to Nyquist.
+    int bins() const {
+        return m_size / 2 + 1;
+    }
+
+    // Transforms size() samples of pInput into the bins() values of pRe and
+    // pIm.
+    void forward(const float* pInput, float* pRe, float* pIm);
+
+    // Transforms a spectrum back into size() samples of pOutput. The result
+    // is not normalized, it is scaled by size().
+    void inverse(const float* pRe, const float* pIm, float* pOutput);
+
+  private:
+    // A complex FFT of m_size / 2 points of m_re and m_im in place. inverse
+    // selects the conjugate twiddles.
+    void transform(bool inverse);
+
+    const int m_size;
+    // The half size tables of the complex FFT.
+    QVector<int> m_bitReverse;
+    QVector<float> m_cos;
+    QVector<float> m_sin;
+    // exp(-2 pi i k / m_size) for splitting the real spectrum.
+    QVector<float> m_splitCos;
+    QVector<float> m_splitSin;
+    QVector<float> m_re;
+    QVector<float> m_im;
+
+    DISALLOW_COPY_AND_ASSIGN(RealFFT);
+};
+
+#endif /* FFT_H */
@@ -57,6 +57,11 @@ WTrackTableView::WTrackTableView(QWidget * parent,
 
     connect(&m_loadTrackMapper, SIGNAL(mapped(QString)),
             this, SLOT(loadSelectionToGroup(QString)));
+    if (m_pTrackCollection != NULL) {
+        connect(&m_pTrackCollection->getTrackDAO(),
+                SIGNAL(trackLoaded(int, TrackPointer)),
+                this, SLOT(slotTrackLoaded(int, TrackPointer)));
+    }
 
     connect(&m_deckMapper, SIGNAL(mapped(QString)),
             this, SLOT(loadSelectionToGroup(QString)));
@@ -171,6 +176,25 @@ void WTrackTableView::slotScrollValueChanged(int) {
     enableCachedOnly();
 }
 
+void WTrackTableView::prefetchVisibleCovers() {
+    TrackModel* pTrackModel = getTrackModel();
+    if (pTrackModel == NULL || m_iCoverColumn < 0 ||
+            isColumnHidden(m_iCoverColumn)) {
+        return;
+    }
+    int firstVisibleRow = rowAt(0);
+    if (firstVisibleRow < 0) {
+        return;
+    }
+    int lastVisibleRow = rowAt(viewport()->height() - 1);
+    if (lastVisibleRow < 0) {
+        // The rows end before the bottom of the viewport.
+        lastVisibleRow = model()->rowCount() - 1;
+    }
+    pTrackModel->prefetchCovers(firstVisibleRow, lastVisibleRow,
+                                columnWidth(m_iCoverColumn));
+}
+
 void WTrackTableView::selectionChanged(const QItemSelection& selected,
                                        const QItemSelection& deselected) {
     m_selectionChangedSinceLastGuiTick = true;
@@ -207,6 +231,11 @@ void WTrackTableView::slotGuiTick50ms(double) {
         // (as opposed to only serving them from cache).
         emit(onlyCachedCoverArt(false));
         m_loadCachedOnly = false;
+
+        // Load the covers of the previous and the next page while the user
+        // is looking at this one. Covers are not prefetched while scrolling,
+        // so fast scrolling does not queue up cover loads.
+        prefetchVisibleCovers();
     }
 }
 
@@ -474,15 +503,73 @@ void WTrackTableView::slotMouseDoubleClicked(const QModelIndex &index) {
             sendToAutoDJ(true); // add track to Auto-DJ Queue (top)
             break;
     default: // load track to next available deck
-            TrackModel* trackModel = getTrackModel();
-            TrackPointer pTrack;
-            if (trackModel && (pTrack = trackModel->getTrack(index))) {
-                emit(loadTrack(pTrack));
-            }
+            loadTrackAt(index, QString(), false);
             break;
     }
 }
 
+void WTrackTableView::loadTrackAt(const QModelIndex& index,
+                                  const QString& group, bool play) {
+    TrackModel* trackModel = getTrackModel();
+    if (trackModel == NULL) {
+        return;
+    }
+    // A track that is still loading in the background must not replace
+    // this one in the player when it arrives.
+    if (!group.isEmpty()) {
+        dropPendingTrackLoads(group);
+    }
+    TrackPointer pTrack;
+    const int trackId = trackModel->getLibraryTrackId(index);
+    if (trackId >= 0 && m_pTrackCollection != NULL) {
+        // Reading a track that is not cached blocks for a while, so it is
+        // done in a worker thread.
+        pTrack = m_pTrackCollection->getTrackDAO().requestTrack(trackId);
+        if (!pTrack) {
+            m_pendingTrackLoads.insert(trackId, qMakePair(group, play));
+            return;
+        }
+    } else {
+        pTrack = trackModel->getTrack(index);
+    }
+    if (pTrack) {
+        emitLoadTrack(pTrack, group, play);
+    }
+}
+
+void WTrackTableView::dropPendingTrackLoads(const QString& group) {
+    QMutableHashIterator<int, QPair<QString, bool> > it(m_pendingTrackLoads);
+    while (it.hasNext()) {
+        if (it.next().value().first == group) {
+            it.remove();
+        }
+    }
+}
+
+void WTrackTableView::emitLoadTrack(TrackPointer pTrack, const QString& group,
+                                    bool play) {
+    if (group.isEmpty()) {
+        emit(loadTrack(pTrack));
+    } else {
+        emit(loadTrackToPlayer(pTrack, group, play));
+    }
+}
+
+void WTrackTableView::slotTrackLoaded(int trackId, TrackPointer pTrack) {
+    QList<QPair<QString, bool> > loads = m_pendingTrackLoads.values(trackId);
+    if (loads.isEmpty()) {
+        return;
+    }
+    m_pendingTrackLoads.remove(trackId);
+    if (!pTrack) {
+        return;
+    }
+    // QMultiHash returns the most recent value first.
+    for (int i = loads.size() - 1; i >= 0; --i) {
+        emitLoadTrack(pTrack, loads[i].first, loads[i].second);
+    }
+}
+
 void WTrackTableView::loadSelectionToGroup(QString group, bool play) {
     QModelIndexList indices = selectionModel()->selectedRows();
     if (indices.size() > 0) {
@@ -496,13 +583,7 @@ void WTrackTableView::loadSelectionToGroup(QString group, bool play) {
                 return;
             }
         }
-        QModelIndex index = indices.at(0);
-        TrackModel* trackModel = getTrackModel();
-        TrackPointer pTrack;
-        if (trackModel &&
-                (pTrack = trackModel->getTrack(index))) {
-            emit(loadTrackToPlayer(pTrack, group, play));
-        }
+        loadTrackAt(indices.at(0), group, play);
     }
 }
 
@@ -3,6 +3,8 @@
 
 #include <QAbstractItemModel>
 #include <QSortFilterProxyModel>
+#include <QHash>
+#include <QPair>
 
 #include "configobject.h"
 #include "controlobjectslave.h"
@@ -77,9 +79,17 @@ class WTrackTableView : public WLibraryTableView {
     void slotScrollValueChanged(int);
     void slotCoverArtSelected(const CoverArt& art);
     void slotReloadCoverArt();
+    void slotTrackLoaded(int trackId, TrackPointer pTrack);
 
   private:
     void sendToAutoDJ(bool bTop);
+    // Emits loadTrackToPlayer() for the track at index, or loadTrack() if
+    // group is empty. Tracks of the library table are loaded in the
+    // background, see slotTrackLoaded().
+    void loadTrackAt(const QModelIndex& index, const QString& group, bool play);
+    // Forgets the background loads into group, a newer load replaces them.
+    void dropPendingTrackLoads(const QString& group);
+    void emitLoadTrack(TrackPointer pTrack, const QString& group, bool play);
     void showTrackInfo(QModelIndex index);
     void showDlgTagFetcher(QModelIndex index);
     void createActions();
@@ -89,6 +99,7 @@ class WTrackTableView : public WLibraryTableView {
     void lockBpm(bool lock);
 
     void enableCachedOnly();
+    void prefetchVisibleCovers();
     void selectionChanged(const QItemSelection &selected,
                           const QItemSelection &deselected);
 
@@ -105,6 +116,11 @@ class WTrackTableView : public WLibraryTableView {
 
     QSignalMapper m_loadTrackMapper;
 
+    // The group and play flag of tracks that are loaded in the background
+    // to be loaded into a player, by track ID. At most one per group, apart
+    // from loads into the next free deck, which have an empty group.
+    QMultiHash<int, QPair<QString, bool> > m_pendingTrackLoads;
+
     DlgTrackInfo* m_pTrackInfo;
     DlgTagFetcher m_DlgTagFetcher;
     QModelIndex currentTrackInfoIndex;